@@ -580,8 +580,8 @@ void LLAudioDecodeMgr::Impl::startMoreDecodes()
     LL::WorkQueue::ptr_t main_queue = LL::WorkQueue::getInstance("mainloop");
     // *NOTE: main_queue->postTo casts this refcounted smart pointer to a weak
     // pointer
-    LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
-    const LL::ThreadPool::ptr_t general_thread_pool = LL::ThreadPool::getInstance("General");
+    LL::WorkQueueBase::ptr_t general_queue = LL::WorkQueueBase::getInstance("General");
+    const LL::ThreadPoolBase::ptr_t general_thread_pool = LL::ThreadPoolBase::getInstance("General");
     llassert_always(main_queue);
     llassert_always(general_queue);
     llassert_always(general_thread_pool);
@@ -348,6 +348,9 @@ void LLApp::setErrorHandler(LLAppErrorHandler handler)
 // static
 void LLApp::runErrorHandler()
 {
+    // get queued log messages out before the handler writes crash reports
+    LLError::flushAsyncLogging();
+
     if (LLApp::sErrorHandler)
     {
         LLApp::sErrorHandler();
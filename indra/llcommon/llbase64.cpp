@@ -1,6 +1,6 @@
 /**
  * @file llbase64.cpp
- * @brief Wrapper for apr base64 encoding that returns a std::string
+ * @brief Base64 encoding and decoding, byte for byte compatible with apr_base64
  * @author James Cook
  *
  * $LicenseInfo:firstyear=2007&license=viewerlgpl$
@@ -29,10 +29,174 @@
 
 #include "llbase64.h"
 
+#include "llprocessor.h"
+
+#include <algorithm>
 #include <string>
+#include <tmmintrin.h>
+
+// The SSSE3 kernels are compiled for that instruction set whatever the rest
+// of the build targets, and only called after checking the CPU has it.
+#if LL_GNUC || LL_CLANG
+#define LL_TARGET_SSSE3 __attribute__((target("ssse3")))
+#else
+#define LL_TARGET_SSSE3
+#endif
+
+namespace
+{
+    const char BASE64_ALPHABET[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    // 6 bit value of each character, 64 outside the alphabet
+    struct DecodeTable
+    {
+        U8 mValue[256];
+
+        DecodeTable()
+        {
+            memset(mValue, 64, sizeof(mValue));
+            for (U8 i = 0; i < 64; ++i)
+            {
+                mValue[(U8)BASE64_ALPHABET[i]] = i;
+            }
+        }
+    };
+
+    const U8* decode_table()
+    {
+        static const DecodeTable table;
+        return table.mValue;
+    }
 
-#include "apr_base64.h"
+    bool has_ssse3()
+    {
+        static const bool ssse3 = LLProcessorInfo().hasSSE3S();
+        return ssse3;
+    }
 
+    // apr_base64_encode_binary(), without the terminating NUL
+    void encode_scalar(const U8* in, size_t len, char* out)
+    {
+        size_t i = 0;
+        for (; i + 2 < len; i += 3)
+        {
+            *out++ = BASE64_ALPHABET[in[i] >> 2];
+            *out++ = BASE64_ALPHABET[((in[i] & 0x03) << 4) | (in[i + 1] >> 4)];
+            *out++ = BASE64_ALPHABET[((in[i + 1] & 0x0f) << 2) | (in[i + 2] >> 6)];
+            *out++ = BASE64_ALPHABET[in[i + 2] & 0x3f];
+        }
+        if (i < len)
+        {
+            *out++ = BASE64_ALPHABET[in[i] >> 2];
+            if (i + 1 == len)
+            {
+                *out++ = BASE64_ALPHABET[(in[i] & 0x03) << 4];
+                *out++ = '=';
+            }
+            else
+            {
+                *out++ = BASE64_ALPHABET[((in[i] & 0x03) << 4) | (in[i + 1] >> 4)];
+                *out++ = BASE64_ALPHABET[(in[i + 1] & 0x0f) << 2];
+            }
+            *out++ = '=';
+        }
+    }
+
+    // apr_base64_decode_binary() on count characters, all in the alphabet.
+    // A lone trailing character decodes to nothing. Returns the bytes written.
+    size_t decode_scalar(const U8* in, size_t count, U8* out)
+    {
+        const U8* table = decode_table();
+        U8* start = out;
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            U8 a = table[in[i]], b = table[in[i + 1]], c = table[in[i + 2]], d = table[in[i + 3]];
+            *out++ = (U8)(a << 2 | b >> 4);
+            *out++ = (U8)(b << 4 | c >> 2);
+            *out++ = (U8)(c << 6 | d);
+        }
+        if (count - i > 1)
+        {
+            *out++ = (U8)(table[in[i]] << 2 | table[in[i + 1]] >> 4);
+        }
+        if (count - i > 2)
+        {
+            *out++ = (U8)(table[in[i + 1]] << 4 | table[in[i + 2]] >> 2);
+        }
+        return out - start;
+    }
+
+    // Encodes 12 bytes into 16 characters per iteration, reading 16; returns
+    // the number of input bytes consumed, a multiple of 12.
+    LL_TARGET_SSSE3 size_t encode_ssse3(const U8* in, size_t len, char* out)
+    {
+        // each 32 bit lane gets bytes 1 0 2 1 of its 3 byte group
+        const __m128i spread = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+        // offset from a 6 bit value to its character, by range
+        const __m128i offsets = _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+        size_t done = 0;
+        for (; done + 16 <= len; done += 12)
+        {
+            __m128i bytes = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + done)), spread);
+            __m128i ac = _mm_mulhi_epu16(_mm_and_si128(bytes, _mm_set1_epi32(0x0fc0fc00)),
+                                         _mm_set1_epi32(0x04000040));
+            __m128i bd = _mm_mullo_epi16(_mm_and_si128(bytes, _mm_set1_epi32(0x003f03f0)),
+                                         _mm_set1_epi32(0x01000010));
+            __m128i values = _mm_or_si128(ac, bd);
+            // 0 for A-Z, 1 for a-z, 2-11 for digits, 12 for '+', 13 for '/'
+            __m128i range = _mm_subs_epu8(values, _mm_set1_epi8(51));
+            range = _mm_sub_epi8(range, _mm_cmpgt_epi8(values, _mm_set1_epi8(25)));
+            __m128i chars = _mm_add_epi8(values, _mm_shuffle_epi8(offsets, range));
+            _mm_storeu_si128((__m128i*)(out + done / 3 * 4), chars);
+        }
+        return done;
+    }
+
+    // Decodes 16 characters into 12 bytes per iteration, stopping before the
+    // first block holding a character outside the alphabet; returns the
+    // number of characters consumed, a multiple of 16.
+    LL_TARGET_SSSE3 size_t decode_ssse3(const U8* in, size_t len, U8* out)
+    {
+        // a character is invalid when the classes of its two nibbles overlap
+        const __m128i classes_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                                 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+        const __m128i classes_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                                 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        // offset from a character to its 6 bit value, by high nibble, with
+        // '/' moved to slot 1
+        const __m128i offsets = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                              0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i slash = _mm_set1_epi8(0x2f);
+        // bytes 2 1 0 of each lane, packed into 12
+        const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        size_t done = 0;
+        for (; done + 16 <= len; done += 16)
+        {
+            __m128i chars = _mm_loadu_si128((const __m128i*)(in + done));
+            __m128i hi = _mm_and_si128(_mm_srli_epi32(chars, 4), slash);
+            __m128i lo = _mm_and_si128(chars, slash);
+            __m128i invalid = _mm_and_si128(_mm_shuffle_epi8(classes_lo, lo),
+                                            _mm_shuffle_epi8(classes_hi, hi));
+            if (_mm_movemask_epi8(_mm_cmpgt_epi8(invalid, _mm_setzero_si128())))
+            {
+                break;
+            }
+            __m128i roll = _mm_shuffle_epi8(offsets, _mm_add_epi8(_mm_cmpeq_epi8(chars, slash), hi));
+            __m128i values = _mm_add_epi8(chars, roll);
+            // aaaaaa bbbbbb cccccc dddddd -> 24 bits per 32 bit lane
+            __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+            __m128i lanes = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+            __m128i bytes = _mm_shuffle_epi8(lanes, pack);
+            U8* dest = out + done / 4 * 3;
+            _mm_storel_epi64((__m128i*)dest, bytes);
+            S32 last = _mm_cvtsi128_si32(_mm_srli_si128(bytes, 8));
+            memcpy(dest + 8, &last, 4);
+        }
+        return done;
+    }
+}
 
 // static
 std::string LLBase64::encode(const U8* input, size_t input_size)
@@ -41,37 +205,43 @@ std::string LLBase64::encode(const U8* input, size_t input_size)
     if (input
         && input_size > 0)
     {
-        // Yes, it returns int.
-        int b64_buffer_length = apr_base64_encode_len(narrow<size_t>(input_size));
-        char* b64_buffer = new char[b64_buffer_length];
-
-        // This is faster than apr_base64_encode() if you know
-        // you're not on an EBCDIC machine.  Also, the output is
-        // null terminated, even though the documentation doesn't
-        // specify.  See apr_base64.c for details. JC
-        b64_buffer_length = apr_base64_encode_binary(
-            b64_buffer,
-            input,
-            narrow<size_t>(input_size));
-        output.assign(b64_buffer);
-        delete[] b64_buffer;
+        output.resize((input_size + 2) / 3 * 4);
+        size_t done = 0;
+        if (input_size >= 16 && has_ssse3())
+        {
+            done = encode_ssse3(input, input_size, &output[0]);
+        }
+        encode_scalar(input + done, input_size - done, &output[done / 3 * 4]);
     }
     return output;
 }
 
-std::string LLBase64::decodeAsString(const std::string &input)
+// static
+std::vector<U8> LLBase64::decode(const char* input, size_t input_size)
 {
-    int b64_buffer_length = apr_base64_decode_len(input.c_str());
-    char* b64_buffer = new char[b64_buffer_length];
-
-        // This is faster than apr_base64_encode() if you know
-        // you're not on an EBCDIC machine.  Also, the output is
-        // null terminated, even though the documentation doesn't
-        // specify.  See apr_base64.c for details. JC
-    b64_buffer_length = apr_base64_decode(b64_buffer, input.c_str());
-    std::string res;
-    res.assign(b64_buffer);
-    delete[] b64_buffer;
-    return res;
+    const U8* in = (const U8*)input;
+    std::vector<U8> output(input_size / 4 * 3 + 2);
+    size_t done = 0;
+    if (input_size >= 16 && has_ssse3())
+    {
+        done = decode_ssse3(in, input_size, output.data());
+    }
+    const U8* table = decode_table();
+    size_t end = done;
+    while (end < input_size && table[in[end]] < 64)
+    {
+        ++end;
+    }
+    output.resize(done / 4 * 3 + decode_scalar(in + done, end - done, output.data() + done / 4 * 3));
+    return output;
 }
 
+// static
+std::string LLBase64::decodeAsString(const std::string &input)
+{
+    std::vector<U8> decoded = decode(input);
+    // apr_base64_decode() NUL terminates what it decodes, and that was read
+    // back as a C string.
+    std::vector<U8>::iterator end = std::find(decoded.begin(), decoded.end(), 0);
+    return std::string(decoded.begin(), end);
+}
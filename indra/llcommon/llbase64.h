@@ -1,6 +1,6 @@
 /**
  * @file llbase64.h
- * @brief Wrapper for apr base64 encoding that returns a std::string
+ * @brief Base64 encoding and decoding, byte for byte compatible with apr_base64
  * @author James Cook
  *
  * $LicenseInfo:firstyear=2007&license=viewerlgpl$
@@ -28,10 +28,24 @@
 #ifndef LLBASE64_H
 #define LLBASE64_H
 
+#include <vector>
+
+// Output matches apr_base64_encode_binary() and apr_base64_decode_binary()
+// exactly; long inputs go through an SSSE3 kernel when the CPU has one.
 class LL_COMMON_API LLBase64
 {
 public:
     static std::string encode(const U8* input, size_t input_size);
+
+    // Decodes up to the first character outside the base64 alphabet, the
+    // '=' padding included, as apr_base64_decode_binary() does.
+    static std::vector<U8> decode(const char* input, size_t input_size);
+    static std::vector<U8> decode(const std::string& input)
+    {
+        return decode(input.data(), input.size());
+    }
+
+    // As decode(), but stops at the first decoded NUL byte.
     static std::string decodeAsString(const std::string& input);
 };
 
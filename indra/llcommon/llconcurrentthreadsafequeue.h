@@ -0,0 +1,476 @@
+/**
+ * @file llconcurrentthreadsafequeue.h
+ * @brief Lock-free multi-producer, multi-consumer LLThreadSafeQueue.
+ *
+ * @Description:
+ * LLThreadSafeQueue serializes every push() and pop() on one mutex, so a
+ * busy consumer (typically the main thread) and several producers (fetch and
+ * decode threads) keep handing the lock back and forth. This queue stores its
+ * elements in the vendored moodycamel::ConcurrentQueue instead, so pushing
+ * and popping never take a lock while the queue is neither empty nor full.
+ * The mutex and condition variables are only used to put a consumer to sleep
+ * on an empty queue, or a producer on a full one.
+ *
+ * It publishes the same API as LLThreadSafeQueue, including close() and the
+ * LLThreadSafeQueueInterrupt semantics, with two differences:
+ * 1/ Elements pushed by the same thread are popped in the order they were
+ *    pushed, but there is no ordering between elements pushed by different
+ *    threads.
+ * 2/ There is no canPop() hook, so it can't back a ThreadSafeSchedule.
+ *
+ * Blocked callers wait on boost::fibers primitives, as with LLThreadSafeQueue,
+ * so a coroutine waiting on the queue does not block the rest of its thread.
+ * That is why this doesn't use moodycamel::BlockingConcurrentQueue, whose
+ * waits block the OS thread.
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLCONCURRENTTHREADSAFEQUEUE_H
+#define LL_LLCONCURRENTTHREADSAFEQUEUE_H
+
+#include "llthreadsafequeue.h"
+#include "concurrentqueue.h"
+#include <atomic>
+#include <chrono>
+
+template<typename ElementT>
+class LLConcurrentThreadSafeQueue
+{
+public:
+    typedef ElementT value_type;
+
+    // Limiting the number of pending items prevents unbounded growth of the
+    // underlying queue.
+    LLConcurrentThreadSafeQueue(size_t capacity = 1024);
+    virtual ~LLConcurrentThreadSafeQueue() {}
+
+    // Add an element to the queue (will block if the queue has reached
+    // capacity).
+    //
+    // This call will raise an interrupt error if the queue is closed while
+    // the caller is blocked.
+    template <typename T>
+    void push(T&& element);
+
+    // Add an element to the queue (will block if the queue has reached
+    // capacity). Return false if the queue is closed before push is possible.
+    template <typename T>
+    bool pushIfOpen(T&& element);
+
+    // Try to add an element to the queue without blocking. Returns
+    // true only if the element was actually added.
+    template <typename T>
+    bool tryPush(T&& element);
+
+    // Try to add an element to the queue, blocking if full but with timeout
+    // after specified duration. Returns true if the element was added.
+    template <typename Rep, typename Period, typename T>
+    bool tryPushFor(const std::chrono::duration<Rep, Period>& timeout,
+                    T&& element);
+
+    // Try to add an element to the queue, blocking if full but with
+    // timeout at specified time_point. Returns true if the element was added.
+    template <typename Clock, typename Duration, typename T>
+    bool tryPushUntil(const std::chrono::time_point<Clock, Duration>& until,
+                      T&& element);
+
+    // Pop an element from the queue (will block if the queue is empty).
+    //
+    // This call will raise an interrupt error if the queue is closed while
+    // the caller is blocked.
+    ElementT pop(void);
+
+    // Pop an element from the queue if there is one available.
+    // Returns true only if an element was popped.
+    bool tryPop(ElementT & element);
+
+    // Pop an element from the queue, blocking if empty, with timeout after
+    // specified duration. Returns true if an element was popped.
+    template <typename Rep, typename Period>
+    bool tryPopFor(const std::chrono::duration<Rep, Period>& timeout, ElementT& element);
+
+    // Pop an element from the queue, blocking if empty, with timeout at
+    // specified time_point. Returns true if an element was popped.
+    template <typename Clock, typename Duration>
+    bool tryPopUntil(const std::chrono::time_point<Clock, Duration>& until,
+                     ElementT& element);
+
+    // Returns the size of the queue. This counts pushes still in progress on
+    // other threads, so it is at least as large as the number of elements
+    // poppable right now.
+    size_t size() { return mSize.load(); }
+
+    //Returns the capacity of the queue.
+    U32 capacity() { return (U32)mCapacity; }
+
+    // closes the queue, with the same semantics as LLThreadSafeQueue::close():
+    // - every subsequent push() call will throw LLThreadSafeQueueInterrupt
+    // - every subsequent tryPush() call will return false
+    // - pop() calls will return normally until the queue is drained, then
+    //   every subsequent pop() will throw LLThreadSafeQueueInterrupt
+    // - tryPop() calls will return normally until the queue is drained,
+    //   then every subsequent tryPop() call will return false
+    void close();
+
+    // producer end: are we prevented from pushing any additional items?
+    bool isClosed() { return mClosed.load(); }
+    // consumer end: are we done, is the queue entirely drained?
+    bool done() { return mClosed.load() && mSize.load() == 0; }
+
+protected:
+    typedef moodycamel::ConcurrentQueue<ElementT> queue_type;
+    queue_type mStorage;
+    size_t mCapacity;
+    // Number of slots claimed by producers and not yet released by a
+    // consumer: elements in mStorage plus pushes in progress.
+    std::atomic<size_t> mSize;
+    std::atomic<bool> mClosed;
+
+    // Only used to sleep and wake: nobody holds mLock while touching
+    // mStorage, except a waiter making its last check before sleeping.
+    LLCoros::Mutex mLock;
+    typedef LLCoros::LockType lock_t;
+    boost::fibers::condition_variable_any mCapacityCond;
+    boost::fibers::condition_variable_any mEmptyCond;
+    // Number of callers blocked (or about to block) on each condition. The
+    // fast paths only take mLock to notify when one of these is nonzero.
+    std::atomic<U32> mPushWaiters;
+    std::atomic<U32> mPopWaiters;
+
+    enum pop_result { EMPTY, DONE, POPPED };
+    // claim a slot for a new element, unless the queue is full
+    bool reserve_();
+    // store an element in a slot claimed by reserve_()
+    template <typename T>
+    void push_(T&& element);
+    // pop an element without blocking, if there is one
+    bool pop_(ElementT& element);
+    // release the slot of an element taken from mStorage
+    void popped_();
+    // push, waiting for room until the passed time_point
+    template <typename Clock, typename Duration, typename T>
+    bool pushUntil_(const std::chrono::time_point<Clock, Duration>* until,
+                    T&& element);
+    // pop, waiting for an element until the passed time_point
+    template <typename Clock, typename Duration>
+    pop_result popUntil_(const std::chrono::time_point<Clock, Duration>* until,
+                         ElementT& element);
+};
+
+/*****************************************************************************
+*   LLConcurrentThreadSafeQueue implementation
+*****************************************************************************/
+template<typename ElementT>
+LLConcurrentThreadSafeQueue<ElementT>::LLConcurrentThreadSafeQueue(size_t capacity) :
+    mCapacity(capacity),
+    mSize(0),
+    mClosed(false),
+    mPushWaiters(0),
+    mPopWaiters(0)
+{
+}
+
+
+template<typename ElementT>
+bool LLConcurrentThreadSafeQueue<ElementT>::reserve_()
+{
+    size_t size = mSize.load(std::memory_order_relaxed);
+    do
+    {
+        if (size >= mCapacity)
+        {
+            return false;
+        }
+    } while (! mSize.compare_exchange_weak(size, size + 1));
+    return true;
+}
+
+
+template<typename ElementT>
+template<typename T>
+void LLConcurrentThreadSafeQueue<ElementT>::push_(T&& element)
+{
+    if (! mStorage.enqueue(std::forward<T>(element)))
+    {
+        // only happens if moodycamel can't allocate a new block
+        popped_();
+        LLTHROW(LLThreadSafeQueueError("concurrent queue allocation failed"));
+    }
+    // Pairs with the fence in popUntil_(): either that consumer sees our
+    // element, or we see it waiting.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mPopWaiters.load())
+    {
+        lock_t lock(mLock);
+        mEmptyCond.notify_one();
+    }
+}
+
+
+template<typename ElementT>
+bool LLConcurrentThreadSafeQueue<ElementT>::pop_(ElementT& element)
+{
+    if (! mStorage.try_dequeue(element))
+        return false;
+    popped_();
+    return true;
+}
+
+
+template<typename ElementT>
+void LLConcurrentThreadSafeQueue<ElementT>::popped_()
+{
+    size_t left = mSize.fetch_sub(1) - 1;
+    if (mPushWaiters.load())
+    {
+        lock_t lock(mLock);
+        mCapacityCond.notify_one();
+    }
+    // A consumer that found the queue closed but not yet drained is waiting
+    // for the last element: if somebody else got it, tell them we're DONE.
+    if (left == 0 && mClosed.load() && mPopWaiters.load())
+    {
+        lock_t lock(mLock);
+        mEmptyCond.notify_all();
+    }
+}
+
+
+template<typename ElementT>
+template<typename Clock, typename Duration, typename T>
+bool LLConcurrentThreadSafeQueue<ElementT>::pushUntil_(
+    const std::chrono::time_point<Clock, Duration>* until,
+    T&& element)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    while (true)
+    {
+        // On the producer side, it doesn't matter whether the queue has been
+        // drained or not: the moment either end calls close(), further push()
+        // operations will fail.
+        if (mClosed)
+            return false;
+
+        if (reserve_())
+        {
+            push_(std::forward<T>(element));
+            return true;
+        }
+
+        // Storage Full. Wait for signal, rechecking under the lock so a pop
+        // or close() in between can't be missed.
+        lock_t lock(mLock);
+        ++mPushWaiters;
+        bool timedout = false;
+        if (! mClosed && mSize.load() >= mCapacity)
+        {
+            if (! until)
+            {
+                mCapacityCond.wait(lock);
+            }
+            else
+            {
+                timedout = (LLCoros::cv_status::timeout == mCapacityCond.wait_until(lock, *until));
+            }
+        }
+        --mPushWaiters;
+        if (timedout)
+            return false;
+    }
+}
+
+
+template<typename ElementT>
+template<typename Clock, typename Duration>
+typename LLConcurrentThreadSafeQueue<ElementT>::pop_result
+LLConcurrentThreadSafeQueue<ElementT>::popUntil_(
+    const std::chrono::time_point<Clock, Duration>* until,
+    ElementT& element)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    while (true)
+    {
+        // On the consumer side, we always try to pop before checking mClosed
+        // so we can finish draining the queue.
+        if (pop_(element))
+            return POPPED;
+
+        lock_t lock(mLock);
+        ++mPopWaiters;
+        // Pairs with the fence in push_().
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool popped = mStorage.try_dequeue(element);
+        bool timedout = false;
+        if (! popped)
+        {
+            // Once the queue is closed and every claimed slot has been
+            // released, there will never be any more coming. Otherwise some
+            // producer may still be completing a push: wait for it.
+            if (mClosed && mSize.load() == 0)
+            {
+                --mPopWaiters;
+                return DONE;
+            }
+            if (! until)
+            {
+                mEmptyCond.wait(lock);
+            }
+            else
+            {
+                timedout = (LLCoros::cv_status::timeout == mEmptyCond.wait_until(lock, *until));
+            }
+        }
+        --mPopWaiters;
+        lock.unlock();
+        if (popped)
+        {
+            popped_();
+            return POPPED;
+        }
+        if (timedout)
+            return EMPTY;
+    }
+}
+
+
+template<typename ElementT>
+template<typename T>
+bool LLConcurrentThreadSafeQueue<ElementT>::pushIfOpen(T&& element)
+{
+    return pushUntil_<std::chrono::steady_clock, std::chrono::steady_clock::duration>(
+        nullptr, std::forward<T>(element));
+}
+
+
+template<typename ElementT>
+template<typename T>
+void LLConcurrentThreadSafeQueue<ElementT>::push(T&& element)
+{
+    if (! pushIfOpen(std::forward<T>(element)))
+    {
+        LLTHROW(LLThreadSafeQueueInterrupt());
+    }
+}
+
+
+template<typename ElementT>
+template<typename T>
+bool LLConcurrentThreadSafeQueue<ElementT>::tryPush(T&& element)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    if (mClosed)
+        return false;
+    if (! reserve_())
+    {
+        // a blocking push just waits, but this element is dropped
+        LL_WARNS_ONCE("ThreadPool") << "Concurrent queue full, tryPush() failed, capacity " << mCapacity << LL_ENDL;
+        return false;
+    }
+    push_(std::forward<T>(element));
+    return true;
+}
+
+
+template<typename ElementT>
+template<typename Rep, typename Period, typename T>
+bool LLConcurrentThreadSafeQueue<ElementT>::tryPushFor(
+    const std::chrono::duration<Rep, Period>& timeout,
+    T&& element)
+{
+    // Convert duration to time_point: passing the same timeout duration to
+    // each of multiple calls is wrong.
+    return tryPushUntil(std::chrono::steady_clock::now() + timeout,
+                        std::forward<T>(element));
+}
+
+
+template<typename ElementT>
+template<typename Clock, typename Duration, typename T>
+bool LLConcurrentThreadSafeQueue<ElementT>::tryPushUntil(
+    const std::chrono::time_point<Clock, Duration>& until,
+    T&& element)
+{
+    return pushUntil_(&until, std::forward<T>(element));
+}
+
+
+template<typename ElementT>
+ElementT LLConcurrentThreadSafeQueue<ElementT>::pop(void)
+{
+    ElementT value;
+    if (popUntil_<std::chrono::steady_clock, std::chrono::steady_clock::duration>(
+            nullptr, value) != POPPED)
+    {
+        LLTHROW(LLThreadSafeQueueInterrupt());
+    }
+    return value;
+}
+
+
+template<typename ElementT>
+bool LLConcurrentThreadSafeQueue<ElementT>::tryPop(ElementT & element)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    // tryPop() behavior when the queue is closed is implemented by simple
+    // inability to push any new elements
+    return pop_(element);
+}
+
+
+template<typename ElementT>
+template<typename Rep, typename Period>
+bool LLConcurrentThreadSafeQueue<ElementT>::tryPopFor(
+    const std::chrono::duration<Rep, Period>& timeout,
+    ElementT& element)
+{
+    // Convert duration to time_point: passing the same timeout duration to
+    // each of multiple calls is wrong.
+    return tryPopUntil(std::chrono::steady_clock::now() + timeout, element);
+}
+
+
+template<typename ElementT>
+template<typename Clock, typename Duration>
+bool LLConcurrentThreadSafeQueue<ElementT>::tryPopUntil(
+    const std::chrono::time_point<Clock, Duration>& until,
+    ElementT& element)
+{
+    // conflate EMPTY, DONE
+    return popUntil_(&until, element) == POPPED;
+}
+
+
+template<typename ElementT>
+void LLConcurrentThreadSafeQueue<ElementT>::close()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    mClosed = true;
+    lock_t lock(mLock);
+    // wake up any blocked pop() calls
+    mEmptyCond.notify_all();
+    // wake up any blocked push() calls
+    mCapacityCond.notify_all();
+}
+
+#endif /* LL_LLCONCURRENTTHREADSAFEQUEUE_H */
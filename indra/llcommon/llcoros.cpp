@@ -33,6 +33,11 @@
 // associated header
 #include "llcoros.h"
 // STL headers
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
 // std headers
 #include <atomic>
 #include <stdexcept>
@@ -56,11 +61,295 @@
 #include "llerror.h"
 #include "stringize.h"
 #include "llexception.h"
+#include "llsd.h"
+#include "llsdutil.h"
 
 #if LL_WINDOWS
 #include <excpt.h>
+#include "llwin32headers.h"
+#else
+#include <sys/mman.h>
 #endif
 
+namespace
+{
+
+/*****************************************************************************
+*   Coroutine stack pool
+*****************************************************************************/
+// Every launch() used to mmap a fresh guard-paged stack and munmap it again
+// when the coroutine ended. StackPool keeps the stacks of terminated
+// coroutines for reuse instead, and measures how deep each coroutine got
+// before its stack is reused (on Windows, only a sample of them).
+class StackPool
+{
+public:
+    typedef boost::context::stack_context stack_context;
+    typedef boost::context::protected_fixedsize_stack allocator_t;
+
+    struct Usage
+    {
+        U64 mCount = 0;
+        U64 mTotal = 0;
+        size_t mMax = 0;
+        U64 mLaunches = 0;
+    };
+
+    // Deliberately leaked: coroutines may still end during static
+    // destruction.
+    static StackPool& instance()
+    {
+        static StackPool* sPool = new StackPool;
+        return *sPool;
+    }
+
+    stack_context allocate(size_t size, Usage* usage)
+    {
+        stack_context sctx;
+        bool reused = false;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto found = mFree.find(size);
+            if (found != mFree.end() && !found->second.empty())
+            {
+                sctx = found->second.back();
+                found->second.pop_back();
+                --mFreeCount;
+                reused = true;
+            }
+        }
+        if (!reused)
+        {
+            sctx = newStack(size);
+        }
+        prepareStack(sctx, usage);
+        return sctx;
+    }
+
+    void deallocate(stack_context& sctx, size_t size, Usage* usage)
+    {
+        size_t used = measureStack(sctx);
+        std::unique_lock<std::mutex> lock(mMutex);
+        if (usage && used) // 0 if not measured
+        {
+            ++usage->mCount;
+            usage->mTotal += used;
+            usage->mMax = std::max(usage->mMax, used);
+        }
+        if (mFreeCount >= mMaxFree)
+        {
+            lock.unlock();
+            deleteStack(sctx, size);
+            return;
+        }
+        lock.unlock();
+        // outside the lock: this hands back the pages that were used
+        resetStack(sctx, used);
+        lock.lock();
+        mFree[size].push_back(sctx);
+        ++mFreeCount;
+    }
+
+    // Stable: Usage entries are never erased.
+    Usage* usage(const std::string& prefix)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return &mUsage[prefix];
+    }
+
+    void setMaxFree(size_t stacks)
+    {
+        std::vector<stack_context> released;
+        std::vector<size_t> sizes;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mMaxFree = stacks;
+            for (auto& free : mFree)
+            {
+                while (mFreeCount > mMaxFree && !free.second.empty())
+                {
+                    released.push_back(free.second.back());
+                    sizes.push_back(free.first);
+                    free.second.pop_back();
+                    --mFreeCount;
+                }
+            }
+        }
+        for (size_t i = 0; i < released.size(); ++i)
+        {
+            deleteStack(released[i], sizes[i]);
+        }
+    }
+
+    std::map<std::string, Usage> getUsage()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mUsage;
+    }
+
+private:
+    static size_t pageSize() { return boost::context::stack_traits::page_size(); }
+    // stack memory proper, without the guard page at the bottom
+    static size_t usable(const stack_context& sctx) { return sctx.size - pageSize(); }
+    static char* bottom(const stack_context& sctx) { return static_cast<char*>(sctx.sp) - usable(sctx); }
+
+#if LL_WINDOWS
+    // protected_fixedsize_stack commits the whole stack up front, so which
+    // pages a coroutine used can't be told from the pages that are committed.
+    // Instead the first stack of each prefix, and 1 in SAMPLE_INTERVAL after
+    // that, is painted before its coroutine starts and scanned for the
+    // deepest byte it overwrote when it ends. Painting touches every page of
+    // the stack, so the rest are neither painted nor measured.
+    static constexpr U64 SAMPLE_INTERVAL = 16;
+    static constexpr unsigned char PAINT = 0xA5;
+
+    static stack_context newStack(size_t size)
+    {
+        return allocator_t(size).allocate();
+    }
+
+    static void deleteStack(stack_context& sctx, size_t size)
+    {
+        allocator_t(size).deallocate(sctx);
+    }
+
+    void prepareStack(const stack_context& sctx, Usage* usage)
+    {
+        if (!usage)
+        {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (usage->mLaunches++ % SAMPLE_INTERVAL)
+            {
+                return;
+            }
+            mPainted.insert(sctx.sp);
+        }
+        memset(bottom(sctx), PAINT, usable(sctx));
+    }
+
+    // 0 for a stack that wasn't painted
+    size_t measureStack(const stack_context& sctx)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (!mPainted.erase(sctx.sp))
+            {
+                return 0;
+            }
+        }
+        const unsigned char* low = reinterpret_cast<const unsigned char*>(bottom(sctx));
+        size_t untouched = 0;
+        while (untouched < usable(sctx) && low[untouched] == PAINT)
+        {
+            ++untouched;
+        }
+        return (usable(sctx) - untouched + pageSize() - 1) / pageSize() * pageSize();
+    }
+
+    // Let Windows drop the pages painting brought in; the contents of a
+    // stack don't need to survive until it is reused.
+    static void resetStack(const stack_context& sctx, size_t used)
+    {
+        if (used)
+        {
+            ::VirtualAlloc(bottom(sctx), usable(sctx), MEM_RESET, PAGE_READWRITE);
+        }
+    }
+#else  // ! LL_WINDOWS
+    // Stack pages are only backed by memory once touched: count the
+    // resident ones below the top of the stack.
+    static size_t measureStack(const stack_context& sctx)
+    {
+        size_t pages = usable(sctx) / pageSize();
+#if LL_DARWIN
+        std::vector<char> resident(pages);
+#else
+        std::vector<unsigned char> resident(pages);
+#endif
+        if (::mincore(bottom(sctx), usable(sctx), resident.data()) != 0)
+        {
+            return 0;
+        }
+        size_t page = 0;
+        while (page < pages && !(resident[page] & 1))
+        {
+            ++page;
+        }
+        return (pages - page) * pageSize();
+    }
+
+    static stack_context newStack(size_t size)
+    {
+        stack_context sctx = allocator_t(size).allocate();
+        resetStack(sctx, usable(sctx));
+        return sctx;
+    }
+
+    // every stack is measured, see measureStack()
+    static void prepareStack(const stack_context&, Usage*)
+    {
+    }
+
+    static void deleteStack(stack_context& sctx, size_t size)
+    {
+        allocator_t(size).deallocate(sctx);
+    }
+
+    // Hand back every page but the top one, so the next coroutine to get
+    // this stack is measured on its own.
+    static void resetStack(const stack_context& sctx, size_t used)
+    {
+        if (used > pageSize())
+        {
+            ::madvise(bottom(sctx), usable(sctx) - pageSize(), MADV_DONTNEED);
+        }
+    }
+#endif // ! LL_WINDOWS
+
+    std::mutex mMutex;
+    // free stacks by requested size
+    std::map<size_t, std::vector<stack_context>> mFree;
+    size_t mFreeCount = 0;
+    size_t mMaxFree = 32;
+    // by launch() prefix
+    std::map<std::string, Usage> mUsage;
+#if LL_WINDOWS
+    // tops of the stacks painted for measuring
+    std::unordered_set<void*> mPainted;
+#endif
+};
+
+// The StackAllocator passed to each fiber. Boost.Fibers keeps this copy
+// with the fiber and deallocates the stack through it, so it can credit
+// the stack use to the coroutine's prefix.
+class PooledStackAllocator
+{
+public:
+    PooledStackAllocator(size_t size, StackPool::Usage* usage):
+        mSize(size),
+        mUsage(usage)
+    {}
+
+    boost::context::stack_context allocate()
+    {
+        return StackPool::instance().allocate(mSize, mUsage);
+    }
+
+    void deallocate(boost::context::stack_context& sctx)
+    {
+        StackPool::instance().deallocate(sctx, mSize, mUsage);
+    }
+
+private:
+    size_t mSize;
+    StackPool::Usage* mUsage;
+};
+
+} // anonymous namespace
+
 // static
 bool LLCoros::on_main_coro()
 {
@@ -176,6 +465,7 @@ void LLCoros::cleanupSingleton()
         boost::this_fiber::yield();
     }
     printActiveCoroutines("after pumping");
+    printStackUsage();
 }
 
 std::string LLCoros::generateDistinctName(const std::string& prefix) const
@@ -250,6 +540,51 @@ void LLCoros::setStackSize(S32 stacksize)
     mStackSize = stacksize;
 }
 
+void LLCoros::setStackPoolSize(size_t stacks)
+{
+    LL_DEBUGS("LLCoros") << "Keeping up to " << stacks << " coroutine stacks" << LL_ENDL;
+    StackPool::instance().setMaxFree(stacks);
+}
+
+LLSD LLCoros::getStackUsage() const
+{
+    LLSD result(LLSD::emptyMap());
+    for (const auto& [prefix, usage] : StackPool::instance().getUsage())
+    {
+        if (usage.mCount)
+        {
+            result[prefix] = llsd::map("count", LLSD::Integer(usage.mCount),
+                                       "max", LLSD::Integer(usage.mMax),
+                                       "mean", LLSD::Integer(usage.mTotal / usage.mCount));
+        }
+    }
+    return result;
+}
+
+void LLCoros::printStackUsage()
+{
+    std::vector<std::pair<std::string, LLSD>> usage;
+    LLSD all = getStackUsage();
+    for (const auto& entry : llsd::inMap(all))
+    {
+        usage.emplace_back(entry.first, entry.second);
+    }
+    if (usage.empty())
+    {
+        return;
+    }
+    std::sort(usage.begin(), usage.end(),
+              [](const auto& a, const auto& b) { return a.second["max"].asInteger() > b.second["max"].asInteger(); });
+    LL_INFOS("LLCoros") << "Coroutine stack use (stack size " << mStackSize << "), deepest first:";
+    for (const auto& entry : usage)
+    {
+        LL_CONT << LL_NEWLINE << entry.first << ": max " << entry.second["max"].asInteger()
+                << " mean " << entry.second["mean"].asInteger()
+                << " over " << entry.second["count"].asInteger() << " coroutines";
+    }
+    LL_CONT << LL_ENDL;
+}
+
 void LLCoros::printActiveCoroutines(const std::string& when)
 {
     LL_INFOS("LLCoros") << "Number of active coroutines " << when
@@ -279,12 +614,13 @@ std::string LLCoros::launch(const std::string& prefix, const callable_t& callabl
     // protected_fixedsize_stack sets a guard page past the end of the new
     // stack so that stack underflow will result in an access violation
     // instead of weird, subtle, possibly undiagnosed memory stomps.
+    // PooledStackAllocator recycles such stacks.
 
     try
     {
         boost::fibers::fiber newCoro(boost::fibers::launch::dispatch,
             std::allocator_arg,
-            boost::fibers::protected_fixedsize_stack(mStackSize),
+            PooledStackAllocator(mStackSize, StackPool::instance().usage(prefix)),
             [this, &name, &callable]() { toplevel(name, callable); });
 
         // You have two choices with a fiber instance: you can join() it or you
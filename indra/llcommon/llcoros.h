@@ -54,6 +54,8 @@ namespace boost {
     }
 }
 
+class LLSD;
+
 /**
  * Registry of named Boost.Coroutine instances
  *
@@ -197,6 +199,24 @@ public:
      */
     void setStackSize(S32 stacksize);
 
+    /**
+     * Coroutine stacks are recycled: when a coroutine terminates, its stack
+     * (guard page and all) is kept for a later launch() with the same stack
+     * size, up to this many stacks in all. 0 disables the pool.
+     */
+    void setStackPoolSize(size_t stacks);
+
+    /**
+     * Deepest stack use seen so far by the coroutines launched with each
+     * prefix, to tune setStackSize() from real data. Returns a map keyed by
+     * prefix of {"count", "max", "mean"} maps; sizes are in bytes, rounded
+     * up to whole pages. On Windows only the first stack of each prefix and
+     * 1 in 16 after that are measured, so "count" is that many.
+     */
+    LLSD getStackUsage() const;
+    /// log getStackUsage(), deepest first
+    void printStackUsage();
+
     /// diagnostic
     void printActiveCoroutines(const std::string& when=std::string());
 
@@ -29,6 +29,12 @@
 #include "llcrc.h"
 #include "llerror.h"
 
+#ifdef LL_USESYSTEMLIBS
+# include <zlib.h>
+#else
+# include "zlib-ng/zlib.h"
+#endif
+
 /* Copyright (C) 1986 Gary S. Brown.  You may use this program, or
    code or tables extracted from it, as desired without restriction.*/
 
@@ -152,9 +158,13 @@ void LLCRC::update(U8 next_byte)
 
 void LLCRC::update(const U8* buffer, size_t buffer_size)
 {
-    for (size_t i = 0; i < buffer_size; i++)
+    // Same polynomial as crc_32_tab. zlib-ng picks a PCLMULQDQ or
+    // VPCLMULQDQ kernel at runtime when the CPU has one. zlib works on the
+    // finished CRC rather than on the shift register, hence the inversions,
+    // and restarts from scratch when handed a null buffer.
+    if (buffer && buffer_size)
     {
-        mCurrent = UPDC32(buffer[i], mCurrent);
+        mCurrent = ~(U32)crc32_z(~mCurrent, buffer, buffer_size);
     }
 }
 
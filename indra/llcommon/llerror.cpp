@@ -31,10 +31,13 @@
 #include "llerrorcontrol.h"
 #include "llsdutil.h"
 
+#include <array>
+#include <atomic>
 #include <cctype>
 #ifdef __GNUC__
 # include <cxxabi.h>
 #endif // __GNUC__
+#include <mutex>
 #include <sstream>
 #if !LL_WINDOWS
 # include <syslog.h>
@@ -43,6 +46,7 @@
 #else
 # include <io.h>
 #endif // !LL_WINDOWS
+#include <thread>
 #include <vector>
 #include "string.h"
 
@@ -56,6 +60,7 @@
 #include "llstl.h"
 #include "lltimer.h"
 #include "llprofiler.h"
+#include "blockingconcurrentqueue.h"
 
 // On Mac, got:
 // #error "Boost.Stacktrace requires `_Unwind_Backtrace` function. Define
@@ -944,6 +949,10 @@ namespace LLError
         {
             setEnabledLogTypesMask(config["enabled-log-types-mask"].asInteger());
         }
+        if (config.has("async-logging"))
+        {
+            setAsyncLogging(config["async-logging"]);
+        }
 
         if (config.has("settings") && config["settings"].isArray())
         {
@@ -1224,7 +1233,10 @@ namespace
         return out.str();
     }
 
-    void writeToRecorders(const LLError::CallSite& site, const std::string& message)
+    // Pass time to use a time string captured when the message was logged
+    // rather than asking mTimeFunction now.
+    void writeToRecorders(const LLError::CallSite& site, const std::string& message,
+                          const std::string* time = nullptr)
     {
         LL_PROFILE_ZONE_SCOPED_CATEGORY_LOGGING;
         LLError::ELevel level = site.mLevel;
@@ -1244,9 +1256,16 @@ namespace
 
             std::ostringstream message_stream;
 
-            if (r->wantsTime() && s->mTimeFunction != NULL)
+            if (r->wantsTime())
             {
-                message_stream << s->mTimeFunction();
+                if (time)
+                {
+                    message_stream << *time;
+                }
+                else if (s->mTimeFunction != NULL)
+                {
+                    message_stream << s->mTimeFunction();
+                }
             }
             message_stream << " ";
 
@@ -1290,6 +1309,162 @@ namespace
             r->recordMessage(level, message_stream.str());
         }
     }
+
+    // Background writer for setAsyncLogging(true). Logging threads push
+    // messages onto a lock-free queue and return; the writer thread hands
+    // them to the recorders in order.
+    class AsyncLogWriter
+    {
+    public:
+        AsyncLogWriter(size_t capacity):
+            mCapacity(capacity),
+            mThread([this]() { run(); })
+        {
+        }
+
+        // stops the writer thread, then writes whatever it left queued
+        ~AsyncLogWriter()
+        {
+            mStopping = true;
+            mThread.join();
+            flush();
+        }
+
+        // Queue message for the writer thread, moving from it only on
+        // success. On a full queue, returns false and counts the message as
+        // dropped or overflowed, depending on the caller's fallback.
+        bool post(const LLError::CallSite& site, std::string&& time, std::string& message)
+        {
+            size_t pending = mPending.load(std::memory_order_relaxed);
+            do
+            {
+                if (pending >= mCapacity)
+                {
+                    if (site.mLevel < LLError::LEVEL_WARN)
+                    {
+                        mDropped[site.mLevel].fetch_add(1, std::memory_order_relaxed);
+                    }
+                    else
+                    {
+                        mOverflowed.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    return false;
+                }
+            } while (!mPending.compare_exchange_weak(pending, pending + 1, std::memory_order_relaxed));
+
+            mQueue.enqueue(Entry{ &site, std::move(time), std::move(message) });
+            mQueued.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Write everything queued so far on the calling thread. The writer
+        // thread holds mDrainMutex from taking an entry until it has written
+        // it, so once we hold it no earlier message is still in flight. On a
+        // crash path that thread may never let go: drain anyway after a while.
+        void flush()
+        {
+            mFlushWaiting.fetch_add(1);
+            std::unique_lock lock(mDrainMutex, std::defer_lock);
+            (void)lock.try_lock_for(std::chrono::milliseconds(500));
+            mFlushWaiting.fetch_sub(1);
+            Entry entry;
+            while (mQueue.try_dequeue(entry))
+            {
+                write(entry);
+            }
+        }
+
+        size_t capacity() const { return mCapacity; }
+
+        LLError::AsyncLoggingStats getStats() const
+        {
+            LLError::AsyncLoggingStats stats;
+            stats.mQueued = mQueued;
+            stats.mWritten = mWritten;
+            for (size_t level = 0; level < mDropped.size(); ++level)
+            {
+                stats.mDropped[level] = mDropped[level];
+            }
+            stats.mOverflowed = mOverflowed;
+            return stats;
+        }
+
+    private:
+        struct Entry
+        {
+            // call sites are function-static, so they outlive the entry
+            const LLError::CallSite* mSite = nullptr;
+            std::string mTime;
+            std::string mMessage;
+        };
+
+        void run()
+        {
+            LL_PROFILER_SET_THREAD_NAME("LogWriter");
+            Entry entry;
+            while (!mStopping)
+            {
+                // Hold mDrainMutex from dequeue to write, so flush() can't
+                // write a later message ahead of the one taken here. Wake up
+                // now and then to notice mStopping and report drops.
+                while (mFlushWaiting.load())
+                {
+                    // let flush() in rather than racing it for the mutex
+                    std::this_thread::yield();
+                }
+                std::unique_lock lock(mDrainMutex);
+                if (mQueue.wait_dequeue_timed(entry, 100000))
+                {
+                    write(entry);
+                }
+                reportDropped();
+            }
+        }
+
+        void write(const Entry& entry)
+        {
+            writeToRecorders(*entry.mSite, entry.mMessage, entry.mTime.empty() ? nullptr : &entry.mTime);
+            mWritten.fetch_add(1, std::memory_order_relaxed);
+            mPending.fetch_sub(1, std::memory_order_release);
+        }
+
+        // Called only by the writer thread: leave a note in the log when
+        // messages were dropped since the last note.
+        void reportDropped()
+        {
+            U64 debug = mDropped[LLError::LEVEL_DEBUG], info = mDropped[LLError::LEVEL_INFO];
+            if (debug + info == mReported)
+            {
+                return;
+            }
+            static const char* tags[] = { "LLError" };
+            static LLError::CallSite site(LLError::LEVEL_WARN, __FILE__, __LINE__,
+                                          typeid(LLError::NoClassInfo), __FUNCTION__, false,
+                                          tags, std::size(tags));
+            std::ostringstream out;
+            out << "Log queue full: " << (debug + info - mReported) << " messages dropped ("
+                << debug << " debug, " << info << " info dropped in total)";
+            mReported = debug + info;
+            writeToRecorders(site, out.str());
+        }
+
+        moodycamel::BlockingConcurrentQueue<Entry> mQueue;
+        // held by whichever thread is taking entries off mQueue and writing them
+        std::timed_mutex mDrainMutex;
+        std::atomic<int> mFlushWaiting{ 0 };
+        const size_t mCapacity;
+        // queued and not yet written
+        std::atomic<size_t> mPending{ 0 };
+        std::atomic<bool> mStopping{ false };
+        std::atomic<U64> mQueued{ 0 }, mWritten{ 0 }, mOverflowed{ 0 };
+        std::array<std::atomic<U64>, LLError::LEVEL_WARN> mDropped{};
+        U64 mReported = 0;
+        // last, so the thread starts once everything else is constructed
+        std::thread mThread;
+    };
+
+    // Guarded by getLogMutex(), which Log::flush() holds while posting.
+    AsyncLogWriter* sAsyncLogWriter = nullptr;
 }
 
 namespace {
@@ -1445,6 +1620,21 @@ namespace LLError
             message = message_stream.str();
         }
 
+        if (sAsyncLogWriter)
+        {
+            if (site.mLevel == LEVEL_ERROR)
+            {
+                // everything logged before the error goes out before it
+                sAsyncLogWriter->flush();
+            }
+            else if (sAsyncLogWriter->post(site, s->mTimeFunction ? s->mTimeFunction() : std::string(), message)
+                     || site.mLevel < LEVEL_WARN)
+            {
+                // queued, or dropped on a full queue
+                return;
+            }
+        }
+
         writeToRecorders(site, message);
 
         if (site.mLevel == LEVEL_ERROR)
@@ -1458,6 +1648,57 @@ namespace LLError
     }
 }
 
+namespace LLError
+{
+    void setAsyncLogging(bool async, size_t capacity)
+    {
+        std::unique_lock lock(*getLogMutex());
+        if (async == (sAsyncLogWriter != nullptr) && (!async || sAsyncLogWriter->capacity() == capacity))
+        {
+            // e.g. configure() rereading an unchanged log control file
+            return;
+        }
+        // Stop the old writer while holding the lock, so its queued messages
+        // are written before any logged from here on.
+        delete sAsyncLogWriter;
+        sAsyncLogWriter = nullptr;
+        if (async)
+        {
+            static bool registered = false;
+            if (!registered)
+            {
+                // stop the writer thread before static destruction
+                registered = true;
+                std::atexit([]() { setAsyncLogging(false); });
+            }
+            sAsyncLogWriter = new AsyncLogWriter(capacity);
+        }
+    }
+
+    bool getAsyncLogging()
+    {
+        std::unique_lock lock(*getLogMutex());
+        return sAsyncLogWriter != nullptr;
+    }
+
+    void flushAsyncLogging()
+    {
+        // On a crash path another thread may be stuck holding the log mutex:
+        // flush anyway rather than hang the crash handler.
+        std::unique_lock lock(*getLogMutex(), std::try_to_lock);
+        if (sAsyncLogWriter)
+        {
+            sAsyncLogWriter->flush();
+        }
+    }
+
+    AsyncLoggingStats getAsyncLoggingStats()
+    {
+        std::unique_lock lock(*getLogMutex());
+        return sAsyncLogWriter ? sAsyncLogWriter->getStats() : AsyncLoggingStats();
+    }
+}
+
 namespace LLError
 {
     SettingsStoragePtr saveAndResetSettings()
@@ -136,6 +136,29 @@ namespace LLError
         // The function is use to return the current time, formatted for
         // display by those error recorders that want the time included.
 
+    LL_COMMON_API void setAsyncLogging(bool async, size_t capacity = 8192);
+        // When async, messages below LEVEL_ERROR are queued and handed to the
+        // recorders by a background thread, so the logging thread doesn't
+        // wait on file or console output. At most capacity messages are
+        // queued: past that, DEBUG and INFO messages are dropped and WARN
+        // messages are written synchronously. LEVEL_ERROR messages flush the
+        // queue and are always written synchronously.
+        // Turning async logging off writes whatever is still queued.
+    LL_COMMON_API bool getAsyncLogging();
+    LL_COMMON_API void flushAsyncLogging();
+        // Write everything queued so far before returning. Safe to call from
+        // crash handlers: it doesn't wait long on a stuck writer thread.
+
+    struct AsyncLoggingStats
+    {
+        U64 mQueued = 0;                // messages handed to the writer thread
+        U64 mWritten = 0;               // of those, messages written so far
+        U64 mDropped[LEVEL_WARN] = {};  // DEBUG and INFO messages dropped on a full queue
+        U64 mOverflowed = 0;            // messages written synchronously on a full queue
+    };
+    LL_COMMON_API AsyncLoggingStats getAsyncLoggingStats();
+        // Counters since async logging was last turned on
+
 
 
     class LL_COMMON_API Recorder
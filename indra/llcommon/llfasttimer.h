@@ -28,6 +28,7 @@
 #define LL_FASTTIMER_H
 
 #include "llinstancetracker.h"
+#include "llflightrecorder.h"
 #include "lltrace.h"
 #include "lltreeiterators.h"
 
@@ -313,16 +314,26 @@ LL_FORCE_INLINE BlockTimer::BlockTimer(BlockTimerStatHandle& timer)
     cur_timer_data->mChildTime = 0;
 
     mStartTime = getCPUClockCount64();
+    if (FlightRecorder::sEnabled.load(std::memory_order_relaxed))
+    {
+        FlightRecorder::record(&timer, mStartTime, true);
+    }
 #endif
 }
 
 LL_FORCE_INLINE BlockTimer::~BlockTimer()
 {
 #if LL_FAST_TIMER_ON
-    U64 total_time = getCPUClockCount64() - mStartTime;
+    U64 end_time = getCPUClockCount64();
+    U64 total_time = end_time - mStartTime;
     BlockTimerStackRecord* cur_timer_data = LLThreadLocalSingletonPointer<BlockTimerStackRecord>::getInstance();
     if (!cur_timer_data) return;
 
+    if (FlightRecorder::sEnabled.load(std::memory_order_relaxed))
+    {
+        FlightRecorder::record(cur_timer_data->mTimeBlock, end_time, false);
+    }
+
     TimeBlockAccumulator& accumulator = cur_timer_data->mTimeBlock->getCurrentAccumulator();
 
     accumulator.mCalls++;
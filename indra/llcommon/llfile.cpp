@@ -32,13 +32,19 @@
 #include "llstring.h"
 #include "llerror.h"
 #include "stringize.h"
+#include <atomic> // <FS/>
 
 #if LL_WINDOWS
 #include "llwin32headerslean.h"
 #include <stdlib.h>                 // Windows errno
 #include <vector>
+#include <process.h>                // _getpid() <FS/>
 #else
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #endif
 
 using namespace std;
@@ -326,6 +332,65 @@ int LLFile::rename(const std::string& filename, const std::string& newname, int
     return warnif(STRINGIZE("rename to '" << newname << "' from"), filename, rc, supress_error);
 }
 
+// <FS>
+static int replace_file(const std::string& filename, const std::string& newname)
+{
+#if LL_WINDOWS
+    llutf16string utf16filename = utf8str_to_utf16str(filename);
+    llutf16string utf16newname = utf8str_to_utf16str(newname);
+    if (!MoveFileExW(utf16filename.c_str(), utf16newname.c_str(), MOVEFILE_REPLACE_EXISTING))
+    {
+        // warnif() reports errno
+        DWORD error = GetLastError();
+        errno = (error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND) ? ENOENT :
+                (error == ERROR_NOT_SAME_DEVICE) ? EXDEV : EACCES;
+        return -1;
+    }
+    return 0;
+#else
+    // rename() already replaces the target atomically
+    return ::rename(filename.c_str(), newname.c_str());
+#endif
+}
+
+int LLFile::replace(const std::string& filename, const std::string& newname, int supress_error)
+{
+    int rc = replace_file(filename, newname);
+    if (rc && errno == EXDEV)
+    {
+        // From another volume, such as a file made with getTempFilename():
+        // copy it next to newname first, so that replacing stays atomic
+        static std::atomic<U32> sCopies{ 0 };
+#if LL_WINDOWS
+        const int pid = _getpid();
+#else
+        const int pid = getpid();
+#endif
+        const std::string copyname = STRINGIZE(newname << '.' << pid << '.' << ++sCopies << ".tmp");
+        if (copy(filename, copyname))
+        {
+            rc = replace_file(copyname, newname);
+            if (rc == 0)
+            {
+                LLFile::remove(filename, ENOENT);
+            }
+            else
+            {
+                int error = errno;
+                LLFile::remove(copyname, ENOENT);
+                errno = error;
+            }
+        }
+        else
+        {
+            LLFile::remove(copyname, ENOENT);
+            errno = EXDEV;
+        }
+    }
+    return warnif(STRINGIZE("replace '" << newname << "' with"), filename, rc, supress_error);
+}
+// </FS>
+
 bool LLFile::copy(const std::string& from, const std::string& to)
 {
     bool copied = false;
@@ -425,6 +490,232 @@ const char *LLFile::tmpdir()
 
 /***************** Modified file stream created to overcome the incorrect behaviour of posix fopen in windows *******************/
 
+/************** LLMappedFile ********************************/
+
+bool LLMappedFile::open(const std::string& filename, bool writable, size_t min_size)
+{
+    close();
+    mWritable = writable;
+
+#if LL_WINDOWS
+    llutf16string utf16filename = utf8str_to_utf16str(filename);
+    HANDLE file = CreateFileW(utf16filename.c_str(),
+                              writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              NULL,
+                              writable ? OPEN_ALWAYS : OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    mFileHandle = file;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size))
+    {
+        close();
+        return false;
+    }
+    size_t size = (size_t)file_size.QuadPart;
+    if (writable && size < min_size)
+    {
+        size = min_size;
+    }
+    if (!size)
+    {
+        close();
+        return false;
+    }
+
+    // CreateFileMapping() grows the file to the requested size for us
+    LARGE_INTEGER map_size;
+    map_size.QuadPart = (LONGLONG)size;
+    HANDLE mapping = CreateFileMappingW(file, NULL, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                        map_size.HighPart, map_size.LowPart, NULL);
+    if (!mapping)
+    {
+        close();
+        return false;
+    }
+    mMappingHandle = mapping;
+
+    mData = (U8*)MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+    if (!mData)
+    {
+        close();
+        return false;
+    }
+    mSize = size;
+#else
+    mFileDescriptor = ::open(filename.c_str(), writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0600);
+    if (mFileDescriptor < 0)
+    {
+        return false;
+    }
+
+    llstat file_stat;
+    if (fstat(mFileDescriptor, &file_stat) != 0)
+    {
+        close();
+        return false;
+    }
+    size_t size = (size_t)file_stat.st_size;
+    if (writable && size < min_size)
+    {
+        if (ftruncate(mFileDescriptor, (off_t)min_size) != 0)
+        {
+            close();
+            return false;
+        }
+        size = min_size;
+    }
+    if (!size)
+    {
+        close();
+        return false;
+    }
+
+    void* data = ::mmap(NULL, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, mFileDescriptor, 0);
+    if (data == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+    mData = (U8*)data;
+    mSize = size;
+#endif
+    return true;
+}
+
+void LLMappedFile::close()
+{
+#if LL_WINDOWS
+    if (mData)
+    {
+        UnmapViewOfFile(mData);
+    }
+    if (mMappingHandle)
+    {
+        CloseHandle((HANDLE)mMappingHandle);
+        mMappingHandle = nullptr;
+    }
+    if (mFileHandle)
+    {
+        CloseHandle((HANDLE)mFileHandle);
+        mFileHandle = nullptr;
+    }
+#else
+    if (mData)
+    {
+        ::munmap(mData, mSize);
+    }
+    if (mFileDescriptor >= 0)
+    {
+        ::close(mFileDescriptor);
+        mFileDescriptor = -1;
+    }
+#endif
+    mData = nullptr;
+    mSize = 0;
+}
+
+bool LLMappedFile::flush()
+{
+    if (!mData || !mWritable)
+    {
+        return false;
+    }
+#if LL_WINDOWS
+    return FlushViewOfFile(mData, 0) != 0;
+#else
+    return ::msync(mData, mSize, MS_ASYNC) == 0;
+#endif
+}
+
+/************** LLFileLock ********************************/
+
+bool LLFileLock::lock(const std::string& filename, bool exclusive, bool try_only)
+{
+    unlock();
+
+#if LL_WINDOWS
+    llutf16string utf16filename = utf8str_to_utf16str(filename);
+    HANDLE file = CreateFileW(utf16filename.c_str(),
+                              GENERIC_READ | GENERIC_WRITE,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              NULL,
+                              OPEN_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL,
+                              NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    DWORD flags = 0;
+    if (exclusive)
+    {
+        flags |= LOCKFILE_EXCLUSIVE_LOCK;
+    }
+    if (try_only)
+    {
+        flags |= LOCKFILE_FAIL_IMMEDIATELY;
+    }
+    OVERLAPPED overlapped = {};
+    if (!LockFileEx(file, flags, 0, MAXDWORD, MAXDWORD, &overlapped))
+    {
+        CloseHandle(file);
+        return false;
+    }
+    mFileHandle = file;
+#else
+    int fd = ::open(filename.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    // flock() rather than fcntl() locks: those belong to the process, so
+    // they wouldn't keep two threads of the same viewer apart
+    int operation = (exclusive ? LOCK_EX : LOCK_SH) | (try_only ? LOCK_NB : 0);
+    int rc;
+    do
+    {
+        rc = ::flock(fd, operation);
+    }
+    while (rc != 0 && errno == EINTR);
+    if (rc != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    mFileDescriptor = fd;
+#endif
+    mLocked = true;
+    return true;
+}
+
+void LLFileLock::unlock()
+{
+    if (!mLocked)
+    {
+        return;
+    }
+#if LL_WINDOWS
+    OVERLAPPED overlapped = {};
+    UnlockFileEx((HANDLE)mFileHandle, 0, MAXDWORD, MAXDWORD, &overlapped);
+    CloseHandle((HANDLE)mFileHandle);
+    mFileHandle = nullptr;
+#else
+    ::flock(mFileDescriptor, LOCK_UN);
+    ::close(mFileDescriptor);
+    mFileDescriptor = -1;
+#endif
+    mLocked = false;
+}
+
 #if LL_WINDOWS
 
 LLFILE *    LLFile::_Fiopen(const std::string& filename,
@@ -77,6 +77,10 @@ public:
     static  int     rmdir(const std::string& filename);
     static  int     remove(const std::string& filename, int supress_error = 0);
     static  int     rename(const std::string& filename,const std::string& newname, int supress_error = 0);
+    // <FS> Like rename(), but atomically replaces newname if it exists, on
+    // Windows too. Other processes see either the old or the new file. A
+    // file on another volume is copied next to newname first.
+    static  int     replace(const std::string& filename, const std::string& newname, int supress_error = 0);
     static  bool    copy(const std::string& from, const std::string& to);
 
     static  int     stat(const std::string& filename,llstat*    file_status);
@@ -151,6 +155,87 @@ private:
     LLFILE* mFileHandle;
 };
 
+/**
+ * RAII memory mapping of a whole file.
+ *
+ * A read-only mapping is a cheap way to get at a large file without reading
+ * it into a buffer first. A writable mapping is shared with the file, so
+ * stores through data() end up on disk without explicit write calls; use
+ * flush() to force them out.
+ */
+class LL_COMMON_API LLMappedFile
+{
+public:
+    LLMappedFile() = default;
+    ~LLMappedFile() { close(); }
+
+    LLMappedFile(const LLMappedFile&) = delete;
+    LLMappedFile& operator=(const LLMappedFile&) = delete;
+
+    /**
+     * Map filename into memory. When writable is true the file is created
+     * if needed and grown to at least min_size bytes before mapping.
+     * Mapping an empty file fails, as there is nothing to map.
+     */
+    bool open(const std::string& filename, bool writable = false, size_t min_size = 0);
+    void close();
+
+    // Write dirty pages of a writable mapping back to the file
+    bool flush();
+
+    bool isOpen() const { return mData != nullptr; }
+    bool isWritable() const { return mWritable; }
+    U8* data() const { return mData; }
+    size_t size() const { return mSize; }
+
+private:
+    U8*     mData{ nullptr };
+    size_t  mSize{ 0 };
+    bool    mWritable{ false };
+#if LL_WINDOWS
+    void*   mFileHandle{ nullptr };
+    void*   mMappingHandle{ nullptr };
+#else
+    int     mFileDescriptor{ -1 };
+#endif
+};
+
+/**
+ * Advisory lock on a file, for processes that share files with each other
+ * (several viewers sharing one cache folder, for example).
+ *
+ * Every lock() opens the lock file anew, so two LLFileLock objects exclude
+ * each other even within one process, and locks are dropped by the OS if
+ * the process dies. Shared locks only exclude exclusive ones. The lock file
+ * is created if needed and never removed.
+ */
+class LL_COMMON_API LLFileLock
+{
+public:
+    LLFileLock() = default;
+    ~LLFileLock() { unlock(); }
+
+    LLFileLock(const LLFileLock&) = delete;
+    LLFileLock& operator=(const LLFileLock&) = delete;
+
+    /**
+     * Wait for the lock, or with try_only set, give up straight away if
+     * another holder is in the way.
+     */
+    bool lock(const std::string& filename, bool exclusive = true, bool try_only = false);
+    void unlock();
+
+    bool isLocked() const { return mLocked; }
+
+private:
+    bool    mLocked{ false };
+#if LL_WINDOWS
+    void*   mFileHandle{ nullptr };
+#else
+    int     mFileDescriptor{ -1 };
+#endif
+};
+
 #if LL_WINDOWS
 /**
  *  @brief  Controlling input for files.
@@ -0,0 +1,556 @@
+/**
+ * @file llflightrecorder.cpp
+ * @brief Always-on recorder of recent BlockTimer activity.
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llflightrecorder.h"
+
+#include "llfasttimer.h"
+#include "llfile.h"
+#include "llstring.h"
+#include "llthread.h"
+
+#include <algorithm>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace LLTrace
+{
+std::atomic<bool> FlightRecorder::sEnabled{ false };
+}
+
+namespace
+{
+    using LLTrace::BlockTimer;
+    using LLTrace::BlockTimerStatHandle;
+    using LLTrace::FlightRecorder;
+
+    struct Event
+    {
+        std::atomic<U64> mTime;
+        // the timer handle, with the low bit set for a begin event
+        std::atomic<uintptr_t> mTimer;
+    };
+
+    // One per recording thread. Only the owning thread writes mEvents and
+    // mHead; snapshots read them from the frame thread.
+    struct ThreadBuffer
+    {
+        ThreadBuffer(size_t capacity):
+            mEvents(new Event[capacity]),
+            mCapacity(capacity),
+            mMask(capacity - 1)
+        {
+        }
+
+        std::unique_ptr<Event[]> mEvents;
+        const size_t mCapacity;     // a power of 2
+        const size_t mMask;
+        // count of events ever claimed: see FlightRecorder::record()
+        std::atomic<U64> mHead{ 0 };
+
+        // guarded by Registry::mMutex
+        U64 mStart = 0;             // first event written by the current owner
+        U32 mThreadId = 0;
+        std::string mThreadName;
+        bool mInUse = false;
+    };
+
+    struct Snapshot
+    {
+        struct Thread
+        {
+            U32 mThreadId;
+            std::string mThreadName;
+            std::vector<std::pair<U64, uintptr_t>> mEvents;
+        };
+
+        std::string mReason;
+        U64 mBegin = 0;             // start of the window
+        U64 mEnd = 0;               // when the snapshot was taken
+        U64 mCountsPerSecond = 1;
+        std::vector<std::pair<U64, U64>> mFrames;
+        std::vector<Thread> mThreads;
+    };
+
+    struct Registry
+    {
+        std::mutex mMutex;
+        // buffers are recycled, never freed: see ThreadReleaser
+        std::vector<std::unique_ptr<ThreadBuffer>> mBuffers;
+        U32 mNextThreadId = 1;
+
+        // start and end of the last frames, oldest first
+        std::deque<std::pair<U64, U64>> mFrames;
+        U64 mFrameStart = 0;
+
+        U64 mThresholdCounts = 0;   // 0: no automatic dumps
+        U32 mWindowFrames = 8;
+        std::string mDumpDir;
+        U64 mCooldownCounts = 0;
+        U32 mMaxDumps = 0;
+        U32 mKeepDumps = 0;
+        U32 mDumps = 0;
+        bool mPaused = false;
+        U64 mLastDump = 0;
+
+        std::thread mWriter;
+        bool mWriting = false;
+    };
+
+    Registry& registry()
+    {
+        // Deliberately leaked: threads may still record during static
+        // destruction.
+        static Registry* sRegistry = new Registry;
+        return *sRegistry;
+    }
+
+    thread_local ThreadBuffer* tBuffer = nullptr;
+    // kept apart from the buffer so naming a thread doesn't allocate one
+    thread_local std::string tThreadName;
+
+    // Hands the calling thread's buffer back for reuse when the thread exits.
+    struct ThreadReleaser
+    {
+        ~ThreadReleaser()
+        {
+            if (tBuffer)
+            {
+                Registry& r = registry();
+                std::lock_guard<std::mutex> lock(r.mMutex);
+                tBuffer->mInUse = false;
+                tBuffer = nullptr;
+            }
+        }
+    };
+
+    ThreadBuffer* acquireBuffer()
+    {
+        static thread_local ThreadReleaser releaser;
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mMutex);
+        size_t capacity = on_main_thread() ? FlightRecorder::MAIN_THREAD_EVENTS
+                                           : FlightRecorder::OTHER_THREAD_EVENTS;
+        ThreadBuffer* buffer = nullptr;
+        for (auto& candidate : r.mBuffers)
+        {
+            if (!candidate->mInUse && candidate->mCapacity == capacity)
+            {
+                buffer = candidate.get();
+                break;
+            }
+        }
+        if (!buffer)
+        {
+            r.mBuffers.emplace_back(new ThreadBuffer(capacity));
+            buffer = r.mBuffers.back().get();
+        }
+        // events before mStart belong to the thread that had the buffer before
+        buffer->mStart = buffer->mHead.load(std::memory_order_relaxed);
+        buffer->mThreadId = r.mNextThreadId++;
+        buffer->mThreadName = tThreadName;
+        buffer->mInUse = true;
+        return buffer;
+    }
+
+    // Copy the events of every thread. Called with r.mMutex locked.
+    void takeSnapshot(Registry& r, Snapshot& snapshot)
+    {
+        for (auto& buffer : r.mBuffers)
+        {
+            // The owner claims a slot (advancing mHead) before it writes it.
+            // Events from the head we read at first, minus the slot that may
+            // still be in progress, are complete (the owner's release store
+            // of that head published them); after copying them, those the
+            // owner may have overwritten in the meantime are dropped.
+            U64 head = buffer->mHead.load(std::memory_order_acquire);
+            if (head <= buffer->mStart + 1)
+            {
+                continue;
+            }
+            U64 first = std::max(buffer->mStart, head > buffer->mCapacity ? head - buffer->mCapacity : 0);
+            U64 last = head - 1;
+
+            Snapshot::Thread thread;
+            thread.mThreadId = buffer->mThreadId;
+            thread.mThreadName = buffer->mThreadName;
+            thread.mEvents.reserve(last - first);
+            for (U64 i = first; i < last; ++i)
+            {
+                const Event& event = buffer->mEvents[i & buffer->mMask];
+                thread.mEvents.emplace_back(event.mTime.load(std::memory_order_relaxed),
+                                            event.mTimer.load(std::memory_order_relaxed));
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            head = buffer->mHead.load(std::memory_order_relaxed);
+            if (head > buffer->mCapacity && head - buffer->mCapacity > first)
+            {
+                size_t overwritten = size_t(std::min(head - buffer->mCapacity, last) - first);
+                thread.mEvents.erase(thread.mEvents.begin(), thread.mEvents.begin() + overwritten);
+            }
+            if (!thread.mEvents.empty())
+            {
+                snapshot.mThreads.push_back(std::move(thread));
+            }
+        }
+    }
+
+    void writeJSONString(std::ostream& out, const std::string& value)
+    {
+        out << '"';
+        for (char c : value)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out << '\\' << c;
+            }
+            else if (U8(c) < 0x20)
+            {
+                out << ' ';
+            }
+            else
+            {
+                out << c;
+            }
+        }
+        out << '"';
+    }
+
+    // Chrome trace "complete" events, matched from the enter/exit pairs of
+    // each thread. Scopes still open when the snapshot was taken end there;
+    // exits whose enter was already overwritten are skipped.
+    void writeTrace(const Snapshot& snapshot, std::ostream& out)
+    {
+        F64 us_per_count = 1000000. / F64(snapshot.mCountsPerSecond);
+        auto timestamp = [&](U64 time)
+        {
+            return (time > snapshot.mBegin ? F64(time - snapshot.mBegin) : -F64(snapshot.mBegin - time)) * us_per_count;
+        };
+        bool first = true;
+        auto complete = [&](const char* name, U32 tid, U64 begin, U64 end)
+        {
+            out << (first ? "\n" : ",\n") << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << tid << ",\"name\":";
+            first = false;
+            writeJSONString(out, name);
+            out << ",\"ts\":" << timestamp(begin) << ",\"dur\":" << F64(end - begin) * us_per_count << "}";
+        };
+        auto threadName = [&](U32 tid, const std::string& name)
+        {
+            out << (first ? "\n" : ",\n") << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+                << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+            first = false;
+            writeJSONString(out, name);
+            out << "}}";
+        };
+
+        out << std::fixed << std::setprecision(3);
+        out << "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"reason\":";
+        writeJSONString(out, snapshot.mReason);
+        out << "},\"traceEvents\":[";
+
+        threadName(0, "Frames");
+        for (const auto& frame : snapshot.mFrames)
+        {
+            complete("Frame", 0, frame.first, frame.second);
+        }
+
+        std::vector<std::pair<const BlockTimerStatHandle*, U64>> stack;
+        for (const auto& thread : snapshot.mThreads)
+        {
+            threadName(thread.mThreadId,
+                       thread.mThreadName.empty() ? "thread " + std::to_string(thread.mThreadId) : thread.mThreadName);
+            stack.clear();
+            for (const auto& event : thread.mEvents)
+            {
+                const BlockTimerStatHandle* timer = reinterpret_cast<const BlockTimerStatHandle*>(event.second & ~uintptr_t(1));
+                if (event.second & 1)
+                {
+                    stack.emplace_back(timer, event.first);
+                    continue;
+                }
+                // Normally the innermost scope: otherwise the enters of the
+                // scopes in between were recorded but not their exits.
+                auto found = std::find_if(stack.rbegin(), stack.rend(),
+                                          [timer](const auto& entry) { return entry.first == timer; });
+                if (found == stack.rend())
+                {
+                    continue;
+                }
+                stack.erase(found.base(), stack.end());
+                if (event.first >= snapshot.mBegin)
+                {
+                    complete(timer->getName().c_str(), thread.mThreadId, stack.back().second, event.first);
+                }
+                stack.pop_back();
+            }
+            for (const auto& open : stack)
+            {
+                complete(open.first->getName().c_str(), thread.mThreadId, open.second, snapshot.mEnd);
+            }
+        }
+        out << "\n]}\n";
+    }
+
+    std::filesystem::path toPath(const std::string& utf8)
+    {
+#if LL_WINDOWS
+        return std::filesystem::path(ll_convert_string_to_wide(utf8));
+#else
+        return std::filesystem::path(utf8);
+#endif
+    }
+
+    // Delete all but the newest keep hitch_*.json files in dir, so dumps
+    // don't pile up in the logs folder session after session.
+    void pruneDumps(const std::string& dir, U32 keep)
+    {
+        std::error_code ec;
+        std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> dumps;
+        for (std::filesystem::directory_iterator it(toPath(dir), ec), end; !ec && it != end; it.increment(ec))
+        {
+            const std::string name = it->path().filename().string();
+            if (name.rfind("hitch_", 0) == 0 && it->path().extension() == ".json")
+            {
+                dumps.emplace_back(it->last_write_time(ec), it->path());
+            }
+        }
+        if (dumps.size() <= keep)
+        {
+            return;
+        }
+        std::sort(dumps.begin(), dumps.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+        for (size_t i = keep; i < dumps.size(); ++i)
+        {
+            std::filesystem::remove(dumps[i].second, ec);
+        }
+    }
+
+    std::string dumpFileName(const Registry& r)
+    {
+        char stamp[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", std::localtime(&now));
+        std::string dir = r.mDumpDir;
+        if (dir.back() != '/' && dir.back() != '\\')
+        {
+            dir += '/';
+        }
+        return dir + "hitch_" + stamp + "_" + std::to_string(r.mDumps) + ".json";
+    }
+
+    // Snapshot the last window_frames frames and write them on a background
+    // thread. Called with r.mMutex locked, so it doesn't log.
+    std::string startDump(Registry& r, const std::string& reason, U32 window_frames)
+    {
+        if (r.mDumpDir.empty() || r.mWriting)
+        {
+            return std::string();
+        }
+
+        auto snapshot = std::make_shared<Snapshot>();
+        snapshot->mReason = reason;
+        snapshot->mEnd = BlockTimer::getCPUClockCount64();
+        snapshot->mCountsPerSecond = BlockTimer::countsPerSecond();
+        size_t frames = std::min<size_t>(window_frames, r.mFrames.size());
+        snapshot->mFrames.assign(r.mFrames.end() - frames, r.mFrames.end());
+        // without frames, dump everything still in the buffers
+        snapshot->mBegin = frames ? snapshot->mFrames.front().first : 0;
+        takeSnapshot(r, *snapshot);
+
+        ++r.mDumps;
+        r.mLastDump = snapshot->mEnd;
+        std::string filename = dumpFileName(r);
+        std::string dir = r.mDumpDir;
+        U32 keep = r.mKeepDumps;
+
+        if (r.mWriter.joinable())
+        {
+            r.mWriter.join();
+        }
+        r.mWriting = true;
+        r.mWriter = std::thread(
+            [snapshot, filename, dir, keep]()
+            {
+                LL_PROFILER_SET_THREAD_NAME("FlightRecorder");
+                llofstream out(filename.c_str(), std::ios::out | std::ios::trunc);
+                if (out.is_open())
+                {
+                    writeTrace(*snapshot, out);
+                }
+                if (!out.good())
+                {
+                    LL_WARNS("FlightRecorder") << "Could not write " << filename << LL_ENDL;
+                }
+                out.close();
+                pruneDumps(dir, keep);
+                Registry& r = registry();
+                std::lock_guard<std::mutex> lock(r.mMutex);
+                r.mWriting = false;
+            });
+        return filename;
+    }
+}
+
+namespace LLTrace
+{
+void FlightRecorder::setEnabled(bool enabled)
+{
+    sEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void FlightRecorder::configure(F32 threshold_ms, U32 window_frames, const std::string& dump_dir,
+                               F32 cooldown_seconds, U32 max_dumps, U32 keep_dumps)
+{
+    F64 counts_per_ms = F64(BlockTimer::countsPerSecond()) / 1000.;
+    Registry& r = registry();
+    {
+        std::lock_guard<std::mutex> lock(r.mMutex);
+        r.mThresholdCounts = threshold_ms > 0.f ? U64(threshold_ms * counts_per_ms) : 0;
+        r.mWindowFrames = llclamp(window_frames, 1U, U32(MAX_FRAMES));
+        r.mDumpDir = dump_dir;
+        r.mCooldownCounts = U64(cooldown_seconds * 1000. * counts_per_ms);
+        r.mMaxDumps = max_dumps;
+        r.mKeepDumps = keep_dumps;
+    }
+    // what earlier sessions left behind
+    if (!dump_dir.empty())
+    {
+        pruneDumps(dump_dir, keep_dumps);
+    }
+}
+
+void FlightRecorder::setPaused(bool paused)
+{
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mMutex);
+    r.mPaused = paused;
+}
+
+void FlightRecorder::setThreadName(const std::string& name)
+{
+    tThreadName = name;
+    if (tBuffer)
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mMutex);
+        tBuffer->mThreadName = name;
+    }
+}
+
+bool FlightRecorder::endFrame()
+{
+    U64 now = BlockTimer::getCPUClockCount64();
+    Registry& r = registry();
+    std::unique_lock<std::mutex> lock(r.mMutex);
+    U64 start = r.mFrameStart;
+    r.mFrameStart = now;
+    if (!start)
+    {
+        return false;
+    }
+    r.mFrames.emplace_back(start, now);
+    if (r.mFrames.size() > MAX_FRAMES)
+    {
+        r.mFrames.pop_front();
+    }
+
+    if (!getEnabled() || r.mPaused || !r.mThresholdCounts || now - start < r.mThresholdCounts
+        || r.mDumps >= r.mMaxDumps || (r.mLastDump && now - r.mLastDump < r.mCooldownCounts))
+    {
+        return false;
+    }
+    std::ostringstream reason;
+    reason << "Frame took " << F64(now - start) * 1000. / F64(BlockTimer::countsPerSecond()) << " ms";
+    std::string filename = startDump(r, reason.str(), r.mWindowFrames);
+    lock.unlock();
+    if (filename.empty())
+    {
+        return false;
+    }
+    LL_WARNS("FlightRecorder") << reason.str() << ", writing trace to " << filename << LL_ENDL;
+    return true;
+}
+
+std::string FlightRecorder::dump(const std::string& reason)
+{
+    if (!getEnabled())
+    {
+        return std::string();
+    }
+    Registry& r = registry();
+    std::unique_lock<std::mutex> lock(r.mMutex);
+    std::string filename = startDump(r, reason, r.mWindowFrames);
+    lock.unlock();
+    if (!filename.empty())
+    {
+        LL_INFOS("FlightRecorder") << reason << ", writing trace to " << filename << LL_ENDL;
+    }
+    return filename;
+}
+
+void FlightRecorder::waitForDump()
+{
+    Registry& r = registry();
+    std::thread writer;
+    {
+        std::lock_guard<std::mutex> lock(r.mMutex);
+        writer.swap(r.mWriter);
+    }
+    if (writer.joinable())
+    {
+        writer.join();
+    }
+}
+
+void FlightRecorder::record(const BlockTimerStatHandle* timer, U64 time, bool begin)
+{
+    ThreadBuffer* buffer = tBuffer;
+    if (!buffer)
+    {
+        buffer = tBuffer = acquireBuffer();
+    }
+    // Claim the slot before writing it, so a snapshot that reads a slot
+    // being overwritten also sees the head that tells it so. The release
+    // store publishes the event written by the previous call, which is why
+    // a snapshot only trusts the slots below head - 1.
+    U64 head = buffer->mHead.load(std::memory_order_relaxed);
+    buffer->mHead.store(head + 1, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_release);
+    Event& event = buffer->mEvents[head & buffer->mMask];
+    event.mTime.store(time, std::memory_order_relaxed);
+    event.mTimer.store(reinterpret_cast<uintptr_t>(timer) | (begin ? 1 : 0), std::memory_order_relaxed);
+}
+
+} // namespace LLTrace
@@ -0,0 +1,103 @@
+/**
+ * @file llflightrecorder.h
+ * @brief Always-on recorder of recent BlockTimer activity, dumped to a
+ *        trace file when a frame hitches.
+ *
+ * @Description:
+ * When a user reports a hitch, the fast timer view only shows averages, and
+ * a Tracy build is rarely at hand. FlightRecorder keeps the most recent
+ * BlockTimer enter and exit events of every thread, each thread writing its
+ * own ring buffer without locks. The frame thread calls endFrame() once a
+ * frame: when the frame took longer than the threshold, the last few frames
+ * of every thread are written to a Chrome trace JSON file (which Perfetto and
+ * chrome://tracing open) in the dump directory.
+ *
+ * Recording costs one well-predicted branch per BlockTimer when disabled,
+ * and a thread-local ring buffer store (two words) per enter and exit when
+ * enabled. Snapshots are taken on the frame thread; the trace is formatted
+ * and written by a background thread.
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLFLIGHTRECORDER_H
+#define LL_LLFLIGHTRECORDER_H
+
+#include <atomic>
+#include <string>
+
+namespace LLTrace
+{
+class BlockTimerStatHandle;
+
+class LL_COMMON_API FlightRecorder
+{
+public:
+    // ring buffer sizes, in events: the main thread runs most of the timers
+    static constexpr size_t MAIN_THREAD_EVENTS = 1 << 18;
+    static constexpr size_t OTHER_THREAD_EVENTS = 1 << 14;
+    // at most this many frames are kept for the dump window
+    static constexpr size_t MAX_FRAMES = 64;
+
+    // Tested inline by BlockTimer: everything else is out of line.
+    static std::atomic<bool> sEnabled;
+
+    static void setEnabled(bool enabled);
+    static bool getEnabled() { return sEnabled.load(std::memory_order_relaxed); }
+
+    // Frames longer than threshold_ms trigger a dump of the last
+    // window_frames frames (including the slow one) to dump_dir. At most one
+    // dump is written every cooldown_seconds, and at most max_dumps per
+    // session, so a stretch of hitches doesn't fill the disk. Only the newest
+    // keep_dumps hitch_*.json files in dump_dir are kept, counting those of
+    // earlier sessions.
+    static void configure(F32 threshold_ms, U32 window_frames, const std::string& dump_dir,
+                          F32 cooldown_seconds = 10.f, U32 max_dumps = 20, U32 keep_dumps = 10);
+
+    // While paused, slow frames don't trigger dumps: for stretches where long
+    // frames are expected, such as logging in or teleporting. dump() still
+    // works.
+    static void setPaused(bool paused);
+
+    // Name the calling thread in the traces.
+    static void setThreadName(const std::string& name);
+
+    // Call once a frame from the frame thread. Returns true if the frame that
+    // just ended was slow enough to start a dump.
+    static bool endFrame();
+
+    // Dump the current window right away, regardless of the threshold and
+    // cooldown. Returns the file name, or an empty string if nothing could be
+    // dumped (disabled, no directory, or a dump still being written).
+    static std::string dump(const std::string& reason);
+
+    // Wait for any dump being written. Call before shutting down logging.
+    static void waitForDump();
+
+    // BlockTimer's hooks
+    static void record(const BlockTimerStatHandle* timer, U64 time, bool begin);
+};
+
+} // namespace LLTrace
+
+#endif // LL_LLFLIGHTRECORDER_H
@@ -35,8 +35,16 @@
 #include "llerror.h"
 #include "../llmath/llmath.h"
 
+#include "llstring.h"
+
 #include <boost/json/src.hpp>
 
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
 //=========================================================================
 LLSD LlsdFromJson(const boost::json::value& val)
 {
@@ -129,3 +137,652 @@ boost::json::value LlsdToJson(const LLSD &val)
 
     return result;
 }
+
+//=========================================================================
+// Direct conversion between JSON text and LLSD. Both directions make a
+// single pass and never build a boost::json::value, which for the larger
+// responses (AIS, profiles) is a second complete copy of the document.
+namespace
+{
+
+// Length of the well formed UTF-8 sequence starting at p, 0 if there is
+// none: truncated, overlong, a surrogate or beyond U+10FFFF
+size_t utf8_sequence_length(const char* p, const char* end)
+{
+    const U8 lead = (U8)p[0];
+    size_t length;
+    U8 low = 0x80;      // bounds of the second byte, tighter than the
+    U8 high = 0xBF;     // usual ones after some lead bytes
+    if (lead >= 0xC2 && lead <= 0xDF)
+    {
+        length = 2;
+    }
+    else if (lead >= 0xE0 && lead <= 0xEF)
+    {
+        length = 3;
+        if (lead == 0xE0)
+        {
+            low = 0xA0;
+        }
+        else if (lead == 0xED)
+        {
+            high = 0x9F;
+        }
+    }
+    else if (lead >= 0xF0 && lead <= 0xF4)
+    {
+        length = 4;
+        if (lead == 0xF0)
+        {
+            low = 0x90;
+        }
+        else if (lead == 0xF4)
+        {
+            high = 0x8F;
+        }
+    }
+    else
+    {
+        return 0;
+    }
+
+    if ((size_t)(end - p) < length || (U8)p[1] < low || (U8)p[1] > high)
+    {
+        return 0;
+    }
+    for (size_t i = 2; i < length; ++i)
+    {
+        if (((U8)p[i] & 0xC0) != 0x80)
+        {
+            return 0;
+        }
+    }
+    return length;
+}
+
+class LLSDJsonReader
+{
+public:
+    LLSDJsonReader(std::string_view json, S32 max_depth)
+    :   mBegin(json.data()),
+        mCur(json.data()),
+        mEnd(json.data() + json.size()),
+        mMaxDepth(max_depth)
+    {
+    }
+
+    bool read(LLSD& result)
+    {
+        skipSpace();
+        if (!readValue(result, 0))
+        {
+            return false;
+        }
+        skipSpace();
+        if (mCur != mEnd)
+        {
+            return fail("unexpected data after the value");
+        }
+        return true;
+    }
+
+    const std::string& getError() const { return mError; }
+
+private:
+    bool fail(const char* what)
+    {
+        mError = std::string(what) + " at offset " + std::to_string(mCur - mBegin);
+        return false;
+    }
+
+    void skipSpace()
+    {
+        while (mCur < mEnd && (*mCur == ' ' || *mCur == '\n' || *mCur == '\r' || *mCur == '\t'))
+        {
+            ++mCur;
+        }
+    }
+
+    bool isDigit() const
+    {
+        return mCur < mEnd && *mCur >= '0' && *mCur <= '9';
+    }
+
+    bool readValue(LLSD& value, S32 depth)
+    {
+        if (mCur == mEnd)
+        {
+            return fail("unexpected end of input");
+        }
+
+        switch (*mCur)
+        {
+            case '{':
+                return readObject(value, depth + 1);
+            case '[':
+                return readArray(value, depth + 1);
+            case '"':
+            {
+                LLSD::String str;
+                if (!readString(str))
+                {
+                    return false;
+                }
+                value = std::move(str);
+                return true;
+            }
+            case 't':
+                value = true;
+                return readLiteral("true", 4);
+            case 'f':
+                value = false;
+                return readLiteral("false", 5);
+            case 'n':
+                value.clear();
+                return readLiteral("null", 4);
+            default:
+                return readNumber(value);
+        }
+    }
+
+    bool readLiteral(const char* literal, size_t len)
+    {
+        if ((size_t)(mEnd - mCur) < len || memcmp(mCur, literal, len) != 0)
+        {
+            return fail("invalid literal");
+        }
+        mCur += len;
+        return true;
+    }
+
+    bool readObject(LLSD& value, S32 depth)
+    {
+        if (depth > mMaxDepth)
+        {
+            return fail("nesting too deep");
+        }
+        ++mCur;
+        value = LLSD::emptyMap();
+
+        skipSpace();
+        if (mCur < mEnd && *mCur == '}')
+        {
+            ++mCur;
+            return true;
+        }
+
+        LLSD::String key;
+        while (true)
+        {
+            skipSpace();
+            if (mCur == mEnd || *mCur != '"')
+            {
+                return fail("expected a member name");
+            }
+            key.clear();
+            if (!readString(key))
+            {
+                return false;
+            }
+            skipSpace();
+            if (mCur == mEnd || *mCur != ':')
+            {
+                return fail("expected ':'");
+            }
+            ++mCur;
+            skipSpace();
+            // Like LlsdFromJson(), a repeated name replaces the earlier value
+            if (!readValue(value[key], depth))
+            {
+                return false;
+            }
+            skipSpace();
+            if (mCur < mEnd && *mCur == ',')
+            {
+                ++mCur;
+                continue;
+            }
+            if (mCur < mEnd && *mCur == '}')
+            {
+                ++mCur;
+                return true;
+            }
+            return fail("expected ',' or '}'");
+        }
+    }
+
+    bool readArray(LLSD& value, S32 depth)
+    {
+        if (depth > mMaxDepth)
+        {
+            return fail("nesting too deep");
+        }
+        ++mCur;
+        value = LLSD::emptyArray();
+
+        skipSpace();
+        if (mCur < mEnd && *mCur == ']')
+        {
+            ++mCur;
+            return true;
+        }
+
+        while (true)
+        {
+            skipSpace();
+            if (!readValue(value.append(LLSD()), depth))
+            {
+                return false;
+            }
+            skipSpace();
+            if (mCur < mEnd && *mCur == ',')
+            {
+                ++mCur;
+                continue;
+            }
+            if (mCur < mEnd && *mCur == ']')
+            {
+                ++mCur;
+                return true;
+            }
+            return fail("expected ',' or ']'");
+        }
+    }
+
+    bool readHex4(U32& value)
+    {
+        if (mEnd - mCur < 4)
+        {
+            return fail("truncated \\u escape");
+        }
+        value = 0;
+        for (S32 i = 0; i < 4; ++i, ++mCur)
+        {
+            if (!is_char_hex(*mCur))
+            {
+                return fail("invalid \\u escape");
+            }
+            value = (value << 4) | hex_as_nybble(*mCur);
+        }
+        return true;
+    }
+
+    bool readString(LLSD::String& out)
+    {
+        ++mCur;
+        while (true)
+        {
+            // Copy runs of plain characters in one go, checking that they
+            // are well formed UTF-8
+            const char* run = mCur;
+            while (mCur < mEnd)
+            {
+                if ((U8)*mCur < 0x80)
+                {
+                    if (*mCur == '"' || *mCur == '\\' || (U8)*mCur < 0x20)
+                    {
+                        break;
+                    }
+                    ++mCur;
+                }
+                else if (size_t length = utf8_sequence_length(mCur, mEnd))
+                {
+                    mCur += length;
+                }
+                else
+                {
+                    return fail("invalid UTF-8 in string");
+                }
+            }
+            out.append(run, mCur - run);
+
+            if (mCur == mEnd)
+            {
+                return fail("unterminated string");
+            }
+            if (*mCur == '"')
+            {
+                ++mCur;
+                return true;
+            }
+            if (*mCur != '\\')
+            {
+                return fail("control character in string");
+            }
+
+            if (++mCur == mEnd)
+            {
+                return fail("unterminated string");
+            }
+            switch (*mCur++)
+            {
+                case '"':   out += '"';     break;
+                case '\\':  out += '\\';    break;
+                case '/':   out += '/';     break;
+                case 'b':   out += '\b';    break;
+                case 'f':   out += '\f';    break;
+                case 'n':   out += '\n';    break;
+                case 'r':   out += '\r';    break;
+                case 't':   out += '\t';    break;
+                case 'u':
+                {
+                    U32 code_point = 0;
+                    if (!readHex4(code_point))
+                    {
+                        return false;
+                    }
+                    if (code_point >= 0xD800 && code_point < 0xDC00)
+                    {
+                        U32 low = 0;
+                        if (mEnd - mCur < 2 || mCur[0] != '\\' || mCur[1] != 'u')
+                        {
+                            return fail("unpaired surrogate");
+                        }
+                        mCur += 2;
+                        if (!readHex4(low))
+                        {
+                            return false;
+                        }
+                        if (low < 0xDC00 || low >= 0xE000)
+                        {
+                            return fail("unpaired surrogate");
+                        }
+                        code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    else if (code_point >= 0xDC00 && code_point < 0xE000)
+                    {
+                        return fail("unpaired surrogate");
+                    }
+                    char utf8[8];
+                    out.append(utf8, wchar_to_utf8chars((llwchar)code_point, utf8));
+                    break;
+                }
+                default:
+                    --mCur;
+                    return fail("invalid escape");
+            }
+        }
+    }
+
+    bool readNumber(LLSD& value)
+    {
+        const char* start = mCur;
+        const bool negative = *mCur == '-';
+        if (negative)
+        {
+            ++mCur;
+        }
+        if (!isDigit())
+        {
+            return fail("invalid value");
+        }
+
+        U64 magnitude = 0;
+        bool overflow = false;
+        if (*mCur == '0')
+        {
+            // no leading zeroes
+            ++mCur;
+        }
+        else
+        {
+            for (; isDigit(); ++mCur)
+            {
+                U32 digit = *mCur - '0';
+                if (magnitude > (std::numeric_limits<U64>::max() - digit) / 10)
+                {
+                    overflow = true;
+                }
+                magnitude = magnitude * 10 + digit;
+            }
+        }
+
+        bool integral = true;
+        if (mCur < mEnd && *mCur == '.')
+        {
+            integral = false;
+            ++mCur;
+            if (!isDigit())
+            {
+                return fail("invalid number");
+            }
+            while (isDigit())
+            {
+                ++mCur;
+            }
+        }
+        if (mCur < mEnd && (*mCur == 'e' || *mCur == 'E'))
+        {
+            integral = false;
+            ++mCur;
+            if (mCur < mEnd && (*mCur == '+' || *mCur == '-'))
+            {
+                ++mCur;
+            }
+            if (!isDigit())
+            {
+                return fail("invalid number");
+            }
+            while (isDigit())
+            {
+                ++mCur;
+            }
+        }
+
+        // boost::json keeps integers that fit in 64 bits, which
+        // LlsdFromJson() then narrows to LLSD::Integer
+        if (integral && !overflow && (!negative || magnitude <= (U64)std::numeric_limits<S64>::max() + 1))
+        {
+            value = (LLSD::Integer)(negative ? 0 - magnitude : magnitude);
+            return true;
+        }
+
+        // strtod() needs a terminated copy, the input may end right here
+        char buf[64];
+        size_t len = mCur - start;
+        if (len < sizeof(buf))
+        {
+            memcpy(buf, start, len);
+            buf[len] = '\0';
+            value = ll_strtod_c_locale(buf, nullptr);
+        }
+        else
+        {
+            value = ll_strtod_c_locale(std::string(start, len).c_str(), nullptr);
+        }
+        return true;
+    }
+
+    const char*         mBegin;
+    const char*         mCur;
+    const char*         mEnd;
+    const S32           mMaxDepth;
+    std::string         mError;
+};
+
+void write_json_string(const char* str, size_t len, std::string& out)
+{
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+
+    out += '"';
+    const char* run = str;
+    const char* end = str + len;
+    for (const char* cur = str; cur < end; ++cur)
+    {
+        U8 c = (U8)*cur;
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+            continue;
+        }
+        out.append(run, cur - run);
+        run = cur + 1;
+        switch (c)
+        {
+            case '"':   out += "\\\"";  break;
+            case '\\':  out += "\\\\";  break;
+            case '\b':  out += "\\b";   break;
+            case '\f':  out += "\\f";   break;
+            case '\n':  out += "\\n";   break;
+            case '\r':  out += "\\r";   break;
+            case '\t':  out += "\\t";   break;
+            default:
+                out += "\\u00";
+                out += HEX_DIGITS[c >> 4];
+                out += HEX_DIGITS[c & 0xf];
+                break;
+        }
+    }
+    out.append(run, end - run);
+    out += '"';
+}
+
+S32 format_real(F64 value, const char* format, char* buf, size_t size)
+{
+    S32 len = snprintf(buf, size, format, value);
+    // LLLocale may have switched LC_NUMERIC to one with a decimal comma
+    for (S32 i = 0; i < len; ++i)
+    {
+        char c = buf[i];
+        if ((c < '0' || c > '9') && c != '-' && c != '+' && c != 'e')
+        {
+            buf[i] = '.';
+        }
+    }
+    return len;
+}
+
+void write_json_real(F64 value, std::string& out)
+{
+    // Same as boost::json::serialize()
+    if (std::isnan(value))
+    {
+        out += "null";
+        return;
+    }
+    if (std::isinf(value))
+    {
+        out += value < 0 ? "-1e99999" : "1e99999";
+        return;
+    }
+
+    // Use the shorter precision when it reads back exactly
+    char buf[32];
+    S32 len = format_real(value, "%.15g", buf, sizeof(buf));
+    if (ll_strtod_c_locale(buf, nullptr) != value)
+    {
+        len = format_real(value, "%.17g", buf, sizeof(buf));
+    }
+    out.append(buf, len);
+    // Keep it a JSON real so that it reads back as LLSD::Real
+    if (!memchr(buf, '.', len) && !memchr(buf, 'e', len))
+    {
+        out += ".0";
+    }
+}
+
+void write_json(const LLSD& val, std::string& out)
+{
+    switch (val.type())
+    {
+        case LLSD::TypeUndefined:
+            out += "null";
+            break;
+        case LLSD::TypeBoolean:
+            out += val.asBoolean() ? "true" : "false";
+            break;
+        case LLSD::TypeInteger:
+        {
+            char buf[16];
+            out.append(buf, std::to_chars(buf, buf + sizeof(buf), val.asInteger()).ptr - buf);
+            break;
+        }
+        case LLSD::TypeReal:
+            write_json_real(val.asReal(), out);
+            break;
+        case LLSD::TypeString:
+        {
+            const LLSD::String& str = val.asStringRef();
+            write_json_string(str.data(), str.size(), out);
+            break;
+        }
+        case LLSD::TypeURI:
+        case LLSD::TypeDate:
+        case LLSD::TypeUUID:
+        {
+            const LLSD::String str = val.asString();
+            write_json_string(str.data(), str.size(), out);
+            break;
+        }
+        case LLSD::TypeMap:
+        {
+            out += '{';
+            bool first = true;
+            // Not llsd::inMap(), whose non-const iterators would copy a
+            // shared map
+            for (LLSD::map_const_iterator it = val.beginMap(), end = val.endMap(); it != end; ++it)
+            {
+                if (!first)
+                {
+                    out += ',';
+                }
+                first = false;
+                write_json_string(it->first.data(), it->first.size(), out);
+                out += ':';
+                write_json(it->second, out);
+            }
+            out += '}';
+            break;
+        }
+        case LLSD::TypeArray:
+        {
+            out += '[';
+            bool first = true;
+            for (LLSD::array_const_iterator it = val.beginArray(), end = val.endArray(); it != end; ++it)
+            {
+                if (!first)
+                {
+                    out += ',';
+                }
+                first = false;
+                write_json(*it, out);
+            }
+            out += ']';
+            break;
+        }
+        case LLSD::TypeBinary:
+        default:
+            LL_ERRS("LlsdToJson") << "Unsupported conversion to JSON from LLSD type (" << val.type() << ")." << LL_ENDL;
+            break;
+    }
+}
+
+} // anonymous namespace
+
+//=========================================================================
+bool LlsdFromJsonString(std::string_view json, LLSD& result, std::string* error, S32 max_depth)
+{
+    LLSDJsonReader reader(json, max_depth);
+    if (!reader.read(result))
+    {
+        result.clear();
+        if (error)
+        {
+            *error = reader.getError();
+        }
+        return false;
+    }
+    return true;
+}
+
+//=========================================================================
+void LlsdToJsonString(const LLSD& val, std::string& out)
+{
+    write_json(val, out);
+}
+
+std::string LlsdToJsonString(const LLSD& val)
+{
+    std::string out;
+    write_json(val, out);
+    return out;
+}
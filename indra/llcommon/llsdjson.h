@@ -29,6 +29,7 @@
 
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "stdtypes.h"
@@ -74,4 +75,22 @@ LLSD LlsdFromJson(const boost::json::value &val);
 /// TypeBinary    | unsupported
 boost::json::value LlsdToJson(const LLSD &val);
 
+/// Parse JSON text straight into LLSD in a single pass, without building a
+/// boost::json::value first. Types are converted as by LlsdFromJson(): a
+/// number without fraction or exponent is an LLSD::Integer when it fits in
+/// 64 bits, and the last of several members with the same name wins.
+///
+/// Returns false for malformed JSON, anything but whitespace after the
+/// value, strings that are not well formed UTF-8, invalid \u escapes or
+/// nesting deeper than max_depth. On failure
+/// result is undefined and error, if given, receives a description with the
+/// offset at which parsing stopped.
+bool LlsdFromJsonString(std::string_view json, LLSD& result,
+                        std::string* error = nullptr, S32 max_depth = 128);
+
+/// Write LLSD as compact JSON text straight to out, which is appended to.
+/// Types are converted as by LlsdToJson(); binary values are not supported.
+void LlsdToJsonString(const LLSD& val, std::string& out);
+std::string LlsdToJsonString(const LLSD& val);
+
 #endif // LL_LLSDJSON_H
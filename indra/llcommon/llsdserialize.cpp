@@ -32,7 +32,7 @@
 #include "llstreamtools.h" // for fullread
 
 #include <iostream>
-#include "apr_base64.h"
+#include "llbase64.h"
 
 #include <boost/iostreams/device/array.hpp>
 #include <boost/iostreams/stream.hpp>
@@ -46,7 +46,6 @@
 #if !LL_WINDOWS
 #include <netinet/in.h> // htonl & ntohl
 #endif
-
 #include "lldate.h"
 #include "llmemorystream.h"
 #include "llsd.h"
@@ -82,6 +81,13 @@ S32 parse_using(std::istream& istr, LLSD& data, size_t max_bytes, S32 max_depth=
     return p->parse(istr, data, max_bytes, max_depth);
 }
 
+template <class Parser>
+S32 parse_buffer_using(const U8* buf, size_t size, LLSD& data, S32 max_depth=-1)
+{
+    LLPointer<Parser> p{ new Parser };
+    return p->parseBuffer(buf, size, data, max_depth);
+}
+
 /**
  * LLSDSerialize
  */
@@ -254,6 +260,79 @@ bool LLSDSerialize::deserialize(LLSD& sd, std::istream& str, llssize max_bytes)
     }
 }
 
+// static
+bool LLSDSerialize::deserialize(LLSD& sd, const U8* buf, size_t size)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
+    if (!buf || !size)
+    {
+        LL_WARNS() << "deserialize LLSD parse failure" << LL_ENDL;
+        return false;
+    }
+
+    const char* text = reinterpret_cast<const char*>(buf);
+    const size_t legacy_len = strlen(LEGACY_NON_HEADER);  /* Flawfinder: ignore */
+    if (size >= legacy_len && !strncasecmp(LEGACY_NON_HEADER, text, legacy_len))
+    {
+        return (parse_buffer_using<LLSDXMLParser>(buf, size, sd) > 0);
+    }
+
+    // Same header detection as the stream version above: look at the
+    // first line only.
+    size_t inbuf = 0;
+    while (inbuf < llmin(size, MAX_HDR_LEN - 1) && text[inbuf] != '\n')
+    {
+        ++inbuf;
+    }
+    if (inbuf < size && text[inbuf] == '\n')
+    {
+        ++inbuf;
+    }
+    std::string header{ text, inbuf };
+    std::string::size_type lastchar = header.find_last_not_of("\r\n");
+    if (lastchar != std::string::npos)
+    {
+        header.erase(lastchar+1);
+    }
+
+    // trim off the <? ... ?> header syntax
+    auto start = header.find_first_not_of("<? ");
+    if (start != std::string::npos)
+    {
+        auto end = header.find_first_of(" ?", start);
+        if (end != std::string::npos)
+        {
+            header = header.substr(start, end - start);
+        }
+    }
+
+    size_t offset = inbuf;
+    while (offset < size && isspace((U8)text[offset]))
+    {
+        ++offset;
+    }
+    if (0 == LLStringUtil::compareInsensitive(header, LLSD_BINARY_HEADER))
+    {
+        return (parse_buffer_using<LLSDBinaryParser>(buf + offset, size - offset, sd) > 0);
+    }
+    else if (0 == LLStringUtil::compareInsensitive(header, LLSD_XML_HEADER))
+    {
+        return (parse_buffer_using<LLSDXMLParser>(buf + offset, size - offset, sd) > 0);
+    }
+    else if (0 == LLStringUtil::compareInsensitive(header, LLSD_NOTATION_HEADER))
+    {
+        return (parse_buffer_using<LLSDNotationParser>(buf + offset, size - offset, sd) > 0);
+    }
+    else if (text[0] == '<')
+    {
+        // no header we recognize, looks like XML
+        LL_DEBUGS() << "deserialize request with no header, assuming XML" << LL_ENDL;
+        return (parse_buffer_using<LLSDXMLParser>(buf, size, sd) > 0);
+    }
+    LL_DEBUGS() << "deserialize request with no header, assuming notation" << LL_ENDL;
+    return (parse_buffer_using<LLSDNotationParser>(buf, size, sd) > 0);
+}
+
 /**
  * Endian handlers
  */
@@ -404,6 +483,19 @@ S32 LLSDParser::parseLines(std::istream& istr, LLSD& data)
     return doParse(istr, data);
 }
 
+S32 LLSDParser::parseBuffer(const U8* buf, size_t size, LLSD& data, S32 max_depth)
+{
+    mCheckLimits = true;
+    mMaxBytesLeft = (llssize)size;
+    return doParseBuffer(buf, size, data, max_depth);
+}
+
+S32 LLSDParser::doParseBuffer(const U8* buf, size_t size, LLSD& data, S32 max_depth) const
+{
+    boost::iostreams::stream<boost::iostreams::array_source> istr((const char*)buf, size);
+    return doParse(istr, data, max_depth);
+}
+
 
 int LLSDParser::get(std::istream& istr) const
 {
@@ -886,16 +978,7 @@ bool LLSDNotationParser::parseBinary(std::istream& istr, LLSD& data) const
         std::stringstream coded_stream;
         get(istr, *(coded_stream.rdbuf()), '\"');
         c = get(istr);
-        std::string encoded(coded_stream.str());
-        S32 len = apr_base64_decode_len(encoded.c_str());
-        std::vector<U8> value;
-        if(len)
-        {
-            value.resize(len);
-            len = apr_base64_decode_binary(&value[0], encoded.c_str());
-            value.resize(len);
-        }
-        data = value;
+        data = LLBase64::decode(coded_stream.str());
     }
     else if(0 == strncmp("b16", buf, 3))
     {
@@ -1298,176 +1381,1017 @@ bool LLSDBinaryParser::parseString(
 
 
 /**
- * LLSDFormatter
- */
-LLSDFormatter::LLSDFormatter(bool boolAlpha, const std::string& realFmt, EFormatterOptions options):
-    mOptions(options)
-{
-    boolalpha(boolAlpha);
-    realFormat(realFmt);
-}
-
-// virtual
-LLSDFormatter::~LLSDFormatter()
-{ }
-
-void LLSDFormatter::boolalpha(bool alpha)
-{
-    mBoolAlpha = alpha;
-}
-
-void LLSDFormatter::realFormat(const std::string& format)
-{
-    mRealFormat = format;
-}
-
-S32 LLSDFormatter::format(const LLSD& data, std::ostream& ostr) const
-{
-    // pass options captured by constructor
-    return format(data, ostr, mOptions);
-}
-
-S32 LLSDFormatter::format(const LLSD& data, std::ostream& ostr, EFormatterOptions options) const
-{
-    return format_impl(data, ostr, options, 0);
-}
-
-void LLSDFormatter::formatReal(LLSD::Real real, std::ostream& ostr) const
-{
-    std::string buffer = llformat(mRealFormat.c_str(), real);
-    ostr << buffer;
-}
-
-/**
- * LLSDNotationFormatter
+ * In-memory decoding
+ *
+ * LLSDBinaryParser::doParseBuffer() and LLSDNotationParser::doParseBuffer()
+ * decode a contiguous buffer directly rather than pulling it byte by byte
+ * out of an istream. They follow the rules of the stream parsers above,
+ * but map keys and unescaped strings are taken straight from the buffer.
  */
-LLSDNotationFormatter::LLSDNotationFormatter(bool boolAlpha, const std::string& realFormat,
-                                             EFormatterOptions options):
-    LLSDFormatter(boolAlpha, realFormat, options)
+namespace
 {
-}
-
-// virtual
-LLSDNotationFormatter::~LLSDNotationFormatter()
-{ }
 
-// static
-std::string LLSDNotationFormatter::escapeString(const std::string& in)
+class LLSDBufferReader
 {
-    std::ostringstream ostr;
-    serialize_string(in, ostr);
-    return ostr.str();
-}
+public:
+    LLSDBufferReader(const U8* buf, size_t size):
+        mCursor(buf),
+        mEnd(buf + size)
+    {
+    }
 
-S32 LLSDNotationFormatter::format_impl(const LLSD& data, std::ostream& ostr,
-                                       EFormatterOptions options, U32 level) const
-{
-    S32 format_count = 1;
-    std::string pre;
-    std::string post;
+protected:
+    bool atEnd() const { return mCursor >= mEnd; }
+    size_t remaining() const { return mEnd - mCursor; }
+    int peek() const { return atEnd() ? EOF : *mCursor; }
+    int get() { return atEnd() ? EOF : *mCursor++; }
 
-    if (options & LLSDFormatter::OPTIONS_PRETTY)
+    void skipSpace()
     {
-        for (U32 i = 0; i < level; i++)
+        while (!atEnd() && isspace(*mCursor))
         {
-            pre += "    ";
+            ++mCursor;
         }
-        post = "\n";
     }
 
-    switch(data.type())
-    {
-    case LLSD::TypeMap:
+    bool readBytes(void* dest, size_t size)
     {
-        if (0 != level) ostr << post << pre;
-        ostr << "{";
-        std::string inner_pre;
-        if (options & LLSDFormatter::OPTIONS_PRETTY)
+        if (size > remaining())
         {
-            inner_pre = pre + "    ";
+            mCursor = mEnd;
+            return false;
         }
+        memcpy(dest, mCursor, size);
+        mCursor += size;
+        return true;
+    }
 
-        bool need_comma = false;
-        LLSD::map_const_iterator iter = data.beginMap();
-        LLSD::map_const_iterator end = data.endMap();
-        for(; iter != end; ++iter)
+    /**
+     * Read a string up to the closing delimiter (the opening one has been
+     * consumed), with the escapes of deserialize_string_delim(). A string
+     * without escapes is returned as a view of the buffer, any other one
+     * is decoded into scratch.
+     */
+    bool readDelimited(int delim, std::string& scratch, std::string_view& value)
+    {
+        const U8* end = mCursor;
+        while (end < mEnd && *end != delim && *end != '\\')
         {
-            if(need_comma) ostr << ",";
-            need_comma = true;
-            ostr << post << inner_pre << '\'';
-            serialize_string((*iter).first, ostr);
-            ostr << "':";
-            format_count += format_impl((*iter).second, ostr, options, level + 2);
+            ++end;
+        }
+        if (end == mEnd)
+        {
+            mCursor = mEnd;
+            return false;
+        }
+        if (*end == delim)
+        {
+            value = std::string_view((const char*)mCursor, end - mCursor);
+            mCursor = end + 1;
+            return true;
         }
-        ostr << post << pre << "}";
-        break;
-    }
 
-    case LLSD::TypeArray:
-    {
-        ostr << post << pre << "[";
-        bool need_comma = false;
-        LLSD::array_const_iterator iter = data.beginArray();
-        LLSD::array_const_iterator end = data.endArray();
-        for(; iter != end; ++iter)
+        scratch.assign((const char*)mCursor, end - mCursor);
+        mCursor = end;
+        while (!atEnd())
         {
-            if(need_comma) ostr << ",";
-            need_comma = true;
-            format_count += format_impl(*iter, ostr, options, level + 1);
+            char c = (char)*mCursor++;
+            if (c == delim)
+            {
+                value = scratch;
+                return true;
+            }
+            if (c != '\\')
+            {
+                scratch.push_back(c);
+                continue;
+            }
+            if (atEnd())
+            {
+                break;
+            }
+            c = (char)*mCursor++;
+            switch (c)
+            {
+            case 'a':
+                scratch.push_back('\a');
+                break;
+            case 'b':
+                scratch.push_back('\b');
+                break;
+            case 'f':
+                scratch.push_back('\f');
+                break;
+            case 'n':
+                scratch.push_back('\n');
+                break;
+            case 'r':
+                scratch.push_back('\r');
+                break;
+            case 't':
+                scratch.push_back('\t');
+                break;
+            case 'v':
+                scratch.push_back('\v');
+                break;
+            case 'x':
+                if (remaining() < 2)
+                {
+                    mCursor = mEnd;
+                    return false;
+                }
+                scratch.push_back((char)((hex_as_nybble(mCursor[0]) << 4) | hex_as_nybble(mCursor[1])));
+                mCursor += 2;
+                break;
+            default:
+                scratch.push_back(c);
+                break;
+            }
         }
-        ostr << "]";
-        break;
+        return false;
     }
 
-    case LLSD::TypeUndefined:
-        ostr << "!";
-        break;
-
-    case LLSD::TypeBoolean:
-        if(mBoolAlpha ||
-#if( LL_WINDOWS || __GNUC__ > 2)
-           (ostr.flags() & std::ios::boolalpha)
-#else
-           (ostr.flags() & 0x0100)
-#endif
-            )
+    bool readDelimited(int delim, std::string& value)
+    {
+        std::string_view view;
+        if (!readDelimited(delim, value, view))
         {
-            ostr << (data.asBoolean()
-                     ? NOTATION_TRUE_SERIAL : NOTATION_FALSE_SERIAL);
+            return false;
         }
-        else
+        if (view.data() != value.data())
         {
-            ostr << (data.asBoolean() ? 1 : 0);
+            value.assign(view);
         }
-        break;
+        return true;
+    }
 
-    case LLSD::TypeInteger:
-        ostr << "i" << data.asInteger();
-        break;
+    const U8* mCursor;
+    const U8* mEnd;
+};
 
-    case LLSD::TypeReal:
-        ostr << "r";
-        if(mRealFormat.empty())
+class LLSDBinaryBufferParser : public LLSDBufferReader
+{
+public:
+    using LLSDBufferReader::LLSDBufferReader;
+
+    S32 parse(LLSD& data, S32 max_depth);
+
+private:
+    S32 parseMap(LLSD& map, S32 max_depth);
+    S32 parseArray(LLSD& array, S32 max_depth);
+
+    bool readSize(U32& size)
+    {
+        U32 size_nbo = 0;
+        if (!readBytes(&size_nbo, sizeof(U32)))
         {
-            ostr << data.asReal();
+            return false;
         }
-        else
+        size = ntohl(size_nbo);
+        return true;
+    }
+
+    // 4 byte size + raw bytes, as written by LLSDBinaryFormatter
+    bool readSized(std::string_view& value)
+    {
+        U32 size = 0;
+        if (!readSize(size) || size > remaining())
         {
-            formatReal(data.asReal(), ostr);
+            return false;
         }
+        value = std::string_view((const char*)mCursor, size);
+        mCursor += size;
+        return true;
+    }
+};
+
+S32 LLSDBinaryBufferParser::parse(LLSD& data, S32 max_depth)
+{
+    if (atEnd())
+    {
+        return 0;
+    }
+    int c = get();
+    if (max_depth == 0)
+    {
+        return LLSDParser::PARSE_FAILURE;
+    }
+    S32 parse_count = 1;
+    bool ok = true;
+    switch (c)
+    {
+    case '{':
+    {
+        S32 child_count = parseMap(data, max_depth - 1);
+        ok = (child_count != LLSDParser::PARSE_FAILURE);
+        parse_count += child_count;
         break;
+    }
 
-    case LLSD::TypeUUID:
-        ostr << "u" << data.asUUID();
+    case '[':
+    {
+        S32 child_count = parseArray(data, max_depth - 1);
+        ok = (child_count != LLSDParser::PARSE_FAILURE);
+        parse_count += child_count;
         break;
+    }
 
-    case LLSD::TypeString:
-        ostr << '\'';
-        serialize_string(data.asStringRef(), ostr);
-        ostr << '\'';
+    case '!':
+        data.clear();
         break;
 
-    case LLSD::TypeDate:
+    case '0':
+        data = false;
+        break;
+
+    case '1':
+        data = true;
+        break;
+
+    case 'i':
+    {
+        U32 value = 0;
+        ok = readSize(value);
+        data = (S32)value;
+        break;
+    }
+
+    case 'r':
+    {
+        F64 real_nbo = 0.0;
+        ok = readBytes(&real_nbo, sizeof(F64));
+        data = ll_ntohd(real_nbo);
+        break;
+    }
+
+    case 'u':
+    {
+        LLUUID id;
+        ok = readBytes(id.mData, UUID_BYTES);
+        data = id;
+        break;
+    }
+
+    case '\'':
+    case '"':
+    {
+        std::string value;
+        ok = readDelimited(c, value);
+        data = std::move(value);
+        break;
+    }
+
+    case 's':
+    {
+        std::string_view value;
+        ok = readSized(value);
+        data = std::string(value);
+        break;
+    }
+
+    case 'l':
+    {
+        std::string_view value;
+        ok = readSized(value);
+        data = LLURI(std::string(value));
+        break;
+    }
+
+    case 'd':
+    {
+        F64 real = 0.0;
+        ok = readBytes(&real, sizeof(F64));
+        data = LLDate(real);
+        break;
+    }
+
+    case 'b':
+    {
+        std::string_view value;
+        ok = readSized(value);
+        data = LLSD::Binary(value.begin(), value.end());
+        break;
+    }
+
+    default:
+        ok = false;
+        LL_INFOS() << "Unrecognized character while parsing: int(" << c
+            << ")" << LL_ENDL;
+        break;
+    }
+    if (!ok)
+    {
+        data.clear();
+        return LLSDParser::PARSE_FAILURE;
+    }
+    return parse_count;
+}
+
+S32 LLSDBinaryBufferParser::parseMap(LLSD& map, S32 max_depth)
+{
+    map = LLSD::emptyMap();
+    U32 size = 0;
+    // every entry takes at least a key byte and a value byte
+    if (!readSize(size) || size > remaining() / 2)
+    {
+        return LLSDParser::PARSE_FAILURE;
+    }
+    S32 parse_count = 0;
+    std::string scratch;
+    for (U32 count = 0; count < size; ++count)
+    {
+        std::string_view name;
+        int c = get();
+        switch (c)
+        {
+        case 'k':
+            if (!readSized(name))
+            {
+                return LLSDParser::PARSE_FAILURE;
+            }
+            break;
+        case '\'':
+        case '"':
+            if (!readDelimited(c, scratch, name))
+            {
+                return LLSDParser::PARSE_FAILURE;
+            }
+            break;
+        default:
+            return LLSDParser::PARSE_FAILURE;
+        }
+        LLSD child;
+        S32 child_count = parse(child, max_depth);
+        if (child_count <= 0)
+        {
+            // There must be a value for every key.
+            return LLSDParser::PARSE_FAILURE;
+        }
+        parse_count += child_count;
+        map.insert(name, child);
+    }
+    if (get() != '}')
+    {
+        return LLSDParser::PARSE_FAILURE;
+    }
+    return parse_count;
+}
+
+S32 LLSDBinaryBufferParser::parseArray(LLSD& array, S32 max_depth)
+{
+    array = LLSD::emptyArray();
+    U32 size = 0;
+    if (!readSize(size) || size > remaining())
+    {
+        return LLSDParser::PARSE_FAILURE;
+    }
+    S32 parse_count = 0;
+    if (size)
+    {
+        // size the array once and decode the elements in place
+        array[size - 1];
+    }
+    for (U32 count = 0; count < size; ++count)
+    {
+        S32 child_count = parse(array[count], max_depth);
+        if (child_count <= 0)
+        {
+            return LLSDParser::PARSE_FAILURE;
+        }
+        parse_count += child_count;
+    }
+    if (get() != ']')
+    {
+        return LLSDParser::PARSE_FAILURE;
+    }
+    return parse_count;
+}
+
+class LLSDNotationBufferParser : public LLSDBufferReader
+{
+public:
+    using LLSDBufferReader::LLSDBufferReader;
+
+    S32 parse(LLSD& data, S32 max_depth);
+
+private:
+    S32 parseMap(LLSD& map, S32 max_depth);
+    S32 parseArray(LLSD& array, S32 max_depth);
+    bool parseBinary(LLSD& data);
+    bool parseInteger(S32& value);
+    bool parseReal(F64& value);
+    bool parseUUID(LLUUID& value);
+
+    // See deserialize_boolean(): the first character has been consumed
+    bool parseBoolean(const std::string& compare)
+    {
+        size_t ii = 0;
+        while (++ii < compare.size() && !atEnd() && tolower(*mCursor) == compare[ii])
+        {
+            ++mCursor;
+        }
+        return ii == compare.size();
+    }
+
+    // s(len)"raw", once the 's' has been consumed
+    bool readRaw(std::string_view& value);
+
+    // "string", 'string' or s(len)"raw", once the first character has
+    // been consumed
+    bool readString(int c, std::string& scratch, std::string_view& value)
+    {
+        if (c == 's')
+        {
+            return readRaw(value);
+        }
+        return readDelimited(c, scratch, value);
+    }
+};
+
+S32 LLSDNotationBufferParser::parse(LLSD& data, S32 max_depth)
+{
+    if (max_depth == 0)
+    {
+        return LLSDParser::PARSE_FAILURE;
+    }
+    skipSpace();
+    if (atEnd())
+    {
+        return 0;
+    }
+    S32 parse_count = 1;
+    bool ok = true;
+    int c = *mCursor;
+    switch (c)
+    {
+    case '{':
+    {
+        S32 child_count = parseMap(data, max_depth - 1);
+        ok = (child_count != LLSDParser::PARSE_FAILURE);
+        parse_count += child_count;
+        break;
+    }
+
+    case '[':
+    {
+        S32 child_count = parseArray(data, max_depth - 1);
+        ok = (child_count != LLSDParser::PARSE_FAILURE);
+        parse_count += child_count;
+        break;
+    }
+
+    case '!':
+        ++mCursor;
+        data.clear();
+        break;
+
+    case '0':
+        ++mCursor;
+        data = false;
+        break;
+
+    case '1':
+        ++mCursor;
+        data = true;
+        break;
+
+    case 'F':
+    case 'f':
+        ++mCursor;
+        ok = !isalpha(peek()) || parseBoolean(NOTATION_FALSE_SERIAL);
+        data = false;
+        break;
+
+    case 'T':
+    case 't':
+        ++mCursor;
+        ok = !isalpha(peek()) || parseBoolean(NOTATION_TRUE_SERIAL);
+        data = true;
+        break;
+
+    case 'i':
+    {
+        ++mCursor;
+        S32 integer = 0;
+        ok = parseInteger(integer);
+        data = integer;
+        break;
+    }
+
+    case 'r':
+    {
+        ++mCursor;
+        F64 real = 0.0;
+        ok = parseReal(real);
+        data = real;
+        break;
+    }
+
+    case 'u':
+    {
+        ++mCursor;
+        LLUUID id;
+        ok = parseUUID(id);
+        data = id;
+        break;
+    }
+
+    case '\"':
+    case '\'':
+    case 's':
+    {
+        ++mCursor;
+        std::string scratch;
+        std::string_view value;
+        ok = readString(c, scratch, value);
+        if (ok)
+        {
+            data = (value.data() == scratch.data()) ? std::move(scratch) : std::string(value);
+        }
+        break;
+    }
+
+    case 'l':
+    case 'd':
+    {
+        ++mCursor;
+        std::string str;
+        int delim = get();
+        ok = (delim != EOF) && readDelimited(delim, str);
+        if (ok)
+        {
+            data = (c == 'l') ? LLSD(LLURI(str)) : LLSD(LLDate(str));
+        }
+        break;
+    }
+
+    case 'b':
+        ok = parseBinary(data);
+        break;
+
+    default:
+        ok = false;
+        LL_INFOS() << "Unrecognized character while parsing: int(" << c
+            << ")" << LL_ENDL;
+        break;
+    }
+    if (!ok)
+    {
+        data.clear();
+        return LLSDParser::PARSE_FAILURE;
+    }
+    return parse_count;
+}
+
+S32 LLSDNotationBufferParser::parseMap(LLSD& map, S32 max_depth)
+{
+    // map: { string:object, string:object }
+    map = LLSD::emptyMap();
+    ++mCursor; // '{'
+    S32 parse_count = 0;
+    bool found_name = false;
+    std::string scratch;
+    std::string_view name;
+    int c = get();
+    while (c != '}' && c != EOF)
+    {
+        if (!found_name)
+        {
+            // eat commas, white
+            if ((c == '\"') || (c == '\'') || (c == 's'))
+            {
+                if (!readString(c, scratch, name))
+                {
+                    return LLSDParser::PARSE_FAILURE;
+                }
+                found_name = true;
+            }
+            c = get();
+        }
+        else
+        {
+            if (isspace(c) || (c == ':'))
+            {
+                c = get();
+                continue;
+            }
+            --mCursor;
+            LLSD child;
+            S32 count = parse(child, max_depth);
+            if (count <= 0)
+            {
+                // There must be a value for every key.
+                return LLSDParser::PARSE_FAILURE;
+            }
+            parse_count += count;
+            map.insert(name, child);
+            found_name = false;
+            c = get();
+        }
+    }
+    if (c != '}')
+    {
+        map.clear();
+        return LLSDParser::PARSE_FAILURE;
+    }
+    return parse_count;
+}
+
+S32 LLSDNotationBufferParser::parseArray(LLSD& array, S32 max_depth)
+{
+    // array: [ object, object, object ]
+    array = LLSD::emptyArray();
+    ++mCursor; // '['
+    S32 parse_count = 0;
+    int c = get();
+    while (c != ']' && c != EOF)
+    {
+        // eat commas, white
+        if (isspace(c) || (c == ','))
+        {
+            c = get();
+            continue;
+        }
+        --mCursor;
+        S32 count = parse(array.append(LLSD()), max_depth);
+        if (count <= 0)
+        {
+            return LLSDParser::PARSE_FAILURE;
+        }
+        parse_count += count;
+        c = get();
+    }
+    if (c != ']')
+    {
+        return LLSDParser::PARSE_FAILURE;
+    }
+    return parse_count;
+}
+
+bool LLSDNotationBufferParser::readRaw(std::string_view& value)
+{
+    // (len)"raw data"
+    if (get() != '(')
+    {
+        return false;
+    }
+    char len_buf[MAX_HDR_LEN];      /* Flawfinder: ignore */
+    size_t digits = 0;
+    while (!atEnd() && *mCursor != ')' && digits < MAX_HDR_LEN - 1)
+    {
+        len_buf[digits++] = (char)*mCursor++;
+    }
+    len_buf[digits] = '\0';
+    if (get() != ')')
+    {
+        return false;
+    }
+    int c = get();
+    if ((c != '"') && (c != '\''))
+    {
+        return false;
+    }
+    auto len = strtol(len_buf, NULL, 0);
+    if (len < 0 || (size_t)len > remaining())
+    {
+        return false;
+    }
+    value = std::string_view((const char*)mCursor, len);
+    mCursor += len;
+    c = get();
+    return (c == '"') || (c == '\'');
+}
+
+bool LLSDNotationBufferParser::parseBinary(LLSD& data)
+{
+    // binary: b##"ff3120ab1"
+    // or: b(len)"..."
+    const U8* quote = mCursor;
+    const U8* header_end = mCursor + llmin(remaining(), (size_t)255);
+    while (quote < header_end && *quote != '"')
+    {
+        ++quote;
+    }
+    if (quote == header_end)
+    {
+        return false;
+    }
+    std::string header((const char*)mCursor, quote - mCursor);
+    mCursor = quote + 1;
+
+    if (0 == header.compare(0, 2, "b("))
+    {
+        auto len = strtol(header.c_str() + 2, NULL, 0);
+        if (len < 0 || (size_t)len > remaining())
+        {
+            return false;
+        }
+        data = LLSD::Binary(mCursor, mCursor + len);
+        mCursor += len;
+        get(); // strip off the trailing double-quote
+        return true;
+    }
+
+    const U8* end = (const U8*)memchr(mCursor, '"', remaining());
+    if (!end)
+    {
+        return false;
+    }
+    if (0 == header.compare(0, 3, "b64"))
+    {
+        data = LLBase64::decode((const char*)mCursor, end - mCursor);
+    }
+    else if (0 == header.compare(0, 3, "b16"))
+    {
+        LLSD::Binary value;
+        value.reserve((end - mCursor) / 2);
+        for (const U8* read = mCursor; read < end; read += 2)
+        {
+            U8 byte = hex_as_nybble(read[0]) << 4;
+            if (read + 1 < end)
+            {
+                byte |= hex_as_nybble(read[1]);
+            }
+            value.push_back(byte);
+        }
+        data = std::move(value);
+    }
+    else
+    {
+        return false;
+    }
+    mCursor = end + 1;
+    return true;
+}
+
+bool LLSDNotationBufferParser::parseInteger(S32& value)
+{
+    skipSpace();
+    const U8* read = mCursor;
+    bool negative = false;
+    if (read < mEnd && (*read == '-' || *read == '+'))
+    {
+        negative = (*read++ == '-');
+    }
+    const U8* digits = read;
+    S64 integer = 0;
+    while (read < mEnd && isdigit(*read))
+    {
+        integer = integer * 10 + (*read++ - '0');
+        if (integer > (S64)S32_MAX + 1)
+        {
+            return false;
+        }
+    }
+    if (read == digits)
+    {
+        return false;
+    }
+    integer = negative ? -integer : integer;
+    if (integer > S32_MAX || integer < S32_MIN)
+    {
+        return false;
+    }
+    value = (S32)integer;
+    mCursor = read;
+    return true;
+}
+
+bool LLSDNotationBufferParser::parseReal(F64& value)
+{
+    skipSpace();
+    // strtod() needs a terminated string and would accept more than
+    // istream >> double does (hex, "inf", "nan"): copy the characters of
+    // a decimal real only.
+    char buf[64];       /* Flawfinder: ignore */
+    size_t len = 0;
+    while (len < sizeof(buf) - 1 && mCursor + len < mEnd)
+    {
+        char c = (char)mCursor[len];
+        if (!isdigit(c) && c != '-' && c != '+' && c != '.' && c != 'e' && c != 'E')
+        {
+            break;
+        }
+        buf[len++] = c;
+    }
+    buf[len] = '\0';
+    // LLLocale may have switched LC_ALL, istream >> double is unaffected
+    char* end = nullptr;
+    value = ll_strtod_c_locale(buf, &end);
+    if (end == buf)
+    {
+        return false;
+    }
+    mCursor += end - buf;
+    return true;
+}
+
+bool LLSDNotationBufferParser::parseUUID(LLUUID& value)
+{
+    // see operator>>(std::istream&, LLUUID&)
+    char uuid_str[UUID_STR_LENGTH];     /* Flawfinder: ignore */
+    for (U32 i = 0; i < UUID_STR_LENGTH - 1; ++i)
+    {
+        skipSpace();
+        if (atEnd())
+        {
+            return false;
+        }
+        uuid_str[i] = (char)*mCursor++;
+    }
+    uuid_str[UUID_STR_LENGTH - 1] = '\0';
+    value.set(uuid_str);
+    return true;
+}
+
+} // anonymous namespace
+
+S32 LLSDNotationParser::doParseBuffer(const U8* buf, size_t size, LLSD& data, S32 max_depth) const
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
+    LLSDNotationBufferParser parser(buf, size);
+    return parser.parse(data, max_depth);
+}
+
+S32 LLSDBinaryParser::doParseBuffer(const U8* buf, size_t size, LLSD& data, S32 max_depth) const
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
+    LLSDBinaryBufferParser parser(buf, size);
+    return parser.parse(data, max_depth);
+}
+
+
+/**
+ * LLSDFormatter
+ */
+LLSDFormatter::LLSDFormatter(bool boolAlpha, const std::string& realFmt, EFormatterOptions options):
+    mOptions(options)
+{
+    boolalpha(boolAlpha);
+    realFormat(realFmt);
+}
+
+// virtual
+LLSDFormatter::~LLSDFormatter()
+{ }
+
+void LLSDFormatter::boolalpha(bool alpha)
+{
+    mBoolAlpha = alpha;
+}
+
+void LLSDFormatter::realFormat(const std::string& format)
+{
+    mRealFormat = format;
+}
+
+S32 LLSDFormatter::format(const LLSD& data, std::ostream& ostr) const
+{
+    // pass options captured by constructor
+    return format(data, ostr, mOptions);
+}
+
+S32 LLSDFormatter::format(const LLSD& data, std::ostream& ostr, EFormatterOptions options) const
+{
+    return format_impl(data, ostr, options, 0);
+}
+
+void LLSDFormatter::formatReal(LLSD::Real real, std::ostream& ostr) const
+{
+    std::string buffer = llformat(mRealFormat.c_str(), real);
+    ostr << buffer;
+}
+
+/**
+ * LLSDNotationFormatter
+ */
+LLSDNotationFormatter::LLSDNotationFormatter(bool boolAlpha, const std::string& realFormat,
+                                             EFormatterOptions options):
+    LLSDFormatter(boolAlpha, realFormat, options)
+{
+}
+
+// virtual
+LLSDNotationFormatter::~LLSDNotationFormatter()
+{ }
+
+// static
+std::string LLSDNotationFormatter::escapeString(const std::string& in)
+{
+    std::ostringstream ostr;
+    serialize_string(in, ostr);
+    return ostr.str();
+}
+
+S32 LLSDNotationFormatter::format_impl(const LLSD& data, std::ostream& ostr,
+                                       EFormatterOptions options, U32 level) const
+{
+    S32 format_count = 1;
+    std::string pre;
+    std::string post;
+
+    if (options & LLSDFormatter::OPTIONS_PRETTY)
+    {
+        for (U32 i = 0; i < level; i++)
+        {
+            pre += "    ";
+        }
+        post = "\n";
+    }
+
+    switch(data.type())
+    {
+    case LLSD::TypeMap:
+    {
+        if (0 != level) ostr << post << pre;
+        ostr << "{";
+        std::string inner_pre;
+        if (options & LLSDFormatter::OPTIONS_PRETTY)
+        {
+            inner_pre = pre + "    ";
+        }
+
+        bool need_comma = false;
+        LLSD::map_const_iterator iter = data.beginMap();
+        LLSD::map_const_iterator end = data.endMap();
+        for(; iter != end; ++iter)
+        {
+            if(need_comma) ostr << ",";
+            need_comma = true;
+            ostr << post << inner_pre << '\'';
+            serialize_string((*iter).first, ostr);
+            ostr << "':";
+            format_count += format_impl((*iter).second, ostr, options, level + 2);
+        }
+        ostr << post << pre << "}";
+        break;
+    }
+
+    case LLSD::TypeArray:
+    {
+        ostr << post << pre << "[";
+        bool need_comma = false;
+        LLSD::array_const_iterator iter = data.beginArray();
+        LLSD::array_const_iterator end = data.endArray();
+        for(; iter != end; ++iter)
+        {
+            if(need_comma) ostr << ",";
+            need_comma = true;
+            format_count += format_impl(*iter, ostr, options, level + 1);
+        }
+        ostr << "]";
+        break;
+    }
+
+    case LLSD::TypeUndefined:
+        ostr << "!";
+        break;
+
+    case LLSD::TypeBoolean:
+        if(mBoolAlpha ||
+#if( LL_WINDOWS || __GNUC__ > 2)
+           (ostr.flags() & std::ios::boolalpha)
+#else
+           (ostr.flags() & 0x0100)
+#endif
+            )
+        {
+            ostr << (data.asBoolean()
+                     ? NOTATION_TRUE_SERIAL : NOTATION_FALSE_SERIAL);
+        }
+        else
+        {
+            ostr << (data.asBoolean() ? 1 : 0);
+        }
+        break;
+
+    case LLSD::TypeInteger:
+        ostr << "i" << data.asInteger();
+        break;
+
+    case LLSD::TypeReal:
+        ostr << "r";
+        if(mRealFormat.empty())
+        {
+            ostr << data.asReal();
+        }
+        else
+        {
+            formatReal(data.asReal(), ostr);
+        }
+        break;
+
+    case LLSD::TypeUUID:
+        ostr << "u" << data.asUUID();
+        break;
+
+    case LLSD::TypeString:
+        ostr << '\'';
+        serialize_string(data.asStringRef(), ostr);
+        ostr << '\'';
+        break;
+
+    case LLSD::TypeDate:
         ostr << "d\"" << data.asDate() << "\"";
         break;
 
@@ -2340,9 +3264,7 @@ LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, const U8* in, S32
     {
         char* result_ptr = strip_deprecated_header((char*)result, cur_size);
 
-        boost::iostreams::stream<boost::iostreams::array_source> istrm(result_ptr, cur_size);
-
-        if (!LLSDSerialize::fromBinary(data, istrm, cur_size, UNZIP_LLSD_MAX_DEPTH))
+        if (!LLSDSerialize::fromBinary(data, (const U8*)result_ptr, cur_size, UNZIP_LLSD_MAX_DEPTH))
         {
             // free(result);
             if( result )
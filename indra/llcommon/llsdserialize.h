@@ -85,6 +85,22 @@ public:
      */
     S32 parseLines(std::istream& istr, LLSD& data);
 
+    /**
+     * @brief Parse one structured data object out of a contiguous buffer.
+     *
+     * The binary and notation parsers decode straight from memory, with
+     * bounds checks, and the XML parser hands the whole buffer to expat,
+     * instead of going through an istream.
+     * @param buf The buffer. It may hold more than one object.
+     * @param size The size of the buffer.
+     * @param data[out] The newly parsed structured data.
+     * @param max_depth Max depth parser will check before exiting
+     *  with parse error, -1 - unlimited.
+     * @return Returns the number of LLSD objects parsed into
+     * data. Returns PARSE_FAILURE (-1) on parse failure.
+     */
+    S32 parseBuffer(const U8* buf, size_t size, LLSD& data, S32 max_depth = -1);
+
     /**
      * @brief Resets the parser so parse() or parseLines() can be called again for another <llsd> chunk.
      */
@@ -110,6 +126,12 @@ protected:
      */
     virtual S32 doParse(std::istream& istr, LLSD& data, S32 max_depth = -1) const = 0;
 
+    /**
+     * @brief Virtual default function for parsing a contiguous buffer,
+     * which wraps it in a stream and calls doParse().
+     */
+    virtual S32 doParseBuffer(const U8* buf, size_t size, LLSD& data, S32 max_depth) const;
+
     /**
      * @brief Virtual default function for resetting the parser
      */
@@ -250,6 +272,11 @@ protected:
      */
     virtual S32 doParse(std::istream& istr, LLSD& data, S32 max_depth = -1) const;
 
+    /**
+     * @brief Decode a buffer in place, see LLSDParser::parseBuffer()
+     */
+    virtual S32 doParseBuffer(const U8* buf, size_t size, LLSD& data, S32 max_depth) const;
+
 private:
     /**
      * @brief Parse a map from the istream
@@ -327,6 +354,12 @@ protected:
      */
     virtual S32 doParse(std::istream& istr, LLSD& data, S32 max_depth = -1) const;
 
+    /**
+     * @brief Feed the whole buffer to expat in one go. The buffer must
+     * hold a complete <llsd> element.
+     */
+    virtual S32 doParseBuffer(const U8* buf, size_t size, LLSD& data, S32 max_depth) const;
+
     /**
      * @brief Virtual default function for resetting the parser
      */
@@ -377,6 +410,11 @@ protected:
      */
     virtual S32 doParse(std::istream& istr, LLSD& data, S32 max_depth = -1) const;
 
+    /**
+     * @brief Decode a buffer in place, see LLSDParser::parseBuffer()
+     */
+    virtual S32 doParseBuffer(const U8* buf, size_t size, LLSD& data, S32 max_depth) const;
+
 private:
     /**
      * @brief Parse a map from the istream
@@ -758,6 +796,12 @@ public:
      */
     static bool deserialize(LLSD& sd, std::istream& str, llssize max_bytes);
 
+    /**
+     * @brief Same as above for data which is already in memory. Binary and
+     * notation data are decoded in place.
+     */
+    static bool deserialize(LLSD& sd, const U8* buf, size_t size);
+
     /*
      * Notation Methods
      */
@@ -790,6 +834,11 @@ public:
         (void)p->parse(str, sd, max_bytes);
         return sd;
     }
+    static S32 fromNotation(LLSD& sd, const U8* buf, size_t size)
+    {
+        LLPointer<LLSDNotationParser> p = new LLSDNotationParser;
+        return p->parseBuffer(buf, size, sd);
+    }
 
     /*
      * XML Methods
@@ -846,6 +895,11 @@ public:
         (void)p->parse(str, sd, max_bytes, max_depth);
         return sd;
     }
+    static S32 fromBinary(LLSD& sd, const U8* buf, size_t size, S32 max_depth = -1)
+    {
+        LLPointer<LLSDBinaryParser> p = new LLSDBinaryParser;
+        return p->parseBuffer(buf, size, sd, max_depth);
+    }
 };
 
 class LL_COMMON_API LLUZipHelper : public LLRefCount
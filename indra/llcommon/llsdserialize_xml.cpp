@@ -26,22 +26,11 @@
 
 #include "linden_common.h"
 #include "llsdserialize_xml.h"
+#include "llsdxmlreader.h"
 
 #include <iostream>
-#include <deque>
 
-#include "apr_base64.h"
-#include <boost/regex.hpp>
-#include <stack>
-
-extern "C"
-{
-#ifdef LL_USESYSTEMLIBS
-# include <expat.h>
-#else
-# include "expat/expat.h"
-#endif
-}
+#include "llbase64.h"
 
 /**
  * LLSDXMLFormatter
@@ -194,17 +183,8 @@ S32 LLSDXMLFormatter::format_impl(const LLSD& data, std::ostream& ostr,
         }
         else
         {
-            // *FIX: memory inefficient.
-            // *TODO: convert to use LLBase64
             ostr << pre << "<binary encoding=\"base64\">";
-            int b64_buffer_length = apr_base64_encode_len(narrow<size_t>(buffer.size()));
-            char* b64_buffer = new char[b64_buffer_length];
-            b64_buffer_length = apr_base64_encode_binary(
-                b64_buffer,
-                &buffer[0],
-                narrow<size_t>(buffer.size()));
-            ostr.write(b64_buffer, b64_buffer_length - 1);
-            delete[] b64_buffer;
+            ostr << LLBase64::encode(buffer.data(), buffer.size());
             ostr << "</binary>" << post;
         }
         break;
@@ -261,86 +241,61 @@ std::string LLSDXMLFormatter::escapeString(const std::string& in)
 
 
 
-class LLSDXMLParser::Impl
+/**
+ * LLSDXMLParser::Impl builds an LLSD tree out of the events of an
+ * LLSDXMLReader.
+ */
+class LLSDXMLParser::Impl : public LLSDXMLReader::Handler
 {
 public:
     Impl(bool emit_errors);
-    ~Impl();
 
     S32 parse(std::istream& input, LLSD& data);
     S32 parseLines(std::istream& input, LLSD& data);
+    S32 parseBuffer(const char* buf, size_t len, LLSD& data);
 
     void parsePart(const char *buf, llssize len);
 
     void reset();
 
 private:
-    void startElementHandler(const XML_Char* name, const XML_Char** attributes);
-    void endElementHandler(const XML_Char* name);
-    void characterDataHandler(const XML_Char* data, int length);
-
-    static void sStartElementHandler(
-        void* userData, const XML_Char* name, const XML_Char** attributes);
-    static void sEndElementHandler(
-        void* userData, const XML_Char* name);
-    static void sCharacterDataHandler(
-        void* userData, const XML_Char* data, int length);
-
-    void startSkipping();
-
-    enum Element {
-        ELEMENT_LLSD,
-        ELEMENT_UNDEF,
-        ELEMENT_BOOL,
-        ELEMENT_INTEGER,
-        ELEMENT_REAL,
-        ELEMENT_STRING,
-        ELEMENT_UUID,
-        ELEMENT_DATE,
-        ELEMENT_URI,
-        ELEMENT_BINARY,
-        ELEMENT_MAP,
-        ELEMENT_ARRAY,
-        ELEMENT_KEY,
-        ELEMENT_UNKNOWN
-    };
-    static Element readElement(const XML_Char* name);
-
-    static const XML_Char* findAttribute(const XML_Char* name, const XML_Char** pairs);
+    EAction mapKey(std::string_view key) override;
+    EAction mapBegin() override;
+    EAction mapEnd() override;
+    EAction arrayBegin() override;
+    EAction arrayEnd() override;
+    EAction undefValue() override;
+    EAction booleanValue(LLSD::Boolean value) override;
+    EAction integerValue(LLSD::Integer value) override;
+    EAction realValue(LLSD::Real value) override;
+    EAction stringValue(LLSD::String& value) override;
+    EAction uuidValue(const LLSD::UUID& value) override;
+    EAction dateValue(const LLSD::Date& value) override;
+    EAction uriValue(const LLSD::URI& value) override;
+    EAction binaryValue(LLSD::Binary& value) override;
+
+    // Where the value being reported goes: the result, the entry of the
+    // current key in the enclosing map or a new element of the enclosing
+    // array.
+    LLSD& newValue();
 
     bool mEmitErrors;
 
-    XML_Parser  mParser;
+    LLSDXMLReader mReader;
 
     LLSD mResult;
-    S32 mParseCount;
-
-    bool mInLLSDElement;            // true if we're on LLSD
-    bool mGracefullStop;            // true if we found the </llsd
 
-    typedef std::deque<LLSD*> LLSDRefStack;
+    typedef std::vector<LLSD*> LLSDRefStack;
     LLSDRefStack mStack;
-    std::stack< Element> mStackElements;
-
-    int mDepth;
-    bool mSkipping;
-    int mSkipThrough;
 
-    std::string mCurrentKey;        // Current XML <tag>
-    std::string mCurrentContent;    // String data between <tag> and </tag>
+    std::string mCurrentKey;
 };
 
 
 LLSDXMLParser::Impl::Impl(bool emit_errors)
-    : mEmitErrors(emit_errors)
+    : mEmitErrors(emit_errors),
+      mReader(*this)
 {
-    mParser = XML_ParserCreate(NULL);
-    reset();
-}
-
-LLSDXMLParser::Impl::~Impl()
-{
-    XML_ParserFree(mParser);
 }
 
 inline bool is_eol(char c)
@@ -373,59 +328,30 @@ static unsigned get_till_eol(std::istream& input, char *buf, unsigned bufsize)
 
 S32 LLSDXMLParser::Impl::parse(std::istream& input, LLSD& data)
 {
-    XML_Status status;
+    LLSDXMLReader::EStatus status = mReader.getStatus();
 
     static const int BUFFER_SIZE = 1024;
-    void* buffer = NULL;
-    int count = 0;
-    while (input.good() && !input.eof())
+    char buffer[BUFFER_SIZE + 1];
+    unsigned count = 0;
+    while (status == LLSDXMLReader::STATUS_OK && input.good() && !input.eof())
     {
-        buffer = XML_GetBuffer(mParser, BUFFER_SIZE);
-
-        /*
-         * If we happened to end our last buffer right at the end of the llsd, but the
-         * stream is still going we will get a null buffer here.  Check for mGracefullStop.
-         */
-        if (!buffer)
-        {
-            break;
-        }
-        count = get_till_eol(input, (char *)buffer, BUFFER_SIZE);
+        count = get_till_eol(input, buffer, BUFFER_SIZE);
         if (!count)
         {
             break;
         }
-        status = XML_ParseBuffer(mParser, count, false);
-
-        if (status == XML_STATUS_ERROR)
-        {
-            break;
-        }
+        status = mReader.feed(buffer, count, false);
     }
 
     // *FIX.: This code is buggy - if the stream was empty or not
-    // good, there is not buffer to parse, both the call to
-    // XML_ParseBuffer and the buffer manipulations are illegal
-    // futhermore, it isn't clear that the expat buffer semantics are
-    // preserved
-
-    status = XML_ParseBuffer(mParser, 0, true);
-    if (status == XML_STATUS_ERROR && !mGracefullStop)
+    // good, there is not buffer to parse
+    status = mReader.feed(NULL, 0, true);
+    if (status == LLSDXMLReader::STATUS_ERROR)
     {
-        if (buffer)
-        {
-            ((char*) buffer)[count ? count - 1 : 0] = '\0';
-            if (mEmitErrors)
-            {
-                LL_INFOS() << "LLSDXMLParser::Impl::parse: XML_STATUS_ERROR parsing:" << (char*)buffer << LL_ENDL;
-            }
-        }
-        else
+        if (mEmitErrors)
         {
-            if (mEmitErrors)
-            {
-                LL_INFOS() << "LLSDXMLParser::Impl::parse: XML_STATUS_ERROR, null buffer" << LL_ENDL;
-            }
+            buffer[count ? count - 1 : 0] = '\0';
+            LL_INFOS() << "LLSDXMLParser::Impl::parse: XML_STATUS_ERROR parsing:" << buffer << LL_ENDL;
         }
         data = LLSD();
         return LLSDParser::PARSE_FAILURE;
@@ -433,46 +359,30 @@ S32 LLSDXMLParser::Impl::parse(std::istream& input, LLSD& data)
 
     clear_eol(input);
     data = mResult;
-    return mParseCount;
+    return mReader.getValueCount();
 }
 
 
 S32 LLSDXMLParser::Impl::parseLines(std::istream& input, LLSD& data)
 {
-    XML_Status status = XML_STATUS_OK;
+    LLSDXMLReader::EStatus status = mReader.getStatus();
 
     data = LLSD();
 
     static const int BUFFER_SIZE = 1024;
-
-    //static char last_buffer[ BUFFER_SIZE ];
-    //std::streamsize last_num_read;
+    char buffer[BUFFER_SIZE];
 
     // Must get rid of any leading \n, otherwise the stream gets into an error/eof state
     clear_eol(input);
 
-    while( !mGracefullStop
+    while (status == LLSDXMLReader::STATUS_OK
         && input.good()
         && !input.eof())
     {
-        void* buffer = XML_GetBuffer(mParser, BUFFER_SIZE);
-        /*
-         * If we happened to end our last buffer right at the end of the llsd, but the
-         * stream is still going we will get a null buffer here.  Check for mGracefullStop.
-         * -- I don't think this is actually true - zero 2008-05-09
-         */
-        if (!buffer)
-        {
-            break;
-        }
-
         // Get one line
-        input.getline((char*)buffer, BUFFER_SIZE);
+        input.getline(buffer, BUFFER_SIZE);
         std::streamsize num_read = input.gcount();
 
-        //memcpy( last_buffer, buffer, num_read );
-        //last_num_read = num_read;
-
         if ( num_read > 0 )
         {
             if (!input.good() )
@@ -481,28 +391,21 @@ S32 LLSDXMLParser::Impl::parseLines(std::istream& input, LLSD& data)
             }
 
             // Re-insert with the \n that was absorbed by getline()
-            char * text = (char *) buffer;
-            if ( text[num_read - 1] == 0)
+            if ( buffer[num_read - 1] == 0)
             {
-                text[num_read - 1] = '\n';
+                buffer[num_read - 1] = '\n';
             }
         }
 
-        status = XML_ParseBuffer(mParser, (int)num_read, false);
-        if (status == XML_STATUS_ERROR)
-        {
-            break;
-        }
+        status = mReader.feed(buffer, (size_t)num_read, false);
     }
 
-    if (status != XML_STATUS_ERROR
-        && !mGracefullStop)
+    if (status == LLSDXMLReader::STATUS_OK)
     {   // Parse last bit
-        status = XML_ParseBuffer(mParser, 0, true);
+        status = mReader.feed(NULL, 0, true);
     }
 
-    if (status == XML_STATUS_ERROR
-        && !mGracefullStop)
+    if (status == LLSDXMLReader::STATUS_ERROR)
     {
         if (mEmitErrors)
         {
@@ -513,436 +416,150 @@ S32 LLSDXMLParser::Impl::parseLines(std::istream& input, LLSD& data)
 
     clear_eol(input);
     data = mResult;
-    return mParseCount;
+    return mReader.getValueCount();
+}
+
+S32 LLSDXMLParser::Impl::parseBuffer(const char* buf, size_t len, LLSD& data)
+{
+    // The whole document is there: unlike the stream parsers, which
+    // trip over the end of the stream, a document without </llsd> fails
+    // here explicitly.
+    if (mReader.feed(buf, len, true) != LLSDXMLReader::STATUS_DONE)
+    {
+        if (mEmitErrors)
+        {
+            LL_INFOS() << "LLSDXMLParser::Impl::parseBuffer: incomplete or malformed LLSD" << LL_ENDL;
+        }
+        data = LLSD();
+        return LLSDParser::PARSE_FAILURE;
+    }
+    data = mResult;
+    return mReader.getValueCount();
 }
 
 
 void LLSDXMLParser::Impl::reset()
 {
     mResult.clear();
-    mParseCount = 0;
-
-    mInLLSDElement = false;
-    mDepth = 0;
-
-    mGracefullStop = false;
-
     mStack.clear();
-    while( !mStackElements.empty() )
-        mStackElements.pop();
-
-    mSkipping = false;
-
     mCurrentKey.clear();
-
-    XML_ParserReset(mParser, "utf-8");
-    XML_SetUserData(mParser, this);
-    XML_SetElementHandler(mParser, sStartElementHandler, sEndElementHandler);
-    XML_SetCharacterDataHandler(mParser, sCharacterDataHandler);
+    mReader.reset();
 }
 
 
-void LLSDXMLParser::Impl::startSkipping()
-{
-    mSkipping = true;
-    mSkipThrough = mDepth;
-}
-
-const XML_Char*
-LLSDXMLParser::Impl::findAttribute(const XML_Char* name, const XML_Char** pairs)
-{
-    while (NULL != pairs && NULL != *pairs)
-    {
-        if(0 == strcmp(name, *pairs))
-        {
-            return *(pairs + 1);
-        }
-        pairs += 2;
-    }
-    return NULL;
-}
-
 void LLSDXMLParser::Impl::parsePart(const char* buf, llssize len)
 {
     if ( buf != NULL
         && len > 0 )
     {
-        XML_Status status = XML_Parse(mParser, buf, (int)len, 0);
-        if (status == XML_STATUS_ERROR)
+        if (mReader.feed(buf, (size_t)len, false) == LLSDXMLReader::STATUS_ERROR)
         {
             LL_INFOS() << "Unexpected XML parsing error at start" << LL_ENDL;
         }
     }
 }
 
-// Performance testing code
-//#define   XML_PARSER_PERFORMANCE_TESTS
-
-#ifdef XML_PARSER_PERFORMANCE_TESTS
-
-extern U64 totalTime();
-U64 readElementTime = 0;
-U64 startElementTime = 0;
-U64 endElementTime = 0;
-U64 charDataTime = 0;
-U64 parseTime = 0;
-
-class XML_Timer
-{
-public:
-    XML_Timer( U64 * sum ) : mSum( sum )
-    {
-        mStart = totalTime();
-    }
-    ~XML_Timer()
-    {
-        *mSum += (totalTime() - mStart);
-    }
-
-    U64 * mSum;
-    U64 mStart;
-};
-#endif // XML_PARSER_PERFORMANCE_TESTS
-
-void LLSDXMLParser::Impl::startElementHandler(const XML_Char* name, const XML_Char** attributes)
+LLSD& LLSDXMLParser::Impl::newValue()
 {
-    #ifdef XML_PARSER_PERFORMANCE_TESTS
-    XML_Timer timer( &startElementTime );
-    #endif // XML_PARSER_PERFORMANCE_TESTS
-
-    ++mDepth;
-    if (mSkipping)
-    {
-        return;
-    }
-
-    Element element = readElement(name);
-    mStackElements.push( element );
-    mCurrentContent.clear();
-
-    switch (element)
-    {
-        case ELEMENT_LLSD:
-            if (mInLLSDElement)
-            {
-                mStackElements.pop();
-                return startSkipping();
-            }
-            mInLLSDElement = true;
-            return;
-
-        case ELEMENT_KEY:
-            if (mStack.empty()  ||  !(mStack.back()->isMap()))
-            {
-                mStackElements.pop();
-                return startSkipping();
-            }
-            return;
-
-        case ELEMENT_BINARY:
-        {
-            const XML_Char* encoding = findAttribute("encoding", attributes);
-            if(encoding && strcmp("base64", encoding) != 0)
-            {
-                mStackElements.pop();
-                return startSkipping();
-            }
-            break;
-        }
-
-        default:
-            // all rest are values, fall through
-            ;
-    }
-
-
-    if (!mInLLSDElement)
-    {
-        mStackElements.pop();
-        return startSkipping();
-    }
-
     if (mStack.empty())
     {
-        mStack.push_back(&mResult);
-    }
-    else if (mStack.back()->isMap())
-    {
-        if (mCurrentKey.empty())
-        {
-            mStackElements.pop();
-            return startSkipping();
-        }
-
-        LLSD& map = *mStack.back();
-        LLSD& newElement = map[mCurrentKey];
-        mStack.push_back(&newElement);
-
-        mCurrentKey.clear();
+        return mResult;
     }
-    else if (mStack.back()->isArray())
+    LLSD& container = *mStack.back();
+    if (container.isMap())
     {
-        LLSD& array = *mStack.back();
-        array.append(LLSD());
-        LLSD& newElement = array[array.size()-1];
-        mStack.push_back(&newElement);
-    }
-    else {
-        // improperly nested value in a non-structure
-        mStackElements.pop();
-        return startSkipping();
-    }
-
-    ++mParseCount;
-    switch (element)
-    {
-        case ELEMENT_MAP:
-            *mStack.back() = LLSD::emptyMap();
-            break;
-
-        case ELEMENT_ARRAY:
-            *mStack.back() = LLSD::emptyArray();
-            break;
-
-        default:
-            // all the other values will be set in the end element handler
-            ;
+        return container[mCurrentKey];
     }
+    return container.append(LLSD());
 }
 
-void LLSDXMLParser::Impl::endElementHandler(const XML_Char* name)
+LLSDXMLReader::Handler::EAction LLSDXMLParser::Impl::mapKey(std::string_view key)
 {
-    #ifdef XML_PARSER_PERFORMANCE_TESTS
-    XML_Timer timer( &endElementTime );
-    #endif // XML_PARSER_PERFORMANCE_TESTS
-
-    --mDepth;
-    if (mSkipping)
-    {
-        if (mDepth < mSkipThrough)
-        {
-            mSkipping = false;
-        }
-        return;
-    }
-
-    // <FS:ND>: we've saved the element we need in a stack, so we can avoid readElement()
-    // Element element = readElement(name);
-    Element element = mStackElements.top(); //readElement(name);
-    mStackElements.pop();
-    // </FS:ND>
-
-    switch (element)
-    {
-        case ELEMENT_LLSD:
-            if (mInLLSDElement)
-            {
-                mInLLSDElement = false;
-                mGracefullStop = true;
-                XML_StopParser(mParser, false);
-            }
-            return;
-
-        case ELEMENT_KEY:
-            mCurrentKey = mCurrentContent;
-            return;
-
-        default:
-            // all rest are values, fall through
-            ;
-    }
+    mCurrentKey.assign(key);
+    return CONTINUE;
+}
 
-    if (!mInLLSDElement) { return; }
+LLSDXMLReader::Handler::EAction LLSDXMLParser::Impl::mapBegin()
+{
+    LLSD& value = newValue();
+    value = LLSD::emptyMap();
+    mStack.push_back(&value);
+    return CONTINUE;
+}
 
-    LLSD& value = *mStack.back();
+LLSDXMLReader::Handler::EAction LLSDXMLParser::Impl::mapEnd()
+{
     mStack.pop_back();
-
-    switch (element)
-    {
-        case ELEMENT_UNDEF:
-            value.clear();
-            break;
-
-        case ELEMENT_BOOL:
-            value = (mCurrentContent == "true" || mCurrentContent == "1");
-            break;
-
-        case ELEMENT_INTEGER:
-            {
-                S32 i;
-                // sscanf okay here with different locales - ints don't change for different locale settings like floats do.
-                if ( sscanf(mCurrentContent.c_str(), "%d", &i ) == 1 )
-                {   // See if sscanf works - it's faster
-                    value = i;
-                }
-                else
-                {
-                    value = LLSD(mCurrentContent).asInteger();
-                }
-            }
-            break;
-
-        case ELEMENT_REAL:
-            {
-                value = LLSD(mCurrentContent).asReal();
-                // removed since this breaks when locale has decimal separator that isn't '.'
-                // investigated changing local to something compatible each time but deemed higher
-                // risk that just using LLSD.asReal() each time.
-                //F64 r;
-                //if ( sscanf(mCurrentContent.c_str(), "%lf", &r ) == 1 )
-                //{ // See if sscanf works - it's faster
-                //  value = r;
-                //}
-                //else
-                //{
-                //  value = LLSD(mCurrentContent).asReal();
-                //}
-            }
-            break;
-
-        case ELEMENT_STRING:
-            value = mCurrentContent;
-            break;
-
-        case ELEMENT_UUID:
-            value = LLSD(mCurrentContent).asUUID();
-            break;
-
-        case ELEMENT_DATE:
-            value = LLSD(mCurrentContent).asDate();
-            break;
-
-        case ELEMENT_URI:
-            value = LLSD(mCurrentContent).asURI();
-            break;
-
-        case ELEMENT_BINARY:
-        {
-            // Regex is expensive, but only fix for whitespace in base64,
-            // created by python and other non-linden systems - DEV-39358
-            // Fortunately we have very little binary passing now,
-            // so performance impact shold be negligible. + poppy 2009-09-04
-            boost::regex r;
-            r.assign("\\s");
-            std::string stripped = boost::regex_replace(mCurrentContent, r, "");
-            S32 len = apr_base64_decode_len(stripped.c_str());
-            std::vector<U8> data;
-            data.resize(len);
-            len = apr_base64_decode_binary(&data[0], stripped.c_str());
-            data.resize(len);
-            value = data;
-            break;
-        }
-
-        case ELEMENT_UNKNOWN:
-            value.clear();
-            break;
-
-        default:
-            // other values, map and array, have already been set
-            break;
-    }
-
-    mCurrentContent.clear();
+    return CONTINUE;
 }
 
-void LLSDXMLParser::Impl::characterDataHandler(const XML_Char* data, int length)
+LLSDXMLReader::Handler::EAction LLSDXMLParser::Impl::arrayBegin()
 {
-    #ifdef XML_PARSER_PERFORMANCE_TESTS
-    XML_Timer timer( &charDataTime );
-    #endif  // XML_PARSER_PERFORMANCE_TESTS
-
-    mCurrentContent.append(data, length);
+    LLSD& value = newValue();
+    value = LLSD::emptyArray();
+    mStack.push_back(&value);
+    return CONTINUE;
 }
 
-
-void LLSDXMLParser::Impl::sStartElementHandler(
-    void* userData, const XML_Char* name, const XML_Char** attributes)
+LLSDXMLReader::Handler::EAction LLSDXMLParser::Impl::arrayEnd()
 {
-    ((LLSDXMLParser::Impl*)userData)->startElementHandler(name, attributes);
+    mStack.pop_back();
+    return CONTINUE;
 }
 
-void LLSDXMLParser::Impl::sEndElementHandler(
-    void* userData, const XML_Char* name)
+LLSDXMLReader::Handler::EAction LLSDXMLParser::Impl::undefValue()
 {
-    ((LLSDXMLParser::Impl*)userData)->endElementHandler(name);
+    newValue().clear();
+    return CONTINUE;
 }
 
-void LLSDXMLParser::Impl::sCharacterDataHandler(
-    void* userData, const XML_Char* data, int length)
+LLSDXMLReader::Handler::EAction LLSDXMLParser::Impl::booleanValue(LLSD::Boolean value)
 {
-    ((LLSDXMLParser::Impl*)userData)->characterDataHandler(data, length);
+    newValue() = value;
+    return CONTINUE;
 }
 
+LLSDXMLReader::Handler::EAction LLSDXMLParser::Impl::integerValue(LLSD::Integer value)
+{
+    newValue() = value;
+    return CONTINUE;
+}
 
-/*
-    This code is time critical
-
-    This is a sample of tag occurances of text in simstate file with ~8000 objects.
-    A tag pair (<key>something</key>) counts is counted as two:
+LLSDXMLReader::Handler::EAction LLSDXMLParser::Impl::realValue(LLSD::Real value)
+{
+    newValue() = value;
+    return CONTINUE;
+}
 
-        key     - 2680178
-        real    - 1818362
-        integer -  906078
-        array   -  295682
-        map     -  191818
-        uuid    -  177903
-        binary  -  175748
-        string  -   53482
-        undef   -   40353
-        boolean -   33874
-        llsd    -   16332
-        uri     -      38
-        date    -       1
-*/
-LLSDXMLParser::Impl::Element LLSDXMLParser::Impl::readElement(const XML_Char* name)
+LLSDXMLReader::Handler::EAction LLSDXMLParser::Impl::stringValue(LLSD::String& value)
 {
-    #ifdef XML_PARSER_PERFORMANCE_TESTS
-    XML_Timer timer( &readElementTime );
-    #endif // XML_PARSER_PERFORMANCE_TESTS
+    newValue() = std::move(value);
+    return CONTINUE;
+}
 
-    XML_Char c = *name;
-    switch (c)
-    {
-        case 'k':
-            if (strcmp(name, "key") == 0) { return ELEMENT_KEY; }
-            break;
-        case 'r':
-            if (strcmp(name, "real") == 0) { return ELEMENT_REAL; }
-            break;
-        case 'i':
-            if (strcmp(name, "integer") == 0) { return ELEMENT_INTEGER; }
-            break;
-        case 'a':
-            if (strcmp(name, "array") == 0) { return ELEMENT_ARRAY; }
-            break;
-        case 'm':
-            if (strcmp(name, "map") == 0) { return ELEMENT_MAP; }
-            break;
-        case 'u':
-            if (strcmp(name, "uuid") == 0) { return ELEMENT_UUID; }
-            if (strcmp(name, "undef") == 0) { return ELEMENT_UNDEF; }
-            if (strcmp(name, "uri") == 0) { return ELEMENT_URI; }
-            break;
-        case 'b':
-            if (strcmp(name, "binary") == 0) { return ELEMENT_BINARY; }
-            if (strcmp(name, "boolean") == 0) { return ELEMENT_BOOL; }
-            break;
-        case 's':
-            if (strcmp(name, "string") == 0) { return ELEMENT_STRING; }
-            break;
-        case 'l':
-            if (strcmp(name, "llsd") == 0) { return ELEMENT_LLSD; }
-            break;
-        case 'd':
-            if (strcmp(name, "date") == 0) { return ELEMENT_DATE; }
-            break;
-    }
-    return ELEMENT_UNKNOWN;
+LLSDXMLReader::Handler::EAction LLSDXMLParser::Impl::uuidValue(const LLSD::UUID& value)
+{
+    newValue() = value;
+    return CONTINUE;
 }
 
+LLSDXMLReader::Handler::EAction LLSDXMLParser::Impl::dateValue(const LLSD::Date& value)
+{
+    newValue() = value;
+    return CONTINUE;
+}
 
+LLSDXMLReader::Handler::EAction LLSDXMLParser::Impl::uriValue(const LLSD::URI& value)
+{
+    newValue() = value;
+    return CONTINUE;
+}
 
+LLSDXMLReader::Handler::EAction LLSDXMLParser::Impl::binaryValue(LLSD::Binary& value)
+{
+    newValue() = std::move(value);
+    return CONTINUE;
+}
 
 
 /**
@@ -967,10 +584,6 @@ S32 LLSDXMLParser::doParse(std::istream& input, LLSD& data, S32 max_depth) const
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
 
-    #ifdef XML_PARSER_PERFORMANCE_TESTS
-    XML_Timer timer( &parseTime );
-    #endif  // XML_PARSER_PERFORMANCE_TESTS
-
     if (mParseLines)
     {
         // Use line-based reading (faster code)
@@ -980,6 +593,13 @@ S32 LLSDXMLParser::doParse(std::istream& input, LLSD& data, S32 max_depth) const
     return impl.parse(input, data);
 }
 
+// virtual
+S32 LLSDXMLParser::doParseBuffer(const U8* buf, size_t size, LLSD& data, S32 max_depth) const
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
+    return impl.parseBuffer((const char*)buf, size, data);
+}
+
 //  virtual
 void LLSDXMLParser::doReset()
 {
@@ -0,0 +1,428 @@
+/**
+ * @file llsdxmlreader.cpp
+ * @brief Event driven reader for XML formatted LLSD.
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llsdxmlreader.h"
+
+#include "llbase64.h"
+#include "lldate.h"
+#include "lluri.h"
+#include "lluuid.h"
+
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include <sstream>
+
+extern "C"
+{
+#ifdef LL_USESYSTEMLIBS
+# include <expat.h>
+#else
+# include "expat/expat.h"
+#endif
+}
+
+// Same conversion as LLSD(string).asReal()
+static F64 string_to_real(const std::string& str)
+{
+    F64 v = 0.0;
+    std::istringstream i_stream(str);
+    i_stream >> v;
+    int c = i_stream.get();
+    return ((EOF == c) ? v : 0.0);
+}
+
+LLSDXMLReader::LLSDXMLReader(Handler& handler)
+:   mHandler(handler)
+{
+    mParser = XML_ParserCreate(NULL);
+    reset();
+}
+
+LLSDXMLReader::~LLSDXMLReader()
+{
+    XML_ParserFree(mParser);
+}
+
+void LLSDXMLReader::reset()
+{
+    mElements.clear();
+    mCurrentKey.clear();
+    mContent.clear();
+    mValueCount = 0;
+    mDepth = 0;
+    mSkipThrough = 0;
+    mSkipping = false;
+    mInLLSDElement = false;
+    mDone = false;
+    mFailed = false;
+
+    XML_ParserReset(mParser, "utf-8");
+    XML_SetUserData(mParser, this);
+    XML_SetElementHandler(mParser, sStartElementHandler, sEndElementHandler);
+    XML_SetCharacterDataHandler(mParser, sCharacterDataHandler);
+}
+
+LLSDXMLReader::EStatus LLSDXMLReader::getStatus() const
+{
+    if (mDone)
+    {
+        return STATUS_DONE;
+    }
+    return mFailed ? STATUS_ERROR : STATUS_OK;
+}
+
+LLSDXMLReader::EStatus LLSDXMLReader::feed(const char* buf, size_t len, bool is_final)
+{
+    // expat takes an int length
+    while (len > INT_MAX && getStatus() == STATUS_OK)
+    {
+        feed(buf, INT_MAX, false);
+        buf += INT_MAX;
+        len -= INT_MAX;
+    }
+    if (getStatus() != STATUS_OK)
+    {
+        return getStatus();
+    }
+
+    XML_Status status = XML_Parse(mParser, buf, (int)len, is_final);
+    if (status == XML_STATUS_ERROR && !mDone)
+    {
+        mFailed = true;
+    }
+    return getStatus();
+}
+
+LLSDXMLReader::EStatus LLSDXMLReader::feed(std::istream& input)
+{
+    constexpr size_t BUFFER_SIZE = 64 * 1024;
+    std::vector<char> buffer(BUFFER_SIZE);
+    while (getStatus() == STATUS_OK && input.good())
+    {
+        input.read(buffer.data(), BUFFER_SIZE);
+        size_t count = (size_t)input.gcount();
+        if (count)
+        {
+            feed(buffer.data(), count, false);
+        }
+    }
+    return feed(nullptr, 0, true);
+}
+
+void LLSDXMLReader::startSkipping()
+{
+    mSkipping = true;
+    mSkipThrough = mDepth;
+}
+
+void LLSDXMLReader::stop()
+{
+    mFailed = true;
+    XML_StopParser(mParser, false);
+}
+
+// This is the parser's hot path, see the tag counts below.
+void LLSDXMLReader::startElement(const char* name, const char** attributes)
+{
+    ++mDepth;
+    if (mSkipping)
+    {
+        return;
+    }
+
+    Element element = readElement(name);
+    mContent.clear();
+
+    switch (element)
+    {
+        case ELEMENT_LLSD:
+            if (mInLLSDElement)
+            {
+                return startSkipping();
+            }
+            mInLLSDElement = true;
+            mElements.push_back(element);
+            return;
+
+        case ELEMENT_KEY:
+            if (mElements.empty() || mElements.back() != ELEMENT_MAP)
+            {
+                return startSkipping();
+            }
+            mElements.push_back(element);
+            return;
+
+        case ELEMENT_BINARY:
+            for (const char** attr = attributes; attr && attr[0] && attr[1]; attr += 2)
+            {
+                if (strcmp(attr[0], "encoding") == 0 && strcmp(attr[1], "base64") != 0)
+                {
+                    return startSkipping();
+                }
+            }
+            break;
+
+        default:
+            // all the rest are values
+            break;
+    }
+
+    if (!mInLLSDElement || mElements.empty())
+    {
+        return startSkipping();
+    }
+
+    // Values may only appear at the top of the document, in an array or
+    // after a key in a map
+    Handler::EAction action = Handler::CONTINUE;
+    Element parent = mElements.back();
+    if (parent == ELEMENT_MAP)
+    {
+        if (mCurrentKey.empty())
+        {
+            return startSkipping();
+        }
+        action = mHandler.mapKey(mCurrentKey);
+        mCurrentKey.clear();
+    }
+    else if (parent != ELEMENT_ARRAY && parent != ELEMENT_LLSD)
+    {
+        // improperly nested value in a non-structure
+        return startSkipping();
+    }
+
+    if (action == Handler::CONTINUE)
+    {
+        ++mValueCount;
+        if (element == ELEMENT_MAP)
+        {
+            action = mHandler.mapBegin();
+        }
+        else if (element == ELEMENT_ARRAY)
+        {
+            action = mHandler.arrayBegin();
+        }
+    }
+
+    if (action == Handler::SKIP)
+    {
+        return startSkipping();
+    }
+    if (action == Handler::STOP)
+    {
+        return stop();
+    }
+    mElements.push_back(element);
+}
+
+void LLSDXMLReader::endElement()
+{
+    --mDepth;
+    if (mSkipping)
+    {
+        if (mDepth < mSkipThrough)
+        {
+            mSkipping = false;
+        }
+        return;
+    }
+
+    Element element = mElements.back();
+    mElements.pop_back();
+
+    Handler::EAction action = Handler::CONTINUE;
+    switch (element)
+    {
+        case ELEMENT_LLSD:
+            mInLLSDElement = false;
+            mDone = true;
+            XML_StopParser(mParser, false);
+            return;
+
+        case ELEMENT_KEY:
+            mCurrentKey.swap(mContent);
+            break;
+
+        case ELEMENT_MAP:
+            action = mHandler.mapEnd();
+            break;
+
+        case ELEMENT_ARRAY:
+            action = mHandler.arrayEnd();
+            break;
+
+        default:
+            action = reportScalar(element);
+            break;
+    }
+    mContent.clear();
+
+    if (action == Handler::STOP)
+    {
+        stop();
+    }
+}
+
+void LLSDXMLReader::characterData(const char* data, int length)
+{
+    if (!mSkipping)
+    {
+        mContent.append(data, length);
+    }
+}
+
+LLSDXMLReader::Handler::EAction LLSDXMLReader::reportScalar(Element element)
+{
+    switch (element)
+    {
+        case ELEMENT_BOOL:
+            return mHandler.booleanValue(mContent == "true" || mContent == "1");
+
+        case ELEMENT_INTEGER:
+        {
+            S32 i;
+            // sscanf okay here with different locales - ints don't change for different locale settings like floats do.
+            if (sscanf(mContent.c_str(), "%d", &i) != 1)
+            {
+                i = (S32)string_to_real(mContent);
+            }
+            return mHandler.integerValue(i);
+        }
+
+        case ELEMENT_REAL:
+            return mHandler.realValue(string_to_real(mContent));
+
+        case ELEMENT_STRING:
+            return mHandler.stringValue(mContent);
+
+        case ELEMENT_UUID:
+            return mHandler.uuidValue(LLUUID(mContent));
+
+        case ELEMENT_DATE:
+            return mHandler.dateValue(LLDate(mContent));
+
+        case ELEMENT_URI:
+            return mHandler.uriValue(LLURI(mContent));
+
+        case ELEMENT_BINARY:
+        {
+            // Strip the whitespace python and other non-linden systems
+            // wrap their base64 with - DEV-39358
+            mContent.erase(std::remove_if(mContent.begin(), mContent.end(),
+                                          [](char c) { return isspace((unsigned char)c); }),
+                           mContent.end());
+            LLSD::Binary data = LLBase64::decode(mContent);
+            return mHandler.binaryValue(data);
+        }
+
+        default:
+            // undef and unknown elements
+            return mHandler.undefValue();
+    }
+}
+
+// static
+void LLSDXMLReader::sStartElementHandler(void* user_data, const char* name, const char** attributes)
+{
+    ((LLSDXMLReader*)user_data)->startElement(name, attributes);
+}
+
+// static
+void LLSDXMLReader::sEndElementHandler(void* user_data, const char* name)
+{
+    ((LLSDXMLReader*)user_data)->endElement();
+}
+
+// static
+void LLSDXMLReader::sCharacterDataHandler(void* user_data, const char* data, int length)
+{
+    ((LLSDXMLReader*)user_data)->characterData(data, length);
+}
+
+/*
+    This code is time critical
+
+    This is a sample of tag occurances of text in simstate file with ~8000 objects.
+    A tag pair (<key>something</key>) counts is counted as two:
+
+        key     - 2680178
+        real    - 1818362
+        integer -  906078
+        array   -  295682
+        map     -  191818
+        uuid    -  177903
+        binary  -  175748
+        string  -   53482
+        undef   -   40353
+        boolean -   33874
+        llsd    -   16332
+        uri     -      38
+        date    -       1
+*/
+// static
+LLSDXMLReader::Element LLSDXMLReader::readElement(const char* name)
+{
+    switch (*name)
+    {
+        case 'k':
+            if (strcmp(name, "key") == 0) { return ELEMENT_KEY; }
+            break;
+        case 'r':
+            if (strcmp(name, "real") == 0) { return ELEMENT_REAL; }
+            break;
+        case 'i':
+            if (strcmp(name, "integer") == 0) { return ELEMENT_INTEGER; }
+            break;
+        case 'a':
+            if (strcmp(name, "array") == 0) { return ELEMENT_ARRAY; }
+            break;
+        case 'm':
+            if (strcmp(name, "map") == 0) { return ELEMENT_MAP; }
+            break;
+        case 'u':
+            if (strcmp(name, "uuid") == 0) { return ELEMENT_UUID; }
+            if (strcmp(name, "undef") == 0) { return ELEMENT_UNDEF; }
+            if (strcmp(name, "uri") == 0) { return ELEMENT_URI; }
+            break;
+        case 'b':
+            if (strcmp(name, "binary") == 0) { return ELEMENT_BINARY; }
+            if (strcmp(name, "boolean") == 0) { return ELEMENT_BOOL; }
+            break;
+        case 's':
+            if (strcmp(name, "string") == 0) { return ELEMENT_STRING; }
+            break;
+        case 'l':
+            if (strcmp(name, "llsd") == 0) { return ELEMENT_LLSD; }
+            break;
+        case 'd':
+            if (strcmp(name, "date") == 0) { return ELEMENT_DATE; }
+            break;
+    }
+    return ELEMENT_UNKNOWN;
+}
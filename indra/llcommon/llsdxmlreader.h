@@ -0,0 +1,183 @@
+/**
+ * @file llsdxmlreader.h
+ * @brief Event driven reader for XML formatted LLSD.
+ *
+ * @Description:
+ * LLSDXMLParser builds the complete LLSD tree before the caller sees any of
+ * it. LLSDXMLReader reports the document to a Handler while expat walks it
+ * instead:
+ * 1/ The handler receives map and array boundaries, map keys and typed
+ *    scalar values, in document order.
+ * 2/ It can skip any map value or any map or array. A skipped subtree is
+ *    neither decoded nor reported, and its text is not buffered.
+ * 3/ The document can be fed in pieces as it arrives, and events are
+ *    emitted as soon as the data for them has been seen.
+ * LLSDXMLParser is a handler on top of it, so any other handler follows the
+ * same structural rules: only the first <llsd> element is read, misplaced
+ * values are skipped, and reading stops at </llsd>.
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLSDXMLREADER_H
+#define LL_LLSDXMLREADER_H
+
+#include "llsd.h"
+
+#include <iosfwd>
+#include <string_view>
+#include <vector>
+
+struct XML_ParserStruct;
+
+class LL_COMMON_API LLSDXMLReader
+{
+public:
+    class LL_COMMON_API Handler
+    {
+    public:
+        enum EAction
+        {
+            CONTINUE,   // carry on with the next event
+            SKIP,       // skip the value or container the event announces
+            STOP        // abort reading, feed() returns STATUS_ERROR
+        };
+
+        virtual ~Handler() = default;
+
+        /**
+         * @brief The next value belongs to key in the enclosing map.
+         * SKIP skips that value.
+         */
+        virtual EAction mapKey(std::string_view key) { return CONTINUE; }
+
+        /**
+         * @brief SKIP skips the whole container, including the matching
+         * mapEnd() or arrayEnd().
+         */
+        virtual EAction mapBegin() { return CONTINUE; }
+        virtual EAction mapEnd() { return CONTINUE; }
+        virtual EAction arrayBegin() { return CONTINUE; }
+        virtual EAction arrayEnd() { return CONTINUE; }
+
+        /**
+         * Scalar values. Unknown elements are reported as undefined values.
+         * Strings and binaries may be moved from.
+         */
+        virtual EAction undefValue() { return CONTINUE; }
+        virtual EAction booleanValue(LLSD::Boolean value) { return CONTINUE; }
+        virtual EAction integerValue(LLSD::Integer value) { return CONTINUE; }
+        virtual EAction realValue(LLSD::Real value) { return CONTINUE; }
+        virtual EAction stringValue(LLSD::String& value) { return CONTINUE; }
+        virtual EAction uuidValue(const LLSD::UUID& value) { return CONTINUE; }
+        virtual EAction dateValue(const LLSD::Date& value) { return CONTINUE; }
+        virtual EAction uriValue(const LLSD::URI& value) { return CONTINUE; }
+        virtual EAction binaryValue(LLSD::Binary& value) { return CONTINUE; }
+    };
+
+    enum EStatus
+    {
+        STATUS_OK,      // waiting for more input
+        STATUS_DONE,    // </llsd> has been read, further input is ignored
+        STATUS_ERROR    // malformed XML, or the handler returned STOP
+    };
+
+    LLSDXMLReader(Handler& handler);
+    ~LLSDXMLReader();
+
+    LLSDXMLReader(const LLSDXMLReader&) = delete;
+    LLSDXMLReader& operator=(const LLSDXMLReader&) = delete;
+
+    /**
+     * @brief Read the next piece of the document. Pass is_final with the
+     * last piece (it may be empty) so that expat can report a truncated
+     * document.
+     */
+    EStatus feed(const char* buf, size_t len, bool is_final = false);
+
+    /**
+     * @brief Feed the rest of the stream in large blocks. Unlike
+     * LLSDXMLParser, this may consume data past </llsd>.
+     */
+    EStatus feed(std::istream& input);
+
+    /**
+     * @brief Get ready for another document
+     */
+    void reset();
+
+    EStatus getStatus() const;
+
+    /**
+     * @brief Number of values (scalars, maps and arrays) reported so far
+     */
+    S32 getValueCount() const { return mValueCount; }
+
+private:
+    enum Element
+    {
+        ELEMENT_LLSD,
+        ELEMENT_UNDEF,
+        ELEMENT_BOOL,
+        ELEMENT_INTEGER,
+        ELEMENT_REAL,
+        ELEMENT_STRING,
+        ELEMENT_UUID,
+        ELEMENT_DATE,
+        ELEMENT_URI,
+        ELEMENT_BINARY,
+        ELEMENT_MAP,
+        ELEMENT_ARRAY,
+        ELEMENT_KEY,
+        ELEMENT_UNKNOWN
+    };
+    static Element readElement(const char* name);
+
+    void startElement(const char* name, const char** attributes);
+    void endElement();
+    void characterData(const char* data, int length);
+    Handler::EAction reportScalar(Element element);
+    void startSkipping();
+    void stop();
+
+    static void sStartElementHandler(void* user_data, const char* name, const char** attributes);
+    static void sEndElementHandler(void* user_data, const char* name);
+    static void sCharacterDataHandler(void* user_data, const char* data, int length);
+
+    Handler&                mHandler;
+    XML_ParserStruct*       mParser;
+
+    std::vector<Element>    mElements;      // open elements we did not skip
+    std::string             mCurrentKey;    // key for the next map value
+    std::string             mContent;       // text of the current element
+    S32                     mValueCount{ 0 };
+
+    int                     mDepth{ 0 };
+    int                     mSkipThrough{ 0 };
+    bool                    mSkipping{ false };
+    bool                    mInLLSDElement{ false };
+    bool                    mDone{ false };     // found </llsd>
+    bool                    mFailed{ false };
+};
+
+#endif // LL_LLSDXMLREADER_H
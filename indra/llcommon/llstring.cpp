@@ -30,8 +30,15 @@
 #include "llerror.h"
 #include "llfasttimer.h"
 #include "llsd.h"
+#include <locale.h> // for ll_strtod_c_locale()
 #include <vector>
 
+#include <emmintrin.h>
+
+#if LL_DARWIN
+#include <xlocale.h>
+#endif
+
 #if LL_WINDOWS
 #include "llwin32headerslean.h"
 #include <winnls.h> // for WideCharToMultiByte
@@ -50,6 +57,17 @@ std::string ll_safe_string(const char* in, S32 maxlen)
     return std::string();
 }
 
+F64 ll_strtod_c_locale(const char* str, char** end)
+{
+#if LL_WINDOWS
+    static _locale_t c_locale = _create_locale(LC_NUMERIC, "C");
+    return _strtod_l(str, end, c_locale);
+#else
+    static locale_t c_locale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+    return strtod_l(str, end, c_locale);
+#endif
+}
+
 bool is_char_hex(char hex)
 {
     if((hex >= '0') && (hex <= '9'))
@@ -397,107 +415,241 @@ S32 wstring_utf8_length(const LLWString& wstr)
     return len;
 }
 
-LLWString utf8str_to_wstring(const char* utf8str, size_t len)
+namespace
 {
-    LLWString wout;
+    // UTF-8 <-> LLWString conversions run for every chat line, text widget
+    // update and name tag, and most of that text is ASCII: runs of ASCII
+    // characters are converted a block at a time, and anything else a
+    // character at a time.
 
-    S32 i = 0;
-    while (i < len)
+    inline U32 lowest_bit(U32 mask)
     {
-        llwchar unichar;
-        U8 cur_char = utf8str[i];
+#if LL_WINDOWS
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (U32)index;
+#else
+        return (U32)__builtin_ctz(mask);
+#endif
+    }
 
-        if (cur_char < 0x80)
-        {
-            // Ascii character, just add it
-            unichar = cur_char;
-        }
-        else
+    // Widen the leading ASCII characters of in to out, and return how many
+    // there were. Converts whole blocks of 16 characters: the block holding
+    // the first non-ASCII byte is written to out in full, so out must have
+    // room for len characters.
+    size_t widen_ascii(const U8* in, size_t len, llwchar* out)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        size_t done = 0;
+        for (; done + 16 <= len; done += 16)
         {
-            S32 cont_bytes = 0;
-            if ((cur_char >> 5) == 0x6)         // Two byte UTF8 -> 1 UTF32
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + done));
+            U32 high = (U32)_mm_movemask_epi8(bytes);
+            if (high & 1)
             {
-                unichar = (0x1F&cur_char);
-                cont_bytes = 1;
+                return done;
             }
-            else if ((cur_char >> 4) == 0xe)    // Three byte UTF8 -> 1 UTF32
+            __m128i low16 = _mm_unpacklo_epi8(bytes, zero);
+            __m128i high16 = _mm_unpackhi_epi8(bytes, zero);
+            __m128i* dest = reinterpret_cast<__m128i*>(out + done);
+            _mm_storeu_si128(dest, _mm_unpacklo_epi16(low16, zero));
+            _mm_storeu_si128(dest + 1, _mm_unpackhi_epi16(low16, zero));
+            _mm_storeu_si128(dest + 2, _mm_unpacklo_epi16(high16, zero));
+            _mm_storeu_si128(dest + 3, _mm_unpackhi_epi16(high16, zero));
+            if (high)
             {
-                unichar = (0x0F&cur_char);
-                cont_bytes = 2;
+                return done + lowest_bit(high);
             }
-            else if ((cur_char >> 3) == 0x1e)   // Four byte UTF8 -> 1 UTF32
+        }
+        return done;
+    }
+
+    // Narrow the leading ASCII characters of in to out, and return how many
+    // there were. U+0000 stops the run: wstring_to_utf8str() drops it.
+    // Converts whole blocks of 16 characters: out must have room for 16
+    // more bytes than the returned count.
+    size_t narrow_ascii(const llwchar* in, size_t len, char* out)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i not_ascii = _mm_set1_epi32(~0x7F);
+        size_t done = 0;
+        for (; done + 16 <= len; done += 16)
+        {
+            const __m128i* src = reinterpret_cast<const __m128i*>(in + done);
+            __m128i a = _mm_loadu_si128(src);
+            __m128i b = _mm_loadu_si128(src + 1);
+            __m128i c = _mm_loadu_si128(src + 2);
+            __m128i d = _mm_loadu_si128(src + 3);
+            __m128i high = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), not_ascii);
+            // saturating packs: exact when every character is ASCII
+            __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(high, zero)) != 0xFFFF
+                || _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, zero)))
             {
-                unichar = (0x07&cur_char);
-                cont_bytes = 3;
+                break;
             }
-            else if ((cur_char >> 2) == 0x3e)   // Five byte UTF8 -> 1 UTF32
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + done), bytes);
+        }
+        // llwchar may be signed
+        for (; done < len && in[done] && (U32)in[done] < 0x80; ++done)
+        {
+            out[done] = (char)in[done];
+        }
+        return done;
+    }
+
+    // Decode the character starting with the non-ASCII byte utf8str[i], and
+    // move i past it. Malformed and overlong sequences decode to
+    // LL_UNKNOWN_CHAR.
+    inline llwchar decode_utf8_sequence(const U8* utf8str, size_t len, size_t& i)
+    {
+        llwchar unichar;
+        U8 cur_char = utf8str[i];
+
+        // well formed two and three byte characters, most non-ASCII text
+        if (cur_char >= 0xC2 && cur_char < 0xE0
+            && i + 1 < len && (utf8str[i + 1] >> 6) == 0x2)
+        {
+            unichar = ((cur_char & 0x1F) << 6) | (utf8str[i + 1] & 0x3F);
+            i += 2;
+            return unichar;
+        }
+        if ((cur_char >> 4) == 0xe
+            && i + 2 < len && (utf8str[i + 1] >> 6) == 0x2 && (utf8str[i + 2] >> 6) == 0x2)
+        {
+            unichar = ((cur_char & 0x0F) << 12) | ((utf8str[i + 1] & 0x3F) << 6) | (utf8str[i + 2] & 0x3F);
+            if (unichar >= 0x800)
             {
-                unichar = (0x03&cur_char);
-                cont_bytes = 4;
+                i += 3;
+                return unichar;
             }
-            else if ((cur_char >> 1) == 0x7e)   // Six byte UTF8 -> 1 UTF32
+        }
+
+        S32 cont_bytes = 0;
+        if ((cur_char >> 5) == 0x6)         // Two byte UTF8 -> 1 UTF32
+        {
+            unichar = (0x1F&cur_char);
+            cont_bytes = 1;
+        }
+        else if ((cur_char >> 4) == 0xe)    // Three byte UTF8 -> 1 UTF32
+        {
+            unichar = (0x0F&cur_char);
+            cont_bytes = 2;
+        }
+        else if ((cur_char >> 3) == 0x1e)   // Four byte UTF8 -> 1 UTF32
+        {
+            unichar = (0x07&cur_char);
+            cont_bytes = 3;
+        }
+        else if ((cur_char >> 2) == 0x3e)   // Five byte UTF8 -> 1 UTF32
+        {
+            unichar = (0x03&cur_char);
+            cont_bytes = 4;
+        }
+        else if ((cur_char >> 1) == 0x7e)   // Six byte UTF8 -> 1 UTF32
+        {
+            unichar = (0x01&cur_char);
+            cont_bytes = 5;
+        }
+        else
+        {
+            ++i;
+            return LL_UNKNOWN_CHAR;
+        }
+
+        // Check that this character doesn't go past the end of the string
+        auto end = (len < (i + cont_bytes)) ? len : (i + cont_bytes);
+        do
+        {
+            ++i;
+
+            // the end of the string ends the sequence too
+            cur_char = (i < len) ? utf8str[i] : 0;
+            if ( (cur_char >> 6) == 0x2 )
             {
-                unichar = (0x01&cur_char);
-                cont_bytes = 5;
+                unichar <<= 6;
+                unichar += (0x3F&cur_char);
             }
             else
             {
-                wout += LL_UNKNOWN_CHAR;
-                ++i;
-                continue;
-            }
-
-            // Check that this character doesn't go past the end of the string
-            auto end = (len < (i + cont_bytes)) ? len : (i + cont_bytes);
-            do
-            {
-                ++i;
-
-                cur_char = utf8str[i];
-                if ( (cur_char >> 6) == 0x2 )
-                {
-                    unichar <<= 6;
-                    unichar += (0x3F&cur_char);
-                }
-                else
-                {
-                    // Malformed sequence - roll back to look at this as a new char
-                    unichar = LL_UNKNOWN_CHAR;
-                    --i;
-                    break;
-                }
-            } while(i < end);
-
-            // Handle overlong characters and NULL characters
-            if ( ((cont_bytes == 1) && (unichar < 0x80))
-                || ((cont_bytes == 2) && (unichar < 0x800))
-                || ((cont_bytes == 3) && (unichar < 0x10000))
-                || ((cont_bytes == 4) && (unichar < 0x200000))
-                || ((cont_bytes == 5) && (unichar < 0x4000000)) )
-            {
+                // Malformed sequence - roll back to look at this as a new char
                 unichar = LL_UNKNOWN_CHAR;
+                --i;
+                break;
             }
+        } while(i < end);
+
+        // Handle overlong characters and NULL characters
+        if ( ((cont_bytes == 1) && (unichar < 0x80))
+            || ((cont_bytes == 2) && (unichar < 0x800))
+            || ((cont_bytes == 3) && (unichar < 0x10000))
+            || ((cont_bytes == 4) && (unichar < 0x200000))
+            || ((cont_bytes == 5) && (unichar < 0x4000000)) )
+        {
+            unichar = LL_UNKNOWN_CHAR;
         }
-
-        wout += unichar;
         ++i;
+        return unichar;
     }
+}
+
+LLWString utf8str_to_wstring(const char* utf8str, size_t len)
+{
+    // no character is shorter than a byte
+    LLWString wout(len, 0);
+    const U8* in = reinterpret_cast<const U8*>(utf8str);
+    llwchar* out = &wout[0];
+
+    size_t i = 0;
+    size_t o = 0;
+    while (i < len)
+    {
+        size_t ascii = widen_ascii(in + i, len - i, out + o);
+        i += ascii;
+        o += ascii;
+        if (i < len && in[i] < 0x80)
+        {
+            // Ascii character past the last block, just add it
+            out[o++] = in[i++];
+        }
+        while (i < len && in[i] >= 0x80)
+        {
+            out[o++] = decode_utf8_sequence(in, len, i);
+        }
+    }
+    wout.resize(o);
     return wout;
 }
 
 std::string wstring_to_utf8str(const llwchar* utf32str, size_t len)
 {
-    std::string out;
+    // Sized for ASCII plus narrow_ascii()'s block of slack, and grown before
+    // each longer character.
+    std::string out(len + 16, '\0');
 
-    S32 i = 0;
+    size_t i = 0;
+    size_t o = 0;
     while (i < len)
     {
-        char tchars[8];     /* Flawfinder: ignore */
-        auto n = wchar_to_utf8chars(utf32str[i], tchars);
-        tchars[n] = 0;
-        out += tchars;
-        i++;
+        size_t ascii = narrow_ascii(utf32str + i, len - i, &out[o]);
+        i += ascii;
+        o += ascii;
+        if (i < len)
+        {
+            size_t needed = o + 6 + (len - i) + 16;
+            if (needed > out.size())
+            {
+                out.resize(std::max(needed, out.size() * 2));
+            }
+            llwchar wc = utf32str[i++];
+            // U+0000 has always been dropped
+            if (wc)
+            {
+                o += wchar_to_utf8chars(wc, &out[o]);
+            }
+        }
     }
+    out.resize(o);
     return out;
 }
 
@@ -231,6 +231,12 @@ public:
 LL_COMMON_API std::string ll_safe_string(const char* in);
 LL_COMMON_API std::string ll_safe_string(const char* in, S32 maxlen);
 
+/**
+ * @brief strtod() that always reads '.' as the decimal point, whatever
+ * LLLocale has set LC_NUMERIC to.
+ */
+LL_COMMON_API F64 ll_strtod_c_locale(const char* str, char** end);
+
 
 // Allowing assignments from non-strings into format_map_t is apparently
 // *really* error-prone, so subclass std::string with just basic c'tors.
@@ -35,6 +35,7 @@
 #include "lltrace.h"
 #include "lltracethreadrecorder.h"
 #include "llexception.h"
+#include "llflightrecorder.h"
 
 #if LL_LINUX
 #include <sched.h>
@@ -150,6 +151,7 @@ void LLThread::threadRun()
 
     // this is the first point at which we're actually running in the new thread
     mID = currentID();
+    LLTrace::FlightRecorder::setThreadName(mName);
 
     // for now, hard code all LLThreads to report to single master thread recorder, which is known to be running on main thread
     mRecorder = new LLTrace::ThreadRecorder(*LLTrace::get_master_thread_recorder());
@@ -0,0 +1,723 @@
+/**
+ * @file lluuidhashmap.h
+ * @brief Open addressing hash map and set keyed by LLUUID.
+ *
+ * @Description:
+ * Most of the viewer's large tables (objects, inventory, avatar names) are
+ * keyed by LLUUID and live in std::map or std::unordered_map, so every
+ * lookup chases a node pointer per tree level or per bucket, and every
+ * insertion allocates. LLUUIDHashMap and LLUUIDHashSet store their elements
+ * in one flat array instead, with a parallel array of one control byte per
+ * slot:
+ * - 0x80 for an empty slot, 0xFE for an erased one, or 7 bits of the key's
+ *   hash for a full one;
+ * - slots are probed 16 at a time: one SSE2 compare of 16 control bytes
+ *   against the key's 7 hash bits finds the few candidate slots, and each
+ *   candidate key is compared with one more 16 byte SSE2 compare.
+ * UUIDs are random, so their bits are used as is for the hash.
+ *
+ * The API is the subset of std::unordered_map the viewer uses. Differences:
+ * 1/ Inserting may move every element, and invalidates all iterators and
+ *    references into the container, as rehashing std::unordered_map does.
+ * 2/ Erasing never moves elements: erase(it++) and erase(it) keep the other
+ *    iterators valid, like std::map.
+ * 3/ Iteration order is unspecified and changes when the container grows.
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLUUIDHASHMAP_H
+#define LL_LLUUIDHASHMAP_H
+
+#include "lluuid.h"
+#include "llmemory.h"
+
+#include <cstring>
+#include <emmintrin.h>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace LLUUIDHash
+{
+    static constexpr U8 CTRL_EMPTY = 0x80;
+    static constexpr U8 CTRL_ERASED = 0xFE;
+    static constexpr size_t GROUP_SIZE = 16;
+
+    inline bool keysEqual(const LLUUID& a, const LLUUID& b)
+    {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a.mData));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b.mData));
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) == 0xFFFF;
+    }
+
+    // Masks of the slots of a 16 slot group holding the passed tag, empty,
+    // or either empty or erased.
+    inline U32 matchTag(__m128i group, U8 tag)
+    {
+        return (U32)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)tag)));
+    }
+
+    inline U32 matchEmpty(__m128i group)
+    {
+        return matchTag(group, CTRL_EMPTY);
+    }
+
+    inline U32 matchFree(__m128i group)
+    {
+        // empty and erased are the only control bytes with the high bit set
+        return (U32)_mm_movemask_epi8(group);
+    }
+
+    // LLUUID::getDigest64(), without assuming the key is 8 byte aligned:
+    // it isn't when the stored element is a pair with a smaller value.
+    inline U64 hashOf(const LLUUID& key)
+    {
+        U64 halves[2];
+        memcpy(halves, key.mData, sizeof(halves));
+        return halves[0] ^ halves[1];
+    }
+
+    inline U32 lowestBit(U32 mask)
+    {
+#if LL_WINDOWS
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (U32)index;
+#else
+        return (U32)__builtin_ctz(mask);
+#endif
+    }
+
+    struct MapKey
+    {
+        template <typename PAIR>
+        static const LLUUID& get(const PAIR& value) { return value.first; }
+    };
+
+    struct SetKey
+    {
+        static const LLUUID& get(const LLUUID& value) { return value; }
+    };
+
+/**
+ * Table shared by LLUUIDHashMap and LLUUIDHashSet. VALUE is the stored
+ * element, KEY_OF extracts its LLUUID.
+ */
+template <typename VALUE, typename KEY_OF>
+class Table
+{
+public:
+    typedef LLUUID key_type;
+    typedef VALUE value_type;
+    typedef size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+
+    // Grow when full and erased slots reach 7/8 of the capacity.
+    static constexpr size_t MAX_LOAD_NUM = 7;
+    static constexpr size_t MAX_LOAD_DEN = 8;
+
+    template <bool CONST>
+    class Iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef VALUE value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef typename std::conditional<CONST, const VALUE*, VALUE*>::type pointer;
+        typedef typename std::conditional<CONST, const VALUE&, VALUE&>::type reference;
+
+        Iterator(): mCtrl(nullptr), mSlot(nullptr), mEnd(nullptr) {}
+        // iterator converts to const_iterator
+        template <bool OTHER, typename = typename std::enable_if<CONST && !OTHER>::type>
+        Iterator(const Iterator<OTHER>& other):
+            mCtrl(other.mCtrl), mSlot(other.mSlot), mEnd(other.mEnd)
+        {}
+
+        reference operator*() const { return *mSlot; }
+        pointer operator->() const { return mSlot; }
+
+        Iterator& operator++()
+        {
+            ++mCtrl;
+            ++mSlot;
+            skipFree();
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator prev(*this);
+            ++*this;
+            return prev;
+        }
+
+        template <bool OTHER>
+        bool operator==(const Iterator<OTHER>& other) const { return mCtrl == other.mCtrl; }
+        template <bool OTHER>
+        bool operator!=(const Iterator<OTHER>& other) const { return mCtrl != other.mCtrl; }
+
+    private:
+        friend class Table;
+        template <bool> friend class Iterator;
+
+        Iterator(const U8* ctrl, VALUE* slot, const U8* end):
+            mCtrl(ctrl), mSlot(slot), mEnd(end)
+        {}
+
+        void skipFree()
+        {
+            while (mCtrl != mEnd && (*mCtrl & 0x80))
+            {
+                ++mCtrl;
+                ++mSlot;
+            }
+        }
+
+        const U8* mCtrl;
+        VALUE* mSlot;
+        const U8* mEnd;
+    };
+
+    typedef Iterator<false> iterator;
+    typedef Iterator<true> const_iterator;
+
+    Table() = default;
+
+    Table(const Table& other)
+    {
+        reserve(other.size());
+        for (const VALUE& value : other)
+        {
+            emplaceNew(KEY_OF::get(value), value);
+        }
+    }
+
+    Table(Table&& other) noexcept
+    {
+        swap(other);
+    }
+
+    ~Table()
+    {
+        destroy();
+    }
+
+    Table& operator=(const Table& other)
+    {
+        if (this != &other)
+        {
+            Table copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    Table& operator=(Table&& other) noexcept
+    {
+        if (this != &other)
+        {
+            destroy();
+            swap(other);
+        }
+        return *this;
+    }
+
+    void swap(Table& other) noexcept
+    {
+        std::swap(mCtrl, other.mCtrl);
+        std::swap(mSlots, other.mSlots);
+        std::swap(mCapacity, other.mCapacity);
+        std::swap(mSize, other.mSize);
+        std::swap(mErased, other.mErased);
+    }
+
+    iterator begin()
+    {
+        iterator it(mCtrl, mSlots, mCtrl + mCapacity);
+        it.skipFree();
+        return it;
+    }
+    const_iterator begin() const
+    {
+        const_iterator it(mCtrl, mSlots, mCtrl + mCapacity);
+        it.skipFree();
+        return it;
+    }
+    const_iterator cbegin() const { return begin(); }
+    iterator end() { return iterator(mCtrl + mCapacity, mSlots + mCapacity, mCtrl + mCapacity); }
+    const_iterator end() const { return const_iterator(mCtrl + mCapacity, mSlots + mCapacity, mCtrl + mCapacity); }
+    const_iterator cend() const { return end(); }
+
+    size_t size() const { return mSize; }
+    bool empty() const { return mSize == 0; }
+    // number of slots, a multiple of 16
+    size_t capacity() const { return mCapacity; }
+
+    void clear()
+    {
+        if (mSize || mErased)
+        {
+            destroyValues();
+            memset(mCtrl, CTRL_EMPTY, mCapacity);
+            mSize = 0;
+            mErased = 0;
+        }
+    }
+
+    // Make room for count elements without growing.
+    void reserve(size_t count)
+    {
+        size_t capacity = GROUP_SIZE;
+        while (capacity * MAX_LOAD_NUM / MAX_LOAD_DEN < count)
+        {
+            capacity *= 2;
+        }
+        if (capacity > mCapacity)
+        {
+            rehash(capacity);
+        }
+    }
+
+    iterator find(const LLUUID& key)
+    {
+        size_t index = findIndex(key);
+        return index == mCapacity ? end() : iterator(mCtrl + index, mSlots + index, mCtrl + mCapacity);
+    }
+
+    const_iterator find(const LLUUID& key) const
+    {
+        size_t index = findIndex(key);
+        return index == mCapacity ? end() : const_iterator(mCtrl + index, mSlots + index, mCtrl + mCapacity);
+    }
+
+    size_t count(const LLUUID& key) const { return findIndex(key) != mCapacity; }
+    bool contains(const LLUUID& key) const { return findIndex(key) != mCapacity; }
+
+    std::pair<iterator, bool> insert(const VALUE& value)
+    {
+        return emplaceKey(KEY_OF::get(value), value);
+    }
+
+    std::pair<iterator, bool> insert(VALUE&& value)
+    {
+        // the key is copied first: constructing the element moves from value
+        LLUUID key(KEY_OF::get(value));
+        return emplaceKey(key, std::move(value));
+    }
+
+    template <typename ITER>
+    void insert(ITER first, ITER last)
+    {
+        for (; first != last; ++first)
+        {
+            insert(*first);
+        }
+    }
+
+    template <typename... ARGS>
+    std::pair<iterator, bool> emplace(ARGS&&... args)
+    {
+        // the key has to be known before finding a slot: build the element
+        // on the stack, as std::unordered_map does for the general case
+        VALUE value(std::forward<ARGS>(args)...);
+        return insert(std::move(value));
+    }
+
+    size_t erase(const LLUUID& key)
+    {
+        size_t index = findIndex(key);
+        if (index == mCapacity)
+        {
+            return 0;
+        }
+        eraseIndex(index);
+        return 1;
+    }
+
+    // Returns the iterator following pos.
+    iterator erase(const_iterator pos)
+    {
+        size_t index = pos.mCtrl - mCtrl;
+        eraseIndex(index);
+        iterator next(mCtrl + index, mSlots + index, mCtrl + mCapacity);
+        return ++next;
+    }
+
+    // Also picks erase(iterator) over erase(const LLUUID&) for maps, whose
+    // iterator would otherwise be ambiguous between the two.
+    iterator erase(iterator pos)
+    {
+        return erase(const_iterator(pos));
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        while (first != last)
+        {
+            first = erase(first);
+        }
+        size_t index = last.mCtrl - mCtrl;
+        return iterator(mCtrl + index, mSlots + index, mCtrl + mCapacity);
+    }
+
+    bool operator==(const Table& other) const
+    {
+        if (mSize != other.mSize)
+        {
+            return false;
+        }
+        for (const VALUE& value : *this)
+        {
+            const_iterator found = other.find(KEY_OF::get(value));
+            if (found == other.end() || !(*found == value))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool operator!=(const Table& other) const { return !(*this == other); }
+
+protected:
+    // Find key, or construct a new element from args if it's missing.
+    template <typename... ARGS>
+    std::pair<iterator, bool> emplaceKey(const LLUUID& key, ARGS&&... args)
+    {
+        size_t index = findIndex(key);
+        if (index != mCapacity)
+        {
+            return { iterator(mCtrl + index, mSlots + index, mCtrl + mCapacity), false };
+        }
+        return { emplaceNew(key, std::forward<ARGS>(args)...), true };
+    }
+
+    // Construct a new element for a key known to be missing.
+    template <typename... ARGS>
+    iterator emplaceNew(const LLUUID& key, ARGS&&... args)
+    {
+        if ((mSize + mErased + 1) * MAX_LOAD_DEN > mCapacity * MAX_LOAD_NUM)
+        {
+            growForInsert();
+        }
+        U64 hash = hashOf(key);
+        size_t index = findFree(hash);
+        new (mSlots + index) VALUE(std::forward<ARGS>(args)...);
+        if (mCtrl[index] == CTRL_ERASED)
+        {
+            --mErased;
+        }
+        mCtrl[index] = tagOf(hash);
+        ++mSize;
+        return iterator(mCtrl + index, mSlots + index, mCtrl + mCapacity);
+    }
+
+private:
+    // The top 7 bits of the hash tag a slot, the low bits pick the first
+    // group to probe.
+    static U8 tagOf(U64 hash) { return U8(hash >> 57); }
+
+    // Triangular probing over a power of 2 number of groups visits every
+    // group once.
+    size_t groupMask() const { return mCapacity / GROUP_SIZE - 1; }
+
+    __m128i loadGroup(size_t group) const
+    {
+        return _mm_load_si128(reinterpret_cast<const __m128i*>(mCtrl + group * GROUP_SIZE));
+    }
+
+    // Index of key's slot, or mCapacity if it's missing.
+    size_t findIndex(const LLUUID& key) const
+    {
+        if (!mSize)
+        {
+            return mCapacity;
+        }
+        U64 hash = hashOf(key);
+        U8 tag = tagOf(hash);
+        size_t mask = groupMask();
+        size_t group = size_t(hash) & mask;
+        for (size_t step = 1; ; group = (group + step++) & mask)
+        {
+            __m128i ctrl = loadGroup(group);
+            for (U32 match = matchTag(ctrl, tag); match; match &= match - 1)
+            {
+                size_t index = group * GROUP_SIZE + lowestBit(match);
+                if (LL_LIKELY(keysEqual(KEY_OF::get(mSlots[index]), key)))
+                {
+                    return index;
+                }
+            }
+            // an insertion would have stopped at the first empty slot
+            if (matchEmpty(ctrl))
+            {
+                return mCapacity;
+            }
+        }
+    }
+
+    // Index of the first empty or erased slot on hash's probe sequence.
+    size_t findFree(U64 hash) const
+    {
+        size_t mask = groupMask();
+        size_t group = size_t(hash) & mask;
+        for (size_t step = 1; ; group = (group + step++) & mask)
+        {
+            U32 free = matchFree(loadGroup(group));
+            if (free)
+            {
+                return group * GROUP_SIZE + lowestBit(free);
+            }
+        }
+    }
+
+    void eraseIndex(size_t index)
+    {
+        mSlots[index].~VALUE();
+        --mSize;
+        // A lookup for a key past this group would have stopped at an empty
+        // slot of this group: when it has one, no probe sequence goes
+        // through the slot and it can be marked empty.
+        if (matchEmpty(loadGroup(index / GROUP_SIZE)))
+        {
+            mCtrl[index] = CTRL_EMPTY;
+        }
+        else
+        {
+            mCtrl[index] = CTRL_ERASED;
+            ++mErased;
+        }
+    }
+
+    void growForInsert()
+    {
+        // Mostly erased slots: rehashing in place purges them. Otherwise
+        // double.
+        if (mCapacity && (mSize + 1) * MAX_LOAD_DEN * 2 <= mCapacity * MAX_LOAD_NUM)
+        {
+            rehash(mCapacity);
+        }
+        else
+        {
+            rehash(mCapacity ? mCapacity * 2 : GROUP_SIZE);
+        }
+    }
+
+    void rehash(size_t capacity)
+    {
+        U8* old_ctrl = mCtrl;
+        VALUE* old_slots = mSlots;
+        size_t old_capacity = mCapacity;
+
+        mCtrl = (U8*)ll_aligned_malloc_16(capacity);
+        memset(mCtrl, CTRL_EMPTY, capacity);
+        mSlots = std::allocator<VALUE>().allocate(capacity);
+        mCapacity = capacity;
+        mErased = 0;
+
+        for (size_t i = 0; i < old_capacity; ++i)
+        {
+            if (!(old_ctrl[i] & 0x80))
+            {
+                U64 hash = hashOf(KEY_OF::get(old_slots[i]));
+                size_t index = findFree(hash);
+                new (mSlots + index) VALUE(std::move(old_slots[i]));
+                old_slots[i].~VALUE();
+                mCtrl[index] = tagOf(hash);
+            }
+        }
+        if (old_ctrl)
+        {
+            ll_aligned_free_16(old_ctrl);
+            std::allocator<VALUE>().deallocate(old_slots, old_capacity);
+        }
+    }
+
+    void destroyValues()
+    {
+        if (!std::is_trivially_destructible<VALUE>::value)
+        {
+            for (size_t i = 0; i < mCapacity; ++i)
+            {
+                if (!(mCtrl[i] & 0x80))
+                {
+                    mSlots[i].~VALUE();
+                }
+            }
+        }
+    }
+
+    void destroy()
+    {
+        if (mCtrl)
+        {
+            destroyValues();
+            ll_aligned_free_16(mCtrl);
+            std::allocator<VALUE>().deallocate(mSlots, mCapacity);
+            mCtrl = nullptr;
+            mSlots = nullptr;
+            mCapacity = 0;
+            mSize = 0;
+            mErased = 0;
+        }
+    }
+
+    U8* mCtrl = nullptr;
+    VALUE* mSlots = nullptr;
+    size_t mCapacity = 0;
+    size_t mSize = 0;
+    size_t mErased = 0;
+};
+
+} // namespace LLUUIDHash
+
+/**
+ * Drop-in replacement for std::map<LLUUID, T> and
+ * std::unordered_map<LLUUID, T> where iteration order doesn't matter.
+ */
+template <typename T>
+class LLUUIDHashMap: public LLUUIDHash::Table<std::pair<const LLUUID, T>, LLUUIDHash::MapKey>
+{
+    typedef LLUUIDHash::Table<std::pair<const LLUUID, T>, LLUUIDHash::MapKey> table_t;
+
+public:
+    typedef T mapped_type;
+    typedef typename table_t::iterator iterator;
+    typedef typename table_t::const_iterator const_iterator;
+
+    using table_t::insert;
+
+    LLUUIDHashMap() = default;
+
+    LLUUIDHashMap(std::initializer_list<typename table_t::value_type> values)
+    {
+        this->reserve(values.size());
+        insert(values.begin(), values.end());
+    }
+
+    template <typename... ARGS>
+    std::pair<iterator, bool> try_emplace(const LLUUID& key, ARGS&&... args)
+    {
+        return this->emplaceKey(key, std::piecewise_construct, std::forward_as_tuple(key),
+                                std::forward_as_tuple(std::forward<ARGS>(args)...));
+    }
+
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(const LLUUID& key, M&& value)
+    {
+        auto result = try_emplace(key, std::forward<M>(value));
+        if (!result.second)
+        {
+            result.first->second = std::forward<M>(value);
+        }
+        return result;
+    }
+
+    T& operator[](const LLUUID& key)
+    {
+        return try_emplace(key).first->second;
+    }
+
+    T& at(const LLUUID& key)
+    {
+        iterator found = this->find(key);
+        if (found == this->end())
+        {
+            throw std::out_of_range("LLUUIDHashMap::at(): " + key.asString());
+        }
+        return found->second;
+    }
+
+    const T& at(const LLUUID& key) const
+    {
+        const_iterator found = this->find(key);
+        if (found == this->end())
+        {
+            throw std::out_of_range("LLUUIDHashMap::at(): " + key.asString());
+        }
+        return found->second;
+    }
+};
+
+/**
+ * Drop-in replacement for std::set<LLUUID> and std::unordered_set<LLUUID>
+ * where iteration order doesn't matter. Elements are const: iterator and
+ * const_iterator both give const LLUUID&.
+ */
+class LLUUIDHashSet: public LLUUIDHash::Table<LLUUID, LLUUIDHash::SetKey>
+{
+    typedef LLUUIDHash::Table<LLUUID, LLUUIDHash::SetKey> table_t;
+
+public:
+    typedef const_iterator iterator;
+
+    LLUUIDHashSet() = default;
+
+    LLUUIDHashSet(std::initializer_list<LLUUID> ids)
+    {
+        reserve(ids.size());
+        insert(ids.begin(), ids.end());
+    }
+
+    template <typename ITER>
+    LLUUIDHashSet(ITER first, ITER last)
+    {
+        insert(first, last);
+    }
+
+    using table_t::insert;
+    using table_t::erase;
+
+    std::pair<iterator, bool> insert(const LLUUID& id)
+    {
+        return emplaceKey(id, id);
+    }
+
+    const_iterator begin() const { return table_t::begin(); }
+    const_iterator end() const { return table_t::end(); }
+    const_iterator find(const LLUUID& id) const { return table_t::find(id); }
+};
+
+// llstl.h map helpers, for the maps migrated from std::map
+
+template <typename T>
+inline bool is_in_map(const LLUUIDHashMap<T>& inmap, const LLUUID& key)
+{
+    return inmap.contains(key);
+}
+
+template <typename T>
+inline T get_if_there(const LLUUIDHashMap<T>& inmap, const LLUUID& key, T default_value)
+{
+    auto found = inmap.find(key);
+    return found == inmap.end() ? default_value : found->second;
+}
+
+#endif // LL_LLUUIDHASHMAP_H
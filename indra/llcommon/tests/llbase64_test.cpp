@@ -34,6 +34,33 @@
 
 #include "../test/lltut.h"
 
+#include "apr_base64.h"
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+    const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::string apr_encode(const std::vector<U8>& bytes, size_t len)
+    {
+        std::vector<char> buffer(apr_base64_encode_len((int)len));
+        int written = apr_base64_encode_binary(buffer.data(), bytes.data(), (int)len);
+        return std::string(buffer.data(), written - 1);
+    }
+
+    std::vector<U8> apr_decode(const std::string& text)
+    {
+        std::vector<U8> buffer(apr_base64_decode_len(text.c_str()));
+        buffer.resize(apr_base64_decode_binary(buffer.data(), text.c_str()));
+        return buffer;
+    }
+}
+
 namespace tut
 {
     struct base64_data
@@ -74,4 +101,98 @@ namespace tut
                 (result == "c9+s/4xGMX3smy3HZRGkg+YTUEBwNYdi7QwaSH4OkY92xAuxhKnDhg==") );
     }
 
+    template<> template<>
+    void base64_object::test<3>()
+    {
+        set_test_name("encode and decode match apr_base64");
+        std::mt19937 random(25);
+        std::vector<U8> bytes(1000);
+        for (U8& byte : bytes)
+        {
+            byte = (U8)random();
+        }
+        for (size_t len = 0; len < bytes.size(); len += (len < 100 ? 1 : 37))
+        {
+            std::string encoded = LLBase64::encode(bytes.data(), len);
+            ensure_equals("encode", encoded, apr_encode(bytes, len));
+            ensure("round trip", LLBase64::decode(encoded) == std::vector<U8>(bytes.begin(), bytes.begin() + len));
+        }
+
+        // decoding stops at the first character outside the alphabet, in
+        // or after a block the SSSE3 kernel takes
+        std::string valid;
+        for (size_t i = 0; i < 48; ++i)
+        {
+            valid += ALPHABET[random() % 64];
+        }
+        for (S32 c = 0; c < 256; ++c)
+        {
+            for (size_t pos : { 0, 1, 2, 3, 15, 16, 17, 30, 31, 47 })
+            {
+                std::string text(valid);
+                text[pos] = (char)c;
+                ensure("decode with a stray character", LLBase64::decode(text) == apr_decode(text));
+            }
+        }
+
+        const char NOISE[] = "= \n\t-_.~\x80\xff";
+        for (S32 trial = 0; trial < 20000; ++trial)
+        {
+            std::string text;
+            size_t len = random() % 80;
+            for (size_t i = 0; i < len; ++i)
+            {
+                if (random() % 16)
+                {
+                    text += ALPHABET[random() % 64];
+                }
+                else
+                {
+                    text += (random() % 4) ? NOISE[random() % (sizeof(NOISE) - 1)] : '\0';
+                }
+            }
+            ensure("decode", LLBase64::decode(text) == apr_decode(text));
+
+            std::vector<char> decoded(apr_base64_decode_len(text.c_str()));
+            apr_base64_decode(decoded.data(), text.c_str());
+            ensure_equals("decodeAsString", LLBase64::decodeAsString(text), std::string(decoded.data()));
+        }
+    }
+
+    template<> template<>
+    void base64_object::test<4>()
+    {
+        set_test_name("throughput against apr_base64");
+        // Only prints timings, the output is checked by the tests above
+        if (!getenv("LL_BASE64_BENCHMARK"))
+        {
+            skip("set LL_BASE64_BENCHMARK to run the benchmark");
+        }
+        std::mt19937 random(26);
+        std::vector<U8> bytes(256 * 1024);
+        for (U8& byte : bytes)
+        {
+            byte = (U8)random();
+        }
+        std::string text = LLBase64::encode(bytes.data(), bytes.size());
+        const S32 ROUNDS = 40;
+        auto mb_per_s = [&](const std::function<size_t()>& run)
+        {
+            size_t check = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (S32 i = 0; i < ROUNDS; ++i)
+            {
+                check += run();
+            }
+            std::chrono::duration<F64> spent(std::chrono::steady_clock::now() - start);
+            ensure("ran", check > 0);
+            return bytes.size() * ROUNDS / spent.count() / (1024. * 1024.);
+        };
+        F64 apr_enc = mb_per_s([&]() { return apr_encode(bytes, bytes.size()).size(); });
+        F64 enc = mb_per_s([&]() { return LLBase64::encode(bytes.data(), bytes.size()).size(); });
+        F64 apr_dec = mb_per_s([&]() { return apr_decode(text).size(); });
+        F64 dec = mb_per_s([&]() { return LLBase64::decode(text).size(); });
+        std::cout << "\nbase64 MB/s of binary, encode: apr " << apr_enc << ", LLBase64 " << enc
+                  << "; decode: apr " << apr_dec << ", LLBase64 " << dec << std::endl;
+    }
 }
@@ -0,0 +1,256 @@
+/**
+ * @file llconcurrentthreadsafequeue_test.cpp
+ * @brief Tests for LLConcurrentThreadSafeQueue, and a many producers, one
+ *        consumer benchmark against LLThreadSafeQueue.
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../llconcurrentthreadsafequeue.h"
+
+#include "../test/lltut.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace tut
+{
+    struct LLConcurrentThreadSafeQueueFixture
+    {
+        typedef std::chrono::duration<F64, std::milli> ms_t;
+
+        // Elements carry their producer in the high bits and a per-producer
+        // sequence number in the low bits.
+        static U64 element(U32 producer, U32 seq) { return (U64(producer) << 32) | seq; }
+
+        struct Result
+        {
+            F64 mMs = 0;
+            F64 mPushNs = 0;
+            bool mOrdered = true;
+        };
+
+        // Run 'producers' threads pushing 'count' elements each to a queue
+        // with the passed capacity, popped by the calling thread.
+        template <typename QUEUE>
+        Result run(U32 producers, U32 count, size_t capacity)
+        {
+            QUEUE queue(capacity);
+            std::vector<std::thread> threads;
+            std::vector<F64> push_ns(producers);
+            auto start = std::chrono::steady_clock::now();
+            for (U32 p = 0; p < producers; ++p)
+            {
+                threads.emplace_back(
+                    [&queue, &push_ns, p, count]()
+                    {
+                        auto begin = std::chrono::steady_clock::now();
+                        for (U32 i = 0; i < count; ++i)
+                        {
+                            queue.push(element(p, i));
+                        }
+                        std::chrono::duration<F64, std::nano> spent(std::chrono::steady_clock::now() - begin);
+                        push_ns[p] = spent.count() / count;
+                    });
+            }
+
+            Result result;
+            std::vector<U32> next(producers, 0);
+            for (U64 popped = 0, total = U64(producers) * count; popped < total; ++popped)
+            {
+                U64 value = queue.pop();
+                U32 p = U32(value >> 32);
+                if (p >= producers || U32(value) != next[p]++)
+                {
+                    result.mOrdered = false;
+                }
+            }
+            result.mMs = ms_t(std::chrono::steady_clock::now() - start).count();
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+            for (F64 ns : push_ns)
+            {
+                result.mPushNs += ns / producers;
+            }
+            return result;
+        }
+    };
+    typedef test_group<LLConcurrentThreadSafeQueueFixture> LLConcurrentThreadSafeQueue_factory;
+    typedef LLConcurrentThreadSafeQueue_factory::object LLConcurrentThreadSafeQueue_t;
+    LLConcurrentThreadSafeQueue_factory tf("LLConcurrentThreadSafeQueue");
+
+    template<> template<>
+    void LLConcurrentThreadSafeQueue_t::test<1>()
+    {
+        set_test_name("push, pop and capacity");
+        LLConcurrentThreadSafeQueue<S32> queue(3);
+        ensure_equals("capacity", queue.capacity(), 3U);
+        S32 value = 0;
+        ensure("tryPop() on empty queue", !queue.tryPop(value));
+        ensure("tryPopFor() on empty queue", !queue.tryPopFor(std::chrono::milliseconds(5), value));
+        queue.push(1);
+        ensure("tryPush()", queue.tryPush(2));
+        ensure("tryPushFor()", queue.tryPushFor(std::chrono::milliseconds(5), 3));
+        ensure_equals("size", queue.size(), 3U);
+        ensure("tryPush() on full queue", !queue.tryPush(4));
+        ensure("tryPushFor() on full queue", !queue.tryPushFor(std::chrono::milliseconds(5), 4));
+        ensure_equals("first", queue.pop(), 1);
+        ensure("tryPop()", queue.tryPop(value));
+        ensure_equals("second", value, 2);
+        ensure("tryPopFor()", queue.tryPopFor(std::chrono::milliseconds(5), value));
+        ensure_equals("third", value, 3);
+        ensure_equals("empty", queue.size(), 0U);
+        ensure("not done while open", !queue.done());
+    }
+
+    template<> template<>
+    void LLConcurrentThreadSafeQueue_t::test<2>()
+    {
+        set_test_name("close()");
+        LLConcurrentThreadSafeQueue<S32> queue;
+        queue.push(1);
+        queue.push(2);
+        queue.close();
+        ensure("isClosed()", queue.isClosed());
+        ensure("not done() until drained", !queue.done());
+        ensure("pushIfOpen() after close()", !queue.pushIfOpen(3));
+        ensure("tryPush() after close()", !queue.tryPush(3));
+        bool threw = false;
+        try
+        {
+            queue.push(3);
+        }
+        catch (const LLThreadSafeQueueInterrupt&)
+        {
+            threw = true;
+        }
+        ensure("push() after close() throws", threw);
+
+        ensure_equals("drains first", queue.pop(), 1);
+        S32 value = 0;
+        ensure("drains second", queue.tryPop(value));
+        ensure_equals("second", value, 2);
+        ensure("done()", queue.done());
+        ensure("tryPop() when done", !queue.tryPop(value));
+        threw = false;
+        try
+        {
+            queue.pop();
+        }
+        catch (const LLThreadSafeQueueInterrupt&)
+        {
+            threw = true;
+        }
+        ensure("pop() when done throws", threw);
+    }
+
+    template<> template<>
+    void LLConcurrentThreadSafeQueue_t::test<3>()
+    {
+        set_test_name("close() wakes blocked pop() and push()");
+        LLConcurrentThreadSafeQueue<S32> empty;
+        std::atomic<bool> interrupted{ false };
+        std::thread consumer(
+            [&empty, &interrupted]()
+            {
+                try
+                {
+                    empty.pop();
+                }
+                catch (const LLThreadSafeQueueInterrupt&)
+                {
+                    interrupted = true;
+                }
+            });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        empty.close();
+        consumer.join();
+        ensure("blocked pop() interrupted", interrupted);
+
+        LLConcurrentThreadSafeQueue<S32> full(1);
+        full.push(1);
+        std::atomic<bool> pushed{ true };
+        std::thread producer(
+            [&full, &pushed]()
+            {
+                pushed = full.pushIfOpen(2);
+            });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        full.close();
+        producer.join();
+        ensure("blocked pushIfOpen() refused", !pushed);
+        ensure_equals("only the first element", full.pop(), 1);
+        ensure("done()", full.done());
+    }
+
+    template<> template<>
+    void LLConcurrentThreadSafeQueue_t::test<4>()
+    {
+        set_test_name("many producers, one consumer");
+        // A small capacity keeps producers blocking and waking on the
+        // consumer, which is where lost wakeups would show up as a hang.
+        Result result = run<LLConcurrentThreadSafeQueue<U64>>(8, 20000, 16);
+        ensure("each producer's elements arrive in order", result.mOrdered);
+    }
+
+    template<> template<>
+    void LLConcurrentThreadSafeQueue_t::test<5>()
+    {
+        set_test_name("throughput and push latency vs LLThreadSafeQueue");
+        // test<4> covers correctness under load; this only prints timings
+        if (!getenv("LL_CONCURRENT_QUEUE_BENCHMARK"))
+        {
+            skip("set LL_CONCURRENT_QUEUE_BENCHMARK to run the benchmark");
+        }
+        const U32 COUNT = 50000;
+        const size_t CAPACITY = 1024;
+        std::cout << "\nproducers x " << COUNT << " elements, capacity " << CAPACITY << ", one consumer" << std::endl;
+        // LLThreadSafeQueue's boost::fibers mutex spins across threads: with
+        // a single core, the spinning thread starves the lock holder and the
+        // run takes minutes. Only time the concurrent queue there.
+        const bool compare = std::thread::hardware_concurrency() > 1;
+        for (U32 producers : { 1U, 2U, 4U, 8U })
+        {
+            F64 total = F64(producers) * COUNT;
+            std::cout << producers << " producers: ";
+            if (compare)
+            {
+                Result locked = run<LLThreadSafeQueue<U64>>(producers, COUNT, CAPACITY);
+                std::cout << "LLThreadSafeQueue " << locked.mMs << " ms, "
+                          << total / locked.mMs / 1000. << " M/s, push " << locked.mPushNs << " ns; ";
+                ensure("mutex queue ordered", locked.mOrdered);
+            }
+            Result concurrent = run<LLConcurrentThreadSafeQueue<U64>>(producers, COUNT, CAPACITY);
+            std::cout << "LLConcurrentThreadSafeQueue " << concurrent.mMs << " ms, "
+                      << total / concurrent.mMs / 1000. << " M/s, push " << concurrent.mPushNs << " ns"
+                      << std::endl;
+            ensure("concurrent queue ordered", concurrent.mOrdered);
+        }
+    }
+}
@@ -0,0 +1,147 @@
+/**
+ * @file llcrc_test.cpp
+ * @brief Tests for LLCRC against a bitwise CRC-32, and its throughput
+ *        against the byte at a time table.
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../llcrc.h"
+
+#include "../test/lltut.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+    U32 bitwise_crc(const U8* data, size_t size)
+    {
+        U32 crc = 0xffffffff;
+        for (size_t i = 0; i < size; ++i)
+        {
+            crc ^= data[i];
+            for (S32 bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+            }
+        }
+        return ~crc;
+    }
+}
+
+namespace tut
+{
+    struct crc_data
+    {
+    };
+    typedef test_group<crc_data> crc_test;
+    typedef crc_test::object crc_object;
+    tut::crc_test crc("LLCRC");
+
+    template<> template<>
+    void crc_object::test<1>()
+    {
+        set_test_name("buffers, bytes and pieces agree with a bitwise CRC-32");
+        const char* CHECK = "123456789";
+        LLCRC check;
+        check.update((const U8*)CHECK, 9);
+        ensure_equals("check value", check.getCRC(), 0xcbf43926U);
+
+        LLCRC none;
+        none.update(NULL, 0);
+        ensure_equals("nothing", none.getCRC(), 0U);
+
+        std::mt19937 random(25);
+        // sizes up to 5000, at every alignment
+        std::vector<U8> data(5000 + 16);
+        for (U8& byte : data)
+        {
+            byte = (U8)random();
+        }
+        for (size_t size = 0; size < 5000; size += (size < 300 ? 1 : 97))
+        {
+            size_t offset = random() % 16;
+            U32 expected = bitwise_crc(&data[offset], size);
+
+            LLCRC whole;
+            whole.update(&data[offset], size);
+            ensure_equals("buffer", whole.getCRC(), expected);
+
+            LLCRC pieces;
+            size_t split = size ? random() % size : 0;
+            pieces.update(&data[offset], split);
+            if (split < size)
+            {
+                pieces.update(data[offset + split]);
+                pieces.update(&data[offset + split + 1], size - split - 1);
+            }
+            ensure_equals("byte and buffers mixed", pieces.getCRC(), expected);
+        }
+    }
+
+    template<> template<>
+    void crc_object::test<2>()
+    {
+        set_test_name("throughput");
+        // Timings only, test<1> covers the results
+        if (!getenv("LL_CRC_BENCHMARK"))
+        {
+            skip("set LL_CRC_BENCHMARK to run the benchmark");
+        }
+        std::mt19937 random(26);
+        std::vector<U8> data(1024 * 1024);
+        for (U8& byte : data)
+        {
+            byte = (U8)random();
+        }
+        const S32 ROUNDS = 20;
+        U32 bytewise = 0, buffered = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (S32 i = 0; i < ROUNDS; ++i)
+        {
+            LLCRC crc;
+            for (U8 byte : data)
+            {
+                crc.update(byte);
+            }
+            bytewise = crc.getCRC();
+        }
+        std::chrono::duration<F64> table(std::chrono::steady_clock::now() - start);
+        start = std::chrono::steady_clock::now();
+        for (S32 i = 0; i < ROUNDS; ++i)
+        {
+            LLCRC crc;
+            crc.update(data.data(), data.size());
+            buffered = crc.getCRC();
+        }
+        std::chrono::duration<F64> kernel(std::chrono::steady_clock::now() - start);
+        ensure_equals("same CRC", buffered, bytewise);
+        F64 mb = data.size() * ROUNDS / (1024. * 1024.);
+        std::cout << "\nCRC-32 MB/s, byte at a time " << mb / table.count()
+                  << ", whole buffer " << mb / kernel.count() << std::endl;
+    }
+}
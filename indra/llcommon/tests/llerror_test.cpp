@@ -921,6 +921,48 @@ namespace tut
     }
 }
 
+namespace tut
+{
+    template<> template<>
+    void ErrorTestObject::test<19>()
+        // async logging keeps order, flushes on errors and drops when full
+    {
+        LLError::setDefaultLevel(LLError::LEVEL_DEBUG);
+        fatalWasCalled = false;
+
+        LLError::setAsyncLogging(true);
+        for (int i = 0; i < 100; ++i)
+        {
+            LL_INFOS() << "async " << i << LL_ENDL;
+        }
+        CATCH(LL_ERRS(), "after async");
+        ensure("fatal callback called", fatalWasCalled);
+        ensure_message_count(101);
+        ensure_message_field_equals(0, MSG_FIELD, "async 0");
+        ensure_message_field_equals(99, MSG_FIELD, "async 99");
+        ensure_message_field_equals(100, MSG_FIELD, "after async");
+        LLError::AsyncLoggingStats stats = LLError::getAsyncLoggingStats();
+        ensure_equals("queued", stats.mQueued, 100U);
+        ensure_equals("written", stats.mWritten, 100U);
+
+        // with no room at all, warnings are written synchronously and the
+        // rest is dropped
+        clearMessages();
+        LLError::setAsyncLogging(true, 0);
+        LL_DEBUGS() << "dropped debug" << LL_ENDL;
+        LL_INFOS() << "dropped info" << LL_ENDL;
+        LL_WARNS() << "overflowed warning" << LL_ENDL;
+        LLError::flushAsyncLogging();
+        stats = LLError::getAsyncLoggingStats();
+        LLError::setAsyncLogging(false);
+        ensure_equals("dropped debug", stats.mDropped[LLError::LEVEL_DEBUG], 1U);
+        ensure_equals("dropped info", stats.mDropped[LLError::LEVEL_INFO], 1U);
+        ensure_equals("overflowed", stats.mOverflowed, 1U);
+        ensure_contains("warning written", message(0), "overflowed warning");
+        ensure("async logging off", !LLError::getAsyncLogging());
+    }
+}
+
 /* Tests left:
     handling of classes without LOG_CLASS
 
@@ -333,4 +333,35 @@ namespace tut
         set_test_name("LLEventLogProxyFor<LLEventMailDrop>");
         tut::test< LLEventLogProxyFor<LLEventMailDrop> >();
     }
+
+    template<> template<>
+    void object::test<8>()
+    {
+        set_test_name("coroutine stack use");
+        const size_t DEPTH = 100000;
+        for (int i = 0; i < 3; ++i)
+        {
+            LLCoros::instance().launch("test<8>",
+                                       [DEPTH]()
+                                       {
+                                           volatile char buffer[DEPTH];
+                                           for (size_t i = 0; i < DEPTH; i += 512)
+                                           {
+                                               buffer[i] = char(i);
+                                           }
+                                       });
+            // let the scheduler release the terminated coroutine
+            llcoro::suspend();
+        }
+        LLSD usage(LLCoros::instance().getStackUsage()["test<8>"]);
+#if LL_WINDOWS
+        // only the first of them is sampled
+        ensure_equals("count", usage["count"].asInteger(), 1);
+#else  // ! LL_WINDOWS
+        ensure_equals("count", usage["count"].asInteger(), 3);
+#endif // ! LL_WINDOWS
+        ensure("max covers the buffer", size_t(usage["max"].asInteger()) >= DEPTH);
+        // recycled stacks are measured afresh, not by what they held before
+        ensure("max not the whole stack", usage["max"].asInteger() < 512 * 1024);
+    }
 }
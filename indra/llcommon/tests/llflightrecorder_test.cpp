@@ -0,0 +1,222 @@
+/**
+ * @file llflightrecorder_test.cpp
+ * @brief Tests for LLTrace::FlightRecorder, and a measure of its overhead
+ *        per BlockTimer.
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../llflightrecorder.h"
+
+#include "../llfasttimer.h"
+#include "../llfile.h"
+#include "../llsdjson.h"
+#include "../lltracethreadrecorder.h"
+#include "../test/lltut.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+    LLTrace::BlockTimerStatHandle sFlightOuter("flight_outer");
+    LLTrace::BlockTimerStatHandle sFlightInner("flight_inner");
+
+    // the first X event named name in trace, or undefined
+    LLSD find_event(const LLSD& trace, const std::string& name)
+    {
+        for (const LLSD& event : llsd::inArray(trace["traceEvents"]))
+        {
+            if (event["ph"].asString() == "X" && event["name"].asString() == name)
+            {
+                return event;
+            }
+        }
+        return LLSD();
+    }
+}
+
+namespace tut
+{
+    struct flightrecorder_data
+    {
+        LLTrace::ThreadRecorder mRecorder;
+        std::string mDir;
+
+        flightrecorder_data():
+            mDir(std::string(LLFile::tmpdir()) + "flightrecorder_test")
+        {
+            LLFile::mkdir(mDir);
+        }
+
+        ~flightrecorder_data()
+        {
+            LLTrace::FlightRecorder::waitForDump();
+            LLTrace::FlightRecorder::setEnabled(false);
+        }
+
+        LLSD readTrace(const std::string& filename)
+        {
+            std::ifstream in(filename);
+            std::stringstream text;
+            text << in.rdbuf();
+            in.close();
+            LLFile::remove(filename);
+            LLSD trace;
+            std::string error;
+            ensure("trace is JSON: " + error, LlsdFromJsonString(text.str(), trace, &error));
+            return trace;
+        }
+    };
+    typedef test_group<flightrecorder_data> flightrecorder_group;
+    typedef flightrecorder_group::object object;
+    flightrecorder_group flightrecorder("LLFlightRecorder");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("slow frames dump nested timers of every thread");
+        LLTrace::FlightRecorder::configure(10.f, 2, mDir, 0.f, 100);
+        LLTrace::FlightRecorder::setEnabled(true);
+        LLTrace::FlightRecorder::endFrame();
+        ensure("fast frame not dumped", !LLTrace::FlightRecorder::endFrame());
+        {
+            LL_RECORD_BLOCK_TIME(sFlightOuter);
+            LL_RECORD_BLOCK_TIME(sFlightInner);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        std::thread worker(
+            []()
+            {
+                LLTrace::FlightRecorder::setThreadName("flight worker");
+                U64 now = LLTrace::BlockTimer::getCPUClockCount64();
+                LLTrace::FlightRecorder::record(&sFlightInner, now, true);
+                LLTrace::FlightRecorder::record(&sFlightInner, now + 1000, false);
+                // the newest event of a thread may be in progress: skipped
+                LLTrace::FlightRecorder::record(&sFlightOuter, now + 2000, true);
+            });
+        worker.join();
+        ensure("slow frame dumped", LLTrace::FlightRecorder::endFrame());
+        LLTrace::FlightRecorder::waitForDump();
+
+        std::string filename = LLTrace::FlightRecorder::dump("test");
+        ensure("dump() names its file", !filename.empty());
+        LLTrace::FlightRecorder::waitForDump();
+        LLSD trace = readTrace(filename);
+        ensure_equals("reason", trace["otherData"]["reason"].asString(), "test");
+
+        LLSD outer = find_event(trace, "flight_outer");
+        LLSD inner = find_event(trace, "flight_inner");
+        ensure("outer timer recorded", outer.isMap());
+        ensure("inner timer recorded", inner.isMap());
+        ensure("inner nested in outer",
+               inner["ts"].asReal() >= outer["ts"].asReal()
+               && inner["ts"].asReal() + inner["dur"].asReal() <= outer["ts"].asReal() + outer["dur"].asReal() + 0.01);
+        S32 frames = 0, inner_tids = 0;
+        bool named = false;
+        for (const LLSD& event : llsd::inArray(trace["traceEvents"]))
+        {
+            frames += event["name"].asString() == "Frame";
+            inner_tids += event["name"].asString() == "flight_inner";
+            named |= event["args"]["name"].asString() == "flight worker";
+        }
+        ensure_equals("window of two frames", frames, 2);
+        ensure_equals("inner timer on both threads", inner_tids, 2);
+        ensure("worker thread named", named);
+
+        // a dump was just written: the next slow frame is within the cooldown
+        LLTrace::FlightRecorder::configure(10.f, 2, mDir, 60.f, 100);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ensure("cooldown", !LLTrace::FlightRecorder::endFrame());
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("cost per BlockTimer");
+        // Two million timers, and all it does is print what they cost
+        if (!getenv("LL_FLIGHT_RECORDER_BENCHMARK"))
+        {
+            skip("set LL_FLIGHT_RECORDER_BENCHMARK to run the benchmark");
+        }
+        const S32 COUNT = 1000000;
+        auto run = [COUNT]()
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (S32 i = 0; i < COUNT; ++i)
+            {
+                LL_RECORD_BLOCK_TIME(sFlightOuter);
+                LL_RECORD_BLOCK_TIME(sFlightInner);
+            }
+            std::chrono::duration<F64, std::nano> spent(std::chrono::steady_clock::now() - start);
+            return spent.count() / (2 * COUNT);
+        };
+        LLTrace::FlightRecorder::setEnabled(false);
+        F64 off = run();
+        LLTrace::FlightRecorder::setEnabled(true);
+        F64 on = run();
+        LLTrace::FlightRecorder::setEnabled(false);
+        // A busy viewer frame runs a few thousand timers.
+        F64 per_frame_us = (on - off) * 5000 / 1000.;
+        std::cout << "\nBlockTimer " << off << " ns, with flight recorder " << on << " ns: "
+                  << per_frame_us << " us for 5000 timers, "
+                  << per_frame_us / 16667. * 100. << "% of a 60 fps frame" << std::endl;
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("paused recorder and old dumps");
+        // dumps an earlier session left behind
+        for (S32 i = 0; i < 3; ++i)
+        {
+            llofstream old(mDir + "/hitch_old_" + std::to_string(i) + ".json");
+            old << "{}";
+        }
+        LLTrace::FlightRecorder::configure(10.f, 2, mDir, 0.f, 100, 1);
+        S32 left = 0;
+        for (S32 i = 0; i < 3; ++i)
+        {
+            left += LLFile::isfile(mDir + "/hitch_old_" + std::to_string(i) + ".json");
+        }
+        ensure_equals("only the newest dump kept", left, 1);
+
+        LLTrace::FlightRecorder::setEnabled(true);
+        LLTrace::FlightRecorder::setPaused(true);
+        LLTrace::FlightRecorder::endFrame();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ensure("paused: slow frame not dumped", !LLTrace::FlightRecorder::endFrame());
+        LLTrace::FlightRecorder::setPaused(false);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ensure("resumed: slow frame dumped", LLTrace::FlightRecorder::endFrame());
+        LLTrace::FlightRecorder::waitForDump();
+        for (S32 i = 0; i < 3; ++i)
+        {
+            LLFile::remove(mDir + "/hitch_old_" + std::to_string(i) + ".json", ENOENT);
+        }
+    }
+}
@@ -0,0 +1,315 @@
+/**
+ * @file llsdbenchmark_test.cpp
+ * @brief Throughput of the LLSD serializers and parsers, for every format
+ * and both directions, on documents shaped like the ones the viewer handles.
+ *
+ * Every format is round-tripped on every run, but only timed when
+ * LL_LLSD_BENCHMARK is set. Results are then printed as a table and, when
+ * LL_LLSD_BENCHMARK_OUTPUT names a file, also written there as a JSON array
+ * with one object per measurement:
+ * { "corpus", "format", "direction", "bytes", "iterations", "mb_per_s",
+ *   "llsd_allocs_per_doc" }
+ * so that runs can be compared to spot regressions. Each measurement runs
+ * for at least LL_LLSD_BENCHMARK_SECONDS (0.05 by default).
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+// Exposes llsd::allocationCount()
+#define LLSD_DEBUG_INFO
+#include "linden_common.h"
+#include "../llsdserialize.h"
+
+#include "../llfile.h"
+#include "../llsdjson.h"
+#include "../llsdutil.h"
+#include "../llstring.h"
+#include "../test/lltut.h"
+
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace tut
+{
+    struct LLSDBenchmarkFixture
+    {
+        LLSDBenchmarkFixture()
+        {
+            mTiming = !LLStringUtil::getenv("LL_LLSD_BENCHMARK").empty();
+            std::string seconds = LLStringUtil::getenv("LL_LLSD_BENCHMARK_SECONDS");
+            if (!seconds.empty())
+            {
+                mMinSeconds = atof(seconds.c_str());
+            }
+            mResults = LLSD::emptyArray();
+        }
+
+        // AIS inventory response
+        static LLSD makeInventory()
+        {
+            LLSD items = LLSD::emptyArray();
+            for (S32 i = 0; i < 1000; ++i)
+            {
+                LLSD item;
+                item["item_id"] = LLUUID::generateNewID();
+                item["parent_id"] = LLUUID::generateNewID();
+                item["asset_id"] = LLUUID::generateNewID();
+                item["name"] = "Inventory item #" + std::to_string(i);
+                item["desc"] = i % 3 ? "" : "(No Description)";
+                item["type"] = i % 20;
+                item["inv_type"] = i % 24;
+                item["flags"] = i * 7;
+                item["created_at"] = (S32)(1700000000 + i);
+                item["sale_info"] = LLSD().with("sale_price", 10).with("sale_type", "not");
+                item["permissions"] = LLSD()
+                    .with("owner_id", LLUUID::generateNewID())
+                    .with("creator_id", LLUUID::generateNewID())
+                    .with("owner_mask", 0x7fffffff)
+                    .with("group_mask", 0)
+                    .with("everyone_mask", 0)
+                    .with("next_owner_mask", 0x82000)
+                    .with("is_owner_group", i % 2 == 0);
+                items.append(item);
+            }
+            return LLSD().with("items", items).with("version", 12).with("agent_id", LLUUID::generateNewID());
+        }
+
+        // GLTF material override messages
+        static LLSD makeMaterialOverrides()
+        {
+            LLSD objects = LLSD::emptyArray();
+            for (S32 i = 0; i < 300; ++i)
+            {
+                LLSD sides = LLSD::emptyArray();
+                LLSD overrides = LLSD::emptyArray();
+                for (S32 side = 0; side < 8; ++side)
+                {
+                    sides.append(side);
+                    LLSD mat;
+                    mat["bc"] = llsd::array(0.5 + side * 0.01, 0.25, 0.125, 1.0);
+                    mat["ec"] = llsd::array(0.0, 0.0, 0.1 * side);
+                    mat["mf"] = 0.75;
+                    mat["rf"] = 0.333333;
+                    mat["tex"] = llsd::array(LLUUID::generateNewID(), LLUUID::null, LLUUID::generateNewID(), LLUUID::null);
+                    mat["ti"] = llsd::array(LLSD().with("o", llsd::array(0.5, 0.5)).with("s", llsd::array(2.0, 2.0)).with("r", 1.5707963));
+                    overrides.append(mat);
+                }
+                objects.append(LLSD().with("object_id", (S32)(1000000 + i)).with("sides", sides).with("gltf_json", overrides));
+            }
+            return LLSD().with("objects", objects).with("region_handle_x", 256000).with("region_handle_y", 256512);
+        }
+
+        // Deep, narrow nesting of maps and arrays
+        static LLSD makeDeep()
+        {
+            LLSD docs = LLSD::emptyArray();
+            for (S32 i = 0; i < 100; ++i)
+            {
+                LLSD leaf = LLSD().with("value", i).with("label", "leaf");
+                for (S32 depth = 0; depth < 60; ++depth)
+                {
+                    leaf = depth % 2 ? LLSD().with("child", leaf).with("depth", depth) : llsd::array(depth, leaf);
+                }
+                docs.append(leaf);
+            }
+            return docs;
+        }
+
+        // Chat, profiles and notecards: long strings needing escapes
+        static LLSD makeStrings()
+        {
+            LLSD messages = LLSD::emptyArray();
+            for (S32 i = 0; i < 2000; ++i)
+            {
+                std::string text = "Line " + std::to_string(i) + ": \"quoted\" <tag> & 'apostrophes'\t"
+                                   "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80 ";
+                while (text.size() < 400)
+                {
+                    text += "lorem ipsum dolor sit amet, ";
+                }
+                messages.append(LLSD().with("from", "Resident " + std::to_string(i % 50)).with("message", text));
+            }
+            return LLSD().with("messages", messages);
+        }
+
+        // Texture and mesh headers, baked appearance blobs
+        static LLSD makeBinaries()
+        {
+            LLSD blobs = LLSD::emptyArray();
+            for (S32 i = 0; i < 200; ++i)
+            {
+                LLSD::Binary data(256 + 64 * i);
+                for (size_t b = 0; b < data.size(); ++b)
+                {
+                    data[b] = (U8)((b * 31 + i) ^ (b >> 3));
+                }
+                blobs.append(LLSD().with("id", LLUUID::generateNewID()).with("data", data));
+            }
+            return LLSD().with("blobs", blobs);
+        }
+
+        // Time op until mMinSeconds have passed, and record the throughput
+        // over size bytes. Without mTiming, just run it once.
+        void measure(const std::string& corpus, const std::string& format, const std::string& direction,
+                     size_t size, const std::function<void()>& op)
+        {
+            // Warm up, and keep a first run out of the numbers
+            op();
+            if (!mTiming)
+            {
+                return;
+            }
+
+            typedef std::chrono::duration<F64> seconds_t;
+            U32 allocs_before = llsd::allocationCount();
+            S32 iterations = 0;
+            auto start = std::chrono::steady_clock::now();
+            F64 elapsed = 0.0;
+            do
+            {
+                op();
+                ++iterations;
+                elapsed = seconds_t(std::chrono::steady_clock::now() - start).count();
+            }
+            while (elapsed < mMinSeconds || iterations < 2);
+            U32 allocs = llsd::allocationCount() - allocs_before;
+
+            LLSD result;
+            result["corpus"] = corpus;
+            result["format"] = format;
+            result["direction"] = direction;
+            result["bytes"] = (S32)size;
+            result["iterations"] = iterations;
+            result["mb_per_s"] = (F64)size * iterations / elapsed / (1024.0 * 1024.0);
+            result["llsd_allocs_per_doc"] = (S32)(allocs / iterations);
+            mResults.append(result);
+
+            std::cout << std::left << std::setw(20) << corpus << std::setw(12) << format
+                      << std::setw(14) << direction << std::right << std::setw(10) << size << " bytes "
+                      << std::fixed << std::setprecision(1) << std::setw(9) << result["mb_per_s"].asReal() << " MB/s "
+                      << std::setw(8) << result["llsd_allocs_per_doc"].asInteger() << " LLSD allocs/doc" << std::endl;
+        }
+
+        // All the formats, both directions
+        void benchmark(const std::string& corpus, const LLSD& sd)
+        {
+            std::ostringstream str;
+
+            LLSDSerialize::toBinary(sd, str);
+            const std::string binary = str.str();
+            str.str("");
+            LLSDSerialize::toNotation(sd, str);
+            const std::string notation = str.str();
+            str.str("");
+            LLSDSerialize::toXML(sd, str);
+            const std::string xml = str.str();
+            LLSD copy(sd);
+            const std::string zipped = zip_llsd(copy);
+
+            auto check = [this, &sd](const char* what, const LLSD& parsed)
+                {
+                    // reals do not all survive notation and XML exactly
+                    ensure(what, parsed.type() == sd.type() && parsed.size() == sd.size());
+                };
+            LLSD parsed;
+
+            measure(corpus, "binary", "write", binary.size(), [&]()
+                { std::ostringstream out; LLSDSerialize::toBinary(sd, out); });
+            measure(corpus, "binary", "read_stream", binary.size(), [&]()
+                { std::istringstream in(binary); parsed.clear(); LLSDSerialize::fromBinary(parsed, in, binary.size()); });
+            check("binary stream", parsed);
+            measure(corpus, "binary", "read_buffer", binary.size(), [&]()
+                { parsed.clear(); LLSDSerialize::fromBinary(parsed, (const U8*)binary.data(), binary.size()); });
+            check("binary buffer", parsed);
+
+            measure(corpus, "notation", "write", notation.size(), [&]()
+                { std::ostringstream out; LLSDSerialize::toNotation(sd, out); });
+            measure(corpus, "notation", "read_stream", notation.size(), [&]()
+                { std::istringstream in(notation); parsed.clear(); LLSDSerialize::fromNotation(parsed, in, notation.size()); });
+            check("notation stream", parsed);
+            measure(corpus, "notation", "read_buffer", notation.size(), [&]()
+                { parsed.clear(); LLSDSerialize::fromNotation(parsed, (const U8*)notation.data(), notation.size()); });
+            check("notation buffer", parsed);
+
+            LLPointer<LLSDXMLParser> xml_parser = new LLSDXMLParser;
+            measure(corpus, "xml", "write", xml.size(), [&]()
+                { std::ostringstream out; LLSDSerialize::toXML(sd, out); });
+            measure(corpus, "xml", "read_stream", xml.size(), [&]()
+                { std::istringstream in(xml); parsed.clear(); LLSDSerialize::fromXMLDocument(parsed, in); });
+            check("xml stream", parsed);
+            measure(corpus, "xml", "read_buffer", xml.size(), [&]()
+                { parsed.clear(); xml_parser->reset(); xml_parser->parseBuffer((const U8*)xml.data(), xml.size(), parsed); });
+            check("xml buffer", parsed);
+
+            measure(corpus, "zipped", "write", zipped.size(), [&]()
+                { zip_llsd(copy); });
+            measure(corpus, "zipped", "read_buffer", zipped.size(), [&]()
+                { parsed.clear(); LLUZipHelper::unzip_llsd(parsed, (const U8*)zipped.data(), (S32)zipped.size()); });
+            check("zipped", parsed);
+
+            // JSON has no binary type
+            if (corpus != "binary_heavy")
+            {
+                const std::string json = LlsdToJsonString(sd);
+                measure(corpus, "json", "write", json.size(), [&]()
+                    { LlsdToJsonString(sd); });
+                measure(corpus, "json", "read_buffer", json.size(), [&]()
+                    { LlsdFromJsonString(json, parsed); });
+                check("json", parsed);
+            }
+        }
+
+        bool    mTiming{ false };
+        F64     mMinSeconds{ 0.05 };
+        LLSD    mResults;
+    };
+    typedef test_group<LLSDBenchmarkFixture> LLSDBenchmark_factory;
+    typedef LLSDBenchmark_factory::object LLSDBenchmark_t;
+    LLSDBenchmark_factory tf("LLSDBenchmark");
+
+    template<> template<>
+    void LLSDBenchmark_t::test<1>()
+    {
+        set_test_name("LLSD serialization throughput");
+        if (mTiming)
+        {
+            std::cout << std::endl;
+        }
+        benchmark("inventory", makeInventory());
+        benchmark("material_overrides", makeMaterialOverrides());
+        benchmark("deep", makeDeep());
+        benchmark("string_heavy", makeStrings());
+        benchmark("binary_heavy", makeBinaries());
+
+        std::string output = LLStringUtil::getenv("LL_LLSD_BENCHMARK_OUTPUT");
+        if (mTiming && !output.empty())
+        {
+            llofstream file(output.c_str());
+            ensure("open " + output, file.is_open());
+            file << LlsdToJsonString(mResults) << std::endl;
+        }
+    }
+}
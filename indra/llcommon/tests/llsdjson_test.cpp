@@ -0,0 +1,191 @@
+/**
+ * @file llsdjson_test.cpp
+ * @brief Tests for the direct JSON reader and writer of llsdjson.h
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../llsdjson.h"
+
+#include "../llsdutil.h"
+#include "../test/lltut.h"
+
+#include <chrono>
+#include <iostream>
+
+namespace tut
+{
+    struct LLSDJsonFixture
+    {
+        // Shaped like an AIS inventory response
+        LLSD makeInventory(S32 count)
+        {
+            LLSD items = LLSD::emptyArray();
+            for (S32 i = 0; i < count; ++i)
+            {
+                LLSD item;
+                item["item_id"] = LLUUID::generateNewID();
+                item["parent_id"] = LLUUID::generateNewID();
+                item["name"] = "Inventory item with a \"quoted\" name #" + std::to_string(i);
+                item["desc"] = "";
+                item["type"] = i % 20;
+                item["created_at"] = LLDate(1700000000.0 + i);
+                item["sale_info"] = LLSD().with("sale_price", 10).with("sale_type", "not");
+                item["permissions"] = LLSD().with("owner_mask", 0x7fffffff).with("is_owner_group", i % 2 == 0);
+                item["scale"] = i * 0.125;
+                items.append(item);
+            }
+            return LLSD().with("items", items).with("version", 3.5).with("next", LLSD());
+        }
+
+        // Parse with the boost::json path
+        LLSD viaBoost(const std::string& json)
+        {
+            boost::system::error_code ec;
+            boost::json::value root = boost::json::parse(json, ec);
+            ensure("boost::json parses " + json.substr(0, 40), !ec.failed());
+            return LlsdFromJson(root);
+        }
+    };
+    typedef test_group<LLSDJsonFixture> LLSDJsonTest_factory;
+    typedef LLSDJsonTest_factory::object LLSDJsonTest_t;
+    LLSDJsonTest_factory tf("LLSDJson");
+
+    template<> template<>
+    void LLSDJsonTest_t::test<1>()
+    {
+        set_test_name("reading matches LlsdFromJson()");
+        const char* documents[] = {
+            "null", "true", "false", "0", "-0", "42", "-2147483648", "1.5", "-2.5e-3", "1E10",
+            "\"\"", "\"plain\"", "\"esc \\\" \\\\ \\/ \\b \\f \\n \\r \\t\"",
+            "\"\\u00e9\\u20ac\\ud83d\\ude00\"", "\"caf\xc3\xa9\"",
+            "\"\xe2\x82\xac \xed\x9f\xbf \xf0\x9f\x98\x80 \xf4\x8f\xbf\xbf\"",
+            "[]", "{}", " [ 1 , [ 2 , [ ] ] , { } ] ",
+            "{\"a\":1,\"b\":{\"c\":[true,null]},\"a\":\"repeated\"}",
+        };
+        for (const char* json : documents)
+        {
+            LLSD direct;
+            std::string error;
+            ensure(std::string("parses ") + json + ": " + error, LlsdFromJsonString(json, direct, &error));
+            ensure_equals(json, direct, viaBoost(json));
+        }
+    }
+
+    template<> template<>
+    void LLSDJsonTest_t::test<2>()
+    {
+        set_test_name("malformed input");
+        const char* documents[] = {
+            "", "{", "[1,]", "{\"a\":1,}", "{\"a\" 1}", "{a:1}", "01", "1.", "-", ".5", "tru",
+            "\"open", "\"\\x\"", "\"\\u12\"", "\"\\ud800\"", "\"\\udc00\"", "\"tab\there\"", "[1] 2",
+            // not UTF-8: stray continuation, truncated, overlong, surrogate,
+            // beyond U+10FFFF, invalid lead byte
+            "\"\x80\"", "\"\xc3\"", "\"\xe2\x82\"", "\"\xc0\xaf\"", "\"\xe0\x80\xaf\"",
+            "\"\xed\xa0\x80\"", "\"\xf4\x90\x80\x80\"", "\"\xff\"", "{\"\xc3\x28\":1}",
+        };
+        for (const char* json : documents)
+        {
+            LLSD result(1);
+            std::string error;
+            ensure(std::string("rejects ") + json, !LlsdFromJsonString(json, result, &error));
+            ensure(std::string("undefined after ") + json, result.isUndefined());
+            ensure(std::string("reports ") + json, !error.empty());
+        }
+
+        LLSD result;
+        ensure("depth limit", !LlsdFromJsonString("[[[[1]]]]", result, nullptr, 3));
+        ensure("within depth limit", LlsdFromJsonString("[[[1]]]", result, nullptr, 3));
+    }
+
+    template<> template<>
+    void LLSDJsonTest_t::test<3>()
+    {
+        set_test_name("writing matches LlsdToJson()");
+        LLSD sd = makeInventory(10);
+        sd["reals"] = llsd::array(0.0, 2.0, -1.0 / 3.0, 0.1, 1e300, 123456789.125);
+        sd["control"] = std::string("\x01\x1f\x7f", 3);
+
+        std::string direct = LlsdToJsonString(sd);
+        ensure_equals("same LLSD as boost::json", viaBoost(direct), LlsdFromJson(LlsdToJson(sd)));
+
+        LLSD parsed;
+        ensure("reads back", LlsdFromJsonString(direct, parsed));
+        ensure("real stays real", parsed["reals"][1].isReal());
+        ensure_equals("exact reals", parsed["reals"], sd["reals"]);
+        direct = "x";
+        LlsdToJsonString(LLSD(1), direct);
+        ensure_equals("appends", direct, "x1");
+    }
+
+    template<> template<>
+    void LLSDJsonTest_t::test<4>()
+    {
+        set_test_name("time per conversion, boost::json vs direct");
+        LLSD sd = makeInventory(5000);
+        const S32 ITERATIONS = 10;
+        const std::string json = LlsdToJsonString(sd);
+
+        LLSD parsed;
+        ensure("parses", LlsdFromJsonString(json, parsed));
+        ensure_equals("same document", parsed, viaBoost(json));
+
+        // The rest is timings
+        if (!getenv("LL_SD_JSON_BENCHMARK"))
+        {
+            skip("set LL_SD_JSON_BENCHMARK to run the benchmark");
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (S32 i = 0; i < ITERATIONS; ++i)
+        {
+            boost::system::error_code ec;
+            LLSD parsed = LlsdFromJson(boost::json::parse(json, ec));
+        }
+        auto boost_read = std::chrono::steady_clock::now();
+        for (S32 i = 0; i < ITERATIONS; ++i)
+        {
+            LLSD parsed;
+            LlsdFromJsonString(json, parsed);
+        }
+        auto direct_read = std::chrono::steady_clock::now();
+        for (S32 i = 0; i < ITERATIONS; ++i)
+        {
+            std::string out = boost::json::serialize(LlsdToJson(sd));
+        }
+        auto boost_write = std::chrono::steady_clock::now();
+        for (S32 i = 0; i < ITERATIONS; ++i)
+        {
+            std::string out = LlsdToJsonString(sd);
+        }
+        auto direct_write = std::chrono::steady_clock::now();
+
+        typedef std::chrono::duration<F64, std::milli> ms_t;
+        std::cout << "\n" << json.size() << " bytes of JSON: read "
+                  << "boost::json " << ms_t(boost_read - start).count() / ITERATIONS << " ms, "
+                  << "direct " << ms_t(direct_read - boost_read).count() / ITERATIONS << " ms; write "
+                  << "boost::json " << ms_t(boost_write - direct_read).count() / ITERATIONS << " ms, "
+                  << "direct " << ms_t(direct_write - boost_write).count() / ITERATIONS << " ms" << std::endl;
+    }
+}
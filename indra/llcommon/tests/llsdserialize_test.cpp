@@ -58,6 +58,7 @@ typedef U32 uint32_t;
 #include "stringize.h"
 #include "StringVec.h"
 #include <functional>
+#include <iterator>
 
 typedef std::function<void(const LLSD& data, std::ostream& str)> FormatterFunction;
 typedef std::function<bool(std::istream& istr, LLSD& data, llssize max_bytes)> ParserFunction;
@@ -268,6 +269,25 @@ namespace tut
             };
         }
 
+        void setBufferParser(LLPointer<LLSDParser> parser)
+        {
+            mParser = [parser](std::istream& istr, LLSD& data, llssize max_bytes) mutable
+            {
+                std::string buffer{ std::istreambuf_iterator<char>(istr), {} };
+                parser->reset();
+                return (parser->parseBuffer((const U8*)buffer.data(), buffer.size(), data) > 0);
+            };
+        }
+
+        void setBufferParser(bool (*parser)(LLSD&, const U8*, size_t))
+        {
+            mParser = [parser](std::istream& istr, LLSD& data, llssize max_bytes)
+            {
+                std::string buffer{ std::istreambuf_iterator<char>(istr), {} };
+                return parser(data, (const U8*)buffer.data(), buffer.size());
+            };
+        }
+
         void setParser(bool (*parser)(LLSD&, std::istream&, llssize))
         {
             // why does LLSDSerialize::deserialize() reverse the parse() params??
@@ -585,6 +605,34 @@ namespace tut
         doRoundTripTests("LLSDXMLFormatter -> deserialize");
     };
 
+    template<> template<>
+    void TestLLSDSerializeObject::test<11>()
+    {
+        setFormatterParser(new LLSDNotationFormatter(false, "", LLSDFormatter::OPTIONS_PRETTY_BINARY),
+                           new LLSDNotationParser());
+        setBufferParser(new LLSDNotationParser());
+        doRoundTripTests("notation serialization -> parseBuffer");
+    };
+
+    template<> template<>
+    void TestLLSDSerializeObject::test<12>()
+    {
+        setFormatterParser(new LLSDBinaryFormatter(), new LLSDBinaryParser());
+        setBufferParser(new LLSDBinaryParser());
+        doRoundTripTests("binary serialization -> parseBuffer");
+    };
+
+    template<> template<>
+    void TestLLSDSerializeObject::test<13>()
+    {
+        mFormatter = [](const LLSD& sd, std::ostream& str)
+        {
+            LLSDSerialize::serialize(sd, str, LLSDSerialize::LLSD_NOTATION);
+        };
+        setBufferParser(LLSDSerialize::deserialize);
+        doRoundTripTests("serialize(LLSD_NOTATION) -> deserialize(buffer)");
+    };
+
 /*==========================================================================*|
     // We do not expect this test to succeed. Without a header, neither
     // notation LLSD nor binary LLSD reliably start with a distinct character,
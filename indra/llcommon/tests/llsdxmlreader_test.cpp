@@ -0,0 +1,176 @@
+/**
+ * @file llsdxmlreader_test.cpp
+ * @brief LLSDXMLReader tests
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../llsdxmlreader.h"
+
+#include "../llsdserialize.h"
+#include "../test/lltut.h"
+
+#include <sstream>
+
+namespace tut
+{
+    // Records the events as one line of text
+    class EventRecorder : public LLSDXMLReader::Handler
+    {
+    public:
+        std::string mEvents;
+        std::string mSkipKey;
+        std::string mStopKey;
+
+        EAction mapKey(std::string_view key) override
+        {
+            mEvents += "k:" + std::string(key) + " ";
+            if (key == mStopKey)
+            {
+                return STOP;
+            }
+            return key == mSkipKey ? SKIP : CONTINUE;
+        }
+        EAction mapBegin() override     { mEvents += "{ "; return CONTINUE; }
+        EAction mapEnd() override       { mEvents += "} "; return CONTINUE; }
+        EAction arrayBegin() override   { mEvents += "[ "; return CONTINUE; }
+        EAction arrayEnd() override     { mEvents += "] "; return CONTINUE; }
+        EAction undefValue() override   { mEvents += "! "; return CONTINUE; }
+        EAction booleanValue(LLSD::Boolean value) override
+        {
+            mEvents += value ? "true " : "false ";
+            return CONTINUE;
+        }
+        EAction integerValue(LLSD::Integer value) override
+        {
+            mEvents += "i" + std::to_string(value) + " ";
+            return CONTINUE;
+        }
+        EAction realValue(LLSD::Real value) override
+        {
+            mEvents += "r" + std::to_string((S32)value) + " ";
+            return CONTINUE;
+        }
+        EAction stringValue(LLSD::String& value) override
+        {
+            mEvents += "s:" + value + " ";
+            return CONTINUE;
+        }
+        EAction uuidValue(const LLSD::UUID& value) override
+        {
+            mEvents += "u:" + value.asString() + " ";
+            return CONTINUE;
+        }
+        EAction binaryValue(LLSD::Binary& value) override
+        {
+            mEvents += "b:" + std::string(value.begin(), value.end()) + " ";
+            return CONTINUE;
+        }
+    };
+
+    struct LLSDXMLReaderFixture
+    {
+        EventRecorder mRecorder;
+        LLSDXMLReader mReader{ mRecorder };
+    };
+
+    typedef test_group<LLSDXMLReaderFixture> LLSDXMLReaderGroup;
+    typedef LLSDXMLReaderGroup::object LLSDXMLReaderObject;
+    LLSDXMLReaderGroup gLLSDXMLReaderGroup("llsd XML reader");
+
+    template<> template<>
+    void LLSDXMLReaderObject::test<1>()
+    {
+        set_test_name("events");
+        std::string xml =
+            "<?xml version=\"1.0\" ?><llsd><map>"
+            "<key>a</key><integer>1</integer>"
+            "<key>b</key><array><real>2.5</real><boolean>true</boolean><undef /><bigint>3</bigint></array>"
+            "<key>c</key><binary encoding=\"base64\">aGVs\nbG8=</binary>"
+            "<key>d</key><uuid>00000000-0000-0000-0000-000000000001</uuid>"
+            "<html>misplaced</html>"
+            "</map></llsd><llsd><string>ignored</string></llsd>";
+        ensure_equals("done", mReader.feed(xml.data(), xml.size(), true), LLSDXMLReader::STATUS_DONE);
+        ensure_equals("events", mRecorder.mEvents,
+                      "{ k:a i1 k:b [ r2 true ! ! ] k:c b:hello k:d u:00000000-0000-0000-0000-000000000001 } ");
+        // map, a, b, its 4 elements, c and d
+        ensure_equals("count", mReader.getValueCount(), 9);
+    }
+
+    template<> template<>
+    void LLSDXMLReaderObject::test<2>()
+    {
+        set_test_name("skipping");
+        mRecorder.mSkipKey = "skip";
+        std::string xml =
+            "<llsd><map>"
+            "<key>skip</key><map><key>x</key><string>hidden</string></map>"
+            "<key>keep</key><string>shown</string>"
+            "<key>skip</key><string>hidden too</string>"
+            "</map></llsd>";
+        ensure_equals("done", mReader.feed(xml.data(), xml.size(), true), LLSDXMLReader::STATUS_DONE);
+        ensure_equals("events", mRecorder.mEvents, "{ k:skip k:keep s:shown k:skip } ");
+
+        mReader.reset();
+        mRecorder.mEvents.clear();
+        mRecorder.mStopKey = "keep";
+        ensure_equals("stopped", mReader.feed(xml.data(), xml.size(), true), LLSDXMLReader::STATUS_ERROR);
+        ensure_equals("events before stop", mRecorder.mEvents, "{ k:skip k:keep ");
+    }
+
+    template<> template<>
+    void LLSDXMLReaderObject::test<3>()
+    {
+        set_test_name("incremental");
+        std::string xml = "<llsd><array><string>first</string><string>second</string></array></llsd>";
+        size_t split = xml.find("<string>second");
+        ensure_equals("first part", mReader.feed(xml.data(), split), LLSDXMLReader::STATUS_OK);
+        ensure_equals("first events", mRecorder.mEvents, "[ s:first ");
+        ensure_equals("second part", mReader.feed(xml.data() + split, xml.size() - split), LLSDXMLReader::STATUS_DONE);
+        ensure_equals("all events", mRecorder.mEvents, "[ s:first s:second ] ");
+
+        mReader.reset();
+        ensure_equals("truncated", mReader.feed(xml.data(), split, true), LLSDXMLReader::STATUS_ERROR);
+    }
+
+    template<> template<>
+    void LLSDXMLReaderObject::test<4>()
+    {
+        set_test_name("fromXML");
+        LLSD sd;
+        sd["name"] = "value";
+        sd["list"][2] = 42;
+        std::stringstream str;
+        LLSDSerialize::toXML(sd, str);
+
+        LLSD parsed;
+        ensure("stream", LLSDSerialize::fromXML(parsed, str) > 0);
+        ensure_equals("stream result", parsed, sd);
+
+        const std::string xml = str.str();
+        LLSD buffer_parsed;
+        ensure("buffer", LLSDSerialize::deserialize(buffer_parsed, (const U8*)xml.data(), xml.size()));
+        ensure_equals("buffer result", buffer_parsed, sd);
+    }
+}
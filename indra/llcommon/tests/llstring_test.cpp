@@ -33,8 +33,164 @@
 #include "StringVec.h"                  // must come BEFORE lltut.h
 #include "../test/lltut.h"
 
+#include <chrono>
+#include <iostream>
+#include <random>
+
 using boost::assign::list_of;
 
+namespace
+{
+    // The character at a time conversions utf8str_to_wstring() and
+    // wstring_to_utf8str() used before they got block ASCII conversion: the
+    // reference their results must match exactly.
+    LLWString reference_utf8str_to_wstring(const char* utf8str, size_t len)
+    {
+        LLWString wout;
+
+        size_t i = 0;
+        while (i < len)
+        {
+            llwchar unichar;
+            U8 cur_char = utf8str[i];
+
+            if (cur_char < 0x80)
+            {
+                unichar = cur_char;
+            }
+            else
+            {
+                S32 cont_bytes = 0;
+                if ((cur_char >> 5) == 0x6)
+                {
+                    unichar = (0x1F&cur_char);
+                    cont_bytes = 1;
+                }
+                else if ((cur_char >> 4) == 0xe)
+                {
+                    unichar = (0x0F&cur_char);
+                    cont_bytes = 2;
+                }
+                else if ((cur_char >> 3) == 0x1e)
+                {
+                    unichar = (0x07&cur_char);
+                    cont_bytes = 3;
+                }
+                else if ((cur_char >> 2) == 0x3e)
+                {
+                    unichar = (0x03&cur_char);
+                    cont_bytes = 4;
+                }
+                else if ((cur_char >> 1) == 0x7e)
+                {
+                    unichar = (0x01&cur_char);
+                    cont_bytes = 5;
+                }
+                else
+                {
+                    wout += LL_UNKNOWN_CHAR;
+                    ++i;
+                    continue;
+                }
+
+                auto end = (len < (i + cont_bytes)) ? len : (i + cont_bytes);
+                do
+                {
+                    ++i;
+
+                    cur_char = utf8str[i];
+                    if ( (cur_char >> 6) == 0x2 )
+                    {
+                        unichar <<= 6;
+                        unichar += (0x3F&cur_char);
+                    }
+                    else
+                    {
+                        unichar = LL_UNKNOWN_CHAR;
+                        --i;
+                        break;
+                    }
+                } while(i < end);
+
+                if ( ((cont_bytes == 1) && (unichar < 0x80))
+                    || ((cont_bytes == 2) && (unichar < 0x800))
+                    || ((cont_bytes == 3) && (unichar < 0x10000))
+                    || ((cont_bytes == 4) && (unichar < 0x200000))
+                    || ((cont_bytes == 5) && (unichar < 0x4000000)) )
+                {
+                    unichar = LL_UNKNOWN_CHAR;
+                }
+            }
+
+            wout += unichar;
+            ++i;
+        }
+        return wout;
+    }
+
+    std::string reference_wstring_to_utf8str(const llwchar* utf32str, size_t len)
+    {
+        std::string out;
+        for (size_t i = 0; i < len; ++i)
+        {
+            char tchars[8];
+            auto n = wchar_to_utf8chars(utf32str[i], tchars);
+            tchars[n] = 0;
+            out += tchars;
+        }
+        return out;
+    }
+
+    // Random text mixing ASCII runs of every length around the block sizes,
+    // well formed characters of every length, and malformed sequences.
+    std::string random_utf8(std::mt19937& random, size_t pieces)
+    {
+        std::string out;
+        for (size_t p = 0; p < pieces; ++p)
+        {
+            char chars[8];
+            switch (random() % 8)
+            {
+            case 0:
+            case 1:
+                for (size_t n = random() % 40; n; --n)
+                {
+                    out += char(random() % 0x80);
+                }
+                break;
+            case 2:
+                out.append(chars, wchar_to_utf8chars(0x80 + random() % 0x780, chars));
+                break;
+            case 3:
+                out.append(chars, wchar_to_utf8chars(0x800 + random() % 0xF800, chars));
+                break;
+            case 4:
+                out.append(chars, wchar_to_utf8chars(0x10000 + random() % 0x100000, chars));
+                break;
+            case 5:
+                // any byte, mostly stray continuations and bad lead bytes
+                out += char(0x80 + random() % 0x80);
+                break;
+            case 6:
+            {
+                // truncated character
+                auto n = wchar_to_utf8chars(0x800 + random() % 0x7FFFF800, chars);
+                out.append(chars, 1 + random() % (n - 1));
+                break;
+            }
+            default:
+                // five and six byte characters, and overlong forms
+                out.append(chars, wchar_to_utf8chars(0x200000 + random() % 0x7FE00000, chars));
+                chars[0] = char(0xC0 | (random() % 2));
+                chars[1] = char(0x80 | (random() % 0x40));
+                out.append(chars, 2);
+                break;
+            }
+        }
+        return out;
+    }
+}
+
 namespace tut
 {
     struct string_index
@@ -868,4 +1024,107 @@ namespace tut
                       LLStringUtil::getTokens("it's^ up there^", " ", "", "'", "^"),
                       list_of("it's up")("there^"));
     }
+
+    template<> template<>
+    void string_index_object_t::test<43>()
+    {
+        set_test_name("utf8str_to_wstring() and wstring_to_utf8str() match the character at a time conversions");
+        // every two byte sequence, at every position of a block
+        std::string padded(40, 'a');
+        for (U32 pair = 0; pair < 0x10000; ++pair)
+        {
+            size_t offset = 12 + pair % 20;
+            padded[offset] = char(pair >> 8);
+            padded[offset + 1] = char(pair & 0xFF);
+            ensure("two bytes", utf8str_to_wstring(padded) == reference_utf8str_to_wstring(padded.c_str(), padded.length()));
+            padded[offset] = padded[offset + 1] = 'a';
+        }
+
+        std::mt19937 random(43);
+        for (S32 i = 0; i < 20000; ++i)
+        {
+            std::string utf8 = random_utf8(random, 1 + random() % 30);
+            LLWString wstr = utf8str_to_wstring(utf8);
+            ensure("decoded " + utf8, wstr == reference_utf8str_to_wstring(utf8.c_str(), utf8.length()));
+            ensure_equals("encoded", wstring_to_utf8str(wstr), reference_wstring_to_utf8str(wstr.c_str(), wstr.length()));
+        }
+
+        // U+0000 has always been dropped, and out of range characters
+        // replaced
+        LLWString odd(40, 'x');
+        odd[3] = 0;
+        odd[20] = 0;
+        odd[33] = 0x80000000;
+        ensure_equals("U+0000 and out of range", wstring_to_utf8str(odd), reference_wstring_to_utf8str(odd.c_str(), odd.length()));
+        ensure_equals("empty", wstring_to_utf8str(LLWString()), std::string());
+        ensure("empty", utf8str_to_wstring(std::string()).empty());
+        // a length shorter than the string truncates the last character
+        std::string euro("\xE2\x82\xAC");
+        ensure("truncated by length", utf8str_to_wstring(euro.c_str(), 2) == LLWString(1, LL_UNKNOWN_CHAR));
+    }
+
+    template<> template<>
+    void string_index_object_t::test<44>()
+    {
+        set_test_name("utf8str_to_wstring() and wstring_to_utf8str() throughput");
+        // The conversions are checked by test<43>, this only times them
+        if (!getenv("LL_STRING_BENCHMARK"))
+        {
+            skip("set LL_STRING_BENCHMARK to run the benchmark");
+        }
+        std::string ascii;
+        while (ascii.length() < 100000)
+        {
+            ascii += "[12:34] Some Resident: the quick brown fox jumps over the lazy dog. ";
+        }
+        std::string latin = ascii;
+        for (size_t i = 0; i < latin.length(); i += 12)
+        {
+            latin.replace(i, 1, "\xC3\xA9");
+        }
+        std::string cjk;
+        while (cjk.length() < 100000)
+        {
+            cjk += "\xE3\x81\x93\xE3\x82\x93\xE3\x81\xAB\xE3\x81\xA1\xE3\x81\xAF ";
+        }
+
+        typedef std::chrono::duration<F64, std::micro> us_t;
+        const S32 REPEAT = 100;
+        for (const auto& text : { std::make_pair("ASCII", ascii), std::make_pair("Latin", latin), std::make_pair("CJK", cjk) })
+        {
+            const std::string& utf8 = text.second;
+            LLWString wstr;
+            auto start = std::chrono::steady_clock::now();
+            for (S32 i = 0; i < REPEAT; ++i)
+            {
+                wstr = reference_utf8str_to_wstring(utf8.c_str(), utf8.length());
+            }
+            F64 ref_decode = us_t(std::chrono::steady_clock::now() - start).count();
+            start = std::chrono::steady_clock::now();
+            for (S32 i = 0; i < REPEAT; ++i)
+            {
+                wstr = utf8str_to_wstring(utf8);
+            }
+            F64 decode = us_t(std::chrono::steady_clock::now() - start).count();
+
+            std::string back;
+            start = std::chrono::steady_clock::now();
+            for (S32 i = 0; i < REPEAT; ++i)
+            {
+                back = reference_wstring_to_utf8str(wstr.c_str(), wstr.length());
+            }
+            F64 ref_encode = us_t(std::chrono::steady_clock::now() - start).count();
+            start = std::chrono::steady_clock::now();
+            for (S32 i = 0; i < REPEAT; ++i)
+            {
+                back = wstring_to_utf8str(wstr);
+            }
+            F64 encode = us_t(std::chrono::steady_clock::now() - start).count();
+            ensure_equals("round trip", back, utf8);
+
+            F64 mb = F64(utf8.length()) * REPEAT;   // bytes per us is MB/s
+            std::cout << "\n" << text.first << " UTF-8 -> LLWString " << mb / ref_decode << " -> " << mb / decode
+                      << " MB/s, LLWString -> UTF-8 " << mb / ref_encode << " -> " << mb / encode << " MB/s" << std::endl;
+        }
+    }
 }
@@ -0,0 +1,292 @@
+/**
+ * @file lluuidhashmap_test.cpp
+ * @brief Tests for LLUUIDHashMap and LLUUIDHashSet, and a lookup and insert
+ *        benchmark against std::map and std::unordered_map.
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../lluuidhashmap.h"
+
+#include "../llpointer.h"
+#include "../llrefcount.h"
+#include "../test/lltut.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    std::vector<LLUUID> random_ids(size_t count, U32 seed)
+    {
+        std::mt19937_64 random(seed);
+        std::vector<LLUUID> ids(count);
+        for (LLUUID& id : ids)
+        {
+            U64 halves[2] = { random(), random() };
+            memcpy(id.mData, halves, sizeof(halves));
+        }
+        return ids;
+    }
+
+    struct Counted: public LLRefCount
+    {
+        static S32 sLive;
+        Counted() { ++sLive; }
+        ~Counted() { --sLive; }
+    };
+    S32 Counted::sLive = 0;
+}
+
+namespace tut
+{
+    struct LLUUIDHashMapFixture
+    {
+        typedef std::chrono::duration<F64, std::nano> ns_t;
+
+        // ns per insertion, then ns per lookup, half of them missing
+        template <typename MAP>
+        std::pair<F64, F64> time(const std::vector<LLUUID>& ids, const std::vector<LLUUID>& missing)
+        {
+            auto start = std::chrono::steady_clock::now();
+            MAP map;
+            for (size_t i = 0; i < ids.size(); ++i)
+            {
+                map[ids[i]] = (U32)i;
+            }
+            F64 insert_ns = ns_t(std::chrono::steady_clock::now() - start).count() / ids.size();
+
+            const size_t LOOKUPS = 2000000;
+            size_t found = 0;
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < LOOKUPS; ++i)
+            {
+                const LLUUID& id = (i & 1) ? missing[i % missing.size()] : ids[(i * 7919) % ids.size()];
+                found += map.find(id) != map.end();
+            }
+            F64 find_ns = ns_t(std::chrono::steady_clock::now() - start).count() / LOOKUPS;
+            ensure_equals("half the lookups found", found, LOOKUPS / 2);
+            return { insert_ns, find_ns };
+        }
+    };
+    typedef test_group<LLUUIDHashMapFixture> LLUUIDHashMap_factory;
+    typedef LLUUIDHashMap_factory::object LLUUIDHashMap_t;
+    LLUUIDHashMap_factory tf("LLUUIDHashMap");
+
+    template<> template<>
+    void LLUUIDHashMap_t::test<1>()
+    {
+        set_test_name("insert, find and erase against std::map");
+        std::vector<LLUUID> ids = random_ids(20000, 1);
+        // the null key and keys differing in a single byte are ordinary keys
+        ids.push_back(LLUUID::null);
+        LLUUID near = ids[0];
+        near.mData[15] ^= 1;
+        ids.push_back(near);
+
+        LLUUIDHashMap<S32> map;
+        std::map<LLUUID, S32> reference;
+        ensure("empty", map.empty());
+        ensure("find in empty map", map.find(ids[0]) == map.end());
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            auto result = map.insert(std::make_pair(ids[i], S32(i)));
+            ensure("inserted", result.second);
+            reference[ids[i]] = S32(i);
+        }
+        ensure("insert existing key", !map.insert(std::make_pair(ids[5], -1)).second);
+        ensure_equals("existing value kept", map[ids[5]], 5);
+        ensure_equals("size", map.size(), reference.size());
+
+        // erase every third key, half of them through iterators
+        for (size_t i = 0; i < ids.size(); i += 3)
+        {
+            if (i & 1)
+            {
+                ensure_equals("erase(key)", map.erase(ids[i]), 1U);
+            }
+            else
+            {
+                map.erase(map.find(ids[i]));
+            }
+            reference.erase(ids[i]);
+        }
+        ensure_equals("erase missing key", map.erase(ids[0]), 0U);
+        ensure_equals("size after erase", map.size(), reference.size());
+
+        // reinsert over the erased slots
+        for (size_t i = 0; i < ids.size(); i += 6)
+        {
+            map[ids[i]] = -S32(i);
+            reference[ids[i]] = -S32(i);
+        }
+
+        for (const LLUUID& id : ids)
+        {
+            auto found = map.find(id);
+            auto expected = reference.find(id);
+            ensure_equals("count", map.count(id), reference.count(id));
+            if (expected != reference.end())
+            {
+                ensure("found", found != map.end());
+                ensure_equals("value", found->second, expected->second);
+            }
+        }
+        size_t iterated = 0;
+        for (const auto& pair : map)
+        {
+            ensure_equals("iterated value", reference[pair.first], pair.second);
+            ++iterated;
+        }
+        ensure_equals("iterates every element", iterated, reference.size());
+
+        map.clear();
+        ensure("cleared", map.empty() && map.begin() == map.end());
+        ensure("find after clear", map.find(ids[1]) == map.end());
+    }
+
+    template<> template<>
+    void LLUUIDHashMap_t::test<2>()
+    {
+        set_test_name("erase(it++), copies and element lifetime");
+        std::vector<LLUUID> ids = random_ids(1000, 2);
+        {
+            LLUUIDHashMap<LLPointer<Counted>> map;
+            for (const LLUUID& id : ids)
+            {
+                map[id] = new Counted;
+            }
+            ensure_equals("live elements", Counted::sLive, 1000);
+
+            LLUUIDHashMap<LLPointer<Counted>> copy(map);
+            ensure("copy equal", copy == map);
+            ensure_equals("copies share elements", Counted::sLive, 1000);
+
+            // the std::map idiom used by the caches
+            for (auto it = map.begin(); it != map.end(); )
+            {
+                if (it->first.mData[0] & 1)
+                {
+                    map.erase(it++);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+            size_t odd = std::count_if(ids.begin(), ids.end(), [](const LLUUID& id) { return id.mData[0] & 1; });
+            ensure_equals("odd keys erased", map.size(), ids.size() - odd);
+            for (const auto& pair : map)
+            {
+                ensure("only even keys left", !(pair.first.mData[0] & 1));
+            }
+
+            copy.clear();
+            ensure_equals("elements released by clear()", Counted::sLive, S32(map.size()));
+
+            LLUUIDHashMap<LLPointer<Counted>> moved(std::move(map));
+            ensure("moved from", map.empty());
+            ensure_equals("moved", moved.size(), ids.size() - odd);
+            const LLUUID& kept = moved.begin()->first;
+            ensure("try_emplace existing", !moved.try_emplace(kept, LLPointer<Counted>(new Counted)).second);
+        }
+        ensure_equals("elements released by the destructor", Counted::sLive, 0);
+
+        bool threw = false;
+        LLUUIDHashMap<S32> empty;
+        try
+        {
+            empty.at(ids[0]);
+        }
+        catch (const std::out_of_range&)
+        {
+            threw = true;
+        }
+        ensure("at() throws on a missing key", threw);
+    }
+
+    template<> template<>
+    void LLUUIDHashMap_t::test<3>()
+    {
+        set_test_name("LLUUIDHashSet");
+        std::vector<LLUUID> ids = random_ids(5000, 3);
+        LLUUIDHashSet set(ids.begin(), ids.end());
+        ensure_equals("size", set.size(), ids.size());
+        ensure("insert existing", !set.insert(ids[10]).second);
+        for (size_t i = 0; i < ids.size(); i += 2)
+        {
+            set.erase(ids[i]);
+        }
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            ensure_equals("contains", set.contains(ids[i]), bool(i & 1));
+        }
+        LLUUIDHashSet other{ ids[1], ids[3] };
+        ensure("initializer list", other.count(ids[3]) && !other.count(ids[0]));
+
+        // churn without growing: erased slots get purged instead
+        LLUUIDHashSet churn;
+        churn.reserve(100);
+        size_t capacity = churn.capacity();
+        std::vector<LLUUID> more = random_ids(100000, 4);
+        for (size_t i = 0; i < more.size(); ++i)
+        {
+            churn.insert(more[i]);
+            if (i >= 50)
+            {
+                churn.erase(more[i - 50]);
+            }
+        }
+        ensure_equals("churned size", churn.size(), 50U);
+        ensure_equals("churn doesn't grow", churn.capacity(), capacity);
+    }
+
+    template<> template<>
+    void LLUUIDHashMap_t::test<4>()
+    {
+        set_test_name("insert and find vs std::map and std::unordered_map");
+        // A million entries per container take a while; only on request
+        if (!getenv("LL_UUID_HASH_MAP_BENCHMARK"))
+        {
+            skip("set LL_UUID_HASH_MAP_BENCHMARK to run the benchmark");
+        }
+        for (size_t count : { 10000U, 100000U, 1000000U })
+        {
+            std::vector<LLUUID> ids = random_ids(count, 5);
+            std::vector<LLUUID> missing = random_ids(count, 6);
+            auto tree = time<std::map<LLUUID, U32>>(ids, missing);
+            auto buckets = time<std::unordered_map<LLUUID, U32>>(ids, missing);
+            auto flat = time<LLUUIDHashMap<U32>>(ids, missing);
+            std::cout << "\n" << count << " entries, ns per insert / find: std::map "
+                      << tree.first << " / " << tree.second << ", std::unordered_map "
+                      << buckets.first << " / " << buckets.second << ", LLUUIDHashMap "
+                      << flat.first << " / " << flat.second << std::endl;
+        }
+    }
+}
@@ -15,8 +15,12 @@
 #include "workqueue.h"
 // STL headers
 // std headers
+#include <atomic>
 #include <chrono>
 #include <deque>
+#include <iostream>
+#include <thread>
+#include <vector>
 // external library headers
 // other Linden headers
 #include "../test/lltut.h"
@@ -236,4 +240,233 @@ namespace tut
         ensure_equals("didn't run coroutine", stored, "ran");
         ensure("void waitForResult() didn't return", done);
     }
+
+    namespace
+    {
+        template <typename QUEUE>
+        void postFromThreads(const std::string& desc)
+        {
+            const int THREADS = 4, ITEMS = 1000;
+            QUEUE work("work", THREADS * ITEMS);
+            // Each posting thread's items must run in the order posted.
+            std::vector<int> next(THREADS, 0);
+            bool ordered = true;
+            std::vector<std::thread> posters;
+            for (int t = 0; t < THREADS; ++t)
+            {
+                posters.emplace_back(
+                    [&work, &next, &ordered, t, ITEMS]()
+                    {
+                        for (int i = 0; i < ITEMS; ++i)
+                        {
+                            // these lambdas only ever run on this test's thread
+                            work.post([&next, &ordered, t, i]()
+                                      { ordered = ordered && next[t]++ == i; });
+                        }
+                    });
+            }
+            for (auto& poster : posters)
+            {
+                poster.join();
+            }
+            work.close();
+            work.runUntilClose();
+            ensure(desc + " each thread's work ran in order", ordered);
+            for (int t = 0; t < THREADS; ++t)
+            {
+                ensure_equals(STRINGIZE(desc << " thread " << t << " work count"), next[t], ITEMS);
+            }
+            ensure(desc + " done", work.done());
+        }
+    } // anonymous namespace
+
+    template<> template<>
+    void object::test<7>()
+    {
+        set_test_name("WorkQueue and ConcurrentWorkQueue posted from several threads");
+        postFromThreads<WorkQueue>("WorkQueue");
+        postFromThreads<ConcurrentWorkQueue>("ConcurrentWorkQueue");
+
+        // WorkQueue also keeps the order between posting threads: work
+        // posted after another thread's post returned runs after it.
+        WorkQueue work("fifo");
+        std::string observe;
+        for (const char* item : { "a", "b", "c" })
+        {
+            std::thread([&work, &observe, item]()
+                        { work.post([&observe, item](){ observe.append(item); }); }).join();
+        }
+        work.post([&observe](){ observe.append("d"); });
+        work.runPending();
+        ensure_equals("WorkQueue order across threads", observe, "abcd");
+    }
+
+    template<> template<>
+    void object::test<8>()
+    {
+        set_test_name("WorkStealingQueue");
+        WorkStealingQueue work("stealing", 2);
+        std::string observe;
+        ensure("post", work.post([&observe](){ observe.append("a"); }));
+        ensure("post with affinity", work.post([&observe](){ observe.append("b"); }, 5));
+        ensure_equals("size", work.size(), 2U);
+        ensure("tryPost() when full", !work.tryPost([&observe](){ observe.append("x"); }));
+        ensure_equals("no workers yet", work.getWorkers(), 0U);
+        work.runPending();
+        ensure_equals("ran in order", observe, "ab");
+        ensure("tryPost()", work.tryPost([&observe](){ observe.append("c"); }));
+        work.close();
+        ensure("post() after close()", !work.post([&observe](){ observe.append("x"); }));
+        ensure("not done until drained", !work.done());
+        // runUntilClose() enlists this thread as a worker and returns once
+        // the queue is drained
+        work.runUntilClose();
+        ensure_equals("drained", observe, "abc");
+        ensure_equals("one worker", work.getWorkers(), 1U);
+        ensure("done", work.done());
+    }
+
+    namespace
+    {
+        // Each work item forks two more until 'depth' reaches zero: the shape
+        // of decode or unpack work split into chunks.
+        template <typename QUEUE>
+        void fork(QUEUE& queue, std::atomic<int>& count, int depth)
+        {
+            ++count;
+            if (depth > 0)
+            {
+                for (int i = 0; i < 2; ++i)
+                {
+                    queue.post([&queue, &count, depth](){ fork(queue, count, depth - 1); });
+                }
+            }
+        }
+
+        template <typename QUEUE>
+        F64 runForks(int threads, int roots, int depth, int& counted)
+        {
+            QUEUE queue("forks", 1024*1024);
+            std::atomic<int> count{ 0 };
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; ++t)
+            {
+                workers.emplace_back([&queue](){ queue.runUntilClose(); });
+            }
+            for (int r = 0; r < roots; ++r)
+            {
+                queue.post([&queue, &count, depth](){ fork(queue, count, depth); });
+            }
+            const int expected = roots * ((2 << depth) - 1);
+            while (count.load() < expected)
+            {
+                std::this_thread::yield();
+            }
+            std::chrono::duration<F64, std::milli> elapsed(std::chrono::steady_clock::now() - start);
+            queue.close();
+            for (auto& worker : workers)
+            {
+                worker.join();
+            }
+            counted = count.load();
+            return elapsed.count();
+        }
+    } // anonymous namespace
+
+    template<> template<>
+    void object::test<9>()
+    {
+        set_test_name("WorkStealingQueue workers forking and stealing");
+        const int THREADS = 4, ROOTS = 16, DEPTH = 10;
+        const int expected = ROOTS * ((2 << DEPTH) - 1);
+        int stealing_count = 0;
+        F64 stealing = runForks<WorkStealingQueue>(THREADS, ROOTS, DEPTH, stealing_count);
+        ensure_equals("WorkStealingQueue ran everything", stealing_count, expected);
+        // set LL_WORK_QUEUE_BENCHMARK to compare with a plain WorkQueue
+        if (getenv("LL_WORK_QUEUE_BENCHMARK"))
+        {
+            int shared_count = 0;
+            F64 shared = runForks<WorkQueue>(THREADS, ROOTS, DEPTH, shared_count);
+            ensure_equals("WorkQueue ran everything", shared_count, expected);
+            std::cout << "\n" << expected << " forked work items on " << THREADS << " threads: WorkQueue "
+                      << shared << " ms, WorkStealingQueue " << stealing << " ms" << std::endl;
+        }
+
+        // affinity posts from a non-worker thread land on worker deques
+        WorkStealingQueue work("affinity");
+        std::vector<std::thread> workers;
+        for (int t = 0; t < THREADS; ++t)
+        {
+            workers.emplace_back([&work](){ work.runUntilClose(); });
+        }
+        while (work.getWorkers() < THREADS)
+        {
+            std::this_thread::yield();
+        }
+        std::atomic<int> ran{ 0 };
+        for (int i = 0; i < 1000; ++i)
+        {
+            work.post([&ran](){ ++ran; }, i);
+        }
+        work.close();
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+        ensure_equals("affinity work all ran", ran.load(), 1000);
+        ensure("done", work.done());
+    }
+
+    template<> template<>
+    void object::test<10>()
+    {
+        set_test_name("PriorityWorkQueue");
+        using Priority = PriorityWorkQueue;
+        PriorityWorkQueue work("priority");
+        std::string observe;
+        auto append = [&observe](const std::string& s)
+        {
+            return [&observe, s](){ observe.append(s); };
+        };
+        ensure("post", work.post(append("n1;")));
+        auto low = work.post(append("low;"), Priority::LOW);
+        ensure("low handle", low != PriorityWorkQueue::NO_HANDLE);
+        work.post(append("bg;"), Priority::BACKGROUND);
+        work.post(append("n2;"), Priority::NORMAL);
+        work.post(append("high;"), Priority::HIGH);
+        auto cancelled = work.post(append("cancelled;"), Priority::HIGH);
+        // a deadline far away orders NORMAL work, but doesn't promote it
+        work.post(append("soon;"), Priority::NORMAL, WorkQueueBase::TimePoint::clock::now() + 1h);
+        ensure_equals("size", work.size(), 7U);
+        ensure_equals("HIGH size", work.size(Priority::HIGH), 2U);
+
+        ensure("cancel", work.cancel(cancelled));
+        ensure("cancel twice", !work.cancel(cancelled));
+        ensure("reprioritize", work.reprioritize(low, Priority::HIGH));
+        work.runPending();
+        // reprioritized work keeps its place in the order posted
+        ensure_equals("run by priority", observe, "low;high;soon;n1;n2;bg;");
+        ensure("reprioritize after run", !work.reprioritize(low, Priority::LOW));
+
+        // overdue work runs ahead of everything that isn't
+        observe.clear();
+        work.post(append("high;"), Priority::HIGH);
+        work.post(append("late;"), Priority::BACKGROUND, WorkQueueBase::TimePoint::clock::now() - 1ms);
+        work.post(append("later;"), Priority::LOW, WorkQueueBase::TimePoint::clock::now() - 2ms);
+        work.runPending();
+        ensure_equals("run overdue first", observe, "later;late;high;");
+
+        // capacity and close()
+        PriorityWorkQueue small("small", 1);
+        ensure("tryPost", small.tryPost(append("a;")));
+        ensure("tryPost when full", !small.tryPost(append("b;")));
+        small.close();
+        ensure("post after close", !small.post(append("c;"), Priority::HIGH));
+        ensure("not done until drained", !small.done());
+        observe.clear();
+        small.runUntilClose();
+        ensure_equals("drained", observe, "a;");
+        ensure("done", small.done());
+    }
 } // namespace tut
@@ -20,6 +20,7 @@
 #include "commoncontrol.h"
 #include "llerror.h"
 #include "llevents.h"
+#include "llflightrecorder.h"
 #include "llsd.h"
 #include "stringize.h"
 
@@ -79,6 +80,7 @@ void LL::ThreadPoolBase::start()
         mThreads.emplace_back(tname, [this, tname]()
             {
                 LL_PROFILER_SET_THREAD_NAME(tname.c_str());
+                LLTrace::FlightRecorder::setThreadName(tname);
                 LL_INFOS("THREAD") << "Started thread " << tname << LL_ENDL;
                 run(tname);
             });
@@ -98,7 +98,8 @@ namespace LL
     };
 
     /**
-     * Specialize with WorkQueue or, for timestamped tasks, WorkSchedule
+     * Specialize with WorkQueue, WorkStealingQueue, PriorityWorkQueue or, for
+     * timestamped tasks, WorkSchedule
      */
     template <class QUEUE>
     struct ThreadPoolUsing: public ThreadPoolBase
@@ -136,6 +137,28 @@ namespace LL
     /// ThreadPool is shorthand for using the simpler WorkQueue
     using ThreadPool = ThreadPoolUsing<WorkQueue>;
 
+    /**
+     * ConcurrentThreadPool posts work without taking a lock shared with the
+     * workers: see ConcurrentWorkQueue. Only use it when nothing depends on
+     * the order of work posted by different threads.
+     */
+    using ConcurrentThreadPool = ThreadPoolUsing<ConcurrentWorkQueue>;
+
+    /**
+     * WorkStealingThreadPool gives each worker thread its own deque: see
+     * WorkStealingQueue. Prefer it for many short work items, especially
+     * work items that post follow-up work, or related work that should stay
+     * on one thread (pass the same affinity to getQueue().post()).
+     */
+    using WorkStealingThreadPool = ThreadPoolUsing<WorkStealingQueue>;
+
+    /**
+     * PriorityThreadPool runs work by priority class and soft deadline: see
+     * PriorityWorkQueue. Prefer it when several subsystems share the pool and
+     * some of their work matters more than the rest.
+     */
+    using PriorityThreadPool = ThreadPoolUsing<PriorityWorkQueue>;
+
 } // namespace LL
 
 #endif /* ! defined(LL_THREADPOOL_H) */
@@ -20,6 +20,9 @@ namespace LL
     struct ThreadPoolUsing;
 
     using ThreadPool = ThreadPoolUsing<WorkQueue>;
+    using ConcurrentThreadPool = ThreadPoolUsing<ConcurrentWorkQueue>;
+    using WorkStealingThreadPool = ThreadPoolUsing<WorkStealingQueue>;
+    using PriorityThreadPool = ThreadPoolUsing<PriorityWorkQueue>;
 } // namespace LL
 
 #endif /* ! defined(LL_THREADPOOL_FWD_H) */
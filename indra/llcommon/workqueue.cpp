@@ -181,6 +181,508 @@ bool LL::WorkQueue::tryPop_(Work& work)
     return mQueue.tryPop(work);
 }
 
+/*****************************************************************************
+*   ConcurrentWorkQueue
+*****************************************************************************/
+LL::ConcurrentWorkQueue::ConcurrentWorkQueue(const std::string& name, size_t capacity):
+    super(name),
+    mQueue(capacity)
+{
+}
+
+void LL::ConcurrentWorkQueue::close()
+{
+    mQueue.close();
+}
+
+size_t LL::ConcurrentWorkQueue::size()
+{
+    return mQueue.size();
+}
+
+bool LL::ConcurrentWorkQueue::isClosed()
+{
+    return mQueue.isClosed();
+}
+
+bool LL::ConcurrentWorkQueue::done()
+{
+    return mQueue.done();
+}
+
+bool LL::ConcurrentWorkQueue::post(const Work& callable)
+{
+    return mQueue.pushIfOpen(callable);
+}
+
+bool LL::ConcurrentWorkQueue::tryPost(const Work& callable)
+{
+    return mQueue.tryPush(callable);
+}
+
+LL::ConcurrentWorkQueue::Work LL::ConcurrentWorkQueue::pop_()
+{
+    return mQueue.pop();
+}
+
+bool LL::ConcurrentWorkQueue::tryPop_(Work& work)
+{
+    return mQueue.tryPop(work);
+}
+
+/*****************************************************************************
+*   WorkStealingQueue
+*****************************************************************************/
+namespace
+{
+    // tells WorkStealingQueue instances apart in the per-thread cache used by
+    // WorkStealingQueue::workerIndex(), even if one is allocated at the
+    // address of another that was destroyed
+    std::atomic<U64> sWorkStealingSerial{ 0 };
+}
+
+LL::WorkStealingQueue::WorkStealingQueue(const std::string& name, size_t capacity):
+    super(name),
+    mSerial(++sWorkStealingSerial),
+    mCapacity(capacity)
+{
+}
+
+void LL::WorkStealingQueue::close()
+{
+    mClosed = true;
+    Lock lock(mLock);
+    // wake up idle workers and blocked posters
+    mWorkCond.notify_all();
+    mCapacityCond.notify_all();
+}
+
+size_t LL::WorkStealingQueue::size()
+{
+    return mSize.load();
+}
+
+bool LL::WorkStealingQueue::isClosed()
+{
+    return mClosed.load();
+}
+
+bool LL::WorkStealingQueue::done()
+{
+    return mClosed.load() && mSize.load() == 0;
+}
+
+bool LL::WorkStealingQueue::post(const Work& callable)
+{
+    // A worker posting work forks it onto its own deque; anyone else shares.
+    return reserve_(true) && post_(callable, workerIndex(false));
+}
+
+bool LL::WorkStealingQueue::post(const Work& callable, size_t affinity)
+{
+    if (! reserve_(true))
+        return false;
+    size_t workers = mWorkers.load();
+    return post_(callable, workers? affinity % workers : NO_WORKER);
+}
+
+bool LL::WorkStealingQueue::tryPost(const Work& callable)
+{
+    return reserve_(false) && post_(callable, workerIndex(false));
+}
+
+size_t LL::WorkStealingQueue::workerIndex(bool enlist)
+{
+    // A worker thread normally services a single queue for its whole life:
+    // remember which deque it got from the last queue it enlisted in.
+    thread_local U64 sSerial = 0;
+    thread_local size_t sIndex = NO_WORKER;
+    if (sSerial == mSerial)
+        return sIndex;
+    if (! enlist)
+        return NO_WORKER;
+
+    std::lock_guard<std::mutex> lock(mEnlistMutex);
+    std::thread::id self = std::this_thread::get_id();
+    size_t workers = mWorkers.load();
+    size_t index = 0;
+    // We might have enlisted before, then enlisted in some other queue.
+    while (index < workers && mDeques[index].mOwner != self)
+        ++index;
+    if (index == workers)
+    {
+        if (workers == MAX_WORKERS)
+        {
+            LL_WARNS_ONCE("ThreadPool") << getKey() << " has more than " << MAX_WORKERS
+                                        << " workers, the rest will only steal" << LL_ENDL;
+            return NO_WORKER;
+        }
+        mDeques[index].mOwner = self;
+        mWorkers.store(workers + 1);
+    }
+    sSerial = mSerial;
+    sIndex = index;
+    return index;
+}
+
+bool LL::WorkStealingQueue::reserve_(bool wait)
+{
+    while (true)
+    {
+        // the moment either end calls close(), further posts fail
+        if (mClosed)
+            return false;
+
+        size_t size = mSize.load(std::memory_order_relaxed);
+        while (size < mCapacity)
+        {
+            if (mSize.compare_exchange_weak(size, size + 1))
+                return true;
+        }
+        if (! wait)
+            return false;
+
+        // Full: wait for a worker to take something, rechecking under the
+        // lock so we can't miss its notification.
+        Lock lock(mLock);
+        ++mPushWaiters;
+        if (! mClosed && mSize.load() >= mCapacity)
+        {
+            mCapacityCond.wait(lock);
+        }
+        --mPushWaiters;
+    }
+}
+
+bool LL::WorkStealingQueue::post_(const Work& callable, size_t index)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    Deque& deque = (index < MAX_WORKERS)? mDeques[index] : mShared;
+    {
+        std::lock_guard<std::mutex> lock(deque.mMutex);
+        deque.mWork.push_back(callable);
+    }
+    // Any worker can steal it, so wake whichever is idle.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mIdle.load())
+    {
+        Lock lock(mLock);
+        mWorkCond.notify_one();
+    }
+    return true;
+}
+
+bool LL::WorkStealingQueue::take_(Work& work, size_t self, bool wait_for_locks)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    auto takeFrom = [&work](Deque& deque, bool wait)
+    {
+        std::unique_lock<std::mutex> lock(deque.mMutex, std::defer_lock);
+        if (wait)
+        {
+            lock.lock();
+        }
+        else if (! lock.try_lock())
+        {
+            return false;
+        }
+        if (deque.mWork.empty())
+            return false;
+        work = std::move(deque.mWork.front());
+        deque.mWork.pop_front();
+        return true;
+    };
+
+    // our own work first, then shared work
+    if (self < MAX_WORKERS && takeFrom(mDeques[self], true))
+        return true;
+    if (takeFrom(mShared, true))
+        return true;
+    // Then steal, starting with our neighbor so thieves spread out. Skip any
+    // deque that's busy right now unless we're about to go to sleep.
+    size_t workers = mWorkers.load();
+    for (size_t i = 0; i < workers; ++i)
+    {
+        size_t victim = (self + 1 + i) % workers;
+        if (victim != self && takeFrom(mDeques[victim], wait_for_locks))
+            return true;
+    }
+    return false;
+}
+
+void LL::WorkStealingQueue::taken_()
+{
+    size_t left = mSize.fetch_sub(1) - 1;
+    if (mPushWaiters.load())
+    {
+        Lock lock(mLock);
+        mCapacityCond.notify_one();
+    }
+    // Idle workers that found the queue closed but not drained are waiting
+    // for the last work item: if somebody else took it, tell them we're done.
+    if (left == 0 && mClosed.load() && mIdle.load())
+    {
+        Lock lock(mLock);
+        mWorkCond.notify_all();
+    }
+}
+
+LL::WorkStealingQueue::Work LL::WorkStealingQueue::pop_()
+{
+    size_t self = workerIndex(true);
+    Work work;
+    while (true)
+    {
+        if (take_(work, self, false))
+        {
+            taken_();
+            return work;
+        }
+
+        // Nothing anywhere: look once more under the lock, then sleep.
+        Lock lock(mLock);
+        ++mIdle;
+        // Pairs with the fence in post_().
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool taken = take_(work, self, true);
+        if (! taken)
+        {
+            // Once closed and drained, there will never be any more coming.
+            if (mClosed && mSize.load() == 0)
+            {
+                --mIdle;
+                LLTHROW(Closed());
+            }
+            mWorkCond.wait(lock);
+        }
+        --mIdle;
+        lock.unlock();
+        if (taken)
+        {
+            taken_();
+            return work;
+        }
+    }
+}
+
+bool LL::WorkStealingQueue::tryPop_(Work& work)
+{
+    if (! take_(work, workerIndex(false), false))
+        return false;
+    taken_();
+    return true;
+}
+
+/*****************************************************************************
+*   PriorityWorkQueue
+*****************************************************************************/
+LL::PriorityWorkQueue::PriorityWorkQueue(const std::string& name, size_t capacity):
+    super(name),
+    mCapacity(capacity)
+{
+}
+
+void LL::PriorityWorkQueue::close()
+{
+    Lock lock(mLock);
+    mClosed = true;
+    lock.unlock();
+    // wake up any blocked workers and posters
+    mEmptyCond.notify_all();
+    mCapacityCond.notify_all();
+}
+
+size_t LL::PriorityWorkQueue::size()
+{
+    return mSize.load();
+}
+
+size_t LL::PriorityWorkQueue::size(Priority priority)
+{
+    Lock lock(mLock);
+    return mClasses[priority].size();
+}
+
+bool LL::PriorityWorkQueue::isClosed()
+{
+    return mClosed.load();
+}
+
+bool LL::PriorityWorkQueue::done()
+{
+    return mClosed.load() && mSize.load() == 0;
+}
+
+bool LL::PriorityWorkQueue::post(const Work& callable)
+{
+    return post(callable, NORMAL) != NO_HANDLE;
+}
+
+bool LL::PriorityWorkQueue::tryPost(const Work& callable)
+{
+    return tryPost(callable, NORMAL) != NO_HANDLE;
+}
+
+LL::PriorityWorkQueue::Handle LL::PriorityWorkQueue::post(
+    const Work& callable, Priority priority, const TimePoint& deadline)
+{
+    Lock lock(mLock);
+    return push_(lock, callable, priority, deadline, true);
+}
+
+LL::PriorityWorkQueue::Handle LL::PriorityWorkQueue::tryPost(
+    const Work& callable, Priority priority, const TimePoint& deadline)
+{
+    // Only fail when the queue is full: the lock is only ever held briefly,
+    // so waiting for it beats dropping work a contended poster could queue.
+    Lock lock(mLock);
+    return push_(lock, callable, priority, deadline, false);
+}
+
+LL::PriorityWorkQueue::Handle LL::PriorityWorkQueue::push_(
+    Lock& lock, const Work& callable, Priority priority,
+    const TimePoint& deadline, bool wait)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    while (true)
+    {
+        // the moment either end calls close(), further posts fail
+        if (mClosed)
+            return NO_HANDLE;
+        if (mSize.load() < mCapacity)
+            break;
+        if (! wait)
+        {
+            LL_WARNS_ONCE("ThreadPool") << getKey() << " full " << mSize.load() << " >= " << mCapacity << LL_ENDL;
+            return NO_HANDLE;
+        }
+        mCapacityCond.wait(lock);
+    }
+
+    Handle handle = ++mLastHandle;
+    mClasses[priority].emplace(Key{ deadline, handle }, callable);
+    mQueued.emplace(handle, std::make_pair(priority, deadline));
+    ++mSize;
+    lock.unlock();
+    // now that we've posted, if some worker's been waiting, signal them
+    mEmptyCond.notify_one();
+    return handle;
+}
+
+bool LL::PriorityWorkQueue::reprioritize(Handle handle, Priority priority,
+                                         const TimePoint& deadline)
+{
+    Lock lock(mLock);
+    auto found = mQueued.find(handle);
+    if (found == mQueued.end())
+        return false;
+
+    auto& [queued_priority, queued_deadline] = found->second;
+    auto node = mClasses[queued_priority].extract(Key{ queued_deadline, handle });
+    node.key().mDeadline = deadline;
+    mClasses[priority].insert(std::move(node));
+    found->second = std::make_pair(priority, deadline);
+    return true;
+}
+
+bool LL::PriorityWorkQueue::cancel(Handle handle)
+{
+    Class::node_type node;
+    {
+        Lock lock(mLock);
+        auto found = mQueued.find(handle);
+        if (found == mQueued.end())
+            return false;
+
+        auto& [priority, deadline] = found->second;
+        node = mClasses[priority].extract(Key{ deadline, handle });
+        mQueued.erase(found);
+        --mSize;
+    }
+    // The work item is destroyed as node goes out of scope, with the lock
+    // released: its captures might want to post more work.
+    mCapacityCond.notify_one();
+    if (done())
+    {
+        // workers waiting for the last work item won't be getting it
+        mEmptyCond.notify_all();
+    }
+    return true;
+}
+
+bool LL::PriorityWorkQueue::take_(Work& work)
+{
+    // Only look at the clock if some class has a deadline to meet.
+    Class* overdue = nullptr;
+    Class* highest = nullptr;
+    TimePoint now;
+    bool have_now = false;
+    for (Class& queued : mClasses)
+    {
+        if (queued.empty())
+            continue;
+        if (! highest)
+            highest = &queued;
+        // each class is sorted by deadline first
+        const TimePoint& deadline = queued.begin()->first.mDeadline;
+        if (deadline == NO_DEADLINE)
+            continue;
+        if (! have_now)
+        {
+            now = TimePoint::clock::now();
+            have_now = true;
+        }
+        if (deadline <= now &&
+            (! overdue || deadline < overdue->begin()->first.mDeadline))
+        {
+            overdue = &queued;
+        }
+    }
+
+    Class* from = overdue? overdue : highest;
+    if (! from)
+        return false;
+
+    auto head = from->begin();
+    mQueued.erase(head->first.mHandle);
+    work = std::move(head->second);
+    from->erase(head);
+    --mSize;
+    return true;
+}
+
+LL::PriorityWorkQueue::Work LL::PriorityWorkQueue::pop_()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    Work work;
+    Lock lock(mLock);
+    while (! take_(work))
+    {
+        // Once the queue is closed and drained, there will never be any more
+        // coming.
+        if (mClosed)
+        {
+            LLTHROW(Closed());
+        }
+        mEmptyCond.wait(lock);
+    }
+    lock.unlock();
+    // now that we've popped, if somebody's been waiting to post, signal them
+    mCapacityCond.notify_one();
+    return work;
+}
+
+bool LL::PriorityWorkQueue::tryPop_(Work& work)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_THREAD;
+    Lock lock(mLock);
+    if (! take_(work))
+        return false;
+    lock.unlock();
+    mCapacityCond.notify_one();
+    return true;
+}
+
 /*****************************************************************************
 *   WorkSchedule
 *****************************************************************************/
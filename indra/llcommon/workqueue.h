@@ -12,15 +12,24 @@
 #if ! defined(LL_WORKQUEUE_H)
 #define LL_WORKQUEUE_H
 
+#include "llconcurrentthreadsafequeue.h"
 #include "llcoros.h"
 #include "llexception.h"
 #include "llinstancetracker.h"
 #include "llinstancetrackersubclass.h"
 #include "threadsafeschedule.h"
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <deque>
 #include <exception>                // std::current_exception
 #include <functional>               // std::function
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
 
 namespace LL
 {
@@ -262,6 +271,295 @@ namespace LL
         bool tryPop_(Work&) override;
     };
 
+/*****************************************************************************
+*   ConcurrentWorkQueue: WorkQueue without a shared lock
+*****************************************************************************/
+    /**
+     * ConcurrentWorkQueue stores its work items in an
+     * LLConcurrentThreadSafeQueue, so posting threads don't contend with the
+     * servicing thread for a lock.
+     *
+     * Unlike WorkQueue, it only runs work in the order posted per posting
+     * thread: there is no ordering between items posted by different
+     * threads. Only use it where nothing depends on that order.
+     */
+    class ConcurrentWorkQueue: public LLInstanceTrackerSubclass<ConcurrentWorkQueue, WorkQueueBase>
+    {
+    private:
+        using super = LLInstanceTrackerSubclass<ConcurrentWorkQueue, WorkQueueBase>;
+
+    public:
+        /**
+         * You may omit the ConcurrentWorkQueue name, in which case a unique
+         * name is synthesized; for practical purposes that makes it anonymous.
+         */
+        ConcurrentWorkQueue(const std::string& name = std::string(), size_t capacity=1024);
+
+        void close() override;
+
+        /// See WorkQueue::size() for the caveats.
+        size_t size() override;
+        /// producer end: are we prevented from pushing any additional items?
+        bool isClosed() override;
+        /// consumer end: are we done, is the queue entirely drained?
+        bool done() override;
+
+        /*---------------------- fire and forget API -----------------------*/
+
+        /**
+         * post work, unless the queue is closed before we can post
+         */
+        bool post(const Work&) override;
+
+        /**
+         * post work, unless the queue is full
+         */
+        bool tryPost(const Work&) override;
+
+    private:
+        using Queue = LLConcurrentThreadSafeQueue<Work>;
+        Queue mQueue;
+
+        Work pop_() override;
+        bool tryPop_(Work&) override;
+    };
+
+/*****************************************************************************
+*   WorkStealingQueue: per-worker deques with work stealing
+*****************************************************************************/
+    /**
+     * WorkStealingQueue gives each worker thread its own deque instead of
+     * sharing one queue among all of them, so short work items don't all
+     * contend for the same lock.
+     *
+     * * A thread that calls runUntilClose() (as every ThreadPool worker does)
+     *   enlists as a worker and gets a deque of its own.
+     * * Work posted by a worker goes to its own deque: a work item can fork
+     *   subtasks cheaply, and they tend to stay on the same thread's cache.
+     * * Work posted by any other thread goes to a shared deque, unless the
+     *   caller passes an affinity hint to pick a worker's deque.
+     * * A worker runs its own work first, then shared work, then steals from
+     *   other workers. It only sleeps when every deque is empty.
+     *
+     * Each deque runs in the order posted, so work posted by one thread
+     * without an affinity hint still runs in the order posted. Unlike
+     * WorkQueue, there is no ordering between different posting threads.
+     */
+    class WorkStealingQueue: public LLInstanceTrackerSubclass<WorkStealingQueue, WorkQueueBase>
+    {
+    private:
+        using super = LLInstanceTrackerSubclass<WorkStealingQueue, WorkQueueBase>;
+
+    public:
+        /// workers beyond this many just take shared work and steal
+        static constexpr size_t MAX_WORKERS = 64;
+
+        /**
+         * You may omit the WorkStealingQueue name, in which case a unique
+         * name is synthesized; for practical purposes that makes it anonymous.
+         */
+        WorkStealingQueue(const std::string& name = std::string(), size_t capacity=1024);
+
+        void close() override;
+
+        /// See WorkQueueBase::size() for the caveats.
+        size_t size() override;
+        /// producer end: are we prevented from pushing any additional items?
+        bool isClosed() override;
+        /// consumer end: are we done, is the queue entirely drained?
+        bool done() override;
+
+        /*---------------------- fire and forget API -----------------------*/
+
+        /**
+         * post work, unless the queue is closed before we can post
+         */
+        bool post(const Work&) override;
+
+        /**
+         * post work to the deque of worker (affinity % getWorkers()), unless
+         * the queue is closed before we can post. Passing the same affinity
+         * for related work items keeps them on the same worker unless that
+         * worker falls behind and others steal from it.
+         */
+        bool post(const Work&, size_t affinity);
+
+        /**
+         * post work, unless the queue is full
+         */
+        bool tryPost(const Work&) override;
+
+        /// number of worker threads enlisted so far
+        size_t getWorkers() const { return mWorkers.load(); }
+
+    private:
+        static constexpr size_t NO_WORKER = MAX_WORKERS;
+
+        // Keep each deque on its own cache line so workers popping their own
+        // deques don't slow each other down.
+        struct alignas(64) Deque
+        {
+            std::mutex mMutex;
+            std::deque<Work> mWork;
+            std::thread::id mOwner;
+        };
+
+        // index of the calling thread's deque, enlisting the calling thread
+        // as a new worker if requested
+        size_t workerIndex(bool enlist);
+        // claim room for one more work item, waiting if so requested
+        bool reserve_(bool wait);
+        bool post_(const Work&, size_t index);
+        // take one work item without sleeping, if there is one anywhere
+        bool take_(Work&, size_t self, bool wait_for_locks);
+        // release the room taken by a work item we just took
+        void taken_();
+
+        Work pop_() override;
+        bool tryPop_(Work&) override;
+
+        const U64 mSerial;
+        const size_t mCapacity;
+        std::atomic<size_t> mSize{ 0 };
+        std::atomic<bool> mClosed{ false };
+        Deque mShared;
+        std::array<Deque, MAX_WORKERS> mDeques;
+        std::atomic<size_t> mWorkers{ 0 };
+        std::mutex mEnlistMutex;
+
+        // Only used to sleep and wake, as with LLConcurrentThreadSafeQueue.
+        LLCoros::Mutex mLock;
+        boost::fibers::condition_variable_any mWorkCond;
+        boost::fibers::condition_variable_any mCapacityCond;
+        std::atomic<U32> mIdle{ 0 };
+        std::atomic<U32> mPushWaiters{ 0 };
+    };
+
+/*****************************************************************************
+*   PriorityWorkQueue: priority classes and soft deadlines
+*****************************************************************************/
+    /**
+     * PriorityWorkQueue runs work by priority class instead of in the order
+     * posted, so one pool of worker threads can serve several subsystems
+     * without the background work of one starving the visible work of
+     * another.
+     *
+     * * Higher priority classes run first. Within a class, work with a
+     *   deadline runs before work without one, earliest deadline first;
+     *   work without a deadline runs in the order posted.
+     * * Deadlines are soft: once work is overdue, it runs ahead of any work
+     *   that isn't, whatever its class. That keeps a steady stream of HIGH
+     *   work from starving everything else forever.
+     * * Posting with a priority returns a Handle, which can be used to
+     *   reprioritize() or cancel() the work until a worker picks it up.
+     */
+    class PriorityWorkQueue: public LLInstanceTrackerSubclass<PriorityWorkQueue, WorkQueueBase>
+    {
+    private:
+        using super = LLInstanceTrackerSubclass<PriorityWorkQueue, WorkQueueBase>;
+
+    public:
+        enum Priority { HIGH, NORMAL, LOW, BACKGROUND };
+        static constexpr size_t PRIORITIES = BACKGROUND + 1;
+
+        /// identifies work posted with a priority
+        using Handle = U64;
+        /// returned when the work could not be posted
+        static constexpr Handle NO_HANDLE = 0;
+        static constexpr TimePoint NO_DEADLINE = TimePoint::max();
+
+        /**
+         * You may omit the PriorityWorkQueue name, in which case a unique
+         * name is synthesized; for practical purposes that makes it anonymous.
+         */
+        PriorityWorkQueue(const std::string& name = std::string(), size_t capacity=1024);
+
+        void close() override;
+
+        /// See WorkQueueBase::size() for the caveats.
+        size_t size() override;
+        /// producer end: are we prevented from pushing any additional items?
+        bool isClosed() override;
+        /// consumer end: are we done, is the queue entirely drained?
+        bool done() override;
+
+        /*---------------------- fire and forget API -----------------------*/
+
+        /**
+         * post NORMAL work without a deadline, unless the queue is closed
+         * before we can post
+         */
+        bool post(const Work&) override;
+
+        /**
+         * post NORMAL work without a deadline, unless the queue is full
+         */
+        bool tryPost(const Work&) override;
+
+        /**
+         * post work with the specified priority and optional deadline,
+         * unless the queue is closed before we can post
+         */
+        Handle post(const Work&, Priority priority, const TimePoint& deadline=NO_DEADLINE);
+
+        /**
+         * post work with the specified priority and optional deadline,
+         * unless the queue is full
+         */
+        Handle tryPost(const Work&, Priority priority, const TimePoint& deadline=NO_DEADLINE);
+
+        /*------------------------- queued work API ------------------------*/
+
+        /**
+         * Change the priority and deadline of work still in the queue.
+         * Returns false if a worker has already picked it up (or it was
+         * cancelled).
+         */
+        bool reprioritize(Handle handle, Priority priority, const TimePoint& deadline=NO_DEADLINE);
+
+        /**
+         * Drop work still in the queue. Returns false if a worker has already
+         * picked it up (or it was cancelled).
+         */
+        bool cancel(Handle handle);
+
+        /// how many work items of that class are in the queue
+        size_t size(Priority priority);
+
+    private:
+        using Lock = LLCoros::LockType;
+
+        struct Key
+        {
+            TimePoint mDeadline;
+            Handle mHandle;
+            bool operator<(const Key& other) const
+            {
+                return std::tie(mDeadline, mHandle) < std::tie(other.mDeadline, other.mHandle);
+            }
+        };
+        using Class = std::map<Key, Work>;
+
+        Handle push_(Lock& lock, const Work& callable, Priority priority,
+                     const TimePoint& deadline, bool wait);
+        // pick the next work item to run, if any
+        bool take_(Work& work);
+
+        Work pop_() override;
+        bool tryPop_(Work&) override;
+
+        LLCoros::Mutex mLock;
+        boost::fibers::condition_variable_any mEmptyCond;
+        boost::fibers::condition_variable_any mCapacityCond;
+        const size_t mCapacity;
+        std::atomic<bool> mClosed{ false };
+        std::atomic<size_t> mSize{ 0 };
+        Handle mLastHandle{ NO_HANDLE };
+        std::array<Class, PRIORITIES> mClasses;
+        // where to find each queued work item by Handle
+        std::unordered_map<Handle, std::pair<Priority, TimePoint>> mQueued;
+    };
+
 /*****************************************************************************
 *   WorkSchedule: add support for timestamped tasks
 *****************************************************************************/
@@ -38,6 +38,7 @@
 #include <chrono>
 
 #include "lldiskcache.h"
+#include "hbxxh.h"
 
  /**
   * The prefix inserted at the start of a cache file filename to
@@ -51,6 +52,62 @@ static const std::string CACHE_FILENAME_PREFIX("sl_cache");
 
 std::string LLDiskCache::sCacheDir;
 
+// <FS> Cache index journal
+/**
+ * The index journal lives in the cache folder alongside the cache files.
+ * It deliberately does not start with CACHE_FILENAME_PREFIX so that the
+ * purge and clear code never mistake it for a cache file.
+ *
+ * Layout: an 8 byte header (4 byte magic + U32 version) followed by fixed
+ * size records of { U8 op, 16 byte UUID, U64 size, S64 access time,
+ * U64 digest }. The digest is the HBXXH64 of the whole file, or 0 when the
+ * file was written in pieces and nobody knows it.
+ */
+static const std::string INDEX_JOURNAL_FILENAME("index.journal");
+static const char INDEX_JOURNAL_MAGIC[4] = { 'S', 'L', 'D', 'I' };
+static const U32 INDEX_JOURNAL_VERSION = 2;
+static const size_t INDEX_JOURNAL_HEADER_SIZE = sizeof(INDEX_JOURNAL_MAGIC) + sizeof(U32);
+static const size_t INDEX_JOURNAL_RECORD_SIZE = 1 + UUID_BYTES + sizeof(U64) + sizeof(S64) + sizeof(U64);
+
+enum : U8
+{
+    JOURNAL_OP_WRITE = 0,   // entry added or resized (also used for snapshots)
+    JOURNAL_OP_ACCESS,      // entry moved to the most recently used end
+    JOURNAL_OP_REMOVE       // entry removed
+};
+
+// The journal is rewritten as a snapshot once it holds this many times more
+// records than there are live entries
+static const size_t INDEX_JOURNAL_COMPACT_RATIO = 4;
+static const size_t INDEX_JOURNAL_COMPACT_MIN_RECORDS = 4096;
+
+// Records are buffered and appended in batches, by the purge thread once a
+// minute or by whoever fills the buffer to this many records. A crash loses
+// at most that much: the files it leaves unindexed are picked up again the
+// next time the index is rebuilt.
+static const size_t INDEX_JOURNAL_FLUSH_RECORDS = 256;
+
+static std::string index_journal_path(const std::string& cache_dir)
+{
+    return gDirUtilp->add(cache_dir, INDEX_JOURNAL_FILENAME);
+}
+
+/**
+ * Several viewers may share the cache folder. Each of them appends its
+ * records to the one journal while holding an exclusive lock on index.lock.
+ * Only the viewer holding the lock on index.owner replays the records the
+ * others appended, purges the cache and rewrites the journal as a snapshot;
+ * another viewer takes over when it exits.
+ */
+static const std::string INDEX_LOCK_FILENAME("index.lock");
+static const std::string INDEX_OWNER_FILENAME("index.owner");
+
+static std::string index_lock_path(const std::string& cache_dir)
+{
+    return gDirUtilp->add(cache_dir, INDEX_LOCK_FILENAME);
+}
+// </FS>
+
 // <FS:Ansariel> Optimize asset simple disk cache
 static const char* subdirs = "0123456789abcdef";
 
@@ -61,6 +118,7 @@ LLDiskCache::LLDiskCache(const std::string& cache_dir,
                          ,const F32 highwater_mark_percent
                          ,const F32 lowwater_mark_percent
 // </FS:Beq>
+                         ,const U32 packed_entry_max_bytes
                          ) :
     mMaxSizeBytes(max_size_bytes),
     mEnableCacheDebugInfo(enable_cache_debug_info)
@@ -75,6 +133,30 @@ LLDiskCache::LLDiskCache(const std::string& cache_dir,
         LLFile::mkdir(dirname);
     }
     // </FS:Ansariel>
+    // <FS> Shared cache folder: only the owner purges and appends to the packs
+    tryBecomeOwner();
+    // </FS>
+    // <FS> Pack-file storage for small assets
+    if (packed_entry_max_bytes)
+    {
+        mPackedCache = std::make_unique<LLPackedCache>(cache_dir + gDirUtilp->getDirDelimiter() + "packs", packed_entry_max_bytes,
+                                                       LLPackedCache::DEFAULT_SEGMENT_SIZE, !mIsOwner);
+    }
+    else if (mIsOwner)
+    {
+        // Pack storage was switched off: the index below won't know about
+        // any packed entries, so drop them rather than leak the space
+        if (gDirUtilp->deleteDirAndContents(cache_dir + gDirUtilp->getDirDelimiter() + "packs"))
+        {
+            LLFile::remove(index_journal_path(sCacheDir), ENOENT);
+        }
+    }
+    // </FS>
+
+    // <FS> Load (or rebuild) the cache index before anything is copied in
+    loadIndex();
+    // </FS>
+
     // <FS:Beq> add static assets into the new cache after clear.
     // Only missing entries are copied on init, skiplist is setup
     // For everything we populate FS specific assets to allow future updates
@@ -82,6 +164,612 @@ LLDiskCache::LLDiskCache(const std::string& cache_dir,
     // </FS:Beq>
 }
 
+// <FS> Cache index
+void LLDiskCache::cleanupSingleton()
+{
+    if (!mIsOwner)
+    {
+        flushIndexJournal();
+        return;
+    }
+
+    LLMutexLock lock(&mIndexMutex);
+    // Write out a compact snapshot so the next session starts from a short
+    // journal
+    writeIndexSnapshot();
+}
+
+bool LLDiskCache::tryBecomeOwner()
+{
+    if (mIsOwner)
+    {
+        return true;
+    }
+    if (!mOwnerLock.lock(gDirUtilp->add(sCacheDir, INDEX_OWNER_FILENAME), true, true))
+    {
+        return false;
+    }
+    mIsOwner = true;
+    return true;
+}
+
+void LLDiskCache::updateOwnership()
+{
+    if (mIsOwner || !tryBecomeOwner())
+    {
+        return;
+    }
+
+    // The previous owner has exited: pick up everything it and the other
+    // viewers wrote since we started, and take over the packs
+    LL_INFOS("LLDiskCache") << "Taking over the cache folder " << sCacheDir << " from another viewer" << LL_ENDL;
+    if (mPackedCache)
+    {
+        mPackedCache->makeWritable();
+    }
+    loadIndex();
+}
+
+void LLDiskCache::loadIndex()
+{
+    LLMutexLock lock(&mIndexMutex);
+
+    // Our own records must not be lost with the old index
+    writeJournalBuffer();
+
+    mIndexLRU.clear();
+    mIndexMap.clear();
+    mPendingAccess.clear();
+    mIndexedSize = 0;
+    mJournalReadOffset = 0;
+
+    bool valid = false;
+    {
+        // Writers hold the lock exclusively, so nobody appends while we read
+        LLFileLock journal_lock;
+        journal_lock.lock(index_lock_path(sCacheDir), false);
+        valid = replayJournal();
+    }
+
+    if (valid)
+    {
+        LL_INFOS("LLDiskCache") << "Loaded cache index with " << mIndexMap.size() << " entries ("
+                                << mIndexedSize << " bytes) from " << getJournalRecordCount() << " journal records" << LL_ENDL;
+        if (mIsOwner
+            && getJournalRecordCount() > INDEX_JOURNAL_COMPACT_MIN_RECORDS
+            && getJournalRecordCount() > mIndexMap.size() * INDEX_JOURNAL_COMPACT_RATIO)
+        {
+            writeIndexSnapshot();
+        }
+    }
+    else
+    {
+        mJournalReadOffset = 0;
+        rebuildIndex();
+    }
+    updateCacheSize(mIndexedSize);
+}
+
+bool LLDiskCache::replayJournal()
+{
+    LLFILE* journal = LLFile::fopen(index_journal_path(sCacheDir), "rb");
+    if (!journal)
+    {
+        return false;
+    }
+
+    bool valid = false;
+    if (!mJournalReadOffset)
+    {
+        U8 header[INDEX_JOURNAL_HEADER_SIZE];
+        if (fread(header, 1, INDEX_JOURNAL_HEADER_SIZE, journal) == INDEX_JOURNAL_HEADER_SIZE)
+        {
+            U32 version = 0;
+            memcpy(&version, header + sizeof(INDEX_JOURNAL_MAGIC), sizeof(U32));
+            valid = memcmp(header, INDEX_JOURNAL_MAGIC, sizeof(INDEX_JOURNAL_MAGIC)) == 0
+                 && version == INDEX_JOURNAL_VERSION;
+        }
+        if (valid)
+        {
+            mJournalReadOffset = INDEX_JOURNAL_HEADER_SIZE;
+        }
+    }
+    else
+    {
+        // Carry on from the first record we haven't seen yet
+        valid = fseek(journal, (long)mJournalReadOffset, SEEK_SET) == 0;
+    }
+
+    if (valid)
+    {
+        // A crash part way through writing a record just leaves a short
+        // tail, which we ignore (and the next writer overwrites)
+        U8 record[INDEX_JOURNAL_RECORD_SIZE];
+        while (fread(record, 1, INDEX_JOURNAL_RECORD_SIZE, journal) == INDEX_JOURNAL_RECORD_SIZE)
+        {
+            LLUUID id;
+            U64 size = 0;
+            S64 access_time = 0;
+            U64 digest = 0;
+            memcpy(id.mData, record + 1, UUID_BYTES);
+            memcpy(&size, record + 1 + UUID_BYTES, sizeof(U64));
+            memcpy(&access_time, record + 1 + UUID_BYTES + sizeof(U64), sizeof(S64));
+            memcpy(&digest, record + 1 + UUID_BYTES + sizeof(U64) + sizeof(S64), sizeof(U64));
+
+            switch (record[0])
+            {
+                case JOURNAL_OP_WRITE:
+                    addIndexEntry(id, (uintmax_t)size, (std::time_t)access_time, digest);
+                    break;
+                case JOURNAL_OP_ACCESS:
+                {
+                    auto it = mIndexMap.find(id);
+                    if (it != mIndexMap.end())
+                    {
+                        it->second->mAccessTime = (std::time_t)access_time;
+                        mIndexLRU.splice(mIndexLRU.end(), mIndexLRU, it->second);
+                    }
+                    break;
+                }
+                case JOURNAL_OP_REMOVE:
+                    removeIndexEntry(id);
+                    break;
+                default:
+                    valid = false;
+                    break;
+            }
+
+            if (!valid)
+            {
+                break;
+            }
+            mJournalReadOffset += INDEX_JOURNAL_RECORD_SIZE;
+        }
+    }
+    LLFile::close(journal);
+    return valid;
+}
+
+size_t LLDiskCache::getJournalRecordCount() const
+{
+    return mJournalReadOffset > INDEX_JOURNAL_HEADER_SIZE ? (size_t)(mJournalReadOffset - INDEX_JOURNAL_HEADER_SIZE) / INDEX_JOURNAL_RECORD_SIZE : 0;
+}
+
+void LLDiskCache::rebuildIndex()
+{
+    LLMutexLock lock(&mIndexMutex);
+
+    LL_INFOS("LLDiskCache") << "Rebuilding cache index from " << sCacheDir << LL_ENDL;
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    mIndexLRU.clear();
+    mIndexMap.clear();
+    mIndexedSize = 0;
+
+    std::vector<IndexEntry> entries;
+
+    boost::system::error_code ec;
+#if LL_WINDOWS
+    std::wstring cache_path(utf8str_to_utf16str(sCacheDir));
+#else
+    std::string cache_path(sCacheDir);
+#endif
+    if (boost::filesystem::is_directory(cache_path, ec) && !ec.failed())
+    {
+        boost::filesystem::recursive_directory_iterator iter(cache_path, ec);
+        while (iter != boost::filesystem::recursive_directory_iterator() && !ec.failed())
+        {
+            if (boost::filesystem::is_regular_file(*iter, ec) && !ec.failed())
+            {
+                const std::string file_name = (*iter).path().filename().string();
+                // sl_cache_<uuid>_0.asset, but not the temporary files
+                // LLFileSystem writes before renaming them into place
+                if (file_name.compare(0, CACHE_FILENAME_PREFIX.size(), CACHE_FILENAME_PREFIX) == 0
+                    && file_name.size() > CACHE_FILENAME_PREFIX.size() + 1 + UUID_STR_LENGTH - 1
+                    && (*iter).path().extension() == ".asset")
+                {
+                    LLUUID id;
+                    if (id.set(file_name.substr(CACHE_FILENAME_PREFIX.size() + 1, UUID_STR_LENGTH - 1), false))
+                    {
+                        uintmax_t file_size = boost::filesystem::file_size(*iter, ec);
+                        if (!ec.failed())
+                        {
+                            std::time_t file_time = boost::filesystem::last_write_time(*iter, ec);
+                            if (!ec.failed())
+                            {
+                                entries.push_back({ id, file_size, file_time });
+                            }
+                        }
+                    }
+                }
+            }
+            iter.increment(ec);
+        }
+    }
+
+    // Packed entries have no file of their own to stat; the time their
+    // segment was last written to is the closest we have
+    if (mPackedCache)
+    {
+        std::vector<LLPackedCache::EntryInfo> packed_entries;
+        mPackedCache->getEntries(packed_entries);
+        for (const LLPackedCache::EntryInfo& entry : packed_entries)
+        {
+            entries.push_back({ entry.mID, entry.mSize, entry.mWriteTime });
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const IndexEntry& x, const IndexEntry& y)
+    {
+        return x.mAccessTime < y.mAccessTime;
+    });
+
+    for (const IndexEntry& entry : entries)
+    {
+        addIndexEntry(entry.mID, entry.mSize, entry.mAccessTime);
+    }
+
+    // Another viewer owns the journal; it rebuilds it when it needs to
+    if (mIsOwner)
+    {
+        writeIndexSnapshot();
+    }
+
+    auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start_time).count();
+    LL_INFOS("LLDiskCache") << "Rebuilt cache index with " << mIndexMap.size() << " entries (" << mIndexedSize
+                            << " bytes) in " << execute_time << " ms" << LL_ENDL;
+}
+
+void LLDiskCache::writeIndexSnapshot()
+{
+    if (!mIsOwner)
+    {
+        return;
+    }
+
+    LLFileLock journal_lock;
+    journal_lock.lock(index_lock_path(sCacheDir));
+
+    // Take in what the other viewers appended since we last looked, or
+    // the snapshot would drop it. If the journal is unreadable the index
+    // we have is still the best there is.
+    if (mJournalReadOffset)
+    {
+        replayJournal();
+    }
+
+    // Write to a temporary file and swap it in so that a crash part way
+    // through leaves the old journal intact
+    const std::string journal_path = index_journal_path(sCacheDir);
+    const std::string temp_path = journal_path + ".tmp";
+    LLFILE* snapshot = LLFile::fopen(temp_path, "wb");
+    if (!snapshot)
+    {
+        LL_WARNS("LLDiskCache") << "Unable to write cache index snapshot " << temp_path << LL_ENDL;
+        return;
+    }
+
+    std::vector<U8> buffer(INDEX_JOURNAL_HEADER_SIZE);
+    buffer.reserve(INDEX_JOURNAL_HEADER_SIZE + mIndexLRU.size() * INDEX_JOURNAL_RECORD_SIZE);
+    memcpy(buffer.data(), INDEX_JOURNAL_MAGIC, sizeof(INDEX_JOURNAL_MAGIC));
+    memcpy(buffer.data() + sizeof(INDEX_JOURNAL_MAGIC), &INDEX_JOURNAL_VERSION, sizeof(U32));
+    mJournalBuffer.swap(buffer);
+    for (const IndexEntry& entry : mIndexLRU)
+    {
+        appendJournalRecord(JOURNAL_OP_WRITE, entry.mID, entry.mSize, entry.mAccessTime, entry.mDigest);
+    }
+    mJournalBuffer.swap(buffer);
+    mPendingAccess.clear();
+
+    bool success = fwrite(buffer.data(), 1, buffer.size(), snapshot) == buffer.size();
+    success = !ferror(snapshot) && success;
+    LLFile::close(snapshot);
+
+    if (!success || LLFile::replace(temp_path, journal_path) != 0)
+    {
+        LL_WARNS("LLDiskCache") << "Unable to replace cache index journal " << journal_path << LL_ENDL;
+        LLFile::remove(temp_path);
+        return;
+    }
+
+    // Our own buffered records are already part of the snapshot
+    mJournalBuffer.clear();
+    mJournalReadOffset = buffer.size();
+}
+
+void LLDiskCache::writeJournalBuffer()
+{
+    if (mJournalBuffer.empty())
+    {
+        return;
+    }
+
+    LLFileLock journal_lock;
+    journal_lock.lock(index_lock_path(sCacheDir));
+
+    const std::string journal_path = index_journal_path(sCacheDir);
+    LLFILE* journal = LLFile::fopen(journal_path, "r+b");
+    if (!journal)
+    {
+        // Leave creating the journal to loadIndex(), which checks it
+        mJournalBuffer.clear();
+        return;
+    }
+
+    // Append after the last whole record, overwriting the torn tail a crash
+    // may have left behind
+    long end = 0;
+    if (fseek(journal, 0, SEEK_END) == 0)
+    {
+        end = ftell(journal);
+    }
+    if (end >= (long)INDEX_JOURNAL_HEADER_SIZE)
+    {
+        end = (long)INDEX_JOURNAL_HEADER_SIZE + ((end - (long)INDEX_JOURNAL_HEADER_SIZE) / (long)INDEX_JOURNAL_RECORD_SIZE) * (long)INDEX_JOURNAL_RECORD_SIZE;
+        if (fseek(journal, end, SEEK_SET) != 0
+            || fwrite(mJournalBuffer.data(), 1, mJournalBuffer.size(), journal) != mJournalBuffer.size())
+        {
+            LL_WARNS("LLDiskCache") << "Unable to append to cache index journal " << journal_path << LL_ENDL;
+        }
+    }
+    LLFile::close(journal);
+    mJournalBuffer.clear();
+}
+
+void LLDiskCache::writeJournalBufferIfFull()
+{
+    if (mJournalBuffer.size() >= INDEX_JOURNAL_FLUSH_RECORDS * INDEX_JOURNAL_RECORD_SIZE)
+    {
+        writeJournalBuffer();
+    }
+}
+
+void LLDiskCache::addIndexEntry(const LLUUID& id, uintmax_t size, std::time_t access_time, U64 digest)
+{
+    auto it = mIndexMap.find(id);
+    if (it != mIndexMap.end())
+    {
+        mIndexedSize -= it->second->mSize;
+        it->second->mSize = size;
+        it->second->mAccessTime = access_time;
+        it->second->mDigest = digest;
+        mIndexLRU.splice(mIndexLRU.end(), mIndexLRU, it->second);
+    }
+    else
+    {
+        mIndexMap.emplace(id, mIndexLRU.insert(mIndexLRU.end(), { id, size, access_time, digest }));
+    }
+    mIndexedSize += size;
+}
+
+void LLDiskCache::removeIndexEntry(const LLUUID& id)
+{
+    auto it = mIndexMap.find(id);
+    if (it != mIndexMap.end())
+    {
+        mIndexedSize -= it->second->mSize;
+        mIndexLRU.erase(it->second);
+        mIndexMap.erase(it);
+    }
+    mPendingAccess.erase(id);
+}
+
+void LLDiskCache::appendJournalRecord(U8 op, const LLUUID& id, uintmax_t size, std::time_t access_time, U64 digest)
+{
+    U8 record[INDEX_JOURNAL_RECORD_SIZE];
+    const U64 record_size = (U64)size;
+    const S64 record_time = (S64)access_time;
+    record[0] = op;
+    memcpy(record + 1, id.mData, UUID_BYTES);
+    memcpy(record + 1 + UUID_BYTES, &record_size, sizeof(U64));
+    memcpy(record + 1 + UUID_BYTES + sizeof(U64), &record_time, sizeof(S64));
+    memcpy(record + 1 + UUID_BYTES + sizeof(U64) + sizeof(S64), &digest, sizeof(U64));
+    mJournalBuffer.insert(mJournalBuffer.end(), record, record + INDEX_JOURNAL_RECORD_SIZE);
+}
+
+void LLDiskCache::indexFileWrite(const LLUUID& id, uintmax_t size, U64 digest)
+{
+    LLMutexLock lock(&mIndexMutex);
+    const std::time_t now = std::time(nullptr);
+    addIndexEntry(id, size, now, digest);
+    mPendingAccess.erase(id);
+    appendJournalRecord(JOURNAL_OP_WRITE, id, size, now, digest);
+    writeJournalBufferIfFull();
+}
+
+void LLDiskCache::indexFileRemove(const LLUUID& id)
+{
+    LLMutexLock lock(&mIndexMutex);
+    if (mIndexMap.find(id) != mIndexMap.end())
+    {
+        removeIndexEntry(id);
+        appendJournalRecord(JOURNAL_OP_REMOVE, id, 0, 0);
+        writeJournalBufferIfFull();
+    }
+}
+
+void LLDiskCache::indexFileRename(const LLUUID& old_id, const LLUUID& new_id)
+{
+    LLMutexLock lock(&mIndexMutex);
+    auto it = mIndexMap.find(old_id);
+    if (it != mIndexMap.end())
+    {
+        const uintmax_t size = it->second->mSize;
+        const U64 digest = it->second->mDigest;
+        const std::time_t now = std::time(nullptr);
+        removeIndexEntry(old_id);
+        addIndexEntry(new_id, size, now, digest);
+        appendJournalRecord(JOURNAL_OP_REMOVE, old_id, 0, 0);
+        appendJournalRecord(JOURNAL_OP_WRITE, new_id, size, now, digest);
+        writeJournalBufferIfFull();
+    }
+}
+
+void LLDiskCache::indexFileAccess(const LLUUID& id)
+{
+    LLMutexLock lock(&mIndexMutex);
+    auto it = mIndexMap.find(id);
+    if (it != mIndexMap.end())
+    {
+        it->second->mAccessTime = std::time(nullptr);
+        mIndexLRU.splice(mIndexLRU.end(), mIndexLRU, it->second);
+        mPendingAccess.insert(id);
+    }
+}
+
+void LLDiskCache::flushIndexJournal()
+{
+    LLMutexLock lock(&mIndexMutex);
+    if (mIsOwner
+        && getJournalRecordCount() > INDEX_JOURNAL_COMPACT_MIN_RECORDS
+        && getJournalRecordCount() > mIndexMap.size() * INDEX_JOURNAL_COMPACT_RATIO)
+    {
+        // The snapshot already has the access order baked in
+        writeIndexSnapshot();
+        return;
+    }
+
+    for (const LLUUID& id : mPendingAccess)
+    {
+        auto it = mIndexMap.find(id);
+        if (it != mIndexMap.end())
+        {
+            appendJournalRecord(JOURNAL_OP_ACCESS, id, 0, it->second->mAccessTime);
+        }
+    }
+    mPendingAccess.clear();
+
+    writeJournalBuffer();
+}
+
+void LLDiskCache::syncIndexFromJournal()
+{
+    LLMutexLock lock(&mIndexMutex);
+    if (!mIsOwner || !mJournalReadOffset)
+    {
+        return;
+    }
+
+    LLFileLock journal_lock;
+    journal_lock.lock(index_lock_path(sCacheDir), false);
+    if (!replayJournal())
+    {
+        LL_WARNS("LLDiskCache") << "Cache index journal is unreadable, it will be rewritten" << LL_ENDL;
+        mJournalReadOffset = 0;
+    }
+}
+
+uintmax_t LLDiskCache::getIndexedSize()
+{
+    LLMutexLock lock(&mIndexMutex);
+    return mIndexedSize;
+}
+
+U64 LLDiskCache::getIndexedDigest(const LLUUID& id, uintmax_t size)
+{
+    LLMutexLock lock(&mIndexMutex);
+    auto it = mIndexMap.find(id);
+    if (it == mIndexMap.end() || it->second->mSize != size)
+    {
+        return 0;
+    }
+    return it->second->mDigest;
+}
+
+// Reading goes on without mIndexMutex, so an entry found corrupted is only
+// evicted if the index still has the digest it was checked against: a
+// rewrite in the meantime may have fixed it already.
+uintmax_t LLDiskCache::scrub(uintmax_t max_bytes)
+{
+    if (!mIsOwner)
+    {
+        return 0;
+    }
+
+    uintmax_t checked_bytes = 0;
+    bool refilled = false;
+    std::vector<U8> data;
+    while (checked_bytes < max_bytes)
+    {
+        LLUUID id;
+        uintmax_t size = 0;
+        U64 digest = 0;
+        {
+            LLMutexLock lock(&mIndexMutex);
+            if (mScrubQueue.empty())
+            {
+                // Start another pass, at most once per call. The queue is
+                // consumed from the back, so recently used entries go first.
+                if (refilled)
+                {
+                    break;
+                }
+                refilled = true;
+                mScrubQueue.reserve(mIndexMap.size());
+                for (const IndexEntry& entry : mIndexLRU)
+                {
+                    if (entry.mDigest)
+                    {
+                        mScrubQueue.push_back(entry.mID);
+                    }
+                }
+                if (mScrubQueue.empty())
+                {
+                    break;
+                }
+            }
+            id = mScrubQueue.back();
+            mScrubQueue.pop_back();
+
+            auto it = mIndexMap.find(id);
+            if (it == mIndexMap.end() || !it->second->mDigest)
+            {
+                continue;
+            }
+            size = it->second->mSize;
+            digest = it->second->mDigest;
+        }
+
+        bool readable = mPackedCache && mPackedCache->readAll(id, data);
+        if (!readable)
+        {
+            const std::string filename = metaDataToFilepath(id, LLAssetType::AT_UNKNOWN);
+            LLFILE* file = LLFile::fopen(filename, "rb");
+            if (!file)
+            {
+                continue; // already gone
+            }
+            data.resize(size);
+            readable = fread(data.data(), 1, size, file) == size && fgetc(file) == EOF;
+            LLFile::close(file);
+        }
+        checked_bytes += size;
+
+        if (readable && data.size() == size && HBXXH64::digest(data.data(), data.size()) == digest)
+        {
+            continue;
+        }
+
+        LLMutexLock lock(&mIndexMutex);
+        auto it = mIndexMap.find(id);
+        if (it == mIndexMap.end() || it->second->mDigest != digest)
+        {
+            continue;
+        }
+        LL_WARNS("LLDiskCache") << "Evicting corrupted cache entry " << id << LL_ENDL;
+        if (mPackedCache)
+        {
+            mPackedCache->removeAll(id);
+        }
+        LLFile::remove(metaDataToFilepath(id, LLAssetType::AT_UNKNOWN), ENOENT);
+        removeIndexEntry(id);
+        appendJournalRecord(JOURNAL_OP_REMOVE, id, 0, 0);
+        writeJournalBufferIfFull();
+    }
+    return checked_bytes;
+}
+// </FS>
+
 // WARNING: purge() is called by LLPurgeDiskCacheThread. As such it must
 // NOT touch any LLDiskCache data without introducing and locking a mutex!
 
@@ -110,221 +798,130 @@ LLDiskCache::LLDiskCache(const std::string& cache_dir,
 // will prevent this. B continues with the next file. If the file is already
 // gone before A finally gets to open it, this operation will fail and the
 // asset will have to be re-requested.
+
+// <FS> The purge now works from the in-memory index (see indexFileWrite() and
+// friends) rather than walking and stat()ing the whole cache directory. Each
+// eviction is done under mIndexMutex so that a concurrent write of the same
+// asset can't be deleted straight after it was re-added to the index.
 void LLDiskCache::purge()
 {
-    if (mEnableCacheDebugInfo)
+    // <FS> Shared cache folder: leave purging to the owner, which needs to
+    // know about the files the other viewers wrote first
+    if (!mIsOwner)
     {
-        LL_INFOS() << "Total dir size before purge is " << dirFileSize(sCacheDir) << LL_ENDL;
+        flushIndexJournal();
+        return;
     }
+    syncIndexFromJournal();
+    // </FS>
 
-    boost::system::error_code ec;
     auto start_time = std::chrono::high_resolution_clock::now();
 
-    typedef std::pair<std::time_t, std::pair<uintmax_t, std::string>> file_info_t;
-    std::vector<file_info_t> file_info;
-
-#if LL_WINDOWS
-    std::wstring cache_path(utf8str_to_utf16str(sCacheDir));
-#else
-    std::string cache_path(sCacheDir);
-#endif
-    uintmax_t file_size_total = 0; // <FS:Beq/> try to make simple cache less naive.
-    
-    if (boost::filesystem::is_directory(cache_path, ec) && !ec.failed())
-    {
-        // <FS:Ansariel> Optimize asset simple disk cache
-        //boost::filesystem::directory_iterator iter(cache_path, ec);
-        //while (iter != boost::filesystem::directory_iterator() && !ec.failed())
-        boost::filesystem::recursive_directory_iterator iter(cache_path, ec);
-        while (iter != boost::filesystem::recursive_directory_iterator() && !ec.failed())
-        // </FS:Ansariel>
-        {
-            if (boost::filesystem::is_regular_file(*iter, ec) && !ec.failed())
-            {
-                if ((*iter).path().string().find(CACHE_FILENAME_PREFIX) != std::string::npos)
-                {
-                    uintmax_t file_size = boost::filesystem::file_size(*iter, ec);
-                    if (ec.failed())
-                    {
-                        continue;
-                    }
-                    const std::string file_path = (*iter).path().string();
-                    const std::time_t file_time = boost::filesystem::last_write_time(*iter, ec);
-                    if (ec.failed())
-                    {
-                        continue;
-                    }
-                    file_size_total += file_size; // <FS:Beq/> try to make simple cache less naive.
-
-                    file_info.push_back(file_info_t(file_time, { file_size, file_path }));
-                }
-            }
-            iter.increment(ec);
-        }
-    }
+    const uintmax_t file_size_total = getIndexedSize();
 
     // <FS:Beq> add high water/low water thresholds to reduce the churn in the cache.
     LL_DEBUGS("LLDiskCache") << "Cache is " << (int)(((F32)file_size_total)/mMaxSizeBytes*100.0) << "% full" << LL_ENDL;
     if( file_size_total < mMaxSizeBytes * (mHighPercent/100) )
     {
-        // Nothing to do here 
+        // Nothing to do here
         LL_DEBUGS("LLDiskCache") << "Not exceded high water - do nothing" << LL_ENDL;
+        flushIndexJournal();
+        updateCacheSize(file_size_total);
         return;
     }
     // If we reach here we are above the trigger level so we must purge until we've removed enough to take us down to the low water mark.
-    // </FS:Beq>
-    std::sort(file_info.begin(), file_info.end(), [](file_info_t& x, file_info_t& y)
-    {
-        return x.first < y.first; // <FS:Beq/> sort oldest to newest, to we can remove the oldest files first.
-    });
-
-
-    // <FS:Beq> add high water/low water thresholds to reduce the churn in the cache.
     auto target_size = (uintmax_t)(mMaxSizeBytes * (mLowPercent/100));
     LL_INFOS() << "Purging cache to a maximum of " << target_size << " bytes" << LL_ENDL;
     // </FS:Beq>
 
     // <FS:Beq> Extra accounting to track the retention of static assets
-    //std::vector<bool> file_removed;
-    enum class purge_action { delete_file=0, keep_file, skip_file };
-    std::map<std::string,purge_action> file_removed;
-    auto keep{file_info.size()};
+    std::unordered_set<LLUUID> skip_ids;
+    for (const std::string& uuid_as_string : mSkipList)
+    {
+        skip_ids.emplace(uuid_as_string);
+    }
     auto del{0};
     auto skip{0};
     // </FS:Beq>
-    // <FS:Beq> revised purge logic to track amount removed not retained to shortern loop
-    // uintmax_t file_size_total = 0;
-    // if (mEnableCacheDebugInfo)
-    // {
-    //     file_removed.reserve(file_info.size());
-    // }
-    // uintmax_t file_size_total = 0;
-    // for (file_info_t& entry : file_info)
-    // {
-    //     file_size_total += entry.second.first;
-
-    //     bool should_remove = file_size_total > mMaxSizeBytes;
-    //     if (mEnableCacheDebugInfo)
-    //     {
-    //         file_removed.push_back(should_remove);
-    //     }
+
     uintmax_t deleted_size_total = 0;
-    for (const file_info_t& entry : file_info)
+    size_t visited = 0;
+    size_t skipped_in_a_row = 0;
+    size_t kept = 0;
+    boost::system::error_code ec;
+    while (true)
     {
-        // first check if we still need to delete more files
-        bool should_remove = (file_size_total - deleted_size_total) > target_size;
+        LLMutexLock lock(&mIndexMutex);
 
-        // <FS> Make sure static assets are not eliminated
-        auto action{ should_remove ? purge_action::delete_file : purge_action::keep_file };
-        if (!should_remove)
+        // Stop once we are under the low water mark, or once everything
+        // that is left is a protected static asset
+        kept = mIndexMap.size();
+        if (mIndexedSize <= target_size || mIndexLRU.empty() || skipped_in_a_row >= mIndexMap.size())
         {
             break;
         }
+        ++visited;
+
+        IndexEntry entry = mIndexLRU.front();
+        const std::string file_path = metaDataToFilepath(entry.mID, LLAssetType::AT_UNKNOWN);
 
-        auto this_file_size = entry.second.first;
-        deleted_size_total += this_file_size;
-        auto uuid_as_string = gDirUtilp->getBaseFileName(entry.second.second, true);
-        uuid_as_string      = uuid_as_string.substr(CACHE_FILENAME_PREFIX.size() + 1, 36);  // skip "sl_cache_" and trailing "_N"
-        // LL_INFOS() << "checking UUID=" <<uuid_as_string<< LL_ENDL;
-        if (std::find(mSkipList.begin(), mSkipList.end(), uuid_as_string) != mSkipList.end())
+        if (skip_ids.find(entry.mID) != skip_ids.end())
         {
-            // this is one of our protected items so no purging
-            should_remove = false;
-            action = purge_action::skip_file;
-            boost::filesystem::last_write_time(entry.second.second, ec);  // force these to the front of the list next time so that purge size works 
+            // this is one of our protected items so no purging - move it to the
+            // back of the list so that purge size works next time around
+            mIndexLRU.splice(mIndexLRU.end(), mIndexLRU, mIndexLRU.begin());
             skip++;
+            skipped_in_a_row++;
+            if (mEnableCacheDebugInfo)
+            {
+                LL_INFOS("LLDiskCache") << "STATIC  " << entry.mAccessTime << "  " << entry.mSize << "  " << file_path << LL_ENDL;
+            }
+            continue;
         }
-        else{
-            del++;
+
+        removeIndexEntry(entry.mID);
+        appendJournalRecord(JOURNAL_OP_REMOVE, entry.mID, 0, 0);
+        deleted_size_total += entry.mSize;
+        del++;
+        skipped_in_a_row = 0;
+
+        if (mPackedCache && mPackedCache->removeAll(entry.mID))
+        {
+            // Packed assets have no file of their own
+            ec.clear();
         }
-        keep--;
-        if (mEnableCacheDebugInfo)
+        else
         {
-            file_removed.emplace(entry.second.second, action);
+#if LL_WINDOWS
+            boost::filesystem::remove(utf8str_to_utf16str(file_path), ec);
+#else
+            boost::filesystem::remove(file_path, ec);
+#endif
         }
-    // </FS>
-        if (should_remove)
+        if (ec.failed())
         {
-            boost::filesystem::remove(entry.second.second, ec);
-            if (ec.failed())
-            {
-                LL_WARNS() << "Failed to delete cache file " << entry.second.second << ": " << ec.message() << LL_ENDL;
-            }
+            LL_WARNS() << "Failed to delete cache file " << file_path << ": " << ec.message() << LL_ENDL;
         }
-    }
-// <FS:Beq> update the debug logging to be more useful
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-// </FS:Beq>
-    if (mEnableCacheDebugInfo)
-    {
-        // <FS:Beq> update the debug logging to be more useful
-        // auto end_time = std::chrono::high_resolution_clock::now();
-        // auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-        // </FS:Beq>
 
-        // Log afterward so it doesn't affect the time measurement
-        // Logging thousands of file results can take hundreds of milliseconds
-        uintmax_t deleted_so_far{ 0 }; // <FS:Beq/> update the debug logging to be more useful
-        for (size_t i = 0; i < file_info.size(); ++i)
+        if (mEnableCacheDebugInfo)
         {
-            const file_info_t& entry = file_info[i];
-            // <FS> Static asset stuff
-            deleted_so_far += entry.second.first; // <FS:Beq/> update the debug logging to be more useful
-            //const bool removed = file_removed[i];
-            //const std::string action = removed ? "DELETE:" : "KEEP:";
-            std::string action{};
-
-            // Check if the file exists in the map
-            auto& filename{ entry.second.second };
-            if (file_removed.find(filename) != file_removed.end()) {
-            // File found in the map, retrieve the corresponding enum value
-            switch (file_removed[filename])
-            {
-                case purge_action::delete_file:
-                    action = "DELETE";
-                    del++;
-                break;
-                case purge_action::skip_file:
-                    action = "STATIC";
-                    skip++;
-                break;
-                default:
-                // Handle any unexpected enum value
-                    action = "UNKNOWN";
-                break;
-            }
-            }
-            else 
-            {
-                action = "KEEP";
-            }            
-            // </FS>
-
-            // have to do this because of LL_INFO/LL_END weirdness
-            std::ostringstream line;
-
-            line << action << "  ";
-            line << entry.first << "  ";
-            line << entry.second.first << "  ";
-            line << entry.second.second;
-            line << " (" << file_size_total - deleted_so_far << "/" << mMaxSizeBytes << ")"; // <FS:Beq/> update the debug logging to be more useful
-            LL_INFOS() << line.str() << LL_ENDL;
+            LL_INFOS("LLDiskCache") << "DELETE  " << entry.mAccessTime << "  " << entry.mSize << "  " << file_path
+                                    << " (" << mIndexedSize << "/" << mMaxSizeBytes << ")" << LL_ENDL;
         }
-// <FS:Beq> make the summary stats more easily enabled.
     }
-    // <FS:Beq> update the debug logging to be more useful
-        // LL_INFOS() << "Total dir size after purge is " << dirFileSize(sCacheDir) << LL_ENDL;
-        // LL_INFOS() << "Cache purge took " << execute_time << " ms to execute for " << file_info.size() << " files" << LL_ENDL;
 
-    auto newCacheSize = updateCacheSize(file_size_total - deleted_size_total); 
-    LL_INFOS("LLDiskCache") << "Total dir size after purge is " << newCacheSize << LL_ENDL; 
-    LL_INFOS("LLDiskCache") << "Cache purge took " << execute_time << " ms to execute for " << file_info.size() << " files" << LL_ENDL;
-// </FS:Beq>
-    LL_INFOS("LLDiskCache") << "Deleted: " << del << " Skipped: " << skip << " Kept: " << keep << LL_ENDL;    // <FS:Beq/> Extra accounting to track the retention of static assets
-    LL_INFOS("LLDiskCache") << "Total of " << deleted_size_total << " bytes removed." << LL_ENDL;    // <FS:Beq/> Extra accounting to track the retention of static assets
-    // } <FS:Beq/> this bracket was moved up a few lines.
+    flushIndexJournal();
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+
+    auto newCacheSize = updateCacheSize(getIndexedSize());
+    LL_INFOS("LLDiskCache") << "Total dir size after purge is " << newCacheSize << LL_ENDL;
+    LL_INFOS("LLDiskCache") << "Cache purge took " << execute_time << " ms to execute for " << visited << " files" << LL_ENDL;
+    LL_INFOS("LLDiskCache") << "Deleted: " << del << " Skipped: " << skip << " Kept: " << kept << LL_ENDL;
+    LL_INFOS("LLDiskCache") << "Total of " << deleted_size_total << " bytes removed." << LL_ENDL;
 }
+// </FS>
 
 const std::string LLDiskCache::metaDataToFilepath(const LLUUID& id, LLAssetType::EType at)
 {
@@ -336,7 +933,10 @@ const std::string LLDiskCache::getCacheInfo()
     std::ostringstream cache_info;
 
     F32 max_in_mb = (F32)mMaxSizeBytes / (1024.0f * 1024.0f);
-    F32 percent_used = ((F32)dirFileSize(sCacheDir) / (F32)mMaxSizeBytes) * 100.0f;
+    // <FS> Cache index
+    //F32 percent_used = ((F32)dirFileSize(sCacheDir) / (F32)mMaxSizeBytes) * 100.0f;
+    F32 percent_used = ((F32)getIndexedSize() / (F32)mMaxSizeBytes) * 100.0f;
+    // </FS>
 
     cache_info << std::fixed;
     cache_info << std::setprecision(1);
@@ -380,6 +980,16 @@ void LLDiskCache::prepopulateCacheWithStatic()
                     {
                         LL_WARNS("LLDiskCache") << "Failed to copy " << from_asset_file << " to " << to_asset_file << LL_ENDL;
                     }
+                    // <FS> Cache index
+                    else
+                    {
+                        llstat file_stat;
+                        if (LLFile::stat(to_asset_file, &file_stat) == 0)
+                        {
+                            indexFileWrite(uuid, file_stat.st_size);
+                        }
+                    }
+                    // </FS>
                 }
                 if (std::find(mSkipList.begin(), mSkipList.end(), uuid_as_string) == mSkipList.end())
                 {
@@ -397,6 +1007,13 @@ void LLDiskCache::prepopulateCacheWithStatic()
 
 void LLDiskCache::clearCache()
 {
+    // <FS> Shared cache folder: don't pull the files from under the owner
+    if (!mIsOwner)
+    {
+        LL_WARNS() << "Not clearing cache " << sCacheDir << ", another viewer is using it" << LL_ENDL;
+        return;
+    }
+    // </FS>
     LL_INFOS() << "clearing cache " << sCacheDir << LL_ENDL;
     /**
      * See notes on performance in dirFileSize(..) - there may be
@@ -410,6 +1027,13 @@ void LLDiskCache::clearCache()
 #else
     std::string cache_path(sCacheDir);
 #endif
+    // <FS> Pack-file storage: unmap and drop the segments first, Windows
+    // won't delete mapped files
+    if (mPackedCache)
+    {
+        mPackedCache->clear();
+    }
+    // </FS>
     if (boost::filesystem::is_directory(cache_path, ec) && !ec.failed())
     {
         // <FS:Ansariel> Optimize asset simple disk cache
@@ -421,7 +1045,8 @@ void LLDiskCache::clearCache()
         {
             if (boost::filesystem::is_regular_file(*iter, ec) && !ec.failed())
             {
-                if ((*iter).path().string().find(CACHE_FILENAME_PREFIX) != std::string::npos)
+                if ((*iter).path().string().find(CACHE_FILENAME_PREFIX) != std::string::npos
+                    && !(mPackedCache && (*iter).path().extension() == ".seg")) // <FS/> the active segment is open
                 {
                     boost::filesystem::remove(*iter, ec);
                     if (ec.failed())
@@ -432,6 +1057,17 @@ void LLDiskCache::clearCache()
             }
             iter.increment(ec);
         }
+        // <FS> Cache index
+        {
+            LLMutexLock lock(&mIndexMutex);
+            mIndexLRU.clear();
+            mIndexMap.clear();
+            mPendingAccess.clear();
+            mIndexedSize = 0;
+            mJournalReadOffset = 0; // don't replay what we just deleted
+            writeIndexSnapshot();
+        }
+        // </FS>
         // <FS:Beq> add static assets into the new cache after clear
     LL_INFOS() << "prepopulating new cache " << LL_ENDL;
         prepopulateCacheWithStatic();
@@ -557,6 +1193,25 @@ void LLPurgeDiskCacheThread::run()
 
     while (LLApp::instance()->sleep(CHECK_INTERVAL))
     {
+        // <FS> Shared cache folder: take over once the owning viewer exits
+        LLDiskCache::instance().updateOwnership();
+
+        // purge() also flushes the index journal
         LLDiskCache::instance().purge();
+
+        // <FS> Pack-file storage: reclaim the space of purged/replaced
+        // entries, or pick up what the owning viewer wrote
+        if (LLPackedCache* packed_cache = LLDiskCache::instance().getPackedCache())
+        {
+            if (packed_cache->isReadOnly())
+            {
+                packed_cache->refresh();
+            }
+            else
+            {
+                packed_cache->compact();
+            }
+        }
+        // </FS>
     }
 }
@@ -28,6 +28,15 @@
  *    directory, sorts them by date of last access (write) and then
  *    deletes any files based on age until the total size of all
  *    the files is less than the maximum size specified.
+ *    <FS> The directory scan is now only used to (re)build an in-memory
+ *    index the first time around. After that, LLFileSystem keeps an LRU
+ *    list and a running size total up to date on every write, remove and
+ *    access, and the index is persisted to a small journal file in the
+ *    cache folder. Purging then just pops the oldest entries off the LRU
+ *    list and never stats the files it keeps. </FS>
+ *    <FS> Several viewers may share the cache folder. They all append to
+ *    the journal under a file lock, but only the one that holds the owner
+ *    lock reads back what the others wrote, purges and compacts. </FS>
  * 4/ An LLSingleton idiom is used since there will only ever be
  *    a single cache and we want to access it from numerous places.
  * 5/ Performance on my modest system seems very acceptable. For
@@ -63,7 +72,16 @@
 #define _LLDISKCACHE
 
 #include "llsingleton.h"
+#include "llfile.h"
+#include "llmutex.h"
+#include "llpackedcache.h"
+#include "lluuid.h"
+#include <atomic>
 #include <chrono>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 using namespace std::chrono;
 
 
@@ -106,10 +124,21 @@ class LLDiskCache :
                      */
                     const F32 lowwater_mark_percent
                     // </FS:Beq>
+                    // <FS> Pack-file storage for small assets
+                    /**
+                     * Assets up to this many bytes are appended to shared
+                     * segment files (see LLPackedCache) instead of getting a
+                     * file each. 0 keeps the one-file-per-asset layout.
+                     */
+                    , const U32 packed_entry_max_bytes = 0
+                    // </FS>
                     );
 
         virtual ~LLDiskCache() = default;
 
+        // <FS> Persist the cache index on shutdown
+        void cleanupSingleton() override;
+
     public:
         /**
          * Construct a filename and path to it based on the file meta data
@@ -152,6 +181,55 @@ class LLDiskCache :
 
         void removeOldVFSFiles();
 
+        /**
+         * Keep the in-memory cache index in step with the files on disk.
+         * These are called by LLFileSystem whenever it writes, removes,
+         * renames or reads a cache file and may be called from any thread.
+         * The digest is the HBXXH64 of the whole file, 0 if unknown.
+         */
+        void indexFileWrite(const LLUUID& id, uintmax_t size, U64 digest = 0);
+        void indexFileRemove(const LLUUID& id);
+        void indexFileRename(const LLUUID& old_id, const LLUUID& new_id);
+        void indexFileAccess(const LLUUID& id);
+
+        /**
+         * Append any buffered records to the index journal and
+         * compact it if it has grown too far beyond the live entry count.
+         * Called periodically from LLPurgeDiskCacheThread.
+         */
+        void flushIndexJournal();
+
+        /**
+         * Try to become the viewer that purges the cache folder if nobody
+         * else is (any more). Called periodically from LLPurgeDiskCacheThread.
+         */
+        void updateOwnership();
+        bool isOwner() const { return mIsOwner; }
+
+        /**
+         * Total size in bytes of all files currently tracked by the index
+         */
+        uintmax_t getIndexedSize();
+
+        /**
+         * Digest recorded for the entry, or 0 if it is unknown or the entry
+         * is not size bytes long
+         */
+        U64 getIndexedDigest(const LLUUID& id, uintmax_t size);
+
+        /**
+         * Read back about max_bytes worth of entries with a known digest,
+         * carrying on where the last call stopped, and evict the ones that
+         * no longer match. Returns the number of bytes checked. Only the
+         * owner of the cache folder scrubs.
+         */
+        uintmax_t scrub(uintmax_t max_bytes);
+
+        /**
+         * The pack-file store for small assets, or nullptr when disabled
+         */
+        LLPackedCache* getPackedCache() const { return mPackedCache.get(); }
+
         // <FS:Ansariel> Better asset cache size control
         void setMaxSizeBytes(uintmax_t size) { mMaxSizeBytes = size; }
         // <FS:Beq> High/Low water control
@@ -175,6 +253,99 @@ class LLDiskCache :
         uintmax_t mStoredCacheSize{ 0 };
         time_point<system_clock> mLastScanTime{ };
 
+    private:
+        /**
+         * Read the index journal from the cache folder, replaying its records
+         * in order. Falls back to rebuildIndex() if the journal is missing
+         * or was written by an incompatible version.
+         */
+        void loadIndex();
+
+        /**
+         * Scan the cache folder once and rebuild the index from the file
+         * sizes and last write times found there, oldest first.
+         */
+        void rebuildIndex();
+
+        /**
+         * Rewrite the journal as a snapshot of the live index, in LRU order
+         * so that replaying it restores the same eviction order. Only the
+         * owner does this. Expects mIndexMutex to be held.
+         */
+        void writeIndexSnapshot();
+
+        /**
+         * Owner only: apply the records other viewers appended to the
+         * journal since we last read it
+         */
+        void syncIndexFromJournal();
+
+        bool tryBecomeOwner();
+
+        /**
+         * Helpers that expect mIndexMutex to be held
+         */
+        void addIndexEntry(const LLUUID& id, uintmax_t size, std::time_t access_time, U64 digest = 0);
+        void removeIndexEntry(const LLUUID& id);
+        void appendJournalRecord(U8 op, const LLUUID& id, uintmax_t size, std::time_t access_time, U64 digest = 0);
+        void writeJournalBuffer();
+        void writeJournalBufferIfFull();
+        bool replayJournal(); // from mJournalReadOffset, expects the journal lock to be held
+        size_t getJournalRecordCount() const;
+
+        struct IndexEntry
+        {
+            LLUUID      mID;
+            uintmax_t   mSize;
+            std::time_t mAccessTime;
+            U64         mDigest{ 0 };
+        };
+        typedef std::list<IndexEntry> index_lru_t;
+        typedef std::unordered_map<LLUUID, index_lru_t::iterator> index_map_t;
+
+        /**
+         * Protects everything below. The index is touched by every thread
+         * that uses LLFileSystem as well as by the purge thread.
+         */
+        LLMutex mIndexMutex;
+
+        /**
+         * Least recently used entries at the front, most recent at the back
+         */
+        index_lru_t mIndexLRU;
+        index_map_t mIndexMap;
+        uintmax_t mIndexedSize{ 0 };
+
+        /**
+         * Reads are far more frequent than writes, so access records are
+         * collected here and only written to the journal by flushIndexJournal()
+         */
+        std::unordered_set<LLUUID> mPendingAccess;
+
+        /**
+         * Entries scrub() has yet to check in the current pass
+         */
+        std::vector<LLUUID> mScrubQueue;
+
+        /**
+         * Records waiting to be appended to the journal by writeJournalBuffer(),
+         * in batches rather than one file write per cache write
+         */
+        std::vector<U8> mJournalBuffer;
+
+        /**
+         * How far into the journal we have replayed, 0 if it needs rewriting
+         */
+        U64 mJournalReadOffset{ 0 };
+
+        /**
+         * Held for as long as we own the cache folder
+         */
+        LLFileLock mOwnerLock;
+        std::atomic<bool> mIsOwner{ false };
+
+        std::unique_ptr<LLPackedCache> mPackedCache;
+
     private:
         /**
          * The maximum size of the cache in bytes. After purge is called, the
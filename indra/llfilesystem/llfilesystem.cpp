@@ -33,8 +33,10 @@
 #include "llfilesystem.h"
 #include "llfasttimer.h"
 #include "lldiskcache.h"
+#include "hbxxh.h"
 
 #include "boost/filesystem.hpp"
+#include "threadpool.h"
 
 constexpr S32 LLFileSystem::READ        = 0x00000001;
 constexpr S32 LLFileSystem::WRITE       = 0x00000002;
@@ -43,6 +45,77 @@ constexpr S32 LLFileSystem::APPEND      = 0x00000006;  // 0x00000004 & LLFileSys
 
 static LLTrace::BlockTimerStatHandle FTM_VFILE_WAIT("VFile Wait");
 
+// <FS> Cache index
+// LLFileSystem is also used by tools and tests that never set up the disk
+// cache, so only keep the index up to date when there is one
+static LLDiskCache* get_disk_cache_index()
+{
+    return LLDiskCache::instanceExists() ? LLDiskCache::getInstance() : nullptr;
+}
+// </FS>
+
+// <FS> Pack-file storage for small assets
+static LLPackedCache* get_packed_cache()
+{
+    LLDiskCache* cache = get_disk_cache_index();
+    return cache ? cache->getPackedCache() : nullptr;
+}
+
+// Write a whole asset to its own cache file. The data goes to a temporary
+// file first, which is then renamed over the asset, so that other threads
+// and other viewers sharing the cache never see a half written file.
+static bool write_loose_file(const std::string& filename, const U8* buffer, S32 bytes)
+{
+    const std::string temp_filename = filename + "." + LLUUID::generateNewID().asString() + ".tmp";
+    LLFILE* ofs = LLFile::fopen(temp_filename, "wb");
+    if (ofs)
+    {
+        S32 bytes_written = static_cast<S32>(fwrite(buffer, 1, bytes, ofs));
+        bool success = (fclose(ofs) == 0) && (bytes_written == bytes);
+        if (success && LLFile::replace(temp_filename, filename) == 0)
+        {
+            return true;
+        }
+        LLFile::remove(temp_filename, ENOENT);
+        if (!success)
+        {
+            return false;
+        }
+    }
+
+    // Windows refuses to rename over a file someone has open: write in place
+    ofs = LLFile::fopen(filename, "wb");
+    if (!ofs)
+    {
+        return false;
+    }
+    S32 bytes_written = static_cast<S32>(fwrite(buffer, 1, bytes, ofs));
+    fclose(ofs);
+    return bytes_written == bytes;
+}
+
+// The whole of an existing cache file, or nothing if there is none
+static void read_loose_file(const std::string& filename, std::vector<U8>& data)
+{
+    data.clear();
+    LLFILE* ifs = LLFile::fopen(filename, "rb");
+    if (!ifs)
+    {
+        return;
+    }
+    if (fseek(ifs, 0, SEEK_END) == 0)
+    {
+        const long size = ftell(ifs);
+        if (size > 0 && fseek(ifs, 0, SEEK_SET) == 0)
+        {
+            data.resize(size);
+            data.resize(fread(data.data(), 1, size, ifs));
+        }
+    }
+    fclose(ifs);
+}
+// </FS>
+
 LLFileSystem::LLFileSystem(const LLUUID& file_id, const LLAssetType::EType file_type, S32 mode)
 {
     mFileType = file_type;
@@ -50,6 +123,8 @@ LLFileSystem::LLFileSystem(const LLUUID& file_id, const LLAssetType::EType file_
     mPosition = 0;
     mBytesRead = 0;
     mMode = mode;
+    mStaged = false; // <FS/> Pack-file storage
+    mStagedLoose = false; // <FS/> Pack-file storage
 
     // This block of code was originally called in the read() method but after comments here:
     // https://bitbucket.org/lindenlab/viewer/commits/e28c1b46e9944f0215a13cab8ee7dded88d7fc90#comment-10537114
@@ -63,20 +138,47 @@ LLFileSystem::LLFileSystem(const LLUUID& file_id, const LLAssetType::EType file_
         // even though we are reading and not writing because this is the
         // way the cache works - it relies on a valid "last accessed time" for
         // each file so it knows how to remove the oldest, unused files
+        // <FS> Pack-file storage: packed assets have no file time to update
+        LLPackedCache* packed_cache = get_packed_cache();
+        if (packed_cache && packed_cache->exists(mFileID, mFileType))
+        {
+            get_disk_cache_index()->indexFileAccess(mFileID);
+        }
+        else
+        // </FS>
+        {
         bool exists = gDirUtilp->fileExists(filename);
         if (exists)
         {
             updateFileAccessTime(filename);
         }
+        }
     }
 }
 
+// <FS> Pack-file storage
+LLFileSystem::~LLFileSystem()
+{
+    close();
+}
+// </FS>
+
 // static
 bool LLFileSystem::getExists(const LLUUID& file_id, const LLAssetType::EType file_type)
 {
     LL_PROFILE_ZONE_SCOPED;
     const std::string filename = LLDiskCache::metaDataToFilepath(file_id, file_type);
 
+    // <FS> Pack-file storage
+    if (LLPackedCache* packed_cache = get_packed_cache())
+    {
+        if (packed_cache->getSize(file_id, file_type) > 0)
+        {
+            return true;
+        }
+    }
+    // </FS>
+
     // <FS:Ansariel> IO-streams replacement
     //llifstream file(filename, std::ios::binary);
     //if (file.is_open())
@@ -100,8 +202,24 @@ bool LLFileSystem::removeFile(const LLUUID& file_id, const LLAssetType::EType fi
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
     const std::string filename = LLDiskCache::metaDataToFilepath(file_id, file_type);
 
+    // <FS> Pack-file storage
+    LLPackedCache* packed_cache = get_packed_cache();
+    if (packed_cache && packed_cache->remove(file_id, file_type))
+    {
+        // Normally there is no loose file as well, don't warn about it
+        suppress_error = ENOENT;
+    }
+    // </FS>
+
     LLFile::remove(filename.c_str(), suppress_error);
 
+    // <FS> Cache index
+    if (LLDiskCache* cache = get_disk_cache_index())
+    {
+        cache->indexFileRemove(file_id);
+    }
+    // </FS>
+
     return true;
 }
 
@@ -116,6 +234,18 @@ bool LLFileSystem::renameFile(const LLUUID& old_file_id, const LLAssetType::ETyp
     // Rename needs the new file to not exist.
     LLFileSystem::removeFile(new_file_id, new_file_type, ENOENT);
 
+    // <FS> Pack-file storage
+    LLPackedCache* packed_cache = get_packed_cache();
+    if (packed_cache && packed_cache->rename(old_file_id, old_file_type, new_file_id, new_file_type))
+    {
+        if (LLDiskCache* cache = get_disk_cache_index())
+        {
+            cache->indexFileRename(old_file_id, new_file_id);
+        }
+        return true;
+    }
+    // </FS>
+
     if (LLFile::rename(old_filename, new_filename) != 0)
     {
         // We would like to return false here indicating the operation
@@ -124,6 +254,27 @@ bool LLFileSystem::renameFile(const LLUUID& old_file_id, const LLAssetType::ETyp
         //return false;
         LL_WARNS() << "Failed to rename " << old_file_id << " to " << new_file_id << " reason: " << strerror(errno) << LL_ENDL;
     }
+    // <FS> Cache index
+    else if (LLDiskCache* cache = get_disk_cache_index())
+    {
+        cache->indexFileRename(old_file_id, new_file_id);
+
+        // Cache integrity checks: an asset appended in pieces under a
+        // temporary id has no digest yet, and is complete once it gets
+        // its asset id. Only read it back if that is the case.
+        llstat file_stat;
+        if (LLFile::stat(new_filename, &file_stat) == 0 && file_stat.st_size > 0
+            && !cache->getIndexedDigest(new_file_id, file_stat.st_size))
+        {
+            std::vector<U8> data;
+            read_loose_file(new_filename, data);
+            if (!data.empty())
+            {
+                cache->indexFileWrite(new_file_id, data.size(), HBXXH64::digest(data.data(), data.size()));
+            }
+        }
+    }
+    // </FS>
 
     return true;
 }
@@ -135,6 +286,19 @@ S32 LLFileSystem::getFileSize(const LLUUID& file_id, const LLAssetType::EType fi
     const std::string filename = LLDiskCache::metaDataToFilepath(file_id, file_type);
 
     S32 file_size = 0;
+
+    // <FS> Pack-file storage
+    if (LLPackedCache* packed_cache = get_packed_cache())
+    {
+        file_size = packed_cache->getSize(file_id, file_type);
+        if (file_size >= 0)
+        {
+            return file_size;
+        }
+        file_size = 0;
+    }
+    // </FS>
+
     // <FS:Ansariel> IO-streams replacement
     //llifstream file(filename, std::ios::binary);
     //if (file.is_open())
@@ -152,6 +316,31 @@ S32 LLFileSystem::getFileSize(const LLUUID& file_id, const LLAssetType::EType fi
     return file_size;
 }
 
+// <FS> Cache integrity checks
+// A read of the whole file is checked against the digest recorded when it
+// was written. A corrupted file is evicted, so that the asset is fetched
+// again instead of failing to decode further down the line.
+bool LLFileSystem::verifyRead(const U8* buffer)
+{
+    if (mPosition != mBytesRead || !mBytesRead)
+    {
+        return true; // partial read, left to the scrubber
+    }
+    LLDiskCache* cache = get_disk_cache_index();
+    const U64 digest = cache ? cache->getIndexedDigest(mFileID, mBytesRead) : 0;
+    if (!digest || HBXXH64::digest(buffer, mBytesRead) == digest)
+    {
+        return true;
+    }
+
+    LL_WARNS() << "Cached asset " << mFileID << " failed its integrity check, evicting it" << LL_ENDL;
+    removeFile(mFileID, mFileType, ENOENT);
+    mBytesRead = 0;
+    mPosition = 0;
+    return false;
+}
+// </FS>
+
 bool LLFileSystem::read(U8* buffer, S32 bytes)
 {
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
@@ -159,6 +348,30 @@ bool LLFileSystem::read(U8* buffer, S32 bytes)
 
     const std::string filename = LLDiskCache::metaDataToFilepath(mFileID, mFileType);
 
+    // <FS> Pack-file storage
+    if (mStaged)
+    {
+        mBytesRead = llclamp((S32)mStagedData.size() - mPosition, 0, bytes);
+        if (mBytesRead)
+        {
+            memcpy(buffer, mStagedData.data() + mPosition, mBytesRead);
+        }
+        mPosition += mBytesRead;
+        return mBytesRead > 0;
+    }
+
+    if (LLPackedCache* packed_cache = get_packed_cache())
+    {
+        S32 bytes_read = packed_cache->read(mFileID, mFileType, mPosition, buffer, bytes);
+        if (bytes_read >= 0)
+        {
+            mBytesRead = bytes_read;
+            mPosition += mBytesRead;
+            return mBytesRead > 0 && verifyRead(buffer); // <FS/> Cache integrity checks
+        }
+    }
+    // </FS>
+
     // <FS:Ansariel> IO-streams replacement
     //llifstream file(filename, std::ios::binary);
     //if (file.is_open())
@@ -197,7 +410,7 @@ bool LLFileSystem::read(U8* buffer, S32 bytes)
             // but that will break avatar rezzing...
             if (mBytesRead)
             {
-                success = true;
+                success = verifyRead(buffer); // <FS/> Cache integrity checks
             }
         }
     }
@@ -224,6 +437,83 @@ bool LLFileSystem::write(const U8* buffer, S32 bytes)
     const std::string filename = LLDiskCache::metaDataToFilepath(mFileID, mFileType);
 
     bool success = false;
+    S32 file_size = 0; // <FS/> Cache index: set when writing inside the file
+
+    // <FS> Pack-file storage
+    // Small assets are kept in the pack as a whole. APPEND and READ_WRITE
+    // writes are gathered in memory and close() stores the entry once,
+    // instead of appending it to the pack again for every write. An APPEND
+    // to an entry that is already packed is an asset arriving in pieces over
+    // several opens (xfers, transfers): it moves to its own file, which the
+    // following pieces are appended to in place. Only one viewer appends to
+    // a pack shared with others, the rest write their own files.
+    if (mStaged)
+    {
+        stageWrite(buffer, bytes);
+        return true;
+    }
+
+    LLPackedCache* packed_cache = get_packed_cache();
+    if (packed_cache && !packed_cache->isReadOnly())
+    {
+        const bool in_pack = packed_cache->exists(mFileID, mFileType);
+        if (in_pack || !gDirUtilp->fileExists(filename))
+        {
+            if (mMode != WRITE)
+            {
+                if (in_pack)
+                {
+                    packed_cache->readAll(mFileID, mFileType, mStagedData);
+                }
+                mStaged = true;
+                mStagedLoose = in_pack && mMode == APPEND;
+                stageWrite(buffer, bytes);
+                return true;
+            }
+
+            if (bytes <= (S32)packed_cache->getMaxEntrySize())
+            {
+                success = packed_cache->write(mFileID, mFileType, buffer, bytes);
+            }
+            else
+            {
+                success = write_loose_file(filename, buffer, bytes);
+                if (success && in_pack)
+                {
+                    packed_cache->remove(mFileID, mFileType);
+                }
+            }
+
+            if (success)
+            {
+                mPosition = bytes;
+                get_disk_cache_index()->indexFileWrite(mFileID, bytes, HBXXH64::digest(buffer, bytes));
+            }
+            return success;
+        }
+    }
+
+    // Write aside: a READ_WRITE or APPEND write that creates the file is
+    // gathered the same way and close() writes the file as a whole, so that
+    // other threads and viewers never see a mesh without its padding or an
+    // asset without its tail. Only what this instance writes is gathered,
+    // plus the entry it replaces if that is in a pack another viewer owns
+    // (packed entries are small). Writes into an existing file, mesh LODs
+    // and skin info filling in their ranges or an asset arriving in pieces
+    // under a temporary id, go straight to the file and cost only what they
+    // write.
+    if ((mMode == READ_WRITE || mMode == APPEND) && !gDirUtilp->fileExists(filename))
+    {
+        if (mMode == READ_WRITE && packed_cache)
+        {
+            packed_cache->readAll(mFileID, mFileType, mStagedData);
+        }
+        mStaged = true;
+        mStagedLoose = true;
+        stageWrite(buffer, bytes);
+        return true;
+    }
+    // </FS>
 
     // <FS:Ansariel> IO-streams replacement
     //if (mMode == APPEND)
@@ -293,37 +583,125 @@ bool LLFileSystem::write(const U8* buffer, S32 bytes)
             {
                 S32 bytes_written = static_cast<S32>(fwrite(buffer, 1, bytes, ofs));
                 mPosition = ftell(ofs);
-                fclose(ofs);
+                // <FS> Cache index: the size of the whole file
+                if (fseek(ofs, 0, SEEK_END) == 0)
+                {
+                    file_size = ftell(ofs);
+                }
+                // </FS>
                 success = (bytes_written == bytes);
             }
+            fclose(ofs); // <FS/> Write aside: was only closed when the seek succeeded
         }
-        else
+        // <FS> Write aside: a file that doesn't exist is gathered above
+        //else
+        //{
+        //    ofs = LLFile::fopen(filename, "wb");
+        //    if (ofs)
+        //    {
+        //        S32 bytes_written = static_cast<S32>(fwrite(buffer, 1, bytes, ofs));
+        //        mPosition = ftell(ofs);
+        //        fclose(ofs);
+        //        success = (bytes_written == bytes);
+        //    }
+        //}
+        // </FS>
+    }
+    else
+    {
+        // <FS> Replace the file as a whole
+        //LLFILE* ofs = LLFile::fopen(filename, "wb");
+        //if (ofs)
+        //{
+        //    S32 bytes_written = static_cast<S32>(fwrite(buffer, 1, bytes, ofs));
+        //    mPosition = ftell(ofs);
+        //    fclose(ofs);
+        //    success = (bytes_written == bytes);
+        //}
+        success = write_loose_file(filename, buffer, bytes);
+        if (success)
         {
-            ofs = LLFile::fopen(filename, "wb");
-            if (ofs)
-            {
-                S32 bytes_written = static_cast<S32>(fwrite(buffer, 1, bytes, ofs));
-                mPosition = ftell(ofs);
-                fclose(ofs);
-                success = (bytes_written == bytes);
-            }
+            mPosition = bytes;
+        }
+        // </FS>
+    }
+    // </FS:Ansariel>
+
+    // <FS> Cache index
+    if (success)
+    {
+        if (LLDiskCache* cache = get_disk_cache_index())
+        {
+            // Only a whole file write knows the digest of the file. A file
+            // appended in pieces gets one when renameFile() completes it, and
+            // a file updated in place drops the one it had rather than hash
+            // the whole file again for every range written.
+            U64 digest = (mMode == WRITE) ? HBXXH64::digest(buffer, bytes) : 0;
+            cache->indexFileWrite(mFileID, llmax(mPosition, file_size), digest);
         }
     }
+    // </FS>
+
+    return success;
+}
+
+// <FS> Pack-file storage
+void LLFileSystem::stageWrite(const U8* buffer, S32 bytes)
+{
+    const S32 offset = (mMode == APPEND) ? (S32)mStagedData.size() : mPosition;
+    if ((S32)mStagedData.size() < offset + bytes)
+    {
+        mStagedData.resize(offset + bytes);
+    }
+    if (bytes > 0)
+    {
+        memcpy(mStagedData.data() + offset, buffer, bytes);
+    }
+    mPosition = offset + bytes;
+}
+
+bool LLFileSystem::close()
+{
+    if (!mStaged)
+    {
+        return true;
+    }
+    mStaged = false;
+
+    const std::string filename = LLDiskCache::metaDataToFilepath(mFileID, mFileType);
+    const S32 size = (S32)mStagedData.size();
+
+    bool success = false;
+    LLPackedCache* packed_cache = get_packed_cache();
+    if (packed_cache && !packed_cache->isReadOnly() && !mStagedLoose && size <= (S32)packed_cache->getMaxEntrySize())
+    {
+        success = packed_cache->write(mFileID, mFileType, mStagedData.data(), size);
+    }
     else
     {
-        LLFILE* ofs = LLFile::fopen(filename, "wb");
-        if (ofs)
+        success = write_loose_file(filename, mStagedData.data(), size);
+        if (success && packed_cache)
         {
-            S32 bytes_written = static_cast<S32>(fwrite(buffer, 1, bytes, ofs));
-            mPosition = ftell(ofs);
-            fclose(ofs);
-            success = (bytes_written == bytes);
+            packed_cache->remove(mFileID, mFileType);
         }
     }
-    // </FS:Ansariel>
 
+    if (success)
+    {
+        if (LLDiskCache* cache = get_disk_cache_index())
+        {
+            cache->indexFileWrite(mFileID, size, HBXXH64::digest(mStagedData.data(), size));
+        }
+    }
+    else
+    {
+        LL_WARNS() << "Failed to store cached asset " << mFileID << LL_ENDL;
+    }
+
+    std::vector<U8>().swap(mStagedData);
     return success;
 }
+// </FS>
 
 bool LLFileSystem::seek(S32 offset, S32 origin)
 {
@@ -365,6 +743,12 @@ S32 LLFileSystem::tell() const
 S32 LLFileSystem::getSize() const
 {
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
+    // <FS> Pack-file storage
+    if (mStaged)
+    {
+        return (S32)mStagedData.size();
+    }
+    // </FS>
     return LLFileSystem::getFileSize(mFileID, mFileType);
 }
 
@@ -378,6 +762,7 @@ S32 LLFileSystem::getMaxSize() const
 bool LLFileSystem::rename(const LLUUID& new_id, const LLAssetType::EType new_type)
 {
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
+    close(); // <FS/> Pack-file storage
     LLFileSystem::renameFile(mFileID, mFileType, new_id, new_type);
 
     mFileID = new_id;
@@ -386,9 +771,13 @@ bool LLFileSystem::rename(const LLUUID& new_id, const LLAssetType::EType new_typ
     return true;
 }
 
-bool LLFileSystem::remove() const
+bool LLFileSystem::remove()
 {
     LL_PROFILE_ZONE_COLOR(tracy::Color::Gold); // <FS:Beq> measure cache performance
+    // <FS> Pack-file storage: nothing left to store
+    mStaged = false;
+    std::vector<U8>().swap(mStagedData);
+    // </FS>
     LLFileSystem::removeFile(mFileID, mFileType);
     return true;
 }
@@ -406,6 +795,15 @@ void LLFileSystem::updateFileAccessTime(const std::string& file_path)
      */
     constexpr std::time_t time_threshold = 1 * 60 * 60;
 
+    // <FS> Cache index
+    // The index keeps the exact access order in memory; the file time below
+    // is only needed if the index ever has to be rebuilt from a directory scan
+    if (LLDiskCache* cache = get_disk_cache_index())
+    {
+        cache->indexFileAccess(mFileID);
+    }
+    // </FS>
+
     // current time
     const std::time_t cur_time = std::time(nullptr);
 
@@ -453,3 +851,144 @@ void LLFileSystem::updateFileAccessTime(const std::string& file_path)
         LL_WARNS() << "Failed to update last write time for cache file " << file_path << ": " << ec.message() << LL_ENDL;
     }
 }
+
+// <FS> Batched asynchronous reads
+// Batches may be posted from any thread while the readers drain the queue,
+// and nothing depends on the order between batches, so posting doesn't
+// take a lock the readers need as well.
+static std::unique_ptr<LL::ConcurrentThreadPool> sReadThreadPool;
+
+//static
+void LLFileSystem::initReadThreadPool(size_t threads)
+{
+    if (!sReadThreadPool)
+    {
+        sReadThreadPool = std::make_unique<LL::ConcurrentThreadPool>("AssetRead", threads);
+        sReadThreadPool->start();
+    }
+}
+
+//static
+void LLFileSystem::cleanupReadThreadPool()
+{
+    if (sReadThreadPool)
+    {
+        // close() joins the worker threads, so no read is in flight after this
+        sReadThreadPool->close();
+        sReadThreadPool.reset();
+    }
+}
+
+static void read_one(LLFileSystem::ReadRequest& request)
+{
+    LL_PROFILE_ZONE_SCOPED;
+    LLFileSystem file(request.mFileID, request.mFileType);
+    request.mFileSize = file.getSize();
+    if (request.mFileSize <= 0 || request.mOffset < 0 || request.mOffset >= request.mFileSize)
+    {
+        return;
+    }
+
+    S32 length = request.mFileSize - request.mOffset;
+    if (request.mLength >= 0)
+    {
+        length = llmin(length, request.mLength);
+    }
+    request.mData.resize(length);
+    if (length && file.seek(request.mOffset, 0) && file.read(request.mData.data(), length))
+    {
+        request.mData.resize(file.getLastBytesRead());
+        request.mSuccess = true;
+    }
+    else
+    {
+        request.mData.clear();
+    }
+}
+
+namespace
+{
+    // Shared between the pool tasks of one readBatch() call; the last task
+    // to finish delivers the results
+    struct ReadBatchState
+    {
+        LLFileSystem::read_batch_t                  mRequests;
+        LLFileSystem::read_callback_t               mCallback;
+        std::weak_ptr<LL::WorkQueueBase>            mReplyQueue;
+        std::atomic<size_t>                         mPending{ 0 };
+
+        void finish()
+        {
+            auto reply_queue = mReplyQueue.lock();
+            if (reply_queue)
+            {
+                // Hand the results over rather than copying them
+                auto requests = std::make_shared<LLFileSystem::read_batch_t>(std::move(mRequests));
+                if (reply_queue->post([callback = std::move(mCallback), requests]() { callback(std::move(*requests)); }))
+                {
+                    return;
+                }
+                mRequests = std::move(*requests);
+            }
+            // no reply queue, or it closed on us: deliver on this thread
+            mCallback(std::move(mRequests));
+        }
+    };
+}
+
+//static
+void LLFileSystem::readBatch(read_batch_t requests, read_callback_t callback, std::weak_ptr<LL::WorkQueueBase> reply_queue)
+{
+    LL_PROFILE_ZONE_SCOPED;
+    auto state = std::make_shared<ReadBatchState>();
+    state->mRequests = std::move(requests);
+    state->mCallback = std::move(callback);
+    state->mReplyQueue = reply_queue;
+
+    const size_t count = state->mRequests.size();
+    const size_t width = sReadThreadPool ? sReadThreadPool->getWidth() : 0;
+    if (!count || !width || sReadThreadPool->getQueue().isClosed())
+    {
+        for (ReadRequest& request : state->mRequests)
+        {
+            read_one(request);
+        }
+        state->finish();
+        return;
+    }
+
+    // One task per worker, each reading a contiguous slice of the batch
+    const size_t tasks = llmin(count, width);
+    const size_t slice = (count + tasks - 1) / tasks;
+    state->mPending = (count + slice - 1) / slice;
+    for (size_t begin = 0; begin < count; begin += slice)
+    {
+        const size_t end = llmin(begin + slice, count);
+        auto task = [state, begin, end]()
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                read_one(state->mRequests[i]);
+            }
+            if (--state->mPending == 0)
+            {
+                state->finish();
+            }
+        };
+        if (!sReadThreadPool->getQueue().post(task))
+        {
+            // queue closed under us
+            task();
+        }
+    }
+}
+
+//static
+std::future<LLFileSystem::read_batch_t> LLFileSystem::readBatch(read_batch_t requests)
+{
+    auto promise = std::make_shared<std::promise<read_batch_t>>();
+    std::future<read_batch_t> result = promise->get_future();
+    readBatch(std::move(requests), [promise](read_batch_t&& results) { promise->set_value(std::move(results)); });
+    return result;
+}
+// </FS>
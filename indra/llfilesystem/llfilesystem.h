@@ -34,24 +34,43 @@
 #include "llassettype.h"
 #include "lldiskcache.h"
 
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace LL
+{
+    class WorkQueueBase;
+}
+
 class LLFileSystem
 {
     public:
         LLFileSystem(const LLUUID& file_id, const LLAssetType::EType file_type, S32 mode = LLFileSystem::READ);
-        ~LLFileSystem() = default;
+        ~LLFileSystem(); // <FS/> Pack-file storage: stores what write() gathered
 
         bool read(U8* buffer, S32 bytes);
         S32  getLastBytesRead() const;
         bool eof() const;
 
         bool write(const U8* buffer, S32 bytes);
+
+        // <FS> Pack-file storage
+        /**
+         * Store what APPEND and READ_WRITE writes have gathered so far. The
+         * destructor calls this; call it first when the asset is handed on
+         * (to an upload, say) while this instance is still alive.
+         */
+        bool close();
+        // </FS>
         bool seek(S32 offset, S32 origin = -1);
         S32  tell() const;
 
         S32 getSize() const;
         S32 getMaxSize() const;
         bool rename(const LLUUID& new_id, const LLAssetType::EType new_type);
-        bool remove() const;
+        bool remove(); // <FS/> Pack-file storage: was const, drops what write() gathered
 
         /**
          * Update the "last write time" of a file to "now". This must be called whenever a
@@ -66,6 +85,51 @@ class LLFileSystem
                                const LLUUID& new_file_id, const LLAssetType::EType new_file_type);
         static S32 getFileSize(const LLUUID& file_id, const LLAssetType::EType file_type);
 
+        // <FS> Batched asynchronous reads
+        /**
+         * One entry of a batched read. The caller fills in the file, offset
+         * and length (a negative length reads to the end of the file); the
+         * rest is filled in when the batch completes.
+         */
+        struct ReadRequest
+        {
+            LLUUID              mFileID;
+            LLAssetType::EType  mFileType{ LLAssetType::AT_NONE };
+            S32                 mOffset{ 0 };
+            S32                 mLength{ -1 };
+
+            bool                mSuccess{ false };
+            S32                 mFileSize{ 0 };     // 0 if the file is not cached
+            std::vector<U8>     mData;
+        };
+        typedef std::vector<ReadRequest> read_batch_t;
+        typedef std::function<void(read_batch_t&&)> read_callback_t;
+
+        /**
+         * Read a whole batch of cache files at once. The requests are spread
+         * over the "AssetRead" thread pool; callback is called once with
+         * every request filled in. If reply_queue is given the callback is
+         * posted there, otherwise it runs on whichever pool thread finished
+         * last. Without a pool (tools, tests, shutdown) the batch is read
+         * synchronously on the calling thread.
+         */
+        static void readBatch(read_batch_t requests, read_callback_t callback,
+                              std::weak_ptr<LL::WorkQueueBase> reply_queue = {});
+
+        /**
+         * As above, but hand back a future for callers that would rather
+         * block on the whole batch once than on each file in turn.
+         */
+        static std::future<read_batch_t> readBatch(read_batch_t requests);
+
+        /**
+         * Start and stop the thread pool used by readBatch(). The pool width
+         * can be overridden with the "AssetRead" key of ThreadPoolSizes.
+         */
+        static void initReadThreadPool(size_t threads);
+        static void cleanupReadThreadPool();
+        // </FS>
+
     public:
         static const S32 READ;
         static const S32 WRITE;
@@ -73,11 +137,25 @@ class LLFileSystem
         static const S32 APPEND;
 
     protected:
+        // <FS> Cache integrity checks: false if the read just completed
+        // covered the whole file and it did not match its recorded digest
+        bool verifyRead(const U8* buffer);
+
+        // <FS> Pack-file storage: apply a write to mStagedData
+        void stageWrite(const U8* buffer, S32 bytes);
+
         LLAssetType::EType mFileType;
         LLUUID  mFileID;
         S32     mPosition;
         S32     mMode;
         S32     mBytesRead;
+
+        // <FS> Pack-file storage: the whole asset as partial writes left it,
+        // until close() stores it
+        std::vector<U8> mStagedData;
+        bool    mStaged;
+        bool    mStagedLoose;   // store it in its own file, not the pack
+        // </FS>
 };
 
 #endif  // LL_FILESYSTEM_H
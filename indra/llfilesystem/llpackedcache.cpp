@@ -0,0 +1,815 @@
+/**
+ * @file llpackedcache.cpp
+ * @brief Pack-file storage for small cached assets.
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llpackedcache.h"
+
+#include <algorithm>
+#include <boost/filesystem.hpp>
+
+namespace
+{
+    /**
+     * Segment files share the disk cache filename prefix so that clearing the
+     * disk cache takes them along too.
+     */
+    const std::string SEGMENT_FILENAME_PREFIX("sl_cache_pack_");
+    const std::string SEGMENT_FILENAME_SUFFIX(".seg");
+
+    // Record header: { U32 magic, U32 flags, U8 id[16], S32 type, U32 size }
+    constexpr U32 RECORD_MAGIC = 0x4b505346; // "FSPK"
+    constexpr size_t RECORD_HEADER_SIZE = sizeof(U32) * 2 + UUID_BYTES + sizeof(S32) + sizeof(U32);
+    constexpr U32 RECORD_FLAG_TOMBSTONE = 0x1;
+    // Written when a compacted segment could not be deleted; the payload is
+    // the segment number. Anything still in that segment is dead.
+    constexpr U32 RECORD_FLAG_RETIRED = 0x2;
+
+    struct RecordHeader
+    {
+        U32                 mFlags{ 0 };
+        LLUUID              mID;
+        LLAssetType::EType  mType{ LLAssetType::AT_NONE };
+        U32                 mSize{ 0 };
+    };
+
+    void pack_header(U8* out, const RecordHeader& header)
+    {
+        const S32 type = (S32)header.mType;
+        memcpy(out, &RECORD_MAGIC, sizeof(U32));
+        memcpy(out + 4, &header.mFlags, sizeof(U32));
+        memcpy(out + 8, header.mID.mData, UUID_BYTES);
+        memcpy(out + 8 + UUID_BYTES, &type, sizeof(S32));
+        memcpy(out + 12 + UUID_BYTES, &header.mSize, sizeof(U32));
+    }
+
+    bool unpack_header(const U8* in, RecordHeader& header)
+    {
+        U32 magic = 0;
+        S32 type = 0;
+        memcpy(&magic, in, sizeof(U32));
+        if (magic != RECORD_MAGIC)
+        {
+            return false;
+        }
+        memcpy(&header.mFlags, in + 4, sizeof(U32));
+        memcpy(header.mID.mData, in + 8, UUID_BYTES);
+        memcpy(&type, in + 8 + UUID_BYTES, sizeof(S32));
+        memcpy(&header.mSize, in + 12 + UUID_BYTES, sizeof(U32));
+        header.mType = (LLAssetType::EType)type;
+        return true;
+    }
+
+#if LL_WINDOWS
+    const char* DIR_DELIMITER = "\\";
+#else
+    const char* DIR_DELIMITER = "/";
+#endif
+
+#if LL_WINDOWS
+    boost::filesystem::path to_fs_path(const std::string& path) { return boost::filesystem::path(utf8str_to_utf16str(path)); }
+#else
+    boost::filesystem::path to_fs_path(const std::string& path) { return boost::filesystem::path(path); }
+#endif
+}
+
+LLPackedCache::LLPackedCache(const std::string& dir, U32 max_entry_size, U64 segment_size, bool read_only) :
+    mDir(dir),
+    mMaxEntrySize(max_entry_size),
+    mSegmentSize(segment_size),
+    mReadOnly(read_only)
+{
+    LLFile::mkdir(mDir);
+
+    // Replay the segments oldest first whatever order the directory
+    // listing is in
+    const std::vector<U32> numbers = listSegments();
+
+    LLMutexLock lock(&mMutex);
+
+    bool last_complete = false;
+    for (U32 number : numbers)
+    {
+        if (mRetiredSegments.count(number))
+        {
+            continue;
+        }
+        Segment& segment = mSegments[number];
+        segment.mPath = segmentPath(number);
+        last_complete = loadSegment(number, segment);
+        if (!last_complete)
+        {
+            LL_WARNS("LLDiskCache") << "Packed cache segment " << segment.mPath
+                                    << " has unreadable bytes at the end, ignoring them" << LL_ENDL;
+        }
+        mActiveSegment = number;
+    }
+
+    if (!mReadOnly)
+    {
+        // Keep appending to the newest segment unless it is full or ends in a
+        // torn record (after a crash), in which case anything we append would
+        // be unreachable on the next load
+        if (mActiveSegment && last_complete && mSegments[mActiveSegment].mSize < mSegmentSize)
+        {
+            mActiveFile = LLFile::fopen(mSegments[mActiveSegment].mPath, "ab");
+        }
+        if (!mActiveFile)
+        {
+            startNewSegment();
+        }
+        removeRetiredSegments();
+    }
+
+    LL_INFOS("LLDiskCache") << "Packed cache has " << mIndex.size() << " entries (" << mLiveBytes
+                            << " bytes) in " << mSegments.size() << " segments"
+                            << (mReadOnly ? ", read-only" : "") << LL_ENDL;
+}
+
+LLPackedCache::~LLPackedCache()
+{
+    LLMutexLock lock(&mMutex);
+    if (mActiveFile)
+    {
+        LLFile::close(mActiveFile);
+        mActiveFile = nullptr;
+    }
+    mSegments.clear();
+}
+
+std::string LLPackedCache::segmentPath(U32 number) const
+{
+    return llformat("%s%s%s%08u%s", mDir.c_str(), DIR_DELIMITER, SEGMENT_FILENAME_PREFIX.c_str(), number, SEGMENT_FILENAME_SUFFIX.c_str());
+}
+
+std::vector<U32> LLPackedCache::listSegments() const
+{
+    std::vector<U32> numbers;
+    boost::system::error_code ec;
+    boost::filesystem::directory_iterator iter(to_fs_path(mDir), ec);
+    while (iter != boost::filesystem::directory_iterator() && !ec.failed())
+    {
+        const std::string name = (*iter).path().filename().string();
+        if (name.compare(0, SEGMENT_FILENAME_PREFIX.size(), SEGMENT_FILENAME_PREFIX) == 0
+            && name.size() > SEGMENT_FILENAME_PREFIX.size() + SEGMENT_FILENAME_SUFFIX.size())
+        {
+            U32 number = 0;
+            if (sscanf(name.c_str() + SEGMENT_FILENAME_PREFIX.size(), "%u", &number) == 1 && number)
+            {
+                numbers.push_back(number);
+            }
+        }
+        iter.increment(ec);
+    }
+    std::sort(numbers.begin(), numbers.end());
+    return numbers;
+}
+
+bool LLPackedCache::loadSegment(U32 number, Segment& segment)
+{
+    std::shared_ptr<LLMappedFile> mapping = std::make_shared<LLMappedFile>();
+    if (!mapping->open(segment.mPath))
+    {
+        // Empty (freshly started) segment
+        return true;
+    }
+    segment.mMapping = mapping;
+
+    llstat segment_stat;
+    if (LLFile::stat(segment.mPath, &segment_stat) == 0)
+    {
+        segment.mWriteTime = segment_stat.st_mtime;
+    }
+
+    const U8* data = mapping->data();
+    const U64 size = mapping->size();
+    U64 offset = segment.mSize;
+    while (offset + RECORD_HEADER_SIZE <= size)
+    {
+        RecordHeader header;
+        if (!unpack_header(data + offset, header) || offset + RECORD_HEADER_SIZE + header.mSize > size)
+        {
+            break;
+        }
+
+        if (header.mFlags & RECORD_FLAG_RETIRED)
+        {
+            U32 retired = 0;
+            if (header.mSize == sizeof(U32))
+            {
+                memcpy(&retired, data + offset + RECORD_HEADER_SIZE, sizeof(U32));
+            }
+            if (retired && retired != number)
+            {
+                retireSegment(retired);
+            }
+            offset += RECORD_HEADER_SIZE + header.mSize;
+            continue;
+        }
+
+        const Key key{ header.mID, header.mType };
+        index_t::iterator it = mIndex.find(key);
+        if (it != mIndex.end())
+        {
+            releaseLocation(it->second);
+            mIndex.erase(it);
+        }
+
+        if (!(header.mFlags & RECORD_FLAG_TOMBSTONE))
+        {
+            mIndex.emplace(key, Location{ number, offset + RECORD_HEADER_SIZE, header.mSize });
+            segment.mLiveBytes += RECORD_HEADER_SIZE + header.mSize;
+            mLiveBytes += header.mSize;
+        }
+        offset += RECORD_HEADER_SIZE + header.mSize;
+    }
+    segment.mSize = offset;
+
+    // A read-only pack can also see the owner's append in progress here
+    return offset == size;
+}
+
+bool LLPackedCache::startNewSegment()
+{
+    if (mActiveFile)
+    {
+        LLFile::close(mActiveFile);
+        mActiveFile = nullptr;
+    }
+
+    const U32 number = mSegments.empty() ? 1 : mSegments.rbegin()->first + 1;
+    Segment& segment = mSegments[number];
+    segment.mPath = segmentPath(number);
+    mActiveFile = LLFile::fopen(segment.mPath, "wb");
+    if (!mActiveFile)
+    {
+        LL_WARNS("LLDiskCache") << "Unable to create packed cache segment " << segment.mPath << LL_ENDL;
+        mSegments.erase(number);
+        return false;
+    }
+    mActiveSegment = number;
+    return true;
+}
+
+bool LLPackedCache::appendRecord(const Key& key, const U8* data, U32 size, U32 flags, Location* location)
+{
+    if (!mActiveFile || mSegments[mActiveSegment].mSize >= mSegmentSize)
+    {
+        if (!startNewSegment())
+        {
+            return false;
+        }
+    }
+
+    Segment& segment = mSegments[mActiveSegment];
+
+    U8 header_buffer[RECORD_HEADER_SIZE];
+    RecordHeader header;
+    header.mFlags = flags;
+    header.mID = key.mID;
+    header.mType = key.mType;
+    header.mSize = size;
+    pack_header(header_buffer, header);
+
+    bool success = fwrite(header_buffer, 1, RECORD_HEADER_SIZE, mActiveFile) == RECORD_HEADER_SIZE;
+    if (success && size)
+    {
+        success = fwrite(data, 1, size, mActiveFile) == size;
+    }
+    // Readers go through the mapping, so the data has to reach the OS now
+    success = (fflush(mActiveFile) == 0) && success;
+    if (!success)
+    {
+        // We no longer know where the end of the segment is; seal it and
+        // carry on in a fresh one. The torn record is skipped on load.
+        LL_WARNS("LLDiskCache") << "Failed to append to packed cache segment " << segment.mPath << LL_ENDL;
+        LLFile::close(mActiveFile);
+        mActiveFile = nullptr;
+        return false;
+    }
+
+    if (location)
+    {
+        *location = Location{ mActiveSegment, segment.mSize + RECORD_HEADER_SIZE, size };
+        segment.mLiveBytes += RECORD_HEADER_SIZE + size;
+    }
+    segment.mSize += RECORD_HEADER_SIZE + size;
+    segment.mWriteTime = std::time(nullptr);
+    return true;
+}
+
+void LLPackedCache::releaseLocation(const Location& location)
+{
+    auto it = mSegments.find(location.mSegment);
+    if (it != mSegments.end())
+    {
+        it->second.mLiveBytes -= llmin(it->second.mLiveBytes, (U64)(RECORD_HEADER_SIZE + location.mSize));
+    }
+    mLiveBytes -= llmin(mLiveBytes, (U64)location.mSize);
+}
+
+std::shared_ptr<LLMappedFile> LLPackedCache::getMapping(U32 segment_number, U64 end_offset)
+{
+    auto it = mSegments.find(segment_number);
+    if (it == mSegments.end())
+    {
+        return nullptr;
+    }
+
+    Segment& segment = it->second;
+    if (!segment.mMapping || segment.mMapping->size() < end_offset)
+    {
+        // The active segment has grown since we last mapped it. Readers
+        // still holding the old mapping keep it alive until they are done.
+        std::shared_ptr<LLMappedFile> mapping = std::make_shared<LLMappedFile>();
+        if (!mapping->open(segment.mPath) || mapping->size() < end_offset)
+        {
+            return nullptr;
+        }
+        segment.mMapping = mapping;
+    }
+    return segment.mMapping;
+}
+
+bool LLPackedCache::exists(const LLUUID& id, LLAssetType::EType type)
+{
+    LLMutexLock lock(&mMutex);
+    return mIndex.find(Key{ id, type }) != mIndex.end();
+}
+
+S32 LLPackedCache::getSize(const LLUUID& id, LLAssetType::EType type)
+{
+    LLMutexLock lock(&mMutex);
+    index_t::const_iterator it = mIndex.find(Key{ id, type });
+    return it != mIndex.end() ? (S32)it->second.mSize : -1;
+}
+
+S32 LLPackedCache::read(const LLUUID& id, LLAssetType::EType type, S32 offset, U8* buffer, S32 bytes)
+{
+    LL_PROFILE_ZONE_SCOPED;
+    Location location;
+    std::shared_ptr<LLMappedFile> mapping;
+    {
+        LLMutexLock lock(&mMutex);
+        index_t::const_iterator it = mIndex.find(Key{ id, type });
+        if (it == mIndex.end())
+        {
+            return -1;
+        }
+        location = it->second;
+        mapping = getMapping(location.mSegment, location.mOffset + location.mSize);
+    }
+
+    if (!mapping)
+    {
+        return -1;
+    }
+
+    // Copy outside the lock; the mapping stays valid for as long as we hold it
+    if (offset < 0 || (U32)offset >= location.mSize || bytes <= 0)
+    {
+        return 0;
+    }
+    const S32 to_copy = llmin(bytes, (S32)(location.mSize - offset));
+    memcpy(buffer, mapping->data() + location.mOffset + offset, to_copy);
+    return to_copy;
+}
+
+bool LLPackedCache::readAll(const LLUUID& id, LLAssetType::EType type, std::vector<U8>& data)
+{
+    const S32 size = getSize(id, type);
+    if (size < 0)
+    {
+        return false;
+    }
+    data.resize(size);
+    return !size || read(id, type, 0, data.data(), size) == size;
+}
+
+bool LLPackedCache::readAll(const LLUUID& id, std::vector<U8>& data)
+{
+    LLAssetType::EType type = LLAssetType::AT_NONE;
+    {
+        LLMutexLock lock(&mMutex);
+        index_t::const_iterator it = mIndex.lower_bound(Key{ id, LLAssetType::AT_NONE });
+        if (it == mIndex.end() || it->first.mID != id)
+        {
+            return false;
+        }
+        type = it->first.mType;
+    }
+    return readAll(id, type, data);
+}
+
+bool LLPackedCache::write(const LLUUID& id, LLAssetType::EType type, const U8* data, S32 size)
+{
+    LL_PROFILE_ZONE_SCOPED;
+    if (size < 0 || (U32)size > mMaxEntrySize)
+    {
+        return false;
+    }
+
+    LLMutexLock lock(&mMutex);
+    if (mReadOnly)
+    {
+        return false;
+    }
+    const Key key{ id, type };
+    Location location;
+    if (!appendRecord(key, data, size, 0, &location))
+    {
+        return false;
+    }
+
+    index_t::iterator it = mIndex.find(key);
+    if (it != mIndex.end())
+    {
+        releaseLocation(it->second);
+        it->second = location;
+    }
+    else
+    {
+        mIndex.emplace(key, location);
+    }
+    mLiveBytes += size;
+    return true;
+}
+
+bool LLPackedCache::rename(const LLUUID& old_id, LLAssetType::EType old_type,
+                           const LLUUID& new_id, LLAssetType::EType new_type)
+{
+    std::vector<U8> data;
+    if (!readAll(old_id, old_type, data) || !write(new_id, new_type, data.data(), (S32)data.size()))
+    {
+        return false;
+    }
+    remove(old_id, old_type);
+    return true;
+}
+
+U32 LLPackedCache::remove(const LLUUID& id, LLAssetType::EType type)
+{
+    LLMutexLock lock(&mMutex);
+    if (mReadOnly)
+    {
+        return 0;
+    }
+    const Key key{ id, type };
+    index_t::iterator it = mIndex.find(key);
+    if (it == mIndex.end())
+    {
+        return 0;
+    }
+
+    // Without its tombstone the entry would come back on the next load, or
+    // in another viewer sharing the cache, so keep it until one is written
+    if (!appendRecord(key, nullptr, 0, RECORD_FLAG_TOMBSTONE, nullptr))
+    {
+        return 0;
+    }
+    const U32 size = it->second.mSize;
+    releaseLocation(it->second);
+    mIndex.erase(it);
+    return size;
+}
+
+U32 LLPackedCache::removeAll(const LLUUID& id)
+{
+    LLMutexLock lock(&mMutex);
+    if (mReadOnly)
+    {
+        return 0;
+    }
+    U32 removed = 0;
+    index_t::iterator it = mIndex.lower_bound(Key{ id, LLAssetType::AT_NONE });
+    while (it != mIndex.end() && it->first.mID == id)
+    {
+        if (!appendRecord(it->first, nullptr, 0, RECORD_FLAG_TOMBSTONE, nullptr))
+        {
+            // see remove()
+            ++it;
+            continue;
+        }
+        removed += it->second.mSize;
+        releaseLocation(it->second);
+        it = mIndex.erase(it);
+    }
+    return removed;
+}
+
+void LLPackedCache::compact(F32 min_dead_fraction)
+{
+    LL_PROFILE_ZONE_SCOPED;
+    std::vector<U32> candidates;
+    {
+        LLMutexLock lock(&mMutex);
+        if (mReadOnly)
+        {
+            return;
+        }
+        removeRetiredSegments();
+        for (const auto& [number, segment] : mSegments)
+        {
+            if (number != mActiveSegment && segment.mSize
+                && (F32)(segment.mSize - segment.mLiveBytes) >= min_dead_fraction * (F32)segment.mSize)
+            {
+                candidates.push_back(number);
+            }
+        }
+    }
+
+    for (U32 number : candidates)
+    {
+        compactSegment(number);
+    }
+}
+
+bool LLPackedCache::compactSegment(U32 number)
+{
+    std::shared_ptr<LLMappedFile> mapping;
+    U64 size = 0;
+    std::string path;
+    {
+        LLMutexLock lock(&mMutex);
+        auto it = mSegments.find(number);
+        if (it == mSegments.end())
+        {
+            return false;
+        }
+        size = it->second.mSize;
+        path = it->second.mPath;
+        mapping = size ? getMapping(number, size) : nullptr;
+        if (size && !mapping)
+        {
+            return false;
+        }
+    }
+
+    U32 moved = 0;
+    U64 offset = 0;
+    while (offset + RECORD_HEADER_SIZE <= size)
+    {
+        RecordHeader header;
+        if (!unpack_header(mapping->data() + offset, header))
+        {
+            break;
+        }
+        const U64 payload_offset = offset + RECORD_HEADER_SIZE;
+        const Key key{ header.mID, header.mType };
+
+        // Sealed segments never change, so only the index needs the lock.
+        // Taking it per record keeps readers and writers moving.
+        LLMutexLock lock(&mMutex);
+        if (header.mFlags & RECORD_FLAG_RETIRED)
+        {
+            // Keep it for as long as the segment it names is there
+            U32 retired = 0;
+            if (header.mSize == sizeof(U32))
+            {
+                memcpy(&retired, mapping->data() + payload_offset, sizeof(U32));
+            }
+            if (mRetiredSegments.count(retired)
+                && !appendRecord(key, mapping->data() + payload_offset, header.mSize, RECORD_FLAG_RETIRED, nullptr))
+            {
+                // Leave the segment in place and try again next time
+                return false;
+            }
+            offset = payload_offset + header.mSize;
+            continue;
+        }
+        index_t::iterator it = mIndex.find(key);
+        if (header.mFlags & RECORD_FLAG_TOMBSTONE)
+        {
+            // A tombstone must outlive any older record it hides
+            if (it == mIndex.end() && mSegments.begin()->first < number
+                && !appendRecord(key, nullptr, 0, RECORD_FLAG_TOMBSTONE, nullptr))
+            {
+                return false;
+            }
+        }
+        else if (it != mIndex.end() && it->second.mSegment == number && it->second.mOffset == payload_offset)
+        {
+            Location location;
+            if (!appendRecord(key, mapping->data() + payload_offset, header.mSize, 0, &location))
+            {
+                // Leave the segment in place and try again next time
+                return false;
+            }
+            releaseLocation(it->second);
+            it->second = location;
+            mLiveBytes += header.mSize;
+            ++moved;
+        }
+        offset = payload_offset + header.mSize;
+    }
+
+    {
+        LLMutexLock lock(&mMutex);
+        mSegments.erase(number);
+    }
+    mapping.reset();
+
+    // On Windows this fails while a reader still holds the mapping. Replaying
+    // the segment on the next load would bring back the entries removed since
+    // their tombstones were dropped, so record that it is dead and try again
+    // on a later pass.
+    if (LLFile::remove(path, ENOENT) != 0 && LLFile::isfile(path))
+    {
+        LLMutexLock lock(&mMutex);
+        if (appendRecord(Key{ LLUUID::null, LLAssetType::AT_NONE }, (const U8*)&number, sizeof(U32), RECORD_FLAG_RETIRED, nullptr))
+        {
+            mRetiredSegments.insert(number);
+        }
+    }
+
+    LL_DEBUGS("LLDiskCache") << "Compacted packed cache segment " << path << ", moved " << moved << " entries" << LL_ENDL;
+    return true;
+}
+
+void LLPackedCache::retireSegment(U32 number)
+{
+    mRetiredSegments.insert(number);
+    for (index_t::iterator entry = mIndex.begin(); entry != mIndex.end();)
+    {
+        if (entry->second.mSegment == number)
+        {
+            releaseLocation(entry->second);
+            entry = mIndex.erase(entry);
+        }
+        else
+        {
+            ++entry;
+        }
+    }
+    mSegments.erase(number);
+}
+
+void LLPackedCache::removeRetiredSegments()
+{
+    for (auto it = mRetiredSegments.begin(); it != mRetiredSegments.end();)
+    {
+        const std::string path = segmentPath(*it);
+        if (LLFile::remove(path, ENOENT) == 0 || !LLFile::isfile(path))
+        {
+            it = mRetiredSegments.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void LLPackedCache::clear()
+{
+    LLMutexLock lock(&mMutex);
+    if (mReadOnly)
+    {
+        return;
+    }
+    if (mActiveFile)
+    {
+        LLFile::close(mActiveFile);
+        mActiveFile = nullptr;
+    }
+    for (auto& [number, segment] : mSegments)
+    {
+        segment.mMapping.reset();
+        LLFile::remove(segment.mPath);
+    }
+    mSegments.clear();
+    removeRetiredSegments();
+    mIndex.clear();
+    mLiveBytes = 0;
+    startNewSegment();
+}
+
+bool LLPackedCache::isReadOnly()
+{
+    LLMutexLock lock(&mMutex);
+    return mReadOnly;
+}
+
+void LLPackedCache::refresh()
+{
+    LL_PROFILE_ZONE_SCOPED;
+    const std::vector<U32> numbers = listSegments();
+
+    LLMutexLock lock(&mMutex);
+    if (!mReadOnly)
+    {
+        return;
+    }
+
+    // Whatever was still live in a segment the owner compacted away has
+    // been copied to a newer one, which is replayed below
+    for (auto it = mSegments.begin(); it != mSegments.end();)
+    {
+        if (std::binary_search(numbers.begin(), numbers.end(), it->first))
+        {
+            ++it;
+            continue;
+        }
+        for (index_t::iterator entry = mIndex.begin(); entry != mIndex.end();)
+        {
+            if (entry->second.mSegment == it->first)
+            {
+                releaseLocation(entry->second);
+                entry = mIndex.erase(entry);
+            }
+            else
+            {
+                ++entry;
+            }
+        }
+        it = mSegments.erase(it);
+    }
+
+    for (U32 number : numbers)
+    {
+        if (mRetiredSegments.count(number))
+        {
+            continue;
+        }
+        Segment& segment = mSegments[number];
+        if (segment.mPath.empty())
+        {
+            segment.mPath = segmentPath(number);
+        }
+        loadSegment(number, segment);
+        mActiveSegment = number;
+    }
+}
+
+void LLPackedCache::makeWritable()
+{
+    refresh();
+
+    LLMutexLock lock(&mMutex);
+    if (!mReadOnly)
+    {
+        return;
+    }
+    // The newest segment may end in the previous owner's torn record, so
+    // don't append to it
+    mReadOnly = false;
+    startNewSegment();
+}
+
+void LLPackedCache::getEntries(std::vector<EntryInfo>& entries)
+{
+    LLMutexLock lock(&mMutex);
+    entries.reserve(entries.size() + mIndex.size());
+    for (const auto& [key, location] : mIndex)
+    {
+        auto segment = mSegments.find(location.mSegment);
+        entries.push_back({ key.mID, location.mSize, segment != mSegments.end() ? segment->second.mWriteTime : 0 });
+    }
+}
+
+size_t LLPackedCache::getEntryCount()
+{
+    LLMutexLock lock(&mMutex);
+    return mIndex.size();
+}
+
+U64 LLPackedCache::getLiveBytes()
+{
+    LLMutexLock lock(&mMutex);
+    return mLiveBytes;
+}
+
+U64 LLPackedCache::getSegmentBytes()
+{
+    LLMutexLock lock(&mMutex);
+    U64 total = 0;
+    for (const auto& [number, segment] : mSegments)
+    {
+        total += segment.mSize;
+    }
+    return total;
+}
@@ -0,0 +1,242 @@
+/**
+ * @file llpackedcache.h
+ * @brief Pack-file storage for small cached assets.
+ *
+ * @Description:
+ * Most cached assets (sounds, animations, notecards, mesh headers...) are
+ * only a few KB in size. Storing each of them in its own file costs an inode,
+ * a directory lookup on every open and a lot of disk slack. LLPackedCache
+ * instead appends small entries to large segment files:
+ * 1/ Every record in a segment starts with a fixed size header holding the
+ *    asset id, asset type and payload size. A record with the tombstone
+ *    flag set marks the entry as removed.
+ * 2/ Segments are only ever appended to. Later records win over earlier
+ *    ones, so the in-memory offset index is rebuilt at startup by walking
+ *    the record headers of each segment in order - no separate index file
+ *    is needed.
+ * 3/ Segments are read through a read-only memory mapping.
+ * 4/ compact() copies the live records out of segments that are mostly
+ *    dead space into the active segment and deletes the old segment. It is
+ *    meant to be called from a background thread (LLPurgeDiskCacheThread).
+ * 5/ When several viewers share the cache folder only one of them appends
+ *    to the segments. The others open the pack read-only and pick up its
+ *    appends and compactions with refresh().
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPACKEDCACHE_H
+#define LL_LLPACKEDCACHE_H
+
+#include "llassettype.h"
+#include "llfile.h"
+#include "llmutex.h"
+#include "lluuid.h"
+
+#include <ctime>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+class LLPackedCache
+{
+public:
+    /**
+     * Entries larger than this are left to the one-file-per-asset layout
+     */
+    static constexpr U32 DEFAULT_MAX_ENTRY_SIZE = 64 * 1024;
+
+    /**
+     * A new segment is started once the active one grows beyond this
+     */
+    static constexpr U64 DEFAULT_SEGMENT_SIZE = 64 * 1024 * 1024;
+
+    /**
+     * @param dir               Folder holding the segment files. Created if needed.
+     * @param max_entry_size    Largest payload the pack will accept.
+     * @param segment_size      Size at which the active segment is sealed.
+     * @param read_only         Another viewer writes the segments; never append.
+     */
+    LLPackedCache(const std::string& dir,
+                  U32 max_entry_size = DEFAULT_MAX_ENTRY_SIZE,
+                  U64 segment_size = DEFAULT_SEGMENT_SIZE,
+                  bool read_only = false);
+    ~LLPackedCache();
+
+    LLPackedCache(const LLPackedCache&) = delete;
+    LLPackedCache& operator=(const LLPackedCache&) = delete;
+
+    U32 getMaxEntrySize() const { return mMaxEntrySize; }
+
+    /**
+     * Read-only packs refuse write(), rename(), remove() and compact()
+     */
+    bool isReadOnly();
+
+    /**
+     * Index the records other viewers appended, and drop the segments they
+     * compacted away, since the pack was opened or last refreshed.
+     * Does nothing for a writable pack.
+     */
+    void refresh();
+
+    /**
+     * Catch up with refresh() and start appending to a new segment. Called
+     * when this viewer takes over the cache folder from another one.
+     */
+    void makeWritable();
+
+    bool exists(const LLUUID& id, LLAssetType::EType type);
+
+    /**
+     * Size of the entry in bytes, or -1 if it is not in the pack
+     */
+    S32 getSize(const LLUUID& id, LLAssetType::EType type);
+
+    /**
+     * Copy up to bytes bytes of the entry, starting at offset, into buffer.
+     * Returns the number of bytes copied, or -1 if the entry is not in the
+     * pack.
+     */
+    S32 read(const LLUUID& id, LLAssetType::EType type, S32 offset, U8* buffer, S32 bytes);
+
+    /**
+     * Fetch the whole entry. Returns false if it is not in the pack.
+     */
+    bool readAll(const LLUUID& id, LLAssetType::EType type, std::vector<U8>& data);
+
+    /**
+     * Fetch the first entry with the given id, whatever its type
+     * (LLDiskCache only tracks ids)
+     */
+    bool readAll(const LLUUID& id, std::vector<U8>& data);
+
+    /**
+     * Store (or replace) the whole entry. Fails for entries larger than
+     * getMaxEntrySize() or if the segment can't be written.
+     */
+    bool write(const LLUUID& id, LLAssetType::EType type, const U8* data, S32 size);
+
+    /**
+     * Rename an entry by copying it to the new key and removing the old one
+     */
+    bool rename(const LLUUID& old_id, LLAssetType::EType old_type,
+                const LLUUID& new_id, LLAssetType::EType new_type);
+
+    /**
+     * Remove one entry, or every entry with the given id regardless of type
+     * (LLDiskCache only tracks ids when it purges).
+     * Both return the number of payload bytes released. An entry whose
+     * tombstone can't be written stays in the pack and counts for nothing.
+     */
+    U32 remove(const LLUUID& id, LLAssetType::EType type);
+    U32 removeAll(const LLUUID& id);
+
+    /**
+     * Rewrite the live records of every sealed segment whose dead space
+     * is at least min_dead_fraction of its size, then delete the segment.
+     */
+    void compact(F32 min_dead_fraction = 0.5f);
+
+    /**
+     * Remove every entry and every segment file
+     */
+    void clear();
+
+    struct EntryInfo
+    {
+        LLUUID      mID;
+        U32         mSize;
+        std::time_t mWriteTime;     // last write to the segment holding it
+    };
+
+    /**
+     * List every live entry. Entries have no file time of their own, so
+     * they get the one of their segment.
+     */
+    void getEntries(std::vector<EntryInfo>& entries);
+
+    size_t getEntryCount();
+    U64 getLiveBytes();
+    U64 getSegmentBytes();
+
+private:
+    struct Key
+    {
+        LLUUID              mID;
+        LLAssetType::EType  mType;
+
+        bool operator<(const Key& rhs) const
+        {
+            return mID < rhs.mID || (mID == rhs.mID && mType < rhs.mType);
+        }
+    };
+
+    struct Location
+    {
+        U32 mSegment;
+        U64 mOffset;    // offset of the payload, just past the record header
+        U32 mSize;
+    };
+
+    struct Segment
+    {
+        std::string                     mPath;
+        U64                             mSize{ 0 };         // bytes written so far
+        U64                             mLiveBytes{ 0 };    // header + payload of live records
+        std::time_t                     mWriteTime{ 0 };
+        std::shared_ptr<LLMappedFile>   mMapping;
+    };
+
+    typedef std::map<Key, Location> index_t;
+
+    /**
+     * These expect mMutex to be held
+     */
+    std::string segmentPath(U32 number) const;
+    std::vector<U32> listSegments() const;
+    bool loadSegment(U32 number, Segment& segment); // indexes the records past segment.mSize
+    bool startNewSegment();
+    bool appendRecord(const Key& key, const U8* data, U32 size, U32 flags, Location* location);
+    void releaseLocation(const Location& location);
+    std::shared_ptr<LLMappedFile> getMapping(U32 segment_number, U64 end_offset);
+    bool compactSegment(U32 number);
+    void retireSegment(U32 number);     // forget whatever is left in it
+    void removeRetiredSegments();
+
+    std::string             mDir;
+    U32                     mMaxEntrySize;
+    U64                     mSegmentSize;
+
+    LLMutex                 mMutex;
+    index_t                 mIndex;
+    std::map<U32, Segment>  mSegments;
+    std::set<U32>           mRetiredSegments;   // compacted, but the file is still there
+    U32                     mActiveSegment{ 0 };
+    LLFILE*                 mActiveFile{ nullptr };
+    U64                     mLiveBytes{ 0 };
+    bool                    mReadOnly{ false };
+};
+
+#endif // LL_LLPACKEDCACHE_H
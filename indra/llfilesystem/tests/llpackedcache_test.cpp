@@ -0,0 +1,240 @@
+/**
+ * @file llpackedcache_test.cpp
+ * @brief LLPackedCache test cases.
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "lltut.h"
+#include "../llpackedcache.h"
+
+#include "lltimer.h"
+
+#include <boost/filesystem.hpp>
+
+namespace tut
+{
+    struct LLPackedCacheFixture
+    {
+        LLPackedCacheFixture()
+        {
+            mDir = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("llpackedcache-%%%%-%%%%")).string();
+        }
+
+        ~LLPackedCacheFixture()
+        {
+            boost::system::error_code ec;
+            boost::filesystem::remove_all(mDir, ec);
+        }
+
+        std::vector<U8> makeData(size_t size, U8 seed)
+        {
+            std::vector<U8> data(size);
+            for (size_t i = 0; i < size; ++i)
+            {
+                data[i] = (U8)(seed + i * 7);
+            }
+            return data;
+        }
+
+        std::string mDir;
+    };
+    typedef test_group<LLPackedCacheFixture> LLPackedCacheTest_factory;
+    typedef LLPackedCacheTest_factory::object LLPackedCacheTest_t;
+    LLPackedCacheTest_factory tf("LLPackedCache");
+
+    template<> template<>
+    void LLPackedCacheTest_t::test<1>()
+    {
+        set_test_name("write, read back, overwrite and remove");
+        LLPackedCache cache(mDir);
+        LLUUID id;
+        id.generate();
+
+        ensure("empty cache", !cache.exists(id, LLAssetType::AT_SOUND));
+        ensure_equals("missing size", cache.getSize(id, LLAssetType::AT_SOUND), -1);
+
+        std::vector<U8> data = makeData(1000, 1);
+        ensure("write", cache.write(id, LLAssetType::AT_SOUND, data.data(), (S32)data.size()));
+        ensure("exists", cache.exists(id, LLAssetType::AT_SOUND));
+        ensure("keyed on type too", !cache.exists(id, LLAssetType::AT_ANIMATION));
+
+        U8 buffer[100];
+        ensure_equals("partial read", cache.read(id, LLAssetType::AT_SOUND, 950, buffer, 100), 50);
+        ensure("partial read content", memcmp(buffer, data.data() + 950, 50) == 0);
+
+        std::vector<U8> replacement = makeData(300, 9);
+        ensure("overwrite", cache.write(id, LLAssetType::AT_SOUND, replacement.data(), (S32)replacement.size()));
+        std::vector<U8> read_back;
+        ensure("read all", cache.readAll(id, LLAssetType::AT_SOUND, read_back));
+        ensure("overwritten content", read_back == replacement);
+        ensure_equals("live bytes", cache.getLiveBytes(), (U64)300);
+
+        ensure_equals("remove", cache.remove(id, LLAssetType::AT_SOUND), (U32)300);
+        ensure("removed", !cache.exists(id, LLAssetType::AT_SOUND));
+
+        std::vector<U8> too_big = makeData(LLPackedCache::DEFAULT_MAX_ENTRY_SIZE + 1, 3);
+        ensure("entries above the limit are refused", !cache.write(id, LLAssetType::AT_SOUND, too_big.data(), (S32)too_big.size()));
+    }
+
+    template<> template<>
+    void LLPackedCacheTest_t::test<2>()
+    {
+        set_test_name("index is rebuilt from the segments");
+        LLUUID kept, removed, replaced;
+        kept.generate();
+        removed.generate();
+        replaced.generate();
+        {
+            // small segments so that records span several of them
+            LLPackedCache cache(mDir, LLPackedCache::DEFAULT_MAX_ENTRY_SIZE, 4096);
+            std::vector<U8> data = makeData(2000, 1);
+            cache.write(kept, LLAssetType::AT_NOTECARD, data.data(), (S32)data.size());
+            cache.write(removed, LLAssetType::AT_NOTECARD, data.data(), (S32)data.size());
+            cache.write(replaced, LLAssetType::AT_NOTECARD, data.data(), (S32)data.size());
+            cache.remove(removed, LLAssetType::AT_NOTECARD);
+            std::vector<U8> replacement = makeData(500, 5);
+            cache.write(replaced, LLAssetType::AT_NOTECARD, replacement.data(), (S32)replacement.size());
+        }
+
+        LLPackedCache cache(mDir, LLPackedCache::DEFAULT_MAX_ENTRY_SIZE, 4096);
+        ensure_equals("entry count", cache.getEntryCount(), (size_t)2);
+        ensure("kept", cache.exists(kept, LLAssetType::AT_NOTECARD));
+        ensure("removed stays removed", !cache.exists(removed, LLAssetType::AT_NOTECARD));
+        ensure_equals("latest record wins", cache.getSize(replaced, LLAssetType::AT_NOTECARD), 500);
+
+        std::vector<LLPackedCache::EntryInfo> entries;
+        cache.getEntries(entries);
+        ensure_equals("listed entries", entries.size(), (size_t)2);
+        for (const LLPackedCache::EntryInfo& entry : entries)
+        {
+            ensure("entries get their segment time", entry.mWriteTime > 0 && entry.mWriteTime <= std::time(nullptr));
+        }
+    }
+
+    template<> template<>
+    void LLPackedCacheTest_t::test<3>()
+    {
+        set_test_name("compaction keeps live data and drops dead space");
+        std::vector<LLUUID> ids(64);
+        std::vector<U8> data = makeData(1000, 2);
+        LLUUID removed_early;
+        {
+            LLPackedCache cache(mDir, LLPackedCache::DEFAULT_MAX_ENTRY_SIZE, 8192);
+            removed_early.generate();
+            cache.write(removed_early, LLAssetType::AT_GESTURE, data.data(), (S32)data.size());
+            for (LLUUID& id : ids)
+            {
+                id.generate();
+                cache.write(id, LLAssetType::AT_GESTURE, data.data(), (S32)data.size());
+            }
+            cache.remove(removed_early, LLAssetType::AT_GESTURE);
+            for (size_t i = 0; i < ids.size(); i += 2)
+            {
+                cache.remove(ids[i], LLAssetType::AT_GESTURE);
+            }
+
+            const U64 before = cache.getSegmentBytes();
+            cache.compact();
+            ensure("segments shrank", cache.getSegmentBytes() < before);
+
+            for (size_t i = 0; i < ids.size(); ++i)
+            {
+                ensure_equals("live entries survive compaction", cache.exists(ids[i], LLAssetType::AT_GESTURE), (i % 2) != 0);
+            }
+            std::vector<U8> read_back;
+            ensure("read after compaction", cache.readAll(ids[1], LLAssetType::AT_GESTURE, read_back) && read_back == data);
+        }
+
+        LLPackedCache cache(mDir, LLPackedCache::DEFAULT_MAX_ENTRY_SIZE, 8192);
+        ensure_equals("entry count after reload", cache.getEntryCount(), ids.size() / 2);
+        ensure("removed entries stay removed after reload", !cache.exists(removed_early, LLAssetType::AT_GESTURE));
+    }
+
+    template<> template<>
+    void LLPackedCacheTest_t::test<4>()
+    {
+        // Compares the pack against the one-file-per-asset layout. Too slow
+        // to run on every build; set LL_PACKED_CACHE_BENCHMARK to the number
+        // of entries (e.g. 100000) to run it.
+        const char* entries_env = getenv("LL_PACKED_CACHE_BENCHMARK");
+        if (!entries_env)
+        {
+            skip("set LL_PACKED_CACHE_BENCHMARK=<entries> to run the benchmark");
+        }
+        const size_t entries = llmax(1, atoi(entries_env));
+
+        std::vector<LLUUID> ids(entries);
+        for (LLUUID& id : ids)
+        {
+            id.generate();
+        }
+        // typical small assets: 1KB-16KB
+        std::vector<U8> data = makeData(16 * 1024, 4);
+        auto entry_size = [](size_t i) { return (S32)(1024 + (i * 2654435761u) % (15 * 1024)); };
+
+        const std::string loose_dir = mDir + "/loose";
+        LLFile::mkdir(mDir);
+        LLFile::mkdir(loose_dir);
+        LLTimer timer;
+        for (size_t i = 0; i < entries; ++i)
+        {
+            LLFILE* file = LLFile::fopen(loose_dir + "/sl_cache_" + ids[i].asString() + "_0.asset", "wb");
+            fwrite(data.data(), 1, entry_size(i), file);
+            fclose(file);
+        }
+        const F64 loose_write = timer.getElapsedTimeAndResetF64();
+        std::vector<U8> buffer(data.size());
+        for (size_t i = 0; i < entries; ++i)
+        {
+            LLFILE* file = LLFile::fopen(loose_dir + "/sl_cache_" + ids[i].asString() + "_0.asset", "rb");
+            size_t bytes_read = fread(buffer.data(), 1, buffer.size(), file);
+            fclose(file);
+            ensure_equals("loose read", (S32)bytes_read, entry_size(i));
+        }
+        const F64 loose_read = timer.getElapsedTimeAndResetF64();
+
+        {
+            LLPackedCache cache(mDir + "/packs");
+            timer.reset();
+            for (size_t i = 0; i < entries; ++i)
+            {
+                cache.write(ids[i], LLAssetType::AT_SOUND, data.data(), entry_size(i));
+            }
+        }
+        const F64 packed_write = timer.getElapsedTimeAndResetF64();
+        LLPackedCache cache(mDir + "/packs");
+        const F64 packed_load = timer.getElapsedTimeAndResetF64();
+        for (size_t i = 0; i < entries; ++i)
+        {
+            ensure_equals("packed read", cache.read(ids[i], LLAssetType::AT_SOUND, 0, buffer.data(), (S32)buffer.size()), entry_size(i));
+        }
+        const F64 packed_read = timer.getElapsedTimeAndResetF64();
+
+        std::cout << "\nLLPackedCache benchmark, " << entries << " entries\n"
+                  << "  one file per asset: write " << loose_write << "s, read " << loose_read << "s\n"
+                  << "  packed:             write " << packed_write << "s, index load " << packed_load
+                  << "s, read " << packed_read << "s" << std::endl;
+    }
+}
@@ -67,7 +67,7 @@ private:
 LLImageDecodeThread::LLImageDecodeThread(bool /*threaded*/)
     : mDecodeCount(0)
 {
-    mThreadPool.reset(new LL::ThreadPool("ImageDecode", 8));
+    mThreadPool.reset(new LL::PriorityThreadPool("ImageDecode", 8));
     mThreadPool->start();
 }
 
@@ -92,7 +92,9 @@ LLImageDecodeThread::handle_t LLImageDecodeThread::decodeImage(
     const LLPointer<LLImageFormatted>& image,
     S32 discard,
     bool needs_aux,
-    const LLPointer<LLImageDecodeThread::Responder>& responder)
+    const LLPointer<LLImageDecodeThread::Responder>& responder,
+    LL::PriorityWorkQueue::Priority priority,
+    LL::PriorityWorkQueue::Handle* work_handle)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
 
@@ -101,14 +103,19 @@ LLImageDecodeThread::handle_t LLImageDecodeThread::decodeImage(
         decode_id = ++mDecodeCount;
 
     // Instantiate the ImageRequest right in the lambda, why not?
-    bool posted = mThreadPool->getQueue().post(
+    LL::PriorityWorkQueue::Handle posted = mThreadPool->getQueue().post(
         [req = ImageRequest(image, discard, needs_aux, responder, decode_id)]
         () mutable
         {
             auto done = req.processRequest();
             req.finishRequest(done);
-        });
-    if (! posted)
+        },
+        priority);
+    if (work_handle)
+    {
+        *work_handle = posted;
+    }
+    if (posted == LL::PriorityWorkQueue::NO_HANDLE)
     {
         LL_DEBUGS() << "Tried to start decoding on shutdown" << LL_ENDL;
         return 0;
@@ -117,6 +124,16 @@ LLImageDecodeThread::handle_t LLImageDecodeThread::decodeImage(
     return decode_id;
 }
 
+bool LLImageDecodeThread::setDecodePriority(LL::PriorityWorkQueue::Handle work_handle, LL::PriorityWorkQueue::Priority priority)
+{
+    return mThreadPool->getQueue().reprioritize(work_handle, priority);
+}
+
+bool LLImageDecodeThread::cancelDecode(LL::PriorityWorkQueue::Handle work_handle)
+{
+    return mThreadPool->getQueue().cancel(work_handle);
+}
+
 void LLImageDecodeThread::shutdown()
 {
     mThreadPool->close();
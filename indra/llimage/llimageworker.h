@@ -48,9 +48,18 @@ public:
 
     // meant to resemble LLQueuedThread::handle_t
     typedef U32 handle_t;
+    // Decodes of higher priority run first: pass HIGH for images on screen.
+    // If work_handle is given, it receives the handle to pass to
+    // setDecodePriority() or cancelDecode().
     handle_t decodeImage(const LLPointer<LLImageFormatted>& image,
                          S32 discard, bool needs_aux,
-                         const LLPointer<Responder>& responder);
+                         const LLPointer<Responder>& responder,
+                         LL::PriorityWorkQueue::Priority priority = LL::PriorityWorkQueue::NORMAL,
+                         LL::PriorityWorkQueue::Handle* work_handle = NULL);
+    // Move a decode to another priority class, or drop it, along with its
+    // responder. Both return false once a worker has started the decode.
+    bool setDecodePriority(LL::PriorityWorkQueue::Handle work_handle, LL::PriorityWorkQueue::Priority priority);
+    bool cancelDecode(LL::PriorityWorkQueue::Handle work_handle);
     size_t getPending();
     size_t update(F32 max_time_ms);
     S32 getTotalDecodeCount() { return mDecodeCount; }
@@ -60,7 +69,7 @@ private:
     // As of SL-17483, LLImageDecodeThread is no longer itself an
     // LLQueuedThread - instead this is the API by which we submit work to the
     // "ImageDecode" ThreadPool.
-    std::unique_ptr<LL::ThreadPool> mThreadPool;
+    std::unique_ptr<LL::PriorityThreadPool> mThreadPool;
     LLAtomicU32 mDecodeCount;
 };
 
@@ -30,6 +30,7 @@
 
 #include "llavatarname.h"   // for convenience
 #include "llsingleton.h"
+#include "lluuidhashmap.h" // <FS/> Flat UUID name cache
 #include <boost/signals2.hpp>
 #include <set>
 
@@ -192,7 +193,10 @@ private:
 
     // Agent IDs that have been requested, but with no reply.
     // Maps agent ID to frame time request was made.
-    typedef std::map<LLUUID, F64> pending_queue_t;
+    // <FS> Flat UUID name cache: looked up for every name shown
+    //typedef std::map<LLUUID, F64> pending_queue_t;
+    typedef LLUUIDHashMap<F64> pending_queue_t;
+    // </FS>
     pending_queue_t mPendingQueue;
 
     // Callbacks to fire when we received a name.
@@ -203,7 +207,10 @@ private:
     signal_map_t mSignalMap;
 
     // The cache at last, i.e. avatar names we know about.
-    typedef std::map<LLUUID, LLAvatarName> cache_t;
+    // <FS> Flat UUID name cache
+    //typedef std::map<LLUUID, LLAvatarName> cache_t;
+    typedef LLUUIDHashMap<LLAvatarName> cache_t;
+    // </FS>
     cache_t mCache;
 
     // Time when unrefreshed cached names were checked last.
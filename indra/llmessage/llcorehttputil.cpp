@@ -35,7 +35,6 @@
 #include "llsd.h"
 #include "llsdjson.h"
 #include "llsdserialize.h"
-#include "boost/json.hpp" // Boost.Json
 #include "llfilesystem.h"
 
 #include "message.h" // for getting the port
@@ -583,19 +582,17 @@ LLSD HttpCoroJSONHandler::handleSuccess(LLCore::HttpResponse * response, LLCore:
         return result;
     }
 
-    LLCore::BufferArrayStream bas(body);
+    // Parse straight into LLSD, without an intermediate boost::json tree
+    std::string json(body->size(), '\0');
+    body->read(0, json.data(), json.size());
 
-    boost::system::error_code ec;
-    boost::json::value jsonRoot = boost::json::parse(bas, ec);
-    if(ec.failed())
+    std::string error;
+    if (!LlsdFromJsonString(json, result, &error))
     {   // deserialization failed.  Record the reason and pass back an empty map for markup.
-        status = LLCore::HttpStatus(499, std::string(ec.what()));
-        return result;
+        status = LLCore::HttpStatus(499, error);
+        return LLSD::emptyMap();
     }
 
-    // Convert the JSON structure to LLSD
-    result = LlsdFromJson(jsonRoot);
-
     return result;
 }
 
@@ -608,18 +605,12 @@ LLSD HttpCoroJSONHandler::parseBody(LLCore::HttpResponse *response, bool &succes
         return LLSD();
     }
 
-    LLCore::BufferArrayStream bas(body);
+    std::string json(body->size(), '\0');
+    body->read(0, json.data(), json.size());
 
-    boost::system::error_code ec;
-    boost::json::value jsonRoot = boost::json::parse(bas, ec);
-    if (ec.failed())
-    {
-        success = false;
-        return LLSD();
-    }
-
-    // Convert the JSON structure to LLSD
-    return LlsdFromJson(jsonRoot);
+    LLSD result;
+    success = LlsdFromJsonString(json, result);
+    return result;
 }
 
 //========================================================================
@@ -795,8 +786,7 @@ LLSD HttpCoroutineAdapter::postJsonAndSuspend(LLCore::HttpRequest::ptr_t request
 
     {
         LLCore::BufferArrayStream outs(rawbody.get());
-        auto root = LlsdToJson(body);
-        std::string value = boost::json::serialize(root);
+        std::string value = LlsdToJsonString(body);
 
         LL_WARNS("Http::post") << "JSON Generates: \"" << value << "\"" << LL_ENDL;
 
@@ -854,8 +844,7 @@ LLSD HttpCoroutineAdapter::putJsonAndSuspend(LLCore::HttpRequest::ptr_t request,
 
     {
         LLCore::BufferArrayStream outs(rawbody.get());
-        auto root = LlsdToJson(body);
-        std::string value = boost::json::serialize(root);
+        std::string value = LlsdToJsonString(body);
 
         LL_WARNS("Http::put") << "JSON Generates: \"" << value << "\"" << LL_ENDL;
         outs << value;
@@ -0,0 +1,121 @@
+/**
+ * @file llzerocode.cpp
+ * @brief Zero-coding of message bodies.
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llzerocode.h"
+
+#include <emmintrin.h>
+
+namespace
+{
+    inline U32 lowest_bit(U32 mask)
+    {
+#if LL_WINDOWS
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (U32)index;
+#else
+        return (U32)__builtin_ctz(mask);
+#endif
+    }
+
+    // Number of leading bytes of data that are zero, or non-zero when
+    // ZERO is false.
+    template <bool ZERO>
+    inline size_t run_length(const U8* data, size_t size)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        size_t done = 0;
+        for (; done + 16 <= size; done += 16)
+        {
+            U32 zeroes = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(data + done)), zero));
+            U32 ends = ZERO ? ~zeroes & 0xffff : zeroes;
+            if (ends)
+            {
+                return done + lowest_bit(ends);
+            }
+        }
+        while (done < size && (data[done] == 0) == ZERO)
+        {
+            ++done;
+        }
+        return done;
+    }
+}
+
+size_t LLZeroCode::nonZeroRun(const U8* data, size_t size)
+{
+    return run_length<false>(data, size);
+}
+
+size_t LLZeroCode::zeroRun(const U8* data, size_t size)
+{
+    return run_length<true>(data, size);
+}
+
+size_t LLZeroCode::encode(const U8* data, size_t size, U8* out)
+{
+    U8* start = out;
+    size_t done = 0;
+    while (done < size)
+    {
+        size_t literal = run_length<false>(data + done, size - done);
+        memcpy(out, data + done, literal);
+        out += literal;
+        done += literal;
+
+        size_t zeroes = run_length<true>(data + done, size - done);
+        done += zeroes;
+        for (; zeroes >= 255; zeroes -= 255)
+        {
+            *out++ = 0;
+            *out++ = 255;
+        }
+        if (zeroes)
+        {
+            *out++ = 0;
+            *out++ = (U8)zeroes;
+        }
+    }
+    return out - start;
+}
+
+S32 LLZeroCode::encodedGain(const U8* data, size_t size)
+{
+    // each run of zeroes becomes two bytes per 255 or part thereof
+    S32 gain = 0;
+    size_t done = 0;
+    while (done < size)
+    {
+        done += run_length<false>(data + done, size - done);
+        size_t zeroes = run_length<true>(data + done, size - done);
+        done += zeroes;
+        gain += 2 * (S32)((zeroes + 254) / 255) - (S32)zeroes;
+    }
+    return gain;
+}
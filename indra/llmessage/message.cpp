@@ -70,6 +70,7 @@
 #include "lltransfermanager.h"
 #include "lluuid.h"
 #include "llxfermanager.h"
+#include "llzerocode.h"
 #include "llquaternion.h"
 #include "u64.h"
 #include "v3dmath.h"
@@ -2770,54 +2771,9 @@ S32 LLMessageSystem::zeroCodeAdjustCurrentSendTotal()
     // TODO: babbage: remove this horror
     mMessageBuilder->setBuilt(false);
 
-    S32 count = mSendSize;
+// skip the packet id field, and don't actually build, just test
 
-    S32 net_gain = 0;
-    U8 num_zeroes = 0;
-
-    U8 *inptr = (U8 *)mSendBuffer;
-
-// skip the packet id field
-
-    for (U32 ii = 0; ii < LL_PACKET_ID_SIZE; ++ii)
-    {
-        count--;
-        inptr++;
-    }
-
-// don't actually build, just test
-
-// sequential zero bytes are encoded as 0 [U8 count]
-// with 0 0 [count] representing wrap (>256 zeroes)
-
-    while (count--)
-    {
-        if (!(*inptr))   // in a zero count
-        {
-            if (num_zeroes)
-            {
-                if (++num_zeroes > 254)
-                {
-                    num_zeroes = 0;
-                }
-                net_gain--;   // subseqent zeroes save one
-            }
-            else
-            {
-                net_gain++;  // starting a zero count adds one
-                num_zeroes = 1;
-            }
-            inptr++;
-        }
-        else
-        {
-            if (num_zeroes)
-            {
-                num_zeroes = 0;
-            }
-            inptr++;
-        }
-    }
+    S32 net_gain = LLZeroCode::encodedGain(mSendBuffer + LL_PACKET_ID_SIZE, mSendSize - LL_PACKET_ID_SIZE);
     if (net_gain < 0)
     {
         return net_gain;
@@ -2879,6 +2835,18 @@ S32 LLMessageSystem::zeroCodeExpand(U8** data, S32* data_size)
             outptr = mEncodedRecvBuffer;
             break;
         }
+        if (*inptr)
+        {
+            // copy the whole literal run at once, as far as the buffer check
+            // above would have let it go a byte at a time
+            S32 literal = (S32)llmin(LLZeroCode::nonZeroRun(inptr, count + 1),
+                                     (size_t)(mEncodedRecvBuffer + MAX_BUFFER_SIZE - outptr));
+            memcpy(outptr, inptr, literal);
+            outptr += literal;
+            inptr += literal;
+            count -= literal - 1;
+            continue;
+        }
         if (!((*outptr++ = *inptr++)))
         {
             while (((count--)) && (!(*inptr)))
@@ -0,0 +1,211 @@
+/**
+ * @file llzerocode_test.cpp
+ * @brief Tests for LLZeroCode against the byte at a time zero-coder it
+ *        replaced, and its throughput on packet-sized bodies.
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../llzerocode.h"
+
+#include "../test/lltut.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // The zero-coder of LLTemplateMessageBuilder before LLZeroCode, on the
+    // body of a packet. Returns the number of bytes written to out.
+    size_t legacy_encode(const U8* inptr, size_t count, U8* out, S32& net_gain)
+    {
+        U8* outptr = out;
+        net_gain = 0;
+        U8 num_zeroes = 0;
+        while (count--)
+        {
+            if (!(*inptr))
+            {
+                if (num_zeroes)
+                {
+                    if (++num_zeroes > 254)
+                    {
+                        *outptr++ = num_zeroes;
+                        num_zeroes = 0;
+                    }
+                    net_gain--;
+                }
+                else
+                {
+                    *outptr++ = 0;
+                    net_gain++;
+                    num_zeroes = 1;
+                }
+                inptr++;
+            }
+            else
+            {
+                if (num_zeroes)
+                {
+                    *outptr++ = num_zeroes;
+                    num_zeroes = 0;
+                }
+                *outptr++ = *inptr++;
+            }
+        }
+        if (num_zeroes)
+        {
+            *outptr++ = num_zeroes;
+        }
+        return outptr - out;
+    }
+
+    // Packet bodies: runs of literal bytes between runs of zeroes, each of
+    // them up to max_run long.
+    std::vector<U8> random_body(std::mt19937& random, size_t size, size_t max_run)
+    {
+        std::vector<U8> body;
+        bool zeroes = random() & 1;
+        while (body.size() < size)
+        {
+            size_t run = std::min(size - body.size(), (size_t)(random() % max_run + 1));
+            for (size_t i = 0; i < run; ++i)
+            {
+                body.push_back(zeroes ? 0 : (U8)(random() % 255 + 1));
+            }
+            zeroes = !zeroes;
+        }
+        return body;
+    }
+}
+
+namespace tut
+{
+    struct zerocode_data
+    {
+    };
+    typedef test_group<zerocode_data> zerocode_test;
+    typedef zerocode_test::object zerocode_object;
+    tut::zerocode_test zerocode("LLZeroCode");
+
+    template<> template<>
+    void zerocode_object::test<1>()
+    {
+        set_test_name("same output as the byte at a time coder");
+        std::mt19937 random(25);
+        std::vector<std::vector<U8>> bodies;
+        bodies.push_back(std::vector<U8>());
+        for (size_t zeroes : { 1, 254, 255, 256, 509, 510, 511, 1000 })
+        {
+            bodies.push_back(std::vector<U8>(zeroes, 0));
+            std::vector<U8> framed(zeroes + 2, 0);
+            framed.front() = framed.back() = 7;
+            bodies.push_back(framed);
+        }
+        for (S32 trial = 0; trial < 5000; ++trial)
+        {
+            size_t max_run = (trial % 4 == 3) ? 600 : 1 + trial % 40;
+            bodies.push_back(random_body(random, random() % 1200, max_run));
+        }
+
+        for (const std::vector<U8>& body : bodies)
+        {
+            S32 expected_gain;
+            std::vector<U8> expected(2 * body.size());
+            expected.resize(legacy_encode(body.data(), body.size(), expected.data(), expected_gain));
+            ensure_equals("legacy gain", expected_gain, (S32)expected.size() - (S32)body.size());
+            std::vector<U8> encoded(2 * body.size());
+            encoded.resize(LLZeroCode::encode(body.data(), body.size(), encoded.data()));
+            ensure("encoded", encoded == expected);
+            ensure_equals("gain", LLZeroCode::encodedGain(body.data(), body.size()), expected_gain);
+
+            size_t offset = body.empty() ? 0 : random() % body.size();
+            size_t non_zero = offset;
+            while (non_zero < body.size() && body[non_zero])
+            {
+                ++non_zero;
+            }
+            size_t zero = offset;
+            while (zero < body.size() && !body[zero])
+            {
+                ++zero;
+            }
+            ensure_equals("non-zero run", LLZeroCode::nonZeroRun(body.data() + offset, body.size() - offset), non_zero - offset);
+            ensure_equals("zero run", LLZeroCode::zeroRun(body.data() + offset, body.size() - offset), zero - offset);
+        }
+    }
+
+    template<> template<>
+    void zerocode_object::test<2>()
+    {
+        set_test_name("throughput on packet bodies");
+        // test<1> already compares the output with the byte at a time
+        // coder; this only times the two
+        if (!getenv("LL_ZERO_CODE_BENCHMARK"))
+        {
+            skip("set LL_ZERO_CODE_BENCHMARK to run the benchmark");
+        }
+        std::mt19937 random(26);
+        for (size_t max_run : { 4, 16, 64 })
+        {
+            std::vector<std::vector<U8>> bodies;
+            size_t bytes = 0;
+            for (S32 i = 0; i < 1000; ++i)
+            {
+                bodies.push_back(random_body(random, 200 + random() % 1000, max_run));
+                bytes += bodies.back().size();
+            }
+            const S32 ROUNDS = 20;
+            std::vector<U8> out(2 * 1200);
+            S32 legacy_gain = 0, gain = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (S32 round = 0; round < ROUNDS; ++round)
+            {
+                for (const std::vector<U8>& body : bodies)
+                {
+                    S32 body_gain;
+                    legacy_encode(body.data(), body.size(), out.data(), body_gain);
+                    legacy_gain += body_gain;
+                }
+            }
+            std::chrono::duration<F64> legacy(std::chrono::steady_clock::now() - start);
+            start = std::chrono::steady_clock::now();
+            for (S32 round = 0; round < ROUNDS; ++round)
+            {
+                for (const std::vector<U8>& body : bodies)
+                {
+                    gain += (S32)LLZeroCode::encode(body.data(), body.size(), out.data()) - (S32)body.size();
+                }
+            }
+            std::chrono::duration<F64> kernel(std::chrono::steady_clock::now() - start);
+            ensure_equals("same gain", gain, legacy_gain);
+            F64 mb = bytes * ROUNDS / (1024. * 1024.);
+            std::cout << "\nzero-coding MB/s with runs up to " << max_run << " bytes: byte at a time "
+                      << mb / legacy.count() << ", LLZeroCode " << mb / kernel.count() << std::endl;
+        }
+    }
+}
@@ -529,7 +529,7 @@ void LLPluginProcessParent::idle(void)
                         LL::WorkQueue::ptr_t main_queue = LL::WorkQueue::getInstance("mainloop");
                         // *NOTE: main_queue->postTo casts this refcounted smart pointer to a weak
                         // pointer
-                        LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+                        LL::WorkQueueBase::ptr_t general_queue = LL::WorkQueueBase::getInstance("General");
                         llassert_always(main_queue);
                         llassert_always(general_queue);
 
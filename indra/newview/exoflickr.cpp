@@ -125,9 +125,8 @@ void exoFlickrResponse( LLSD const &aData, exoFlickr::response_callback_t aCallb
     std::string result;
     result.assign( rawData.begin(), rawData.end() );
 
-    boost::system::error_code ec;
-    boost::json::value root = boost::json::parse(result, ec);
-    if (ec.failed())
+    LLSD response;
+    if (!LlsdFromJsonString(result, response))
     {
         if (aCallback)
         {
@@ -138,7 +137,6 @@ void exoFlickrResponse( LLSD const &aData, exoFlickr::response_callback_t aCallb
     else
     {
         LL_INFOS("FlickrAPI") << "Got response string: " << result << LL_ENDL;
-        LLSD response = LlsdFromJson(root);
         if (aCallback)
         {
             aCallback((status.getType() >= 200 && status.getType() < 300), response);
@@ -0,0 +1,62 @@
+/**
+ * @file fscachescrubber.cpp
+ * @brief Background integrity checks of the asset and texture caches
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fscachescrubber.h"
+
+#include "llapp.h"
+#include "lldiskcache.h"
+#include "lltexturecache.h"
+
+FSCacheScrubberThread::FSCacheScrubberThread(LLTextureCache* texture_cache, U32 bytes_per_second) :
+    LLThread("CacheScrubberThread", nullptr),
+    mTextureCache(texture_cache),
+    mBytesPerSecond(bytes_per_second)
+{
+}
+
+void FSCacheScrubberThread::run()
+{
+    constexpr std::chrono::seconds SCRUB_INTERVAL{1};
+
+    // The budget is split evenly between both caches. Whatever one of them
+    // did not need is not carried over: the point is to stay out of the way
+    // of the fetches, not to finish a pass quickly.
+    while (LLApp::instance()->sleep(SCRUB_INTERVAL) && !isQuitting())
+    {
+        const S64 budget = mBytesPerSecond / 2;
+        if (LLDiskCache::instanceExists())
+        {
+            LLDiskCache::instance().scrub(budget);
+        }
+        if (mTextureCache)
+        {
+            mTextureCache->scrub(budget);
+        }
+    }
+}
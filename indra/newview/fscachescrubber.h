@@ -0,0 +1,50 @@
+/**
+ * @file fscachescrubber.h
+ * @brief Background integrity checks of the asset and texture caches
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_FSCACHESCRUBBER_H
+#define FS_FSCACHESCRUBBER_H
+
+#include "llthread.h"
+
+class LLTextureCache;
+
+// Re-reads cached assets and textures at a bounded rate and evicts the
+// ones that no longer match the digest recorded when they were written.
+class FSCacheScrubberThread : public LLThread
+{
+public:
+    FSCacheScrubberThread(LLTextureCache* texture_cache, U32 bytes_per_second);
+
+protected:
+    void run() override;
+
+private:
+    LLTextureCache* mTextureCache;
+    U32             mBytesPerSecond;
+};
+
+#endif // FS_FSCACHESCRUBBER_H
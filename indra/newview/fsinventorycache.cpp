@@ -0,0 +1,607 @@
+/**
+ * @file fsinventorycache.cpp
+ * @brief Binary, chunked inventory cache
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsinventorycache.h"
+
+#include "lldir.h"
+#include "llfile.h"
+#include "llviewerinventory.h"
+#include "workqueue.h"
+
+#include <future>
+
+// File layout:
+//
+//   FileHeader
+//   CategoryRecord[mCategoryCount]
+//   category name pool (mCategoryPoolSize bytes)
+//   ChunkRecord[mChunkCount]
+//   chunk payloads
+//
+// A chunk holds the items of one folder, sorted by item id and stored as
+// columns: the 7 UUID columns, then the 12 U32 columns, then the 3 byte
+// columns (see ITEM_FIXED_SIZE), followed by the pool that the name and
+// description offsets point into.
+
+namespace
+{
+    const U32 FILE_MAGIC = 0x43494E46; // "FNIC"
+    const U32 FILE_VERSION = 1;
+
+    struct FileHeader
+    {
+        U32 mMagic;
+        U32 mFileVersion;
+        S32 mInvCacheVersion;   // LLInventoryModel::getInvCacheVersion()
+        U32 mCategoryCount;
+        U32 mCategoryPoolSize;
+        U32 mChunkCount;
+    };
+
+    struct CategoryRecord
+    {
+        LLUUID  mID;
+        LLUUID  mParentID;
+        LLUUID  mOwnerID;
+        LLUUID  mThumbnailID;
+        S32     mVersion;
+        S32     mPreferredType;
+        U32     mNameOffset;
+        U32     mNameLength;
+    };
+
+    struct ChunkRecord
+    {
+        LLUUID  mParentID;
+        S32     mVersion;       // of the folder when the chunk was encoded
+        U32     mItemCount;
+        U64     mOffset;
+        U64     mSize;
+    };
+
+    static_assert(sizeof(FileHeader) == 24, "FileHeader layout changed");
+    static_assert(sizeof(CategoryRecord) == 80, "CategoryRecord layout changed");
+    static_assert(sizeof(ChunkRecord) == 40, "ChunkRecord layout changed");
+
+    const size_t UUID_COLUMNS = 7;
+    const size_t U32_COLUMNS = 12;
+    const size_t U8_COLUMNS = 3;
+    const size_t ITEM_FIXED_SIZE = UUID_COLUMNS * UUID_BYTES + U32_COLUMNS * sizeof(U32) + U8_COLUMNS;
+
+    // Aim for a few chunk groups per worker thread
+    const size_t LOAD_SLICES = 16;
+
+    typedef std::vector<LLViewerInventoryItem*> folder_items_t;
+
+    // The viewer item getters follow links, the cache wants the item's own
+    // values (as LLInventoryItem::asLLSD() does), hence the qualified calls.
+    void encode_chunk(const folder_items_t& items, std::vector<U8>& out)
+    {
+        const size_t count = items.size();
+        std::string pool;
+        std::vector<U32> name_offsets(count), desc_offsets(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            name_offsets[i] = (U32)pool.size();
+            pool += items[i]->LLInventoryItem::getName();
+            desc_offsets[i] = (U32)pool.size();
+            pool += items[i]->LLInventoryItem::getDescription();
+        }
+
+        out.assign(count * ITEM_FIXED_SIZE, 0);
+        out.insert(out.end(), pool.begin(), pool.end());
+
+        size_t column = 0;
+        auto uuid_column = [&](auto getter)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                memcpy(&out[column + i * UUID_BYTES], getter(items[i]).mData, UUID_BYTES);
+            }
+            column += count * UUID_BYTES;
+        };
+        auto u32_column = [&](auto getter)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                U32 value = (U32)getter(i);
+                memcpy(&out[column + i * sizeof(U32)], &value, sizeof(U32));
+            }
+            column += count * sizeof(U32);
+        };
+        auto u8_column = [&](auto getter)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                out[column + i] = (U8)getter(items[i]);
+            }
+            column += count;
+        };
+
+        uuid_column([](const LLViewerInventoryItem* item) -> const LLUUID& { return item->getUUID(); });
+        uuid_column([](const LLViewerInventoryItem* item) -> const LLUUID& { return item->LLInventoryItem::getAssetUUID(); });
+        uuid_column([](const LLViewerInventoryItem* item) -> const LLUUID& { return item->LLInventoryItem::getThumbnailUUID(); });
+        uuid_column([](const LLViewerInventoryItem* item) -> const LLUUID& { return item->LLInventoryItem::getPermissions().getCreator(); });
+        uuid_column([](const LLViewerInventoryItem* item) -> const LLUUID& { return item->LLInventoryItem::getPermissions().getOwner(); });
+        uuid_column([](const LLViewerInventoryItem* item) -> const LLUUID& { return item->LLInventoryItem::getPermissions().getLastOwner(); });
+        uuid_column([](const LLViewerInventoryItem* item) -> const LLUUID& { return item->LLInventoryItem::getPermissions().getGroup(); });
+
+        u32_column([&](size_t i) { return items[i]->LLInventoryItem::getPermissions().getMaskBase(); });
+        u32_column([&](size_t i) { return items[i]->LLInventoryItem::getPermissions().getMaskOwner(); });
+        u32_column([&](size_t i) { return items[i]->LLInventoryItem::getPermissions().getMaskGroup(); });
+        u32_column([&](size_t i) { return items[i]->LLInventoryItem::getPermissions().getMaskEveryone(); });
+        u32_column([&](size_t i) { return items[i]->LLInventoryItem::getPermissions().getMaskNextOwner(); });
+        u32_column([&](size_t i) { return items[i]->LLInventoryItem::getFlags(); });
+        u32_column([&](size_t i) { return (S32)items[i]->LLInventoryItem::getCreationDate(); });
+        u32_column([&](size_t i) { return items[i]->LLInventoryItem::getSaleInfo().getSalePrice(); });
+        u32_column([&](size_t i) { return name_offsets[i]; });
+        u32_column([&](size_t i) { return items[i]->LLInventoryItem::getName().size(); });
+        u32_column([&](size_t i) { return desc_offsets[i]; });
+        u32_column([&](size_t i) { return items[i]->LLInventoryItem::getDescription().size(); });
+
+        u8_column([](const LLViewerInventoryItem* item) { return (S8)item->LLInventoryItem::getType(); });
+        u8_column([](const LLViewerInventoryItem* item) { return (S8)item->LLInventoryItem::getInventoryType(); });
+        u8_column([](const LLViewerInventoryItem* item) { return item->LLInventoryItem::getSaleInfo().getSaleType(); });
+    }
+
+    // Runs on a worker thread: only touches the chunk and the new items
+    bool decode_chunk(const U8* data, U64 size, const ChunkRecord& chunk, LLInventoryModel::item_array_t& items)
+    {
+        const size_t count = chunk.mItemCount;
+        if (size < count * ITEM_FIXED_SIZE)
+        {
+            return false;
+        }
+        const U8* pool = data + count * ITEM_FIXED_SIZE;
+        const U64 pool_size = size - count * ITEM_FIXED_SIZE;
+
+        auto uuid_at = [&](size_t column, size_t i)
+        {
+            LLUUID id;
+            memcpy(id.mData, data + column * count * UUID_BYTES + i * UUID_BYTES, UUID_BYTES);
+            return id;
+        };
+        const U8* u32_base = data + UUID_COLUMNS * count * UUID_BYTES;
+        auto u32_at = [&](size_t column, size_t i)
+        {
+            U32 value;
+            memcpy(&value, u32_base + column * count * sizeof(U32) + i * sizeof(U32), sizeof(U32));
+            return value;
+        };
+        const U8* u8_base = u32_base + U32_COLUMNS * count * sizeof(U32);
+        auto u8_at = [&](size_t column, size_t i)
+        {
+            return u8_base[column * count + i];
+        };
+        auto string_at = [&](size_t offset_column, size_t i, std::string& str)
+        {
+            U64 offset = u32_at(offset_column, i);
+            U64 length = u32_at(offset_column + 1, i);
+            if (offset + length > pool_size)
+            {
+                return false;
+            }
+            str.assign((const char*)pool + offset, (size_t)length);
+            return true;
+        };
+
+        items.reserve(items.size() + count);
+        std::string name, desc;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!string_at(8, i, name) || !string_at(10, i, desc))
+            {
+                return false;
+            }
+
+            LLPermissions perm;
+            perm.init(uuid_at(3, i), uuid_at(4, i), uuid_at(5, i), uuid_at(6, i));
+            perm.setMaskBase(u32_at(0, i));
+            perm.setMaskOwner(u32_at(1, i));
+            perm.setMaskGroup(u32_at(2, i));
+            perm.setMaskEveryone(u32_at(3, i));
+            perm.setMaskNext(u32_at(4, i));
+            perm.fix();
+
+            LLSaleInfo sale_info((LLSaleInfo::EForSale)u8_at(2, i), (S32)u32_at(7, i));
+
+            LLPointer<LLViewerInventoryItem> item = new LLViewerInventoryItem(
+                uuid_at(0, i), chunk.mParentID, perm, uuid_at(1, i),
+                (LLAssetType::EType)(S8)u8_at(0, i), (LLInventoryType::EType)(S8)u8_at(1, i),
+                name, desc, sale_info, u32_at(5, i), (time_t)(S32)u32_at(6, i));
+            item->setThumbnailUUID(uuid_at(2, i));
+            items.push_back(item);
+        }
+        return true;
+    }
+
+    bool read_header(const LLMappedFile& file, FileHeader& header)
+    {
+        if (file.size() < sizeof(FileHeader))
+        {
+            return false;
+        }
+        memcpy(&header, file.data(), sizeof(FileHeader));
+        if (header.mMagic != FILE_MAGIC || header.mFileVersion != FILE_VERSION)
+        {
+            return false;
+        }
+        U64 tables_size = sizeof(FileHeader) + (U64)header.mCategoryCount * sizeof(CategoryRecord)
+            + header.mCategoryPoolSize + (U64)header.mChunkCount * sizeof(ChunkRecord);
+        return tables_size <= file.size();
+    }
+
+    bool read_chunks(const LLMappedFile& file, const FileHeader& header, std::vector<ChunkRecord>& chunks)
+    {
+        const U8* pos = file.data() + sizeof(FileHeader) + (size_t)header.mCategoryCount * sizeof(CategoryRecord)
+            + header.mCategoryPoolSize;
+        chunks.resize(header.mChunkCount);
+        if (!chunks.empty())
+        {
+            memcpy(chunks.data(), pos, chunks.size() * sizeof(ChunkRecord));
+        }
+        for (const ChunkRecord& chunk : chunks)
+        {
+            if (chunk.mOffset > file.size() || chunk.mSize > file.size() - chunk.mOffset)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+//static
+std::string FSInventoryCache::getFilename(const LLUUID& owner_id)
+{
+    std::string filename = LLInventoryModel::getInvCacheAddres(owner_id);
+    const std::string llsd_ext(".llsd");
+    if (filename.size() > llsd_ext.size() && filename.compare(filename.size() - llsd_ext.size(), llsd_ext.size(), llsd_ext) == 0)
+    {
+        filename.erase(filename.size() - llsd_ext.size());
+    }
+    return filename + ".bin";
+}
+
+//static
+bool FSInventoryCache::load(const std::string& filename,
+                            LLInventoryModel::cat_array_t& categories,
+                            LLInventoryModel::item_array_t& items,
+                            LLInventoryModel::changed_items_t& cats_to_update,
+                            bool& is_cache_obsolete)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    LLMappedFile file;
+    if (!file.open(filename))
+    {
+        LL_INFOS("Inventory") << "unable to load inventory from: " << filename << LL_ENDL;
+        return false;
+    }
+    LL_INFOS("Inventory") << "loading inventory from: (" << filename << ")" << LL_ENDL;
+
+    is_cache_obsolete = true; // Obsolete until proven current
+
+    FileHeader header;
+    std::vector<ChunkRecord> chunks;
+    if (!read_header(file, header) || !read_chunks(file, header, chunks))
+    {
+        LL_WARNS("Inventory") << "Inventory cache " << filename << " is corrupt" << LL_ENDL;
+        return false;
+    }
+    if (header.mInvCacheVersion != LLInventoryModel::getInvCacheVersion())
+    {
+        LL_WARNS("Inventory") << "Inventory cache is out of date" << LL_ENDL;
+        return false;
+    }
+    is_cache_obsolete = false;
+
+    // Categories
+    const U8* cat_records = file.data() + sizeof(FileHeader);
+    const char* cat_pool = (const char*)cat_records + (size_t)header.mCategoryCount * sizeof(CategoryRecord);
+    categories.reserve(categories.size() + header.mCategoryCount);
+    for (U32 i = 0; i < header.mCategoryCount; ++i)
+    {
+        CategoryRecord record;
+        memcpy(&record, cat_records + i * sizeof(CategoryRecord), sizeof(CategoryRecord));
+        if ((U64)record.mNameOffset + record.mNameLength > header.mCategoryPoolSize)
+        {
+            LL_WARNS("Inventory") << "Inventory cache " << filename << " is corrupt" << LL_ENDL;
+            return false;
+        }
+
+        LLPointer<LLViewerInventoryCategory> cat = new LLViewerInventoryCategory(
+            record.mID, record.mParentID, (LLFolderType::EType)record.mPreferredType,
+            std::string(cat_pool + record.mNameOffset, record.mNameLength), record.mOwnerID);
+        cat->setThumbnailUUID(record.mThumbnailID);
+        cat->setVersion(record.mVersion);
+        categories.push_back(cat);
+    }
+
+    // Items: split the chunks into slices of roughly equal item counts and
+    // decode them on the general pool, or here if it isn't available
+    size_t total_items = 0;
+    for (const ChunkRecord& chunk : chunks)
+    {
+        total_items += chunk.mItemCount;
+    }
+    const size_t slice_target = total_items / LOAD_SLICES + 1;
+
+    struct Slice
+    {
+        size_t mBegin;
+        size_t mEnd;
+        LLInventoryModel::item_array_t mItems;
+        bool mSuccess{ true };
+    };
+    std::vector<Slice> slices;
+    for (size_t begin = 0; begin < chunks.size(); )
+    {
+        size_t end = begin;
+        size_t slice_items = 0;
+        while (end < chunks.size() && (end == begin || slice_items < slice_target))
+        {
+            slice_items += chunks[end++].mItemCount;
+        }
+        slices.push_back({ begin, end });
+        begin = end;
+    }
+
+    auto decode_slice = [&file, &chunks](Slice& slice)
+    {
+        for (size_t i = slice.mBegin; slice.mSuccess && i < slice.mEnd; ++i)
+        {
+            const ChunkRecord& chunk = chunks[i];
+            slice.mSuccess = decode_chunk(file.data() + chunk.mOffset, chunk.mSize, chunk, slice.mItems);
+        }
+    };
+
+    LL::WorkQueueBase::ptr_t queue = slices.size() > 1 ? LL::WorkQueueBase::getInstance("General") : nullptr;
+    std::vector<std::future<void>> pending;
+    for (Slice& slice : slices)
+    {
+        auto done = std::make_shared<std::promise<void>>();
+        std::future<void> future = done->get_future();
+        if (queue && queue->post([&decode_slice, &slice, done]()
+                                 {
+                                     decode_slice(slice);
+                                     done->set_value();
+                                 }))
+        {
+            pending.push_back(std::move(future));
+        }
+        else
+        {
+            decode_slice(slice);
+        }
+    }
+    for (std::future<void>& future : pending)
+    {
+        future.wait();
+    }
+
+    // Back on the main thread: the checks and fixups LLViewerInventoryItem::fromLLSD() does
+    items.reserve(items.size() + total_items);
+    for (Slice& slice : slices)
+    {
+        if (!slice.mSuccess)
+        {
+            LL_WARNS("Inventory") << "Inventory cache " << filename << " has a corrupt folder, ignoring the rest of it" << LL_ENDL;
+            break;
+        }
+        for (LLPointer<LLViewerInventoryItem>& item : slice.mItems)
+        {
+            if (item->getUUID().isNull())
+            {
+                LL_DEBUGS("Inventory") << "Ignoring inventory with null item id: " << item->getName() << LL_ENDL;
+            }
+            else if (item->LLInventoryItem::getType() == LLAssetType::AT_UNKNOWN)
+            {
+                cats_to_update.insert(item->getParentUUID());
+            }
+            else
+            {
+                item->localizeName();
+                items.push_back(item);
+            }
+        }
+    }
+
+    LL_INFOS("Inventory") << "Loaded " << categories.size() << " categories and " << items.size()
+                          << " items from " << chunks.size() << " folders in " << slices.size() << " slices" << LL_ENDL;
+    return true;
+}
+
+//static
+bool FSInventoryCache::save(const std::string& filename,
+                            const LLInventoryModel::cat_array_t& categories,
+                            const LLInventoryModel::item_array_t& items,
+                            const uuid_set_t& dirty_folders)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    if (filename.empty())
+    {
+        LL_ERRS("Inventory") << "Filename is Null!" << LL_ENDL;
+        return false;
+    }
+    LL_INFOS("Inventory") << "saving inventory to: (" << filename << ")" << LL_ENDL;
+
+    // Categories with a known version, as saveToFile() writes them
+    std::vector<CategoryRecord> cat_records;
+    std::string cat_pool;
+    std::map<LLUUID, S32> folder_versions;
+    for (const LLPointer<LLViewerInventoryCategory>& cat : categories)
+    {
+        folder_versions[cat->getUUID()] = cat->getVersion();
+        if (cat->getVersion() == LLViewerInventoryCategory::VERSION_UNKNOWN)
+        {
+            continue;
+        }
+        CategoryRecord record;
+        record.mID = cat->getUUID();
+        record.mParentID = cat->getParentUUID();
+        record.mOwnerID = cat->getOwnerID();
+        record.mThumbnailID = cat->getThumbnailUUID();
+        record.mVersion = cat->getVersion();
+        record.mPreferredType = cat->getPreferredType();
+        record.mNameOffset = (U32)cat_pool.size();
+        record.mNameLength = (U32)cat->getName().size();
+        cat_pool += cat->getName();
+        cat_records.push_back(record);
+    }
+
+    // Items by folder, sorted by id so that a chunk of the old file can be
+    // matched by comparing its id column
+    std::map<LLUUID, folder_items_t> folders;
+    for (const LLPointer<LLViewerInventoryItem>& item : items)
+    {
+        folders[item->getParentUUID()].push_back(item.get());
+    }
+    for (auto& folder : folders)
+    {
+        std::sort(folder.second.begin(), folder.second.end(),
+                  [](const LLViewerInventoryItem* lhs, const LLViewerInventoryItem* rhs) { return lhs->getUUID() < rhs->getUUID(); });
+    }
+
+    // Chunks of the previous file that may be copied over
+    LLMappedFile old_file;
+    std::map<LLUUID, ChunkRecord> old_chunks;
+    FileHeader old_header;
+    std::vector<ChunkRecord> chunk_list;
+    if (old_file.open(filename) && read_header(old_file, old_header)
+        && old_header.mInvCacheVersion == LLInventoryModel::getInvCacheVersion()
+        && read_chunks(old_file, old_header, chunk_list))
+    {
+        for (const ChunkRecord& chunk : chunk_list)
+        {
+            old_chunks[chunk.mParentID] = chunk;
+        }
+    }
+
+    // unique name, another instance may be saving the same cache
+    std::string temp_filename = gDirUtilp->getTempFilename();
+    LLFILE* fp = LLFile::fopen(temp_filename, "wb");
+    if (!fp)
+    {
+        LL_WARNS("Inventory") << "Failed to open file. Unable to save inventory to: " << temp_filename << LL_ENDL;
+        return false;
+    }
+
+    FileHeader header;
+    header.mMagic = FILE_MAGIC;
+    header.mFileVersion = FILE_VERSION;
+    header.mInvCacheVersion = LLInventoryModel::getInvCacheVersion();
+    header.mCategoryCount = (U32)cat_records.size();
+    header.mCategoryPoolSize = (U32)cat_pool.size();
+    header.mChunkCount = (U32)folders.size();
+
+    std::vector<ChunkRecord> chunks;
+    chunks.reserve(folders.size());
+    const long chunk_table_pos = (long)(sizeof(FileHeader) + cat_records.size() * sizeof(CategoryRecord) + cat_pool.size());
+    U64 offset = chunk_table_pos + folders.size() * sizeof(ChunkRecord);
+
+    bool success = fwrite(&header, sizeof(FileHeader), 1, fp) == 1
+        && (cat_records.empty() || fwrite(cat_records.data(), sizeof(CategoryRecord), cat_records.size(), fp) == cat_records.size())
+        && (cat_pool.empty() || fwrite(cat_pool.data(), cat_pool.size(), 1, fp) == 1)
+        && fseek(fp, (long)offset, SEEK_SET) == 0;
+
+    size_t reused = 0;
+    std::vector<U8> payload;
+    for (auto folder = folders.begin(); success && folder != folders.end(); ++folder)
+    {
+        const LLUUID& folder_id = folder->first;
+        const folder_items_t& folder_items = folder->second;
+        auto version_it = folder_versions.find(folder_id);
+        S32 version = version_it != folder_versions.end() ? version_it->second : LLViewerInventoryCategory::VERSION_UNKNOWN;
+
+        ChunkRecord chunk;
+        chunk.mParentID = folder_id;
+        chunk.mVersion = version;
+        chunk.mItemCount = (U32)folder_items.size();
+        chunk.mOffset = offset;
+
+        const U8* data = nullptr;
+        auto old_chunk = old_chunks.find(folder_id);
+        if (old_chunk != old_chunks.end()
+            && version != LLViewerInventoryCategory::VERSION_UNKNOWN
+            && old_chunk->second.mVersion == version
+            && old_chunk->second.mItemCount == chunk.mItemCount
+            && old_chunk->second.mSize >= chunk.mItemCount * ITEM_FIXED_SIZE
+            && dirty_folders.find(folder_id) == dirty_folders.end())
+        {
+            const U8* old_data = old_file.data() + old_chunk->second.mOffset;
+            bool same_items = true;
+            for (size_t i = 0; same_items && i < folder_items.size(); ++i)
+            {
+                same_items = memcmp(old_data + i * UUID_BYTES, folder_items[i]->getUUID().mData, UUID_BYTES) == 0;
+            }
+            if (same_items)
+            {
+                data = old_data;
+                chunk.mSize = old_chunk->second.mSize;
+                ++reused;
+            }
+        }
+        if (!data)
+        {
+            encode_chunk(folder_items, payload);
+            data = payload.data();
+            chunk.mSize = payload.size();
+        }
+
+        success = chunk.mSize == 0 || fwrite(data, (size_t)chunk.mSize, 1, fp) == 1;
+        offset += chunk.mSize;
+        chunks.push_back(chunk);
+    }
+
+    success = success
+        && fseek(fp, chunk_table_pos, SEEK_SET) == 0
+        && (chunks.empty() || fwrite(chunks.data(), sizeof(ChunkRecord), chunks.size(), fp) == chunks.size());
+    success = (fclose(fp) == 0) && success;
+    old_file.close();
+
+    if (!success)
+    {
+        LL_WARNS("Inventory") << "Failed to write inventory cache " << temp_filename << LL_ENDL;
+        LLFile::remove(temp_filename);
+        return false;
+    }
+
+    if (LLFile::replace(temp_filename, filename) != 0)
+    {
+        LL_WARNS("Inventory") << "Failed to move " << temp_filename << " to " << filename << LL_ENDL;
+        LLFile::remove(temp_filename, ENOENT);
+        return false;
+    }
+
+    LL_INFOS("Inventory") << "Inventory saved: " << cat_records.size() << " categories, " << items.size() << " items in "
+                          << chunks.size() << " folders, " << reused << " of them unchanged." << LL_ENDL;
+    return true;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file fsinventorycache.h
+ * @brief Binary, chunked inventory cache
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_INVENTORYCACHE_H
+#define FS_INVENTORYCACHE_H
+
+#include "llinventorymodel.h"
+
+// Binary replacement for the gzipped LLSD inventory cache written by
+// LLInventoryModel::saveToFile(). Items are stored column by column in one
+// chunk per folder, so the file loads without any LLSD parsing, chunks are
+// decoded in parallel on the general thread pool, and saving only encodes
+// the folders that changed since the file was last written.
+class FSInventoryCache
+{
+public:
+    // Cache file for the given inventory owner, next to the LLSD one
+    static std::string getFilename(const LLUUID& owner_id);
+
+    // Same contract as LLInventoryModel::loadFromFile()
+    static bool load(const std::string& filename,
+                     LLInventoryModel::cat_array_t& categories,
+                     LLInventoryModel::item_array_t& items,
+                     LLInventoryModel::changed_items_t& cats_to_update,
+                     bool& is_cache_obsolete);
+
+    // Write the cache, copying the chunks of folders that are not in
+    // dirty_folders and whose version and item ids are unchanged from the
+    // existing file instead of encoding them again.
+    static bool save(const std::string& filename,
+                     const LLInventoryModel::cat_array_t& categories,
+                     const LLInventoryModel::item_array_t& items,
+                     const uuid_set_t& dirty_folders);
+};
+
+#endif // FS_INVENTORYCACHE_H
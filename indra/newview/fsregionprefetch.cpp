@@ -0,0 +1,475 @@
+/**
+ * @file fsregionprefetch.cpp
+ * @brief Per-region asset prefetch profiles
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "fsregionprefetch.h"
+
+#include "llagent.h"
+#include "llappviewer.h"
+#include "llcallbacklist.h"
+#include "lldir.h"
+#include "llfilesystem.h"
+#include "llmeshrepository.h"
+#include "lltexturecache.h"
+#include "llviewercontrol.h"
+#include "llviewerregion.h"
+#include "llviewertexture.h"
+#include "llviewertexturelist.h"
+#include "llvocache.h"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr U32 PROFILE_MAGIC = 0x46504653; // "FSPF"
+    constexpr U32 PROFILE_VERSION = 1;
+
+    // Entries not requested during this many visits are dropped
+    constexpr U32 MAX_UNUSED_VISITS = 8;
+    constexpr size_t MAX_PROFILE_ENTRIES = 4096;
+
+    constexpr U32 PREFETCH_REQUESTS_PER_FRAME = 32;
+    // Texture stats for a prefetched texture: enough to get a small mip out
+    // of the cache, too little to compete with what is on screen
+    constexpr F32 PREFETCH_PIXEL_AREA = 64.f * 64.f;
+
+    // How long prefetched textures are held and watched for use after arrival
+    constexpr F32 WATCH_TIME = 120.f;
+    constexpr F32 WATCH_INTERVAL = 1.f;
+
+    struct ProfileHeader
+    {
+        U32 mMagic;
+        U32 mVersion;
+        U32 mVisits;
+        U32 mNumEntries;
+    };
+
+    struct ProfileRecord
+    {
+        LLUUID  mID;
+        S8      mType;
+        S8      mLevel;
+        U16     mPad;
+        F32     mPixelArea;
+        U32     mUseCount;
+        U32     mLastVisit;
+    };
+    static_assert(sizeof(ProfileRecord) == 32, "ProfileRecord layout changed");
+}
+
+FSRegionPrefetch::FSRegionPrefetch()
+{
+}
+
+void FSRegionPrefetch::init()
+{
+    if (!mRegionChangedConnection.connected())
+    {
+        mRegionChangedConnection = gAgent.addRegionChangedCallback(boost::bind(&FSRegionPrefetch::onRegionChanged, this));
+    }
+    onRegionChanged();
+}
+
+void FSRegionPrefetch::cleanupSingleton()
+{
+    if (mRegionChangedConnection.connected())
+    {
+        mRegionChangedConnection.disconnect();
+    }
+
+    if (mRegionHandle)
+    {
+        saveProfile();
+        logStats();
+    }
+    mWatchedTextures.clear();
+    mPrefetchQueue.clear();
+}
+
+void FSRegionPrefetch::recordTexture(const LLUUID& id, S32 discard, F32 pixel_area)
+{
+    record(id, LLAssetType::AT_TEXTURE, discard, pixel_area);
+}
+
+void FSRegionPrefetch::recordMesh(const LLUUID& id, S32 lod)
+{
+    record(id, LLAssetType::AT_MESH, lod, 0.f);
+}
+
+void FSRegionPrefetch::record(const LLUUID& id, LLAssetType::EType type, S32 level, F32 pixel_area)
+{
+    if (!mRegionHandle || id.isNull())
+    {
+        return;
+    }
+
+    const bool first_request = mRequested.insert(id).second;
+    if (first_request)
+    {
+        if (mPrefetched.count(id))
+        {
+            ++mRegionStats.mHits;
+            ++mSessionStats.mHits;
+        }
+        else
+        {
+            ++mRegionStats.mMisses;
+            ++mSessionStats.mMisses;
+        }
+    }
+
+    Entry& entry = mProfile[id];
+    if (entry.mUseCount == 0)
+    {
+        entry.mType = type;
+        entry.mLevel = level;
+    }
+    else if (level >= 0)
+    {
+        // Textures keep the lowest discard level, meshes the highest LOD
+        entry.mLevel = (type == LLAssetType::AT_TEXTURE) ? llmin(entry.mLevel, level) : llmax(entry.mLevel, level);
+    }
+    entry.mPixelArea = llmax(entry.mPixelArea, pixel_area);
+
+    if (first_request || entry.mLastVisit != mVisit)
+    {
+        ++entry.mUseCount;
+        entry.mLastVisit = mVisit;
+    }
+}
+
+void FSRegionPrefetch::onRegionChanged()
+{
+    LLViewerRegion* regionp = gAgent.getRegion();
+    const U64 handle = regionp ? regionp->getHandle() : 0;
+    if (handle == mRegionHandle)
+    {
+        return;
+    }
+
+    if (mRegionHandle)
+    {
+        saveProfile();
+        logStats();
+    }
+
+    mProfile.clear();
+    mRequested.clear();
+    mPrefetched.clear();
+    mPrefetchQueue.clear();
+    mWatchedTextures.clear();
+    mRegionStats = Stats();
+    mVisit = 1;
+
+    mRegionHandle = handle;
+    if (!mRegionHandle)
+    {
+        return;
+    }
+
+    loadProfile(mRegionHandle);
+
+    static LLCachedControl<bool> prefetch_enabled(gSavedSettings, "FSRegionPrefetch");
+    static LLCachedControl<U32> max_assets(gSavedSettings, "FSRegionPrefetchMaxAssets");
+    if (!prefetch_enabled || mProfile.empty())
+    {
+        return;
+    }
+
+    // Rank by how many visits asked for the asset, then by how recently.
+    // The queue is consumed from the back, so the best entries go last.
+    std::vector<std::pair<LLUUID, const Entry*> > ranked;
+    ranked.reserve(mProfile.size());
+    for (const auto& [id, entry] : mProfile)
+    {
+        ranked.emplace_back(id, &entry);
+    }
+    std::sort(ranked.begin(), ranked.end(),
+              [](const std::pair<LLUUID, const Entry*>& lhs, const std::pair<LLUUID, const Entry*>& rhs)
+              {
+                  if (lhs.second->mUseCount != rhs.second->mUseCount)
+                  {
+                      return lhs.second->mUseCount > rhs.second->mUseCount;
+                  }
+                  if (lhs.second->mLastVisit != rhs.second->mLastVisit)
+                  {
+                      return lhs.second->mLastVisit > rhs.second->mLastVisit;
+                  }
+                  return lhs.second->mPixelArea > rhs.second->mPixelArea;
+              });
+    if (ranked.size() > (size_t)max_assets())
+    {
+        ranked.resize(max_assets());
+    }
+
+    mPrefetchQueue.reserve(ranked.size());
+    for (auto it = ranked.rbegin(); it != ranked.rend(); ++it)
+    {
+        mPrefetchQueue.push_back(it->first);
+    }
+
+    mArrivalTimer.reset();
+    mWatchTimer.reset();
+    if (!mIdleRunning && !mPrefetchQueue.empty())
+    {
+        mIdleRunning = true;
+        doOnIdleRepeating([]()
+                          {
+                              return !FSRegionPrefetch::instanceExists() || FSRegionPrefetch::instance().onIdle();
+                          });
+    }
+}
+
+bool FSRegionPrefetch::onIdle()
+{
+    for (U32 i = 0; i < PREFETCH_REQUESTS_PER_FRAME && !mPrefetchQueue.empty(); ++i)
+    {
+        const LLUUID id = mPrefetchQueue.back();
+        mPrefetchQueue.pop_back();
+
+        profile_t::const_iterator found = mProfile.find(id);
+        if (found == mProfile.end() || mRequested.count(id))
+        {
+            // Already asked for by the region itself
+            continue;
+        }
+        const Entry& entry = found->second;
+
+        if (entry.mType == LLAssetType::AT_TEXTURE)
+        {
+            // Only warm textures we can read locally, like mesh headers below
+            if (LLViewerTexture::isInvisiprim(id) || !LLAppViewer::getTextureCache()->isInCache(id))
+            {
+                continue;
+            }
+
+            LLViewerFetchedTexture* image = LLViewerTextureManager::getFetchedTexture(id, FTT_DEFAULT, MIPMAP_TRUE, LLGLTexture::BOOST_NONE, LLViewerTexture::LOD_TEXTURE);
+            if (!image || image->getTotalNumFaces() > 0)
+            {
+                // Already on screen, nothing to gain
+                continue;
+            }
+            image->addTextureStats(PREFETCH_PIXEL_AREA);
+            mWatchedTextures.emplace_back(image);
+        }
+        else if (entry.mType == LLAssetType::AT_MESH)
+        {
+            // Only warm headers we can read locally; anything else would
+            // just add to the HTTP queue the region's own requests use
+            if (!LLFileSystem::getExists(id, LLAssetType::AT_MESH))
+            {
+                continue;
+            }
+            gMeshRepo.prefetchMeshHeader(id);
+        }
+        else
+        {
+            continue;
+        }
+
+        mPrefetched.insert(id);
+        ++mRegionStats.mPrefetched;
+        ++mSessionStats.mPrefetched;
+    }
+
+    if (mWatchTimer.getElapsedTimeF32() >= WATCH_INTERVAL)
+    {
+        mWatchTimer.reset();
+        checkWatchedTextures();
+    }
+
+    if (mArrivalTimer.getElapsedTimeF32() >= WATCH_TIME)
+    {
+        // Whatever hasn't been drawn by now may go back to the texture list
+        mWatchedTextures.clear();
+    }
+
+    mIdleRunning = !mPrefetchQueue.empty() || !mWatchedTextures.empty();
+    return !mIdleRunning;
+}
+
+void FSRegionPrefetch::checkWatchedTextures()
+{
+    // A texture that finished loading before anything drew it never goes
+    // through a fetch request again, so its use has to be noticed here
+    auto it = mWatchedTextures.begin();
+    while (it != mWatchedTextures.end())
+    {
+        LLViewerFetchedTexture* image = *it;
+        if (image->getTotalNumFaces() > 0)
+        {
+            record(image->getID(), LLAssetType::AT_TEXTURE, -1, image->getMaxVirtualSize());
+            it = mWatchedTextures.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+bool FSRegionPrefetch::loadProfile(U64 handle)
+{
+    const std::string filename = LLVOCache::getPrefetchProfileFilename(handle);
+    LLFILE* fp = LLFile::fopen(filename, "rb");
+    if (!fp)
+    {
+        return false;
+    }
+
+    bool success = false;
+    ProfileHeader header;
+    if (fread(&header, sizeof(header), 1, fp) == 1 &&
+        header.mMagic == PROFILE_MAGIC && header.mVersion == PROFILE_VERSION &&
+        header.mNumEntries <= MAX_PROFILE_ENTRIES)
+    {
+        std::vector<ProfileRecord> records(header.mNumEntries);
+        if (records.empty() || fread(records.data(), sizeof(ProfileRecord), records.size(), fp) == records.size())
+        {
+            for (const ProfileRecord& record : records)
+            {
+                Entry& entry = mProfile[record.mID];
+                entry.mType = (LLAssetType::EType)record.mType;
+                entry.mLevel = record.mLevel;
+                entry.mPixelArea = record.mPixelArea;
+                entry.mUseCount = record.mUseCount;
+                entry.mLastVisit = record.mLastVisit;
+            }
+            mVisit = header.mVisits + 1;
+            success = true;
+        }
+    }
+    LLFile::close(fp);
+
+    if (!success)
+    {
+        LL_WARNS() << "Discarding unreadable prefetch profile " << filename << LL_ENDL;
+        mProfile.clear();
+        LLFile::remove(filename);
+    }
+    return success;
+}
+
+void FSRegionPrefetch::saveProfile()
+{
+    if (!mRegionHandle || mProfile.empty())
+    {
+        return;
+    }
+
+    std::vector<std::pair<LLUUID, const Entry*> > kept;
+    kept.reserve(mProfile.size());
+    for (const auto& [id, entry] : mProfile)
+    {
+        if (mVisit - entry.mLastVisit < MAX_UNUSED_VISITS)
+        {
+            kept.emplace_back(id, &entry);
+        }
+    }
+    if (kept.size() > MAX_PROFILE_ENTRIES)
+    {
+        std::nth_element(kept.begin(), kept.begin() + MAX_PROFILE_ENTRIES, kept.end(),
+                         [](const std::pair<LLUUID, const Entry*>& lhs, const std::pair<LLUUID, const Entry*>& rhs)
+                         {
+                             if (lhs.second->mUseCount != rhs.second->mUseCount)
+                             {
+                                 return lhs.second->mUseCount > rhs.second->mUseCount;
+                             }
+                             return lhs.second->mLastVisit > rhs.second->mLastVisit;
+                         });
+        kept.resize(MAX_PROFILE_ENTRIES);
+    }
+
+    std::vector<ProfileRecord> records;
+    records.reserve(kept.size());
+    for (const auto& [id, entry] : kept)
+    {
+        ProfileRecord record;
+        record.mID = id;
+        record.mType = (S8)entry->mType;
+        record.mLevel = (S8)llclamp(entry->mLevel, -1, 127);
+        record.mPad = 0;
+        record.mPixelArea = entry->mPixelArea;
+        record.mUseCount = entry->mUseCount;
+        record.mLastVisit = entry->mLastVisit;
+        records.push_back(record);
+    }
+
+    ProfileHeader header;
+    header.mMagic = PROFILE_MAGIC;
+    header.mVersion = PROFILE_VERSION;
+    header.mVisits = mVisit;
+    header.mNumEntries = (U32)records.size();
+
+    const std::string filename = LLVOCache::getPrefetchProfileFilename(mRegionHandle);
+    // A temporary file of our own, so that viewers sharing the cache don't
+    // write over each other's
+    const std::string temp_filename = gDirUtilp->getTempFilename();
+    LLFILE* fp = LLFile::fopen(temp_filename, "wb");
+    if (!fp)
+    {
+        LL_DEBUGS() << "Unable to write prefetch profile " << temp_filename << LL_ENDL;
+        return;
+    }
+
+    bool success = fwrite(&header, sizeof(header), 1, fp) == 1;
+    if (success && !records.empty())
+    {
+        success = fwrite(records.data(), sizeof(ProfileRecord), records.size(), fp) == records.size();
+    }
+    success = (LLFile::close(fp) == 0) && success;
+
+    if (!success || LLFile::replace(temp_filename, filename) != 0)
+    {
+        LL_WARNS() << "Failed to write prefetch profile " << filename << LL_ENDL;
+        LLFile::remove(temp_filename, ENOENT);
+    }
+}
+
+void FSRegionPrefetch::logStats()
+{
+    if (!mRegionStats.mPrefetched && !mRegionStats.mHits && !mRegionStats.mMisses)
+    {
+        return;
+    }
+
+    U32 region_x, region_y;
+    grid_from_region_handle(mRegionHandle, &region_x, &region_y);
+
+    const U32 requested = mRegionStats.mHits + mRegionStats.mMisses;
+    const U32 session_requested = mSessionStats.mHits + mSessionStats.mMisses;
+    LL_INFOS() << "Region " << region_x << "," << region_y << " visit " << mVisit
+               << ": prefetched " << mRegionStats.mPrefetched
+               << ", hits " << mRegionStats.mHits << "/" << requested
+               << " (" << (requested ? 100.f * mRegionStats.mHits / requested : 0.f) << "%)"
+               << ", wasted " << (mRegionStats.mPrefetched - llmin(mRegionStats.mPrefetched, mRegionStats.mHits))
+               << ". Session: prefetched " << mSessionStats.mPrefetched
+               << ", hits " << mSessionStats.mHits << "/" << session_requested
+               << LL_ENDL;
+}
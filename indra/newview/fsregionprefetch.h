@@ -0,0 +1,116 @@
+/**
+ * @file fsregionprefetch.h
+ * @brief Per-region asset prefetch profiles
+ *
+ * $LicenseInfo:firstyear=2026&license=fsviewerlgpl$
+ * Phoenix Firestorm Viewer Source Code
+ * Copyright (C) 2026, The Phoenix Firestorm Project, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * The Phoenix Firestorm Project, Inc., 1831 Oakwood Drive, Fairmont, Minnesota 56031-3225 USA
+ * http://www.firestormviewer.org
+ * $/LicenseInfo$
+ */
+
+#ifndef FS_REGIONPREFETCH_H
+#define FS_REGIONPREFETCH_H
+
+#include "llassettype.h"
+#include "llframetimer.h"
+#include "llpointer.h"
+#include "llsingleton.h"
+#include "lluuid.h"
+
+#include <boost/signals2.hpp>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class LLViewerFetchedTexture;
+
+// Remembers which textures and meshes were requested while the agent was in
+// a region and, the next time the agent arrives there, requests the most
+// used of them ahead of the object updates that would ask for them. The
+// profiles live next to the region's object cache files.
+class FSRegionPrefetch : public LLSingleton<FSRegionPrefetch>
+{
+    LOG_CLASS(FSRegionPrefetch);
+
+    LLSINGLETON(FSRegionPrefetch);
+    virtual ~FSRegionPrefetch() = default;
+
+public:
+    void init();
+
+    // Called from the main thread whenever a texture fetch or mesh LOD load
+    // is started
+    void recordTexture(const LLUUID& id, S32 discard, F32 pixel_area);
+    void recordMesh(const LLUUID& id, S32 lod);
+
+    struct Stats
+    {
+        U32 mPrefetched{ 0 };   // assets requested ahead of time
+        U32 mHits{ 0 };         // ...that the region then asked for
+        U32 mMisses{ 0 };       // assets the region asked for that weren't prefetched
+    };
+    const Stats& getRegionStats() const { return mRegionStats; }
+    const Stats& getSessionStats() const { return mSessionStats; }
+
+private:
+    void cleanupSingleton() override;
+
+    void onRegionChanged();
+    void record(const LLUUID& id, LLAssetType::EType type, S32 level, F32 pixel_area);
+
+    bool loadProfile(U64 handle);
+    void saveProfile();
+    void logStats();
+
+    // Idle callback issuing a few requests per frame, then watching the
+    // prefetched textures for a while to see which of them get used
+    bool onIdle();
+    void checkWatchedTextures();
+
+    struct Entry
+    {
+        LLAssetType::EType  mType{ LLAssetType::AT_NONE };
+        S32                 mLevel{ 0 };        // best discard level or LOD asked for
+        F32                 mPixelArea{ 0.f };  // textures only
+        U32                 mUseCount{ 0 };     // visits during which it was requested
+        U32                 mLastVisit{ 0 };
+    };
+    typedef std::unordered_map<LLUUID, Entry> profile_t;
+
+    U64                         mRegionHandle{ 0 };
+    U32                         mVisit{ 0 };        // visits to the region so far, this one included
+    profile_t                   mProfile;           // loaded profile plus this visit's requests
+    std::unordered_set<LLUUID>  mRequested;         // this visit
+    std::unordered_set<LLUUID>  mPrefetched;        // this visit
+    std::vector<LLUUID>         mPrefetchQueue;
+    // Prefetched textures are held until something draws them or until the
+    // watch time is over, so the texture list doesn't drop them first
+    std::vector<LLPointer<LLViewerFetchedTexture> > mWatchedTextures;
+    LLFrameTimer                mArrivalTimer;
+    LLFrameTimer                mWatchTimer;
+    bool                        mIdleRunning{ false };
+
+    Stats                       mRegionStats;
+    Stats                       mSessionStats;
+
+    boost::signals2::connection mRegionChangedConnection;
+};
+
+#endif // FS_REGIONPREFETCH_H
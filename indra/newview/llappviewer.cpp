@@ -70,6 +70,7 @@
 #include "lltexturestats.h"
 #include "lltrace.h"
 #include "lltracethreadrecorder.h"
+#include "llflightrecorder.h" // <FS/> Frame hitch flight recorder
 #include "llviewerwindow.h"
 #include "llviewerdisplay.h"
 #include "llviewermedia.h"
@@ -101,6 +102,7 @@
 #include "llprogressview.h"
 #include "llvocache.h"
 #include "lldiskcache.h"
+#include "llfilesystem.h" // <FS> Batched asynchronous reads
 #include "llvopartgroup.h"
 // [SL:KB] - Patch: Appearance-Misc | Checked: 2013-02-12 (Catznip-3.4)
 #include "llappearancemgr.h"
@@ -289,6 +291,7 @@ using namespace LL;
 
 #include "fsradar.h"
 #include "fsassetblacklist.h"
+#include "fscachescrubber.h" // <FS/> Cache integrity checks
 
 // #include "fstelemetry.h" // <FS:Beq> Tracy profiler support
 
@@ -720,6 +723,7 @@ LLAppViewer::LLAppViewer()
     mRandomizeFramerate(LLCachedControl<bool>(gSavedSettings,"Randomize Framerate", false)),
     mPeriodicSlowFrame(LLCachedControl<bool>(gSavedSettings,"Periodic Slow Frame", false)),
     mFastTimerLogThread(NULL),
+    mCacheScrubberThread(NULL), // <FS/> Cache integrity checks
     mSettingsLocationList(NULL),
     mIsFirstRun(false),
     mSaveSettingsOnExit(true),      // <FS:Zi> Backup Settings
@@ -1657,6 +1661,11 @@ bool LLAppViewer::doFrame()
 
             LLTrace::get_frame_recording().nextPeriod();
             LLTrace::BlockTimer::logStats();
+            // <FS> Frame hitch flight recorder: long frames are expected while logging in or teleporting
+            LLTrace::FlightRecorder::setPaused(LLStartUp::getStartupState() < STATE_STARTED
+                                               || gAgent.getTeleportState() != LLAgent::TELEPORT_NONE);
+            LLTrace::FlightRecorder::endFrame();
+            // </FS>
         }
 
         LLTrace::get_thread_recorder()->pullFromChildren();
@@ -2447,6 +2456,12 @@ bool LLAppViewer::cleanup()
     // shotdown all worker threads before deleting them in case of co-dependencies
     mAppCoreHttp.requestStop();
     sTextureFetch->shutdown();
+    // <FS> Cache integrity checks: the scrubber uses the texture cache
+    if (mCacheScrubberThread)
+    {
+        mCacheScrubberThread->shutdown();
+    }
+    // </FS>
     sTextureCache->shutdown();
     sImageDecodeThread->shutdown();
     sPurgeDiskCacheThread->shutdown();
@@ -2454,6 +2469,7 @@ bool LLAppViewer::cleanup()
     {
         mGeneralThreadPool->close();
     }
+    LLFileSystem::cleanupReadThreadPool(); // <FS> Batched asynchronous reads
 
     sTextureFetch->shutDownTextureCacheThread() ;
     LLLFSThread::sLocal->shutdown();
@@ -2483,6 +2499,10 @@ bool LLAppViewer::cleanup()
     mFastTimerLogThread = NULL;
     delete sPurgeDiskCacheThread;
     sPurgeDiskCacheThread = NULL;
+    // <FS> Cache integrity checks
+    delete mCacheScrubberThread;
+    mCacheScrubberThread = NULL;
+    // </FS>
     delete mGeneralThreadPool;
     mGeneralThreadPool = NULL;
 
@@ -2545,6 +2565,11 @@ bool LLAppViewer::cleanup()
 
     ll_close_fail_log();
 
+    // <FS> Frame hitch flight recorder: finish any trace before logging stops
+    LLTrace::FlightRecorder::setEnabled(false);
+    LLTrace::FlightRecorder::waitForDump();
+    // </FS>
+    LLError::setAsyncLogging(false); // <FS/> Asynchronous logging: write what is still queued
     LLError::LLCallStacks::cleanup();
     LL::GLTFSceneManager::deleteSingleton();
     LLEnvironment::deleteSingleton();
@@ -2583,7 +2608,11 @@ void LLAppViewer::initGeneralThread()
         return;
     }
 
-    mGeneralThreadPool = new LL::ThreadPool("General", 3);
+    // <FS> General work is many short items, some posting follow-up work:
+    // give each worker its own deque to take them from
+    //mGeneralThreadPool = new LL::ThreadPool("General", 3);
+    mGeneralThreadPool = new LL::WorkStealingThreadPool("General", 3);
+    // </FS>
     mGeneralThreadPool->start();
 }
 
@@ -2621,6 +2650,9 @@ bool LLAppViewer::initThreads()
     threadCounts["ImageDecode"] = image_decode_count;
     gSavedSettings.setLLSD("ThreadPoolSizes", threadCounts);
 
+    // <FS> Batched asynchronous cache reads; disk bound, so a few threads suffice
+    LLFileSystem::initReadThreadPool(llclamp(cores / 2, 2, 4));
+
     // Image decoding
     LLAppViewer::sImageDecodeThread = new LLImageDecodeThread(enable_threads && true);
     LLAppViewer::sTextureCache = new LLTextureCache(enable_threads && true);
@@ -3182,6 +3214,11 @@ bool LLAppViewer::initConfiguration()
 
     // <FS:Ansariel> Debug setting to disable log throttle
     nd::logging::setThrottleEnabled(gSavedSettings.getBOOL("FSEnableLogThrottle"));
+    LLError::setAsyncLogging(gSavedSettings.getBOOL("FSAsyncLogging")); // <FS/> Asynchronous logging
+    // <FS> Frame hitch flight recorder
+    LLTrace::FlightRecorder::setThreadName("Main");
+    handleFlightRecorderChanged();
+    // </FS>
 
     // - apply command line settings
     if (!clp.notify())
@@ -4983,7 +5020,13 @@ bool LLAppViewer::initCache()
 {
     mPurgeCache = false;
     bool read_only = mSecondInstance;
-    LLAppViewer::getTextureCache()->setReadOnly(read_only) ;
+    // <FS> Viewers that share the texture cache can all write to it. Purges
+    // and the object cache stay with the first instance.
+    //LLAppViewer::getTextureCache()->setReadOnly(read_only) ;
+    const bool shared_texture_cache = gSavedSettings.getBOOL("FSSharedCache");
+    LLAppViewer::getTextureCache()->setSharedCache(shared_texture_cache);
+    LLAppViewer::getTextureCache()->setReadOnly(read_only && !shared_texture_cache);
+    // </FS>
     LLVOCache::initParamSingleton(read_only);
 
     // initialize the new disk cache using saved settings
@@ -5087,7 +5130,11 @@ bool LLAppViewer::initCache()
     const std::string cache_dir = gDirUtilp->getExpandedFilename(LL_PATH_CACHE, cache_dir_name);
     // <FS:Beq> Improve cache purge triggering
     // LLDiskCache::initParamSingleton(cache_dir, disk_cache_size, enable_cache_debug_info);
-    LLDiskCache::initParamSingleton(cache_dir, disk_cache_size, enable_cache_debug_info, gSavedSettings.getF32("FSDiskCacheHighWaterPercent"), gSavedSettings.getF32("FSDiskCacheLowWaterPercent"));
+    // <FS> Pack-file storage for small assets
+    //LLDiskCache::initParamSingleton(cache_dir, disk_cache_size, enable_cache_debug_info, gSavedSettings.getF32("FSDiskCacheHighWaterPercent"), gSavedSettings.getF32("FSDiskCacheLowWaterPercent"));
+    const U32 packed_entry_max_bytes = gSavedSettings.getBOOL("FSDiskCachePackSmallAssets") ? LLPackedCache::DEFAULT_MAX_ENTRY_SIZE : 0;
+    LLDiskCache::initParamSingleton(cache_dir, disk_cache_size, enable_cache_debug_info, gSavedSettings.getF32("FSDiskCacheHighWaterPercent"), gSavedSettings.getF32("FSDiskCacheLowWaterPercent"), packed_entry_max_bytes);
+    // </FS>
     // </FS:Beq>
 
     if (!read_only)
@@ -5120,6 +5167,14 @@ bool LLAppViewer::initCache()
     }
     LLAppViewer::getPurgeDiskCacheThread()->start();
 
+    // <FS> Cache integrity checks
+    if (U32 scrub_rate = gSavedSettings.getU32("FSCacheScrubRate"); scrub_rate > 0 && (!read_only || shared_texture_cache))
+    {
+        mCacheScrubberThread = new FSCacheScrubberThread(LLAppViewer::getTextureCache(), scrub_rate * 1024);
+        mCacheScrubberThread->start();
+    }
+    // </FS>
+
     // <FS:Ansariel> FIRE-13066
     if (!mPurgeCache && mPurgeTextures && !read_only) // <FS:Beq> no need to purge textures if we already purged the cache above
     {
@@ -324,7 +324,7 @@ private:
     static LLImageDecodeThread* sImageDecodeThread;
     static LLTextureFetch* sTextureFetch;
     static LLPurgeDiskCacheThread* sPurgeDiskCacheThread;
-    LL::ThreadPool* mGeneralThreadPool;
+    LL::WorkStealingThreadPool* mGeneralThreadPool; // <FS/> was LL::ThreadPool
 
     S32 mNumSessions;
 
@@ -352,6 +352,7 @@ private:
 
     // For performance and metric gathering
     class LLThread* mFastTimerLogThread;
+    class FSCacheScrubberThread* mCacheScrubberThread; // <FS/> Cache integrity checks
 
     // for tracking viewer<->region circuit death
     bool mAgentRegionLastAlive;
@@ -1446,7 +1446,10 @@ void LLFloaterBvhPreview::onBtnOK(void* userdata)
             LLFileSystem file(motionp->getID(), LLAssetType::AT_ANIMATION, LLFileSystem::APPEND);
 
             S32 size = dp.getCurrentSize();
-            if (file.write((U8*)buffer, size))
+            // <FS> Pack-file storage: store it before the upload reads it
+            //if (file.write((U8*)buffer, size))
+            if (file.write((U8*)buffer, size) && file.close())
+            // </FS>
             {
                 std::string name = floaterp->getChild<LLUICtrl>("name_form")->getValue().asString();
                 std::string desc = floaterp->getChild<LLUICtrl>("description_form")->getValue().asString();
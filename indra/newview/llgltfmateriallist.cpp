@@ -168,11 +168,9 @@ namespace
 
 void LLGLTFMaterialList::applyOverrideMessage(LLMessageSystem* msg, const std::string& data_in)
 {
-    std::istringstream str(data_in);
-
     LLSD data;
 
-    LLSDSerialize::fromNotation(data, str, data_in.length());
+    LLSDSerialize::fromNotation(data, (const U8*)data_in.data(), data_in.length());
 
     const LLHost& host = msg->getSender();
 
@@ -513,7 +511,7 @@ void LLGLTFMaterialList::onAssetLoadComplete(const LLUUID& id, LLAssetType::ETyp
     {
 
         LL::WorkQueue::ptr_t main_queue = LL::WorkQueue::getInstance("mainloop");
-        LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+        LL::WorkQueueBase::ptr_t general_queue = LL::WorkQueueBase::getInstance("General");
 
         main_queue->postTo(
             general_queue,
@@ -87,6 +87,7 @@
 
 #include "aoengine.h"
 #include "fsfloaterwearablefavorites.h"
+#include "fsinventorycache.h"
 #include "fslslbridge.h"
 #ifdef OPENSIM
 #include "llviewernetwork.h"
@@ -182,8 +183,7 @@ public:
         sparam_t::const_iterator it = strings.begin();
         if (it != strings.end()) {
             const std::string& llsdRaw = *it++;
-            std::istringstream llsdData(llsdRaw);
-            if (!LLSDSerialize::deserialize(message, llsdData, llsdRaw.length()))
+            if (!LLSDSerialize::deserialize(message, (const U8*)llsdRaw.data(), llsdRaw.length()))
             {
                 LL_WARNS() << "LLDispatchBulkUpdateInventory: Attempted to read parameter data into LLSD but failed:" << llsdRaw << LL_ENDL;
             }
@@ -2385,6 +2385,19 @@ void LLInventoryModel::addChangedMask(U32 mask, const LLUUID& referent)
         mModifyMask |= mask;
     }
 
+    // <FS> The item's folder has to be written again to the binary cache
+    static LLCachedControl<bool> binary_cache(gSavedSettings, "FSBinaryInventoryCache");
+    if (binary_cache && referent.notNull())
+    {
+        const LLViewerInventoryItem* item = getItem(referent);
+        mCacheDirtyFolders.insert(item ? item->getParentUUID() : referent);
+    }
+    else if (referent.notNull())
+    {
+        mCacheDirtyFoldersIncomplete = true;
+    }
+    // </FS>
+
     bool needs_update = false;
     if (referent.notNull())
     {
@@ -2515,6 +2528,34 @@ void LLInventoryModel::cache(
         items,
         INCLUDE_TRASH,
         can_cache);
+    // <FS> Binary inventory cache. The LLSD cache below is still written as
+    // well, as the fallback for a binary cache that can't be read, until the
+    // binary format has been out for a release.
+    static LLCachedControl<bool> binary_cache(gSavedSettings, "FSBinaryInventoryCache");
+    if (binary_cache)
+    {
+        if (mCacheDirtyFoldersIncomplete)
+        {
+            // the setting was off for a while, none of the old chunks can be trusted
+            LLFile::remove(FSInventoryCache::getFilename(agent_id), ENOENT);
+        }
+        if (FSInventoryCache::save(FSInventoryCache::getFilename(agent_id), categories, items, mCacheDirtyFolders))
+        {
+            // these folders are written out now
+            for (const LLPointer<LLViewerInventoryCategory>& cat : categories)
+            {
+                mCacheDirtyFolders.erase(cat->getUUID());
+            }
+            // and the cache was rebuilt from scratch if it had to be
+            mCacheDirtyFoldersIncomplete = false;
+        }
+    }
+    else
+    {
+        LLFile::remove(FSInventoryCache::getFilename(agent_id), ENOENT);
+    }
+    // </FS>
+
     // Use temporary file to avoid potential conflicts with other
     // instances (even a 'read only' instance unzips into a file)
     std::string temp_file = gDirUtilp->getTempFilename();
@@ -2852,6 +2893,13 @@ bool LLInventoryModel::loadSkeleton(
             LLFile::remove(inventory_filename);
         }
 
+        inventory_filename = FSInventoryCache::getFilename(owner_id);
+        if (LLFile::isfile(inventory_filename))
+        {
+            LL_INFOS("LLInventoryModel") << "Purging inventory cache file: " << inventory_filename << LL_ENDL;
+            LLFile::remove(inventory_filename);
+        }
+
         // also delete library cache if inventory cache is purged, so issues with EEP settings going missing
         // and bridge objects not being found can be resolved
         // <FS:Beq> correct OS library owner.
@@ -2871,6 +2919,13 @@ bool LLInventoryModel::loadSkeleton(
             LLFile::remove(inventory_filename);
         }
 
+        inventory_filename = FSInventoryCache::getFilename(gInventory.getLibraryOwnerID());
+        if (LLFile::isfile(inventory_filename))
+        {
+            LL_INFOS("LLInventoryModel") << "Purging library cache file: " << inventory_filename << LL_ENDL;
+            LLFile::remove(inventory_filename);
+        }
+
         LL_INFOS("LLInventoryModel") << "Clear inventory cache marker removed: " << delete_cache_marker << LL_ENDL;
         LLFile::remove(delete_cache_marker);
     }
@@ -2932,9 +2987,24 @@ bool LLInventoryModel::loadSkeleton(
         const S32 NO_VERSION = LLViewerInventoryCategory::VERSION_UNKNOWN;
         std::string gzip_filename(inventory_filename);
         gzip_filename.append(".gz");
-        LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
+        // <FS> Prefer the binary cache if there is one, it needs no
+        // unpacking. The LLSD cache is still written next to it, and is read
+        // instead if the binary cache can't be.
+        std::string binary_filename = FSInventoryCache::getFilename(owner_id);
+        bool is_binary_cache_obsolete = false;
+        bool binary_cache_loaded = LLFile::isfile(binary_filename)
+            && FSInventoryCache::load(binary_filename, categories, items, categories_to_update, is_binary_cache_obsolete);
+        if (!binary_cache_loaded)
+        {
+            // drop whatever a failed load left behind
+            categories.clear();
+            items.clear();
+            categories_to_update.clear();
+        }
+        LLFILE* fp = binary_cache_loaded ? NULL : LLFile::fopen(gzip_filename, "rb");
+        // </FS>
         bool remove_inventory_file = false;
-        if (LLAppViewer::instance()->isSecondInstance())
+        if (!binary_cache_loaded && LLAppViewer::instance()->isSecondInstance())
         {
             // Safeguard viewer against trying to unpack file twice
             // ex: user logs into two accounts simultaneously, so two
@@ -2962,7 +3032,12 @@ bool LLInventoryModel::loadSkeleton(
             }
         }
         bool is_cache_obsolete = false;
-        if (loadFromFile(inventory_filename, categories, items, categories_to_update, is_cache_obsolete))
+        // <FS> Binary inventory cache
+        //if (loadFromFile(inventory_filename, categories, items, categories_to_update, is_cache_obsolete))
+        bool cache_loaded = binary_cache_loaded
+            || loadFromFile(inventory_filename, categories, items, categories_to_update, is_cache_obsolete);
+        if (cache_loaded)
+        // </FS>
         {
             // We were able to find a cache of files. So, use what we
             // found to generate a set of categories we should add. We
@@ -3157,6 +3232,12 @@ bool LLInventoryModel::loadSkeleton(
             LL_WARNS(LOG_INV) << "Inv cache out of date, removing" << LL_ENDL;
             LLFile::remove(gzip_filename);
         }
+        // <FS> Binary inventory cache
+        if ((is_cache_obsolete || is_binary_cache_obsolete) && !LLAppViewer::instance()->isSecondInstance())
+        {
+            LLFile::remove(binary_filename, ENOENT);
+        }
+        // </FS>
         categories.clear(); // will unref and delete entries
     }
 
@@ -36,6 +36,7 @@
 #include "llfoldertype.h"
 #include "llframetimer.h"
 #include "lluuid.h"
+#include "lluuidhashmap.h" // <FS/> Flat UUID inventory maps
 #include "llpermissionsflags.h"
 #include "llviewerinventory.h"
 #include "llstring.h"
@@ -204,6 +205,7 @@ public:
     void createCommonSystemCategories();
 
     static std::string getInvCacheAddres(const LLUUID& owner_id);
+    static S32 getInvCacheVersion() { return sCurrentInvCacheVersion; } // <FS/> for FSInventoryCache
 
     // Call on logout to save a terse representation.
     void cache(const LLUUID& parent_folder_id, const LLUUID& agent_id);
@@ -213,13 +215,22 @@ private:
     // the inventory using several different identifiers.
     // mInventory member data is the 'master' list of inventory, and
     // mCategoryMap and mItemMap store uuid->object mappings.
-    typedef std::map<LLUUID, LLPointer<LLViewerInventoryCategory> > cat_map_t;
-    typedef std::map<LLUUID, LLPointer<LLViewerInventoryItem> > item_map_t;
+    // <FS> Flat UUID inventory maps: looked up for every item of every
+    // folder, large inventories hold several 100K entries
+    //typedef std::map<LLUUID, LLPointer<LLViewerInventoryCategory> > cat_map_t;
+    //typedef std::map<LLUUID, LLPointer<LLViewerInventoryItem> > item_map_t;
+    typedef LLUUIDHashMap<LLPointer<LLViewerInventoryCategory> > cat_map_t;
+    typedef LLUUIDHashMap<LLPointer<LLViewerInventoryItem> > item_map_t;
+    // </FS>
     cat_map_t mCategoryMap;
     item_map_t mItemMap;
     // This last set of indices is used to map parents to children.
-    typedef std::map<LLUUID, cat_array_t*> parent_cat_map_t;
-    typedef std::map<LLUUID, item_array_t*> parent_item_map_t;
+    // <FS> Flat UUID inventory maps
+    //typedef std::map<LLUUID, cat_array_t*> parent_cat_map_t;
+    //typedef std::map<LLUUID, item_array_t*> parent_item_map_t;
+    typedef LLUUIDHashMap<cat_array_t*> parent_cat_map_t;
+    typedef LLUUIDHashMap<item_array_t*> parent_item_map_t;
+    // </FS>
     parent_cat_map_t mParentChildCategoryTree;
     parent_item_map_t mParentChildItemTree;
 
@@ -643,6 +654,12 @@ private:
     U32 mModifyMaskBacklog;
     changed_items_t mChangedItemIDsBacklog;
     changed_items_t mAddedItemIDsBacklog;
+    // <FS> Folders whose items changed since the binary inventory cache was
+    // last saved, re-encoded by the next save (see FSInventoryCache::save).
+    // Only tracked while FSBinaryInventoryCache is on.
+    uuid_set_t mCacheDirtyFolders;
+    // Set if something changed while it was off, until the next save
+    bool mCacheDirtyFoldersIncomplete = false;
     typedef std::map<LLUUID , changed_items_t> broken_links_t;
     broken_links_t mPossiblyBrockenLinks; // there can be multiple links per item
     changed_items_t mLinksRebuildList;
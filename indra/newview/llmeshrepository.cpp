@@ -91,6 +91,7 @@
 #endif
 
 #include "llviewernetwork.h"
+#include "fsregionprefetch.h" // <FS> Region prefetch profiles
 
 // Purpose
 //
@@ -1002,26 +1003,77 @@ void LLMeshRepoThread::run()
             }
         }
 
-        if (!mHeaderReqQ.empty() && mHttpRequestSet.size() < sRequestHighWater)
+        // <FS> Batched asynchronous reads
+        // Each header fetch adds at most one HTTP request, so pop as many
+        // requests as the high water mark allows and read all of their
+        // cache entries in one batch instead of one file at a time. The
+        // batch is only started here; its results are picked up below once
+        // the read threads are done, on this pass or a later one, so the
+        // other queues keep being served in the meantime.
+        //if (!mHeaderReqQ.empty() && mHttpRequestSet.size() < sRequestHighWater)
+        if (!mHeaderReqQ.empty() && mHttpRequestSet.size() < sRequestHighWater && !mHeaderReads.valid())
+        // </FS>
         {
             std::list<HeaderRequest> incomplete;
-            while (!mHeaderReqQ.empty() && mHttpRequestSet.size() < sRequestHighWater)
+            // <FS> Batched asynchronous reads
+            std::vector<HeaderRequest> ready;
+            if (mMutex)
             {
-                if (!mMutex)
+                LLMutexLock locker(mMutex);
+                const size_t capacity = (size_t)sRequestHighWater - mHttpRequestSet.size();
+                while (!mHeaderReqQ.empty() && ready.size() < capacity)
                 {
-                    break;
+                    HeaderRequest req = mHeaderReqQ.front();
+                    mHeaderReqQ.pop();
+                    if (req.isDelayed())
+                    {
+                        // failed to load before, wait a bit
+                        incomplete.push_front(req);
+                    }
+                    else
+                    {
+                        ready.push_back(req);
+                    }
                 }
+            }
 
-                mMutex->lock();
-                HeaderRequest req = mHeaderReqQ.front();
-                mHeaderReqQ.pop();
-                mMutex->unlock();
-                if (req.isDelayed())
+            if (!ready.empty())
+            {
+                LLFileSystem::read_batch_t headers(ready.size());
+                for (size_t i = 0; i < ready.size(); ++i)
                 {
-                    // failed to load before, wait a bit
-                    incomplete.push_front(req);
+                    headers[i].mFileID = ready[i].mMeshParams.getSculptID();
+                    headers[i].mFileType = LLAssetType::AT_MESH;
+                    headers[i].mLength = MESH_HEADER_SIZE;
+                }
+                mHeaderReadRequests = std::move(ready);
+                mHeaderReads = LLFileSystem::readBatch(std::move(headers));
+            }
+            // </FS>
+
+            if (!incomplete.empty())
+            {
+                LLMutexLock locker(mMutex);
+                for (std::list<HeaderRequest>::iterator iter = incomplete.begin(); iter != incomplete.end(); iter++)
+                {
+                    mHeaderReqQ.push(*iter);
                 }
-                else if (!fetchMeshHeader(req.mMeshParams, req.canRetry()))
+            }
+        }
+
+        // <FS> Batched asynchronous reads
+        if (mHeaderReads.valid()
+            && mHeaderReads.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            LLFileSystem::read_batch_t headers = mHeaderReads.get();
+            std::vector<HeaderRequest> ready;
+            ready.swap(mHeaderReadRequests);
+
+            std::list<HeaderRequest> incomplete;
+            for (size_t i = 0; i < ready.size(); ++i)
+            {
+                HeaderRequest& req = ready[i];
+                if (!fetchMeshHeader(req.mMeshParams, req.canRetry(), &headers[i].mData))
                 {
                     if (req.canRetry())
                     {
@@ -1045,6 +1097,7 @@ void LLMeshRepoThread::run()
                 }
             }
         }
+        // </FS>
 
         // For the final three request lists, similar goal to above but
         // slightly different queue structures.  Stay off the mutex when
@@ -1252,6 +1305,22 @@ void LLMeshRepoThread::loadMeshLOD(const LLVolumeParams& mesh_params, S32 lod)
     }
 }
 
+// <FS> Region prefetch profiles
+void LLMeshRepoThread::loadMeshHeader(const LLVolumeParams& mesh_params)
+{ //could be called from any thread
+    const LLUUID& mesh_id = mesh_params.getSculptID();
+    LLMutexLock lock(mMutex);
+    LLMutexLock header_lock(mHeaderMutex);
+    if (mMeshHeader.find(mesh_id) == mMeshHeader.end() && mPendingLOD.find(mesh_id) == mPendingLOD.end())
+    {
+        // An empty pending list marks the header as requested; LOD requests
+        // arriving before it does get appended to it as usual
+        mHeaderReqQ.push(HeaderRequest(mesh_params));
+        mPendingLOD[mesh_id];
+    }
+}
+// </FS>
+
 // Mutex:  must be holding mMutex when called
 // <FS:Ansariel> [UDP Assets]
 //void LLMeshRepoThread::setGetMeshCap(const std::string & mesh_cap)
@@ -1782,24 +1851,41 @@ void LLMeshRepoThread::decActiveHeaderRequests()
 }
 
 //return false if failed to get header
-bool LLMeshRepoThread::fetchMeshHeader(const LLVolumeParams& mesh_params, bool can_retry)
+bool LLMeshRepoThread::fetchMeshHeader(const LLVolumeParams& mesh_params, bool can_retry, const std::vector<U8>* cached_header)
 {
     ++LLMeshRepository::sMeshRequestCount;
 
     {
-        //look for mesh in asset in cache
-        LLFileSystem file(mesh_params.getSculptID(), LLAssetType::AT_MESH);
+        // *NOTE:  if the header size is ever more than 4KB, this will break
+        U8 buffer[MESH_HEADER_SIZE];
+        S32 bytes = 0;
+        // <FS> Batched asynchronous reads
+        if (cached_header)
+        {
+            bytes = llmin((S32)cached_header->size(), MESH_HEADER_SIZE);
+            if (bytes > 0)
+            {
+                memcpy(buffer, cached_header->data(), bytes);
+            }
+        }
+        else
+        // </FS>
+        {
+            //look for mesh in asset in cache
+            LLFileSystem file(mesh_params.getSculptID(), LLAssetType::AT_MESH);
 
-        S32 size = file.getSize();
+            S32 size = file.getSize();
+            if (size > 0)
+            {
+                bytes = llmin(size, MESH_HEADER_SIZE);
+                file.read(buffer, bytes);
+            }
+        }
 
-        if (size > 0)
+        if (bytes > 0)
         {
-            // *NOTE:  if the header size is ever more than 4KB, this will break
-            U8 buffer[MESH_HEADER_SIZE];
-            S32 bytes = llmin(size, MESH_HEADER_SIZE);
             LLMeshRepository::sCacheBytesRead += bytes;
             ++LLMeshRepository::sCacheReads;
-            file.read(buffer, bytes);
             if (headerReceived(mesh_params, buffer, bytes) == MESH_OK)
             {
                 LL_DEBUGS(LOG_MESH) << "Mesh/Cache: Mesh header for ID " << mesh_params.getSculptID() << " - was retrieved from the cache." << LL_ENDL;
@@ -3785,6 +3871,8 @@ S32 LLMeshRepository::loadMesh(LLVOVolume* vobj, const LLVolumeParams& mesh_para
         return detail;
     }
 
+    FSRegionPrefetch::instance().recordMesh(mesh_params.getSculptID(), detail); // <FS> Region prefetch profiles
+
     {
         LLMutexLock lock(mMeshMutex);
         //add volume to list of loading meshes
@@ -3860,6 +3948,18 @@ S32 LLMeshRepository::loadMesh(LLVOVolume* vobj, const LLVolumeParams& mesh_para
     return detail;
 }
 
+// <FS> Region prefetch profiles
+void LLMeshRepository::prefetchMeshHeader(const LLUUID& mesh_id)
+{
+    if (mesh_id.notNull() && mThread)
+    {
+        LLVolumeParams mesh_params;
+        mesh_params.setSculptID(mesh_id, LL_SCULPT_TYPE_MESH);
+        mThread->loadMeshHeader(mesh_params);
+    }
+}
+// </FS>
+
 void LLMeshRepository::notifyLoadedMeshes()
 { //called from main thread
     LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK; //LL_RECORD_BLOCK_TIME(FTM_MESH_FETCH);
@@ -40,6 +40,7 @@
 #include "httpheaders.h"
 #include "httphandler.h"
 #include "llthread.h"
+#include "llfilesystem.h" // <FS/> Batched asynchronous reads
 
 #define LLCONVEXDECOMPINTER_STATIC 1
 
@@ -368,6 +369,12 @@ public:
     //queue of requested headers
     std::queue<HeaderRequest> mHeaderReqQ;
 
+    // <FS> Header requests whose cache entries are being read in a batch,
+    // and the batch itself (repo thread only)
+    std::vector<HeaderRequest> mHeaderReadRequests;
+    std::future<LLFileSystem::read_batch_t> mHeaderReads;
+    // </FS>
+
     //queue of requested LODs
     std::queue<LODRequest> mLODReqQ;
 
@@ -408,8 +415,11 @@ public:
 
     void lockAndLoadMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
     void loadMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
+    void loadMeshHeader(const LLVolumeParams& mesh_params); // <FS> Region prefetch profiles
 
-    bool fetchMeshHeader(const LLVolumeParams& mesh_params, bool can_retry = true);
+    // <FS> cached_header, if given, holds the first MESH_HEADER_SIZE bytes of
+    // the cache entry as already read by a batched read (empty if not cached)
+    bool fetchMeshHeader(const LLVolumeParams& mesh_params, bool can_retry = true, const std::vector<U8>* cached_header = nullptr);
     bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry = true);
     EMeshProcessingResult headerReceived(const LLVolumeParams& mesh_params, U8* data, S32 data_size);
     EMeshProcessingResult lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size);
@@ -669,6 +679,11 @@ public:
     void unregisterMesh(LLVOVolume* volume);
     //mesh management functions
     S32 loadMesh(LLVOVolume* volume, const LLVolumeParams& mesh_params, S32 detail = 0, S32 last_lod = -1);
+    // <FS> Region prefetch profiles
+    // Queue a header fetch for a mesh nothing has asked for yet, so its
+    // header is already known when the first LOD request comes in
+    void prefetchMeshHeader(const LLUUID& mesh_id);
+    // </FS>
 
     void notifyLoadedMeshes();
     void notifyMeshLoaded(const LLVolumeParams& mesh_params, LLVolume* volume);
@@ -1154,6 +1154,7 @@ void LLPreviewGesture::saveIfNeeded()
 
             S32 size = dp.getCurrentSize();
             file.write((U8*)buffer, size);
+            file.close(); // <FS/> Pack-file storage: store it before the upload reads it
 
             LLLineEditor* descEditor = getChild<LLLineEditor>("desc");
             LLSaveInfo* info = new LLSaveInfo(mItemUUID, mObjectUUID, descEditor->getText(), tid);
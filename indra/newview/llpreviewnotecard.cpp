@@ -623,6 +623,7 @@ bool LLPreviewNotecard::saveIfNeeded(LLInventoryItem* copyitem, bool sync)
 
                 S32 size = static_cast<S32>(buffer.length()) + 1;
                 file.write((U8*)buffer.c_str(), size);
+                file.close(); // <FS/> Pack-file storage: store it before the upload reads it
 
                 gAssetStorage->storeAssetData(tid, LLAssetType::AT_NOTECARD,
                                                 &onSaveComplete,
@@ -240,6 +240,7 @@
 #include "fsfloaterwearablefavorites.h"
 #include "fslslbridge.h"
 #include "fsradar.h"
+#include "fsregionprefetch.h"
 #include "fsregistrarutils.h"
 #include "fsscriptlibrary.h"
 #include "lfsimfeaturehandler.h"
@@ -2222,6 +2223,9 @@ bool idle_startup()
         // <FS:Ansariel> Load persisted avatar render settings
         FSAvatarRenderPersistence::instance().init();
 
+        // <FS> Record and prefetch per-region asset profiles
+        FSRegionPrefetch::instance().init();
+
         // Do something with pContacts so no overzealous optimizer optimzes our neat little call to FSFloaterContacts::getInstance() away.
         if( pContacts )
             LL_INFOS("AppInit") << "Constructed " <<  pContacts->getName() << LL_ENDL;
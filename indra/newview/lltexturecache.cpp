@@ -38,6 +38,7 @@
 // Included to allow LLTextureCache::purgeTextures() to pause watchdog timeout
 #include "llappviewer.h"
 #include "llmemory.h"
+#include "hbxxh.h"
 
 // Cache organization:
 // cache/texture.entries
@@ -266,8 +267,32 @@ private:
     e_state mState;
     LLPointer<LLImageRaw> mRawImage;
     S32 mRawDiscardLevel;
+    // <FS> Cache integrity checks: what the entry promised when it was read
+    U64 mEntryDigest{ 0 };
+    S32 mEntryBodySize{ 0 };
+    // </FS>
 };
 
+// <FS> Cache integrity checks
+// The digest of an entry covers the whole header record, zero padding
+// included, followed by the body.
+static U64 texture_entry_digest(const U8* data, S32 data_size)
+{
+    HBXXH64 digest;
+    digest.update(data, llmin(data_size, TEXTURE_CACHE_ENTRY_SIZE));
+    if (data_size < TEXTURE_CACHE_ENTRY_SIZE)
+    {
+        std::vector<U8> padding(TEXTURE_CACHE_ENTRY_SIZE - data_size, 0);
+        digest.update(padding.data(), padding.size());
+    }
+    else
+    {
+        digest.update(data + TEXTURE_CACHE_ENTRY_SIZE, data_size - TEXTURE_CACHE_ENTRY_SIZE);
+    }
+    return digest.digest();
+}
+// </FS>
+
 
 //virtual
 void LLTextureCacheWorker::startWork(S32 param)
@@ -391,6 +416,10 @@ bool LLTextureCacheRemoteWorker::doRead()
         else
         {
             mImageSize = entry.mImageSize ;
+            // <FS> Cache integrity checks
+            mEntryDigest = entry.mDigest;
+            mEntryBodySize = entry.mBodySize;
+            // </FS>
             // If the read offset is bigger than the header cache, we read directly from the body
             // Note that currently, we *never* read with offset from the cache, so the result is *always* HEADER
             mState = mOffset < TEXTURE_CACHE_ENTRY_SIZE ? HEADER : BODY;
@@ -522,6 +551,20 @@ bool LLTextureCacheRemoteWorker::doRead()
         done = true;
     }
 
+    // <FS> Cache integrity checks: a read of the whole entry is checked
+    // against its digest, a corrupted entry becomes a cache miss
+    if (done && mReadData && mOffset == 0 && mEntryDigest
+        && mDataSize == TEXTURE_CACHE_ENTRY_SIZE + mEntryBodySize
+        && HBXXH64::digest(mReadData, mDataSize) != mEntryDigest)
+    {
+        LL_WARNS("TextureCache") << "Cached texture " << mID << " failed its integrity check, evicting it" << LL_ENDL;
+        mCache->removeFromCache(mID);
+        ll_aligned_free_16(mReadData);
+        mReadData = NULL;
+        mDataSize = 0; // no data
+    }
+    // </FS>
+
     // Clean up and exit
     return done;
 }
@@ -657,6 +700,12 @@ bool LLTextureCacheRemoteWorker::doWrite()
             // we're done so we don't have a body to store
             if (mDataSize <= bytes_written)
             {
+                // <FS> Cache integrity checks
+                if (bytes_written > 0)
+                {
+                    mCache->setEntryDigest(idx, mID, texture_entry_digest(mWriteData, mDataSize));
+                }
+                // </FS>
                 done = true;
             }
             else
@@ -683,10 +732,34 @@ bool LLTextureCacheRemoteWorker::doWrite()
                 // build the cache file name from the UUID
                 std::string filename = mCache->getTextureFileName(mID);
                 //          LL_INFOS() << "Writing Body: " << filename << " Bytes: " << file_offset+file_size << LL_ENDL;
-                S32 bytes_written = LLAPRFile::writeEx(filename,
+                // <FS> Shared texture cache: another viewer may be reading the
+                // body, so write it aside and swap it in whole
+                //S32 bytes_written = LLAPRFile::writeEx(filename,
+                //                                       mWriteData + TEXTURE_CACHE_ENTRY_SIZE,
+                //                                       0, file_size,
+                //                                       mCache->getLocalAPRFilePool());
+                S32 bytes_written = 0;
+                if (mCache->mSharedCache)
+                {
+                    std::string temp_filename = filename + "." + LLUUID::generateNewID().asString() + ".tmp";
+                    bytes_written = LLAPRFile::writeEx(temp_filename,
                                                        mWriteData + TEXTURE_CACHE_ENTRY_SIZE,
                                                        0, file_size,
                                                        mCache->getLocalAPRFilePool());
+                    if (bytes_written <= 0 || LLFile::replace(temp_filename, filename) != 0)
+                    {
+                        LLFile::remove(temp_filename, ENOENT);
+                        bytes_written = 0;
+                    }
+                }
+                if (bytes_written <= 0)
+                {
+                    bytes_written = LLAPRFile::writeEx(filename,
+                                                       mWriteData + TEXTURE_CACHE_ENTRY_SIZE,
+                                                       0, file_size,
+                                                       mCache->getLocalAPRFilePool());
+                }
+                // </FS>
                 if (bytes_written <= 0)
                 {
                     LL_WARNS() << "LLTextureCacheWorker: " << mID
@@ -695,6 +768,12 @@ bool LLTextureCacheRemoteWorker::doWrite()
                     mDataSize = -1; // failed
                     done = true;
                 }
+                // <FS> Cache integrity checks
+                else
+                {
+                    mCache->setEntryDigest(idx, mID, texture_entry_digest(mWriteData, mDataSize));
+                }
+                // </FS>
             }
 
             // Nothing else to do at that point...
@@ -789,13 +868,46 @@ void LLTextureCacheWorker::endWork(S32 param, bool aborted)
 
 //////////////////////////////////////////////////////////////////////////////
 
+S32 LLTextureCache::EntryIDMap::find(const LLUUID& id)
+{
+    Shard& shard = getShard(id);
+    LLMutexLock lock(&shard.mMutex);
+    auto iter = shard.mMap.find(id);
+    return iter != shard.mMap.end() ? iter->second : -1;
+}
+
+void LLTextureCache::EntryIDMap::set(const LLUUID& id, S32 idx)
+{
+    Shard& shard = getShard(id);
+    LLMutexLock lock(&shard.mMutex);
+    shard.mMap[id] = idx;
+}
+
+void LLTextureCache::EntryIDMap::erase(const LLUUID& id)
+{
+    Shard& shard = getShard(id);
+    LLMutexLock lock(&shard.mMutex);
+    shard.mMap.erase(id);
+}
+
+void LLTextureCache::EntryIDMap::clear()
+{
+    // One shard at a time, so this never waits on a shard while holding another
+    for (Shard& shard : mShards)
+    {
+        LLMutexLock lock(&shard.mMutex);
+        shard.mMap.clear();
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 LLTextureCache::LLTextureCache(bool threaded)
     : LLWorkerThread("TextureCache", threaded),
       mWorkersMutex(),
       mHeaderMutex(),
       mListMutex(),
       mFastCacheMutex(),
-      mHeaderAPRFile(NULL),
       mReadOnly(true), //do not allow to change the texture cache until setReadOnly() is called.
       mTexturesSizeTotal(0),
       mDoPurge(false),
@@ -850,6 +962,16 @@ size_t LLTextureCache::update(F32 max_time_ms)
         writeUpdatedEntries() ;
     }
 
+    // <FS> Shared texture cache: take over purging when the owner quits
+    static LLFrameTimer owner_timer;
+    static const F32 OWNER_RETRY_INTERVAL = 30.f; // seconds
+    if (mSharedCache && !mSharedCacheOwner && owner_timer.getElapsedTimeF32() > OWNER_RETRY_INTERVAL)
+    {
+        owner_timer.reset();
+        updateSharedCacheOwner();
+    }
+    // </FS>
+
     return res;
 }
 
@@ -875,10 +997,7 @@ std::string LLTextureCache::getTextureFileName(const LLUUID& id)
 //debug
 bool LLTextureCache::isInCache(const LLUUID& id)
 {
-    LLMutexLock lock(&mHeaderMutex);
-    id_map_t::const_iterator iter = mHeaderIDMap.find(id);
-
-    return (iter != mHeaderIDMap.end()) ;
+    return mHeaderIDMap.find(id) >= 0;
 }
 
 //debug
@@ -923,7 +1042,7 @@ bool LLTextureCache::isInLocal(const LLUUID& id)
 //////////////////////////////////////////////////////////////////////////////
 
 //static
-F32 LLTextureCache::sHeaderCacheVersion = 1.71f;
+F32 LLTextureCache::sHeaderCacheVersion = 1.73f; // <FS/> 1.72: entry digests, 1.73: records packed on every platform
 U32 LLTextureCache::sCacheMaxEntries = 1024 * 1024; //~1 million textures.
 S64 LLTextureCache::sCacheMaxTexturesSize = 0; // no limit
 std::string LLTextureCache::sHeaderCacheEncoderVersion = LLImageJ2C::getEngineInfo();
@@ -940,6 +1059,12 @@ const char* old_textures_dirname = "textures";
 //change the location of the texture cache to prevent from being deleted by old version viewers.
 const char* textures_dirname = "texturecache";
 const char* fast_cache_filename = "FastCache.cache";
+// <FS> Shared texture cache
+const char* shared_mode_filename = "texture.shared";
+const char* shared_owner_filename = "texture.owner";
+const char* header_lock_filename = "texture.lock";
+const char* shared_changes_filename = "texture.changes";
+// </FS>
 
 void LLTextureCache::setDirNames(ELLPath location)
 {
@@ -954,12 +1079,19 @@ void LLTextureCache::setDirNames(ELLPath location)
 
 void LLTextureCache::purgeCache(ELLPath location, bool remove_dir)
 {
-    LLMutexLock lock(&mHeaderMutex);
-
+    // <FS> Shared texture cache: find out whether other viewers use the
+    // cache before deleting anything
+    //LLMutexLock lock(&mHeaderMutex);
     if (!mReadOnly)
     {
         setDirNames(location);
-        llassert_always(mHeaderAPRFile == NULL);
+        initSharedCache();
+    }
+    HeaderLock lock(this);
+    // </FS>
+
+    if (!mReadOnly)
+    {
 
         //remove the legacy cache if exists
         std::string texture_dir = mTexturesDirName ;
@@ -1009,6 +1141,7 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, bool texture_cache
             << " Textures size: " << sCacheMaxTexturesSize / (1024 * 1024) << " MB" << LL_ENDL;
 
     setDirNames(location);
+    initSharedCache(); // <FS/> may turn the cache read-only
 
     if(texture_cache_mismatch)
     {
@@ -1047,39 +1180,342 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, bool texture_cache
 }
 
 //----------------------------------------------------------------------------
-// mHeaderMutex must be locked for the following functions!
+// <FS> Shared texture cache
+//
+// Viewers with FSSharedCache set write to one texture cache folder together:
+// - texture.shared is held with a shared lock by each of them, and with an
+//   exclusive one by a viewer using the folder on its own, so the two modes
+//   never mix. The loser of that race runs with a read-only cache.
+// - texture.lock is held along with mHeaderMutex (see lockHeaders()), so
+//   only one viewer at a time changes the entries file.
+// - texture.changes records the entry slots each change touched. On taking
+//   the header lock a viewer replays the changes it hasn't seen yet into its
+//   in-memory index.
+// - Only the holder of texture.owner purges old textures.
+// Lookups that skip the header lock go through mHeaderIDMap, which may still
+// point at a slot another viewer recycled: the record then holds another id
+// and the slow path drops the stale mapping.
+
+void LLTextureCache::initSharedCache()
+{
+    if (!mHeaderLockFileName.empty())
+    {
+        return; // already done for this cache folder
+    }
+
+    if (!mReadOnly && !LLFile::isdir(mTexturesDirName))
+    {
+        if (!LLFile::isdir(mCacheParentDirName))
+        {
+            LLFile::mkdir(mCacheParentDirName);
+        }
+        LLFile::mkdir(mTexturesDirName);
+    }
+
+    std::string mode_filename = gDirUtilp->add(mTexturesDirName, shared_mode_filename);
+    mHeaderLockFileName = gDirUtilp->add(mTexturesDirName, header_lock_filename);
+    mSharedOwnerFileName = gDirUtilp->add(mTexturesDirName, shared_owner_filename);
+
+    if (mReadOnly)
+    {
+        mSharedCache = false;
+        return;
+    }
+
+    if (!mSharedModeLock.lock(mode_filename, !mSharedCache, true))
+    {
+        LL_WARNS("TextureCache") << "Texture cache folder " << mTexturesDirName << " is in use by another viewer that "
+                                 << (mSharedCache ? "doesn't share it" : "shares it") << ", using it read-only" << LL_ENDL;
+        mSharedCache = false;
+        mReadOnly = true;
+        return;
+    }
 
-LLAPRFile* LLTextureCache::openHeaderEntriesFile(bool readonly, S32 offset)
+    if (!mSharedCache)
+    {
+        mSharedCacheOwner = true;
+        return;
+    }
+
+    std::string changes_filename = gDirUtilp->add(mTexturesDirName, shared_changes_filename);
+    if (!mSharedChangesMap.open(changes_filename, true, sizeof(SharedChanges)))
+    {
+        LL_WARNS("TextureCache") << "Unable to map " << changes_filename << ", not sharing the texture cache" << LL_ENDL;
+        mSharedModeLock.unlock();
+        mSharedCache = false;
+        mReadOnly = true;
+        return;
+    }
+
+    updateSharedCacheOwner();
+    LL_INFOS("TextureCache") << "Sharing texture cache folder " << mTexturesDirName
+                             << (mSharedCacheOwner ? " as its owner" : "") << LL_ENDL;
+}
+
+void LLTextureCache::updateSharedCacheOwner()
 {
-    llassert_always(mHeaderAPRFile == NULL);
-    apr_int32_t flags = readonly ? APR_READ|APR_BINARY : APR_READ|APR_WRITE|APR_BINARY;
-    mHeaderAPRFile = new LLAPRFile(mHeaderEntriesFileName, flags, mHeaderAPRFilePoolp);
-    if(offset > 0)
+    if (!mSharedOwnerLock.isLocked() && mSharedOwnerLock.lock(mSharedOwnerFileName, true, true))
     {
-        mHeaderAPRFile->seek(APR_SET, offset);
+        LL_INFOS("TextureCache") << "This viewer purges the shared texture cache" << LL_ENDL;
     }
-    return mHeaderAPRFile;
+    mSharedCacheOwner = mSharedOwnerLock.isLocked();
 }
 
-void LLTextureCache::closeHeaderEntriesFile()
+// The change count lives in memory shared with the other viewers, which bump
+// it under the header file lock; access it atomically so the plain loads and
+// stores aren't a data race. Release on the store, so a viewer that sees the
+// new count also sees the change record written before it.
+static U32 load_change_count(const U32& count)
+{
+#if __cpp_lib_atomic_ref
+    return std::atomic_ref<U32>(const_cast<U32&>(count)).load(std::memory_order_acquire);
+#else
+    U32 value = *static_cast<const volatile U32*>(&count);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return value;
+#endif
+}
+
+static void store_change_count(U32& count, U32 value)
+{
+#if __cpp_lib_atomic_ref
+    std::atomic_ref<U32>(count).store(value, std::memory_order_release);
+#else
+    std::atomic_thread_fence(std::memory_order_release);
+    *static_cast<volatile U32*>(&count) = value;
+#endif
+}
+
+LLTextureCache::SharedChanges* LLTextureCache::getSharedChanges() const
 {
-    if(!mHeaderAPRFile)
+    if (!mSharedChangesMap.isOpen() || mSharedChangesMap.size() < sizeof(SharedChanges))
     {
-        return ;
+        return NULL;
+    }
+    return reinterpret_cast<SharedChanges*>(mSharedChangesMap.data());
+}
+
+// Lock free peek used by the lookup hit path. Another viewer may be bumping
+// the count right now: a stale value only costs a cache miss, the texture is
+// found again after the next sync.
+bool LLTextureCache::haveSharedChanges() const
+{
+    SharedChanges* changes = getSharedChanges();
+    return changes && load_change_count(changes->mChangeCount) != mSharedChangeCount;
+}
+
+void LLTextureCache::lockHeaders()
+{
+    mHeaderMutex.lock();
+    if (mHeaderLockDepth++ == 0 && mSharedCache && !mHeaderLockFileName.empty())
+    {
+        if (!mHeaderFileLock.lock(mHeaderLockFileName))
+        {
+            LL_WARNS_ONCE("TextureCache") << "Unable to lock " << mHeaderLockFileName << LL_ENDL;
+        }
+        syncSharedEntries();
+    }
+}
+
+void LLTextureCache::unlockHeaders()
+{
+    if (--mHeaderLockDepth == 0 && mHeaderFileLock.isLocked())
+    {
+        mHeaderFileLock.unlock();
+    }
+    mHeaderMutex.unlock();
+}
+
+// Called with the header lock held
+void LLTextureCache::syncSharedEntries()
+{
+    SharedChanges* changes = getSharedChanges();
+    if (!changes || !mHeaderEntriesMap.isOpen() || mHeaderEntriesMap.size() < sizeof(EntriesInfo))
+    {
+        return;
+    }
+
+    U32 change_count = load_change_count(changes->mChangeCount);
+    U32 seen = mSharedChangeCount;
+    if (change_count == seen)
+    {
+        return;
+    }
+
+    memcpy((void*)&mHeaderEntriesInfo, mHeaderEntriesMap.data(), sizeof(EntriesInfo));
+    updateTimeStampMode();
+
+    if (change_count - seen > SHARED_CHANGE_COUNT)
+    {
+        // Too far behind, the ring has been overwritten since
+        mLRU.clear();
+        openAndReadEntries();
+    }
+    else
+    {
+        for (U32 i = seen; i != change_count; ++i)
+        {
+            const SharedChange& change = changes->mChanges[i % SHARED_CHANGE_COUNT];
+            applySharedChange(change.mIndex, change.mOldID);
+        }
+    }
+    mSharedChangeCount = change_count;
+}
+
+void LLTextureCache::forgetSharedEntry(const LLUUID& id)
+{
+    size_map_t::iterator iter = mTexturesSizeMap.find(id);
+    if (iter != mTexturesSizeMap.end())
+    {
+        mTexturesSizeTotal -= iter->second;
+        mTexturesSizeMap.erase(iter);
+    }
+    LLMutexLock lock(mHeaderIDMap.getMutex(id));
+    mHeaderIDMap.erase(id);
+}
+
+// Bring our view of one slot in line with the mapped record
+void LLTextureCache::applySharedChange(S32 idx, const LLUUID& old_id)
+{
+    Entry* entries = getMappedEntries();
+    if (!entries || idx < 0 || (U32)idx >= mHeaderEntriesCapacity)
+    {
+        return; // past the part of the file this viewer uses
+    }
+
+    if (mHeaderIDMap.find(old_id) == idx)
+    {
+        forgetSharedEntry(old_id);
+    }
+
+    Entry entry = entries[idx];
+    if (entry.mImageSize > entry.mBodySize)
+    {
+        S32 old_idx = mHeaderIDMap.find(entry.mID);
+        if (old_idx >= 0 && old_idx != idx)
+        {
+            forgetSharedEntry(entry.mID);
+        }
+        {
+            LLMutexLock lock(mHeaderIDMap.getMutex(entry.mID));
+            mHeaderIDMap.set(entry.mID, idx);
+        }
+        S32& body_size = mTexturesSizeMap[entry.mID];
+        mTexturesSizeTotal += entry.mBodySize - body_size;
+        body_size = entry.mBodySize;
+        mFreeList.erase(idx);
+    }
+    else
+    {
+        if (mHeaderIDMap.find(entry.mID) == idx)
+        {
+            forgetSharedEntry(entry.mID);
+        }
+        if ((U32)idx < mHeaderEntriesInfo.mEntries)
+        {
+            mFreeList.insert(idx);
+        }
+    }
+}
+
+// Called with the header lock held, once this viewer changed a record
+void LLTextureCache::pushSharedChange(S32 idx, const LLUUID& old_id)
+{
+    SharedChanges* changes = getSharedChanges();
+    if (!mSharedCache || !changes || mReadOnly)
+    {
+        return;
     }
 
-    delete mHeaderAPRFile;
-    mHeaderAPRFile = NULL;
+    U32 change_count = load_change_count(changes->mChangeCount);
+    SharedChange& change = changes->mChanges[change_count % SHARED_CHANGE_COUNT];
+    change.mOldID = old_id;
+    change.mIndex = idx;
+    store_change_count(changes->mChangeCount, ++change_count);
+    mSharedChangeCount = change_count;
+}
+
+// Empty every record in place, the other viewers keep the file mapped
+void LLTextureCache::clearSharedEntries()
+{
+    SharedChanges* changes = getSharedChanges();
+    if (!changes || !openHeaderEntriesFile() || !mHeaderEntriesMap.isWritable())
+    {
+        return;
+    }
+
+    Entry* entries = getMappedEntries();
+    if (entries)
+    {
+        U32 num_entries = mHeaderEntriesInfo.mEntries;
+        if (mHeaderEntriesMap.size() >= sizeof(EntriesInfo))
+        {
+            num_entries = llmax(num_entries, reinterpret_cast<const EntriesInfo*>(mHeaderEntriesMap.data())->mEntries);
+        }
+        num_entries = llmin(num_entries, mHeaderEntriesCapacity.load());
+        memset((void*)entries, 0, (size_t)num_entries * sizeof(Entry));
+    }
+
+    // Push every other viewer past the ring, so they reread the entries
+    U32 change_count = load_change_count(changes->mChangeCount) + SHARED_CHANGE_COUNT + 1;
+    store_change_count(changes->mChangeCount, change_count);
+    mSharedChangeCount = change_count;
+}
+// </FS>
+
+//----------------------------------------------------------------------------
+// mHeaderMutex must be locked for the following functions!
+
+// <FS> The entries file is mapped once and stays mapped until the cache is
+// purged. When writable it is grown up front to hold sCacheMaxEntries records,
+// so the mapping never has to move while the workers are reading it.
+bool LLTextureCache::openHeaderEntriesFile()
+{
+    if (mHeaderEntriesMap.isOpen())
+    {
+        return true;
+    }
+
+    size_t min_size = mReadOnly ? 0 : sizeof(EntriesInfo) + (size_t)sCacheMaxEntries * sizeof(Entry);
+    if (!mHeaderEntriesMap.open(mHeaderEntriesFileName, !mReadOnly, min_size))
+    {
+        LL_WARNS("TextureCache") << "Unable to map " << mHeaderEntriesFileName << LL_ENDL;
+        return false;
+    }
+
+    // The capacity goes out first: whoever sees the records sees how many
+    // there are
+    size_t size = mHeaderEntriesMap.size();
+    U32 capacity = size > sizeof(EntriesInfo) ? (U32)((size - sizeof(EntriesInfo)) / sizeof(Entry)) : 0;
+    mHeaderEntriesCapacity.store(capacity, std::memory_order_relaxed);
+    mHeaderEntries.store(capacity ? reinterpret_cast<Entry*>(mHeaderEntriesMap.data() + sizeof(EntriesInfo)) : NULL,
+                         std::memory_order_release);
+    return true;
+}
+
+// Every shard of mHeaderIDMap must have been cleared first, so that no
+// worker can still be reading a record.
+void LLTextureCache::closeHeaderEntriesFile()
+{
+    mHeaderEntries.store(NULL, std::memory_order_release);
+    mHeaderEntriesCapacity.store(0, std::memory_order_relaxed);
+    mHeaderEntriesMap.close();
+}
+
+// Load the records before their capacity (see openHeaderEntriesFile())
+LLTextureCache::Entry* LLTextureCache::getMappedEntries() const
+{
+    return mHeaderEntries.load(std::memory_order_acquire);
 }
 
 void LLTextureCache::readEntriesHeader()
 {
     // mHeaderEntriesInfo initializes to default values so safe not to read it
-    llassert_always(mHeaderAPRFile == NULL);
-    if (LLAPRFile::isExist(mHeaderEntriesFileName, mHeaderAPRFilePoolp))
+    if (LLFile::isfile(mHeaderEntriesFileName) && openHeaderEntriesFile()
+        && mHeaderEntriesMap.size() >= sizeof(EntriesInfo))
     {
-        LLAPRFile::readEx(mHeaderEntriesFileName, (U8*)&mHeaderEntriesInfo, 0, sizeof(EntriesInfo),
-                          mHeaderAPRFilePoolp);
+        memcpy((void*)&mHeaderEntriesInfo, mHeaderEntriesMap.data(), sizeof(EntriesInfo));
+        updateTimeStampMode();
     }
     else //create an empty entries header.
     {
@@ -1103,38 +1539,39 @@ void LLTextureCache::setEntriesHeader()
     mHeaderEntriesInfo.mAdressSize = sHeaderCacheAddressSize;
     strcpy(mHeaderEntriesInfo.mEncoderVersion, sHeaderCacheEncoderVersion.c_str());
     mHeaderEntriesInfo.mEntries = 0;
+    updateTimeStampMode();
 }
 
 void LLTextureCache::writeEntriesHeader()
 {
-    llassert_always(mHeaderAPRFile == NULL);
-    if (!mReadOnly)
+    if (!mReadOnly && openHeaderEntriesFile() && mHeaderEntriesMap.isWritable())
     {
-        LLAPRFile::writeEx(mHeaderEntriesFileName, (U8*)&mHeaderEntriesInfo, 0, sizeof(EntriesInfo),
-                           mHeaderAPRFilePoolp);
+        memcpy(mHeaderEntriesMap.data(), (const void*)&mHeaderEntriesInfo, sizeof(EntriesInfo));
     }
 }
 
+// Time stamps only matter for choosing which entries to recycle, which
+// doesn't happen until most of the entry index space is in use.
+void LLTextureCache::updateTimeStampMode()
+{
+    mStampEntryTimes = mHeaderEntriesInfo.mEntries >= (U32)(sCacheMaxEntries * 0.75f);
+}
+
 //mHeaderMutex is locked before calling this.
 S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create)
 {
-    S32 idx = -1;
-
-    id_map_t::iterator iter1 = mHeaderIDMap.find(id);
-    if (iter1 != mHeaderIDMap.end())
-    {
-        idx = iter1->second;
-    }
+    S32 idx = mHeaderIDMap.find(id);
+    Entry* entries = getMappedEntries();
 
     if (idx < 0)
     {
         if (create && !mReadOnly)
         {
-            if (mHeaderEntriesInfo.mEntries < sCacheMaxEntries)
+            if (mHeaderEntriesInfo.mEntries < llmin(sCacheMaxEntries, mHeaderEntriesCapacity.load()))
             {
                 // Add an entry to the end of the list
                 idx = mHeaderEntriesInfo.mEntries++;
-
+                updateTimeStampMode();
             }
             else if (!mFreeList.empty())
             {
@@ -1151,10 +1588,23 @@ S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create
                     // Erase entry from LRU regardless
                     mLRU.erase(curiter2);
                     // Look up entry and use it if it is valid
-                    id_map_t::iterator iter3 = mHeaderIDMap.find(oldid);
-                    if (iter3 != mHeaderIDMap.end() && iter3->second >= 0)
+                    S32 old_idx = mHeaderIDMap.find(oldid);
+                    if (old_idx >= 0 && entries && (U32)old_idx < mHeaderEntriesCapacity)
                     {
-                        idx = iter3->second;
+                        // <FS> Lookups no longer take mHeaderMutex to drop
+                        // themselves from mLRU; skip entries stamped since
+                        // the LRU was built instead.
+                        bool used_since = false;
+                        {
+                            LLMutexLock lock(mHeaderIDMap.getMutex(oldid));
+                            used_since = entries[old_idx].mTime > mLRUTime;
+                        }
+                        if (used_since)
+                        {
+                            continue;
+                        }
+                        // </FS>
+                        idx = old_idx;
                         removeCachedTexture(oldid) ;//remove the existing cached texture to release the entry index.
                         break;
                     }
@@ -1176,15 +1626,23 @@ S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create
         // Remove this entry from the LRU if it exists
         mLRU.erase(id);
         // Read the entry
-        idx_entry_map_t::iterator iter = mUpdatedEntryMap.find(idx) ;
-        if(iter != mUpdatedEntryMap.end())
+        if (!entries || (U32)idx >= mHeaderEntriesCapacity)
+        {
+            clearCorruptedCache() ; //clear the cache.
+            return -1;
+        }
         {
-            entry = iter->second ;
+            LLMutexLock lock(mHeaderIDMap.getMutex(id));
+            entry = entries[idx];
         }
-        else
+        // <FS> Shared texture cache: another viewer recycled the slot
+        // after we last synced, forget the stale mapping
+        if (mSharedCache && entry.mID != id)
         {
-            readEntryFromHeaderImmediately(idx, entry) ;
+            forgetSharedEntry(id);
+            return -1;
         }
+        // </FS>
         if(entry.mImageSize <= entry.mBodySize)//it happens on 64-bit systems, do not know why
         {
             LL_WARNS() << "corrupted entry: " << id << " entry image size: " << entry.mImageSize << " entry body size: " << entry.mBodySize << LL_ENDL ;
@@ -1192,7 +1650,6 @@ S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create
             //erase this entry and the cached texture from the cache.
             std::string tex_filename = getTextureFileName(id);
             removeEntry(idx, entry, tex_filename) ;
-            mUpdatedEntryMap.erase(idx) ;
             idx = -1 ;
         }
     }
@@ -1202,75 +1659,168 @@ S32 LLTextureCache::openAndReadEntry(const LLUUID& id, Entry& entry, bool create
 //mHeaderMutex is locked before calling this.
 void LLTextureCache::writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool write_header)
 {
-    LLAPRFile* aprfile ;
-    S32 bytes_written ;
-    S32 offset = sizeof(EntriesInfo) + idx * sizeof(Entry);
-    if(write_header)
-    {
-        aprfile = openHeaderEntriesFile(false, 0);
-        bytes_written = aprfile->write((U8*)&mHeaderEntriesInfo, sizeof(EntriesInfo)) ;
-        if(bytes_written != sizeof(EntriesInfo))
-        {
-            clearCorruptedCache() ; //clear the cache.
-            idx = -1 ;//mark the idx invalid.
-            return ;
-        }
-
-        mHeaderAPRFile->seek(APR_SET, offset);
-    }
-    else
+    if (mReadOnly)
     {
-        aprfile = openHeaderEntriesFile(false, offset);
+        return;
     }
-    bytes_written = aprfile->write((void*)&entry, (S32)sizeof(Entry));
-    if(bytes_written != sizeof(Entry))
+
+    Entry* entries = getMappedEntries();
+    if (!entries || !mHeaderEntriesMap.isWritable() || idx < 0 || (U32)idx >= mHeaderEntriesCapacity)
     {
         clearCorruptedCache() ; //clear the cache.
         idx = -1 ;//mark the idx invalid.
-
         return ;
     }
 
-    closeHeaderEntriesFile();
-    mUpdatedEntryMap.erase(idx) ;
-}
-
-//mHeaderMutex is locked before calling this.
-void LLTextureCache::readEntryFromHeaderImmediately(S32& idx, Entry& entry)
-{
-    S32 offset = sizeof(EntriesInfo) + idx * sizeof(Entry);
-    LLAPRFile* aprfile = openHeaderEntriesFile(true, offset);
-    S32 bytes_read = aprfile->read((void*)&entry, (S32)sizeof(Entry));
-    closeHeaderEntriesFile();
+    if(write_header)
+    {
+        memcpy(mHeaderEntriesMap.data(), (const void*)&mHeaderEntriesInfo, sizeof(EntriesInfo));
+    }
 
-    if(bytes_read != sizeof(Entry))
+    LLUUID old_id = entries[idx].mID;
     {
-        clearCorruptedCache() ; //clear the cache.
-        idx = -1 ;//mark the idx invalid.
+        LLMutexLock lock(mHeaderIDMap.getMutex(entry.mID));
+        entries[idx] = entry;
     }
+    pushSharedChange(idx, old_id); // <FS/> Shared texture cache
 }
 
-//mHeaderMutex is locked before calling this.
-//update an existing entry time stamp, delay writing.
+//update an existing entry time stamp in place. The mapped file is written
+//back by the OS, or by writeUpdatedEntries().
 void LLTextureCache::updateEntryTimeStamp(S32 idx, Entry& entry)
 {
-    static const U32 MAX_ENTRIES_WITHOUT_TIME_STAMP = (U32)(LLTextureCache::sCacheMaxEntries * 0.75f) ;
-
-    if(mHeaderEntriesInfo.mEntries < MAX_ENTRIES_WITHOUT_TIME_STAMP)
+    if (!mStampEntryTimes)
     {
         return ; //there are enough empty entry index space, no need to stamp time.
     }
 
     if (idx >= 0)
     {
-        if (!mReadOnly)
+        if (!mReadOnly && mHeaderEntriesMap.isWritable())
         {
             entry.mTime = (U32)time(NULL);
-            mUpdatedEntryMap[idx] = entry ;
+
+            LLMutexLock lock(mHeaderIDMap.getMutex(entry.mID));
+            Entry* entries = getMappedEntries();
+            if (entries && (U32)idx < mHeaderEntriesCapacity)
+            {
+                entries[idx].mTime = entry.mTime;
+            }
         }
     }
 }
 
+// <FS> Cache integrity checks
+// Only touches the record if it still belongs to the texture the digest was
+// computed for. This runs on the workers without the header lock: the
+// mapping is only safe to write while id still maps to idx under its shard
+// lock, because purgeAllTextures() clears every shard before it unmaps the
+// entries file. Otherwise the digest is dropped.
+void LLTextureCache::setEntryDigest(S32 idx, const LLUUID& id, U64 digest)
+{
+    if (mReadOnly || idx < 0)
+    {
+        return;
+    }
+
+    LLMutexLock lock(mHeaderIDMap.getMutex(id));
+    if (mHeaderIDMap.find(id) != idx)
+    {
+        return;
+    }
+    Entry* entries = getMappedEntries();
+    if (entries && mHeaderEntriesMap.isWritable() && (U32)idx < mHeaderEntriesCapacity && entries[idx].mID == id)
+    {
+        entries[idx].mDigest = digest;
+    }
+}
+
+// Entries are read back without the header lock, so one found corrupted is
+// only evicted if it still holds the digest it was checked against.
+S64 LLTextureCache::scrub(S64 max_bytes)
+{
+    if (mReadOnly || !mSharedCacheOwner)
+    {
+        return 0;
+    }
+
+    S64 checked_bytes = 0;
+    U32 visited = 0;
+    std::vector<U8> data;
+    while (checked_bytes < max_bytes)
+    {
+        S32 idx = -1;
+        Entry entry;
+        {
+            HeaderLock lock(this);
+            Entry* entries = getMappedEntries();
+            U32 num_entries = llmin(mHeaderEntriesInfo.mEntries, mHeaderEntriesCapacity.load());
+            if (!entries || visited >= num_entries) // one pass per call at most
+            {
+                break;
+            }
+            if (mScrubIndex >= num_entries)
+            {
+                mScrubIndex = 0;
+            }
+            idx = (S32)mScrubIndex++;
+            ++visited;
+            LLMutexLock id_lock(mHeaderIDMap.getMutex(entries[idx].mID));
+            entry = entries[idx];
+        }
+        if (entry.mImageSize <= entry.mBodySize || !entry.mDigest)
+        {
+            continue;
+        }
+
+        data.resize(TEXTURE_CACHE_ENTRY_SIZE + entry.mBodySize);
+        bool readable = false;
+        if (LLFILE* file = LLFile::fopen(mHeaderDataFileName, "rb"))
+        {
+            readable = fseek(file, (long)idx * TEXTURE_CACHE_ENTRY_SIZE, SEEK_SET) == 0
+                && fread(data.data(), 1, TEXTURE_CACHE_ENTRY_SIZE, file) == (size_t)TEXTURE_CACHE_ENTRY_SIZE;
+            LLFile::close(file);
+        }
+        if (readable && entry.mBodySize > 0)
+        {
+            readable = false;
+            if (LLFILE* file = LLFile::fopen(getTextureFileName(entry.mID), "rb"))
+            {
+                readable = fread(data.data() + TEXTURE_CACHE_ENTRY_SIZE, 1, entry.mBodySize, file) == (size_t)entry.mBodySize
+                    && fgetc(file) == EOF;
+                LLFile::close(file);
+            }
+        }
+        checked_bytes += data.size();
+
+        if (readable && HBXXH64::digest(data.data(), data.size()) == entry.mDigest)
+        {
+            continue;
+        }
+
+        HeaderLock lock(this);
+        Entry* entries = getMappedEntries();
+        if (!entries || (U32)idx >= mHeaderEntriesCapacity)
+        {
+            break;
+        }
+        Entry current;
+        {
+            LLMutexLock id_lock(mHeaderIDMap.getMutex(entry.mID));
+            current = entries[idx];
+        }
+        if (current.mID == entry.mID && current.mDigest == entry.mDigest && mHeaderIDMap.find(entry.mID) == idx)
+        {
+            LL_WARNS("TextureCache") << "Evicting corrupted cached texture " << entry.mID << LL_ENDL;
+            std::string tex_filename = getTextureFileName(entry.mID);
+            removeEntry(idx, current, tex_filename);
+            writeEntryToHeaderImmediately(idx, current);
+        }
+    }
+    return checked_bytes;
+}
+// </FS>
+
 //update an existing entry, write to header file immediately.
 bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_data_size)
 {
@@ -1279,6 +1829,14 @@ bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32
 
     if(new_image_size == entry.mImageSize && new_body_size == entry.mBodySize)
     {
+        // <FS> Cache integrity checks: the caller rewrites the data, the
+        // digest is set again once it is done
+        if (entry.mDigest)
+        {
+            entry.mDigest = 0;
+            setEntryDigest(idx, entry.mID, 0);
+        }
+        // </FS>
         return true ; //nothing changed.
     }
     else
@@ -1287,10 +1845,14 @@ bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32
 
         lockHeaders() ;
 
+        // <FS> Hold the id's shard until its record is written, so a lookup
+        // never finds the new index before the record behind it is valid
+        LLMutexLock id_lock(mHeaderIDMap.getMutex(entry.mID));
+
         bool update_header = false ;
         if(entry.mImageSize < 0) //is a brand-new entry
         {
-            mHeaderIDMap[entry.mID] = idx;
+            mHeaderIDMap.set(entry.mID, idx);
             mTexturesSizeMap[entry.mID] = new_body_size ;
             mTexturesSizeTotal += new_body_size ;
 
@@ -1307,6 +1869,7 @@ bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32
         entry.mTime = (U32)time(NULL);
         entry.mImageSize = new_image_size ;
         entry.mBodySize = new_body_size ;
+        entry.mDigest = 0; // <FS/> set once the data is written
 
         writeEntryToHeaderImmediately(idx, entry, update_header) ;
 
@@ -1326,7 +1889,8 @@ bool LLTextureCache::updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32
     return false ;
 }
 
-U32 LLTextureCache::openAndReadEntries(std::vector<Entry>& entries)
+// Rebuild the in-memory maps from the mapped entries file
+U32 LLTextureCache::openAndReadEntries()
 {
     U32 num_entries = mHeaderEntriesInfo.mEntries;
 
@@ -1335,37 +1899,31 @@ U32 LLTextureCache::openAndReadEntries(std::vector<Entry>& entries)
     mFreeList.clear();
     mTexturesSizeTotal = 0;
 
-    LLAPRFile* aprfile = NULL;
-    if(mUpdatedEntryMap.empty())
-    {
-        aprfile = openHeaderEntriesFile(true, (S32)sizeof(EntriesInfo));
-    }
-    else //update the header file first.
+    Entry* entries = getMappedEntries();
+    // <FS> Shared texture cache: a viewer with a larger cache may have grown
+    // the entries file past our mapping, only use the part we see
+    if (mSharedCache)
     {
-        aprfile = openHeaderEntriesFile(false, 0);
-        updatedHeaderEntriesFile() ;
-        if(!aprfile)
+        if (SharedChanges* changes = getSharedChanges())
         {
-            return 0;
+            mSharedChangeCount = load_change_count(changes->mChangeCount);
         }
-        aprfile->seek(APR_SET, (S32)sizeof(EntriesInfo));
+        num_entries = entries ? llmin(num_entries, mHeaderEntriesCapacity.load()) : 0;
+    }
+    // </FS>
+    if (num_entries && (!entries || num_entries > mHeaderEntriesCapacity))
+    {
+        LL_WARNS() << "Corrupted header entries, " << num_entries << " entries but room for " << mHeaderEntriesCapacity.load() << LL_ENDL;
+        purgeAllTextures(false);
+        return 0;
     }
     for (U32 idx=0; idx<num_entries; idx++)
     {
-        Entry entry;
-        S32 bytes_read = aprfile->read((void*)(&entry), (S32)sizeof(Entry));
-        if (bytes_read < sizeof(Entry))
-        {
-            LL_WARNS() << "Corrupted header entries, failed at " << idx << " / " << num_entries << LL_ENDL;
-            closeHeaderEntriesFile();
-            purgeAllTextures(false);
-            return 0;
-        }
-        entries.push_back(entry);
+        const Entry& entry = entries[idx];
 //      LL_INFOS() << "ENTRY: " << entry.mTime << " TEX: " << entry.mID << " IDX: " << idx << " Size: " << entry.mImageSize << LL_ENDL;
         if(entry.mImageSize > entry.mBodySize)
         {
-            mHeaderIDMap[entry.mID] = idx;
+            mHeaderIDMap.set(entry.mID, idx);
             mTexturesSizeMap[entry.mID] = entry.mBodySize;
             mTexturesSizeTotal += entry.mBodySize;
         }
@@ -1374,86 +1932,24 @@ U32 LLTextureCache::openAndReadEntries(std::vector<Entry>& entries)
             mFreeList.insert(idx);
         }
     }
-    closeHeaderEntriesFile();
     return num_entries;
 }
 
-void LLTextureCache::writeEntriesAndClose(const std::vector<Entry>& entries)
-{
-    auto num_entries = entries.size();
-    llassert_always(num_entries == mHeaderEntriesInfo.mEntries);
-
-    if (!mReadOnly)
-    {
-        LLAPRFile* aprfile = openHeaderEntriesFile(false, (S32)sizeof(EntriesInfo));
-        for (size_t idx=0; idx<num_entries; idx++)
-        {
-            S32 bytes_written = aprfile->write((void*)(&entries[idx]), (S32)sizeof(Entry));
-            if(bytes_written != sizeof(Entry))
-            {
-                clearCorruptedCache() ; //clear the cache.
-                return ;
-            }
-        }
-        closeHeaderEntriesFile();
-    }
-}
-
 void LLTextureCache::writeUpdatedEntries()
 {
     lockHeaders() ;
-    if (!mReadOnly && !mUpdatedEntryMap.empty())
+    if (!mReadOnly && mHeaderEntriesMap.isWritable())
     {
-        openHeaderEntriesFile(false, 0);
-        updatedHeaderEntriesFile() ;
-        closeHeaderEntriesFile();
+        mHeaderEntriesMap.flush();
     }
     unlockHeaders() ;
 }
-
-//mHeaderMutex is locked and mHeaderAPRFile is created before calling this.
-void LLTextureCache::updatedHeaderEntriesFile()
-{
-    if (!mReadOnly && !mUpdatedEntryMap.empty() && mHeaderAPRFile)
-    {
-        //entriesInfo
-        mHeaderAPRFile->seek(APR_SET, 0);
-        S32 bytes_written = mHeaderAPRFile->write((U8*)&mHeaderEntriesInfo, sizeof(EntriesInfo)) ;
-        if(bytes_written != sizeof(EntriesInfo))
-        {
-            clearCorruptedCache() ; //clear the cache.
-            return ;
-        }
-
-        //write each updated entry
-        S32 entry_size = (S32)sizeof(Entry) ;
-        S32 prev_idx = -1 ;
-        S32 delta_idx ;
-        for (idx_entry_map_t::iterator iter = mUpdatedEntryMap.begin(); iter != mUpdatedEntryMap.end(); ++iter)
-        {
-            delta_idx = iter->first - prev_idx - 1;
-            prev_idx = iter->first ;
-            if(delta_idx)
-            {
-                mHeaderAPRFile->seek(APR_CUR, delta_idx * entry_size);
-            }
-
-            bytes_written = mHeaderAPRFile->write((void*)(&iter->second), entry_size);
-            if(bytes_written != entry_size)
-            {
-                clearCorruptedCache() ; //clear the cache.
-                return ;
-            }
-        }
-        mUpdatedEntryMap.clear() ;
-    }
-}
 //----------------------------------------------------------------------------
 
 // Called from either the main thread or the worker thread
 void LLTextureCache::readHeaderCache()
 {
-    mHeaderMutex.lock();
+    lockHeaders(); // <FS/> Shared texture cache
 
     mLRU.clear(); // always clear the LRU
 
@@ -1471,8 +1967,8 @@ void LLTextureCache::readHeaderCache()
     }
     else
     {
-        std::vector<Entry> entries;
-        U32 num_entries = openAndReadEntries(entries);
+        U32 num_entries = openAndReadEntries();
+        Entry* entries = getMappedEntries();
         if (num_entries)
         {
             U32 empty_entries = 0;
@@ -1518,6 +2014,7 @@ void LLTextureCache::readHeaderCache()
             }
 
             {
+                mLRUTime = (U32)time(NULL);
                 S32 lru_entries = (S32)((F32)sCacheMaxEntries * TEXTURE_CACHE_LRU_SIZE);
                 for (std::set<lru_data_t>::iterator iter = lru.begin(); iter != lru.end(); ++iter)
                 {
@@ -1528,7 +2025,7 @@ void LLTextureCache::readHeaderCache()
                 }
             }
 
-            if (purge_list.size() > 0)
+            if (purge_list.size() > 0 && mSharedCacheOwner) // <FS/> Shared texture cache: only the owner purges
             {
                 LLTimer timer;
                 for (std::set<U32>::iterator iter = purge_list.begin(); iter != purge_list.end(); ++iter)
@@ -1542,15 +2039,11 @@ void LLTextureCache::readHeaderCache()
                         break;
                     }
                 }
-                writeEntriesAndClose(entries);
-            }
-            else
-            {
-                //entries are not changed, nothing here.
+                // removeEntry() updated the mapped records in place
             }
         }
     }
-    mHeaderMutex.unlock();
+    unlockHeaders(); // <FS/> Shared texture cache
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1560,8 +2053,7 @@ void LLTextureCache::clearCorruptedCache()
 {
     LL_WARNS() << "the texture cache is corrupted, need to be cleared." << LL_ENDL ;
 
-    closeHeaderEntriesFile();//close possible file handler
-    purgeAllTextures(false) ; //clear the cache.
+    purgeAllTextures(false) ; //clear the cache, this also unmaps the entries file
 
     if (!mReadOnly) //regenerate the directory tree if not exists.
     {
@@ -1580,7 +2072,34 @@ void LLTextureCache::clearCorruptedCache()
 
 void LLTextureCache::purgeAllTextures(bool purge_directories)
 {
-    if (!mReadOnly)
+    HeaderLock lock(this); // <FS/> Shared texture cache
+
+    // <FS> Drop every index first so no worker is left reading the mapping,
+    // then unmap the entries file so it can be deleted below. With a shared
+    // cache the other viewers keep the headers mapped and the lock files
+    // open: only delete the texture bodies and empty the records in place.
+    mHeaderIDMap.clear();
+
+    bool shared = mSharedCache && !mReadOnly;
+    if (shared)
+    {
+        const char* subdirs = "0123456789abcdef";
+        std::string delem = gDirUtilp->getDirDelimiter();
+        for (S32 i=0; i<16; i++)
+        {
+            std::string dirname = mTexturesDirName + delem + subdirs[i];
+            LL_INFOS() << "Deleting files in directory: " << dirname << LL_ENDL;
+            gDirUtilp->deleteFilesInDir(dirname, "*");
+        }
+        clearSharedEntries();
+    }
+    else
+    {
+        closeHeaderEntriesFile();
+    }
+
+    if (!mReadOnly && !shared)
+    // </FS>
     {
 // <FS:ND> Windows can be really slow deleting a huge texture cache.
 // In case of a full purge rename the directory and then purge this using a low priority background thread.
@@ -1604,6 +2123,9 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
         const char* subdirs = "0123456789abcdef";
         std::string delem = gDirUtilp->getDirDelimiter();
         std::string mask = "*";
+        // <FS> Leave the lock files alone, they may be held by this viewer
+        std::string headers_mask = "*.{entries,cache,changes}";
+        // </FS>
         for (S32 i=0; i<16; i++)
         {
             std::string dirname = mTexturesDirName + delem + subdirs[i];
@@ -1627,7 +2149,7 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
         if (LLFile::isdir(mTexturesDirName))
         {
         // </FS:Ansariel>
-        gDirUtilp->deleteFilesInDir(mTexturesDirName, mask); // headers, fast cache
+        gDirUtilp->deleteFilesInDir(mTexturesDirName, headers_mask); // headers, fast cache // <FS/> was mask
         if (purge_directories)
         {
             LLFile::rmdir(mTexturesDirName);
@@ -1642,7 +2164,6 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
     mTexturesSizeTotal = 0;
     mFreeList.clear();
     mTexturesSizeTotal = 0;
-    mUpdatedEntryMap.clear();
 
     // Info with 0 entries
     setEntriesHeader();
@@ -1653,7 +2174,7 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
 
 void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
 {
-    if (mReadOnly)
+    if (mReadOnly || !mSharedCacheOwner) // <FS/> Shared texture cache: only the owner purges
     {
         return;
     }
@@ -1664,14 +2185,13 @@ void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
     }
 
     // time_limit doesn't account for lock time
-    LLMutexLock lock(&mHeaderMutex);
+    HeaderLock lock(this); // <FS/> Shared texture cache
 
     if (mPurgeEntryList.empty())
     {
-        // Read the entries list and form list of textures to purge
-        std::vector<Entry> entries;
-        U32 num_entries = openAndReadEntries(entries);
-        if (!num_entries)
+        // Form list of textures to purge from the mapped entries
+        Entry* entries = getMappedEntries();
+        if (!entries || !mHeaderEntriesInfo.mEntries)
         {
             return; // nothing to purge
         }
@@ -1684,10 +2204,9 @@ void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
         {
             if (iter1->second > 0)
             {
-                id_map_t::iterator iter2 = mHeaderIDMap.find(iter1->first);
-                if (iter2 != mHeaderIDMap.end())
+                S32 idx = mHeaderIDMap.find(iter1->first);
+                if (idx >= 0)
                 {
-                    S32 idx = iter2->second;
                     time_idx_set.insert(std::make_pair(entries[idx].mTime, idx));
                 }
                 else
@@ -1725,8 +2244,7 @@ void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
             Entry entry = mPurgeEntryList.back().second;
             mPurgeEntryList.pop_back();
             // make sure record is still valid
-            id_map_t::iterator iter_header = mHeaderIDMap.find(entry.mID);
-            if (iter_header != mHeaderIDMap.end() && iter_header->second == idx)
+            if (mHeaderIDMap.find(entry.mID) == idx)
             {
                 std::string tex_filename = getTextureFileName(entry.mID);
                 removeEntry(idx, entry, tex_filename);
@@ -1738,7 +2256,7 @@ void LLTextureCache::purgeTexturesLazy(F32 time_limit_sec)
 
 void LLTextureCache::purgeTextures(bool validate)
 {
-    if (mReadOnly)
+    if (mReadOnly || !mSharedCacheOwner) // <FS/> Shared texture cache: only the owner purges
     {
         return;
     }
@@ -1749,14 +2267,14 @@ void LLTextureCache::purgeTextures(bool validate)
         LLAppViewer::instance()->pauseMainloopTimeout();
     }
 
-    LLMutexLock lock(&mHeaderMutex);
+    HeaderLock lock(this); // <FS/> Shared texture cache
 
     LL_INFOS() << "TEXTURE CACHE: Purging." << LL_ENDL;
 
-    // Read the entries list
-    std::vector<Entry> entries;
-    U32 num_entries = openAndReadEntries(entries);
-    if (!num_entries)
+    // The entries list is the mapped entries file
+    Entry* entries = getMappedEntries();
+    U32 num_entries = mHeaderEntriesInfo.mEntries;
+    if (!entries || !num_entries)
     {
         return; // nothing to purge
     }
@@ -1769,10 +2287,9 @@ void LLTextureCache::purgeTextures(bool validate)
     {
         if (iter1->second > 0)
         {
-            id_map_t::iterator iter2 = mHeaderIDMap.find(iter1->first);
-            if (iter2 != mHeaderIDMap.end())
+            S32 idx = mHeaderIDMap.find(iter1->first);
+            if (idx >= 0)
             {
-                S32 idx = iter2->second;
                 time_idx_set.insert(std::make_pair(entries[idx].mTime, idx));
 //              LL_INFOS() << "TIME: " << entries[idx].mTime << " TEX: " << entries[idx].mID << " IDX: " << idx << " Size: " << entries[idx].mImageSize << LL_ENDL;
             }
@@ -1838,9 +2355,7 @@ void LLTextureCache::purgeTextures(bool validate)
         }
     }
 
-    LL_DEBUGS("TextureCache") << "TEXTURE CACHE: Writing Entries: " << num_entries << LL_ENDL;
-
-    writeEntriesAndClose(entries);
+    // removeEntry() updated the mapped records in place
 
     // *FIX:Mani - watchdog back on.
     LLAppViewer::instance()->resumeMainloopTimeout();
@@ -1886,7 +2401,31 @@ LLTextureCacheWorker* LLTextureCache::getWriter(handle_t handle)
 S32 LLTextureCache::getHeaderCacheEntry(const LLUUID& id, Entry& entry)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
-    LLMutexLock lock(&mHeaderMutex);
+    // <FS> Hit path: lock only the id's shard and copy the record straight
+    // out of the mapped entries file
+    {
+        LLMutexLock lock(mHeaderIDMap.getMutex(id));
+        S32 idx = mHeaderIDMap.find(id);
+        Entry* entries = getMappedEntries();
+        if (idx >= 0 && entries && (U32)idx < mHeaderEntriesCapacity)
+        {
+            entry = entries[idx];
+            if (entry.mID == id && entry.mImageSize > entry.mBodySize)
+            {
+                updateEntryTimeStamp(idx, entry); // updates time
+                return idx;
+            }
+        }
+        else if (idx < 0 && (!mSharedCache || !haveSharedChanges()))
+        {
+            // Not cached, unless another viewer sharing the cache added it
+            // since we last synced
+            return -1;
+        }
+    }
+    // Bad record: take the slow path, which removes it
+    HeaderLock lock(this);
+    // </FS>
     S32 idx = openAndReadEntry(id, entry, false);
     if (idx >= 0)
     {
@@ -1899,24 +2438,38 @@ S32 LLTextureCache::getHeaderCacheEntry(const LLUUID& id, Entry& entry)
 S32 LLTextureCache::setHeaderCacheEntry(const LLUUID& id, Entry& entry, S32 imagesize, S32 datasize)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
-    mHeaderMutex.lock();
+    // <FS> Shared texture cache: reserve the slot and fill it in under one
+    // header lock, so no other viewer sees it half done
+    //mHeaderMutex.lock();
+    //S32 idx = openAndReadEntry(id, entry, true); // read or create
+    //mHeaderMutex.unlock();
+    lockHeaders();
     S32 idx = openAndReadEntry(id, entry, true); // read or create
-    mHeaderMutex.unlock();
+    if (idx >= 0)
+    {
+        updateEntry(idx, entry, imagesize, datasize);
+    }
+    unlockHeaders();
 
     if(idx < 0) // retry once
     {
         readHeaderCache(); // We couldn't write an entry, so refresh the LRU
 
-        mHeaderMutex.lock();
+        lockHeaders();
         idx = openAndReadEntry(id, entry, true);
-        mHeaderMutex.unlock();
-    }
-
-    if (idx >= 0)
-    {
-        updateEntry(idx, entry, imagesize, datasize);
+        if (idx >= 0)
+        {
+            updateEntry(idx, entry, imagesize, datasize);
+        }
+        unlockHeaders();
     }
-    else
+    //if (idx >= 0)
+    //{
+    //    updateEntry(idx, entry, imagesize, datasize);
+    //}
+    //else
+    if (idx < 0)
+    // </FS>
     {
         LL_WARNS() << "Failed to set cache entry for image: " << id << LL_ENDL;
         // We couldn't write to file, switch to read only mode and clear data
@@ -2031,18 +2584,12 @@ LLTextureCache::handle_t LLTextureCache::writeToCache(const LLUUID& id,
 //called in the main thread
 LLPointer<LLImageRaw> LLTextureCache::readFromFastCache(const LLUUID& id, S32& discardlevel)
 {
-    U32 offset;
+    S32 idx = mHeaderIDMap.find(id);
+    if (idx < 0)
     {
-        LLMutexLock lock(&mHeaderMutex);
-        id_map_t::const_iterator iter = mHeaderIDMap.find(id);
-        if(iter == mHeaderIDMap.end())
-        {
-            return NULL; //not in the cache
-        }
-
-        offset = iter->second;
+        return NULL; //not in the cache
     }
-    offset *= TEXTURE_FAST_CACHE_ENTRY_SIZE;
+    U32 offset = (U32)idx * TEXTURE_FAST_CACHE_ENTRY_SIZE;
 
     U8* data;
     S32 head[4];
@@ -2287,11 +2834,16 @@ void LLTextureCache::removeEntry(S32 idx, Entry& entry, std::string& filename)
         }
         mTexturesSizeTotal -= entry.mBodySize;
 
-        entry.mImageSize = -1;
-        entry.mBodySize = 0;
-        mHeaderIDMap.erase(entry.mID);
+        {
+            // entry may be the mapped record itself
+            LLMutexLock lock(mHeaderIDMap.getMutex(entry.mID));
+            entry.mImageSize = -1;
+            entry.mBodySize = 0;
+            mHeaderIDMap.erase(entry.mID);
+        }
         mTexturesSizeMap.erase(entry.mID);
         mFreeList.insert(idx);
+        pushSharedChange(idx, entry.mID); // <FS/> Shared texture cache
     }
 
     if (file_maybe_exists)
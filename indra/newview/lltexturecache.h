@@ -28,10 +28,14 @@
 #define LL_LLTEXTURECACHE_H
 
 #include "lldir.h"
+#include "llfile.h"
 #include "llstl.h"
 #include "llstring.h"
 #include "lluuid.h"
 
+#include <atomic>
+#include <unordered_map>
+
 #include "llworkerthread.h"
 
 class LLImageFormatted;
@@ -46,9 +50,12 @@ class LLTextureCache : public LLWorkerThread
 
 private:
 
-#if LL_WINDOWS
+// <FS> Packed everywhere, not just on Windows: the entries file is shared
+// and mapped, and its records start right after the 44 byte EntriesInfo
+//#if LL_WINDOWS
 #pragma pack(push,1)
-#endif
+//#endif
+// </FS>
 
     // Entries
     static const U32 sHeaderEncoderStringSize = 32;
@@ -65,22 +72,74 @@ private:
             Entry() :
                 mBodySize(0),
             mImageSize(0),
-            mTime(0)
+            mTime(0),
+            mDigest(0)
         {
         }
         Entry(const LLUUID& id, S32 imagesize, S32 bodysize, U32 time) :
-            mID(id), mImageSize(imagesize), mBodySize(bodysize), mTime(time) {}
-        void init(const LLUUID& id, U32 time) { mID = id, mImageSize = 0; mBodySize = 0; mTime = time; }
-        Entry& operator=(const Entry& entry) {mID = entry.mID, mImageSize = entry.mImageSize; mBodySize = entry.mBodySize; mTime = entry.mTime; return *this;}
+            mID(id), mImageSize(imagesize), mBodySize(bodysize), mTime(time), mDigest(0) {}
+        void init(const LLUUID& id, U32 time) { mID = id, mImageSize = 0; mBodySize = 0; mTime = time; mDigest = 0; }
+        Entry& operator=(const Entry& entry) {mID = entry.mID, mImageSize = entry.mImageSize; mBodySize = entry.mBodySize; mTime = entry.mTime; mDigest = entry.mDigest; return *this;}
         LLUUID mID; // 16 bytes
         S32 mImageSize; // total size of image if known
         S32 mBodySize; // size of body file in body cache
         U32 mTime; // seconds since 1/1/1970
+        U64 mDigest; // <FS/> HBXXH64 of the header record followed by the body, 0 if unknown
+    };
+    static_assert(sizeof(Entry) == 36, "texture.entries records must be the same on every platform"); // <FS/>
+
+    // <FS> Shared texture cache: texture.changes is a ring of the entry
+    // slots whose texture id or validity changed, so that every viewer
+    // using the cache can bring its in-memory index up to date with what
+    // the others did. A viewer that falls further behind than the ring
+    // holds rereads the whole entries file.
+    static const U32 SHARED_CHANGE_COUNT = 256;
+    struct SharedChange
+    {
+        LLUUID mOldID; // id the slot held before the change
+        S32 mIndex;
+    };
+    struct SharedChanges
+    {
+        U32 mChangeCount;
+        SharedChange mChanges[SHARED_CHANGE_COUNT];
     };
+    // </FS>
 
-#if LL_WINDOWS
+// <FS> See above
+//#if LL_WINDOWS
 #pragma pack(pop)
-#endif
+//#endif
+// </FS>
+
+    // <FS> Texture id -> entry index, split over independently locked
+    // shards so that lookups from the LLTextureFetch workers don't all
+    // serialise on mHeaderMutex. Holding the lock of the shard an id lives
+    // in (getMutex()) also gives access to that id's record in the mapped
+    // entries file. Lock order is mHeaderMutex first, then a shard.
+    class EntryIDMap
+    {
+    public:
+        static const U32 SHARD_COUNT = 32;
+
+        LLMutex* getMutex(const LLUUID& id) { return &getShard(id).mMutex; }
+
+        S32 find(const LLUUID& id); // -1 if not in the map
+        void set(const LLUUID& id, S32 idx);
+        void erase(const LLUUID& id);
+        void clear();
+
+    private:
+        struct Shard
+        {
+            LLMutex mMutex;
+            std::unordered_map<LLUUID, S32> mMap;
+        };
+        Shard& getShard(const LLUUID& id) { return mShards[id.mData[0] % SHARD_COUNT]; }
+
+        Shard mShards[SHARD_COUNT];
+    };
+    // </FS>
 
 public:
 
@@ -117,6 +176,15 @@ public:
 
     void purgeCache(ELLPath location, bool remove_dir = true);
     void setReadOnly(bool read_only) ;
+    // <FS> Share the cache folder with other viewers that do the same.
+    // Must be called before initCache(), like setReadOnly().
+    void setSharedCache(bool shared) { mSharedCache = shared; }
+
+    // <FS> Cache integrity checks: read back about max_bytes worth of
+    // entries, carrying on where the last call stopped, and evict the ones
+    // that no longer match their digest. Returns the number of bytes checked.
+    // Called from FSCacheScrubberThread.
+    S64 scrub(S64 max_bytes);
     S64 initCache(ELLPath location, S64 maxsize, bool texture_cache_mismatch);
 
     handle_t readFromCache(const std::string& local_filename, const LLUUID& id, S32 offset, S32 size,
@@ -165,26 +233,47 @@ private:
     void purgeAllTextures(bool purge_directories);
     void purgeTexturesLazy(F32 time_limit_sec);
     void purgeTextures(bool validate);
-    LLAPRFile* openHeaderEntriesFile(bool readonly, S32 offset);
+    bool openHeaderEntriesFile();
     void closeHeaderEntriesFile();
+    Entry* getMappedEntries() const;
     void readEntriesHeader();
     void setEntriesHeader();
     void writeEntriesHeader();
+    void updateTimeStampMode();
     S32 openAndReadEntry(const LLUUID& id, Entry& entry, bool create);
     bool updateEntry(S32& idx, Entry& entry, S32 new_image_size, S32 new_body_size);
     void updateEntryTimeStamp(S32 idx, Entry& entry) ;
-    U32 openAndReadEntries(std::vector<Entry>& entries);
-    void writeEntriesAndClose(const std::vector<Entry>& entries);
-    void readEntryFromHeaderImmediately(S32& idx, Entry& entry) ;
+    void setEntryDigest(S32 idx, const LLUUID& id, U64 digest); // <FS/> Cache integrity checks
+    U32 openAndReadEntries();
     void writeEntryToHeaderImmediately(S32& idx, Entry& entry, bool write_header = false) ;
     void removeEntry(S32 idx, Entry& entry, std::string& filename);
     void removeCachedTexture(const LLUUID& id) ;
     S32 getHeaderCacheEntry(const LLUUID& id, Entry& entry);
     S32 setHeaderCacheEntry(const LLUUID& id, Entry& entry, S32 imagesize, S32 datasize);
     void writeUpdatedEntries() ;
-    void updatedHeaderEntriesFile() ;
-    void lockHeaders() { mHeaderMutex.lock(); }
-    void unlockHeaders() { mHeaderMutex.unlock(); }
+    // <FS> Shared texture cache: with sharing on these also take the
+    // cross-viewer header lock and catch up with the other viewers' changes
+    void lockHeaders();
+    void unlockHeaders();
+    class HeaderLock
+    {
+    public:
+        HeaderLock(LLTextureCache* cache) : mCache(cache) { mCache->lockHeaders(); }
+        ~HeaderLock() { mCache->unlockHeaders(); }
+    private:
+        LLTextureCache* mCache;
+    };
+
+    void initSharedCache();
+    void updateSharedCacheOwner();
+    SharedChanges* getSharedChanges() const;
+    bool haveSharedChanges() const;
+    void syncSharedEntries();
+    void applySharedChange(S32 idx, const LLUUID& old_id);
+    void forgetSharedEntry(const LLUUID& id);
+    void pushSharedChange(S32 idx, const LLUUID& old_id);
+    void clearSharedEntries();
+    // </FS>
 
     void openFastCache(bool first_time = false);
     void closeFastCache(bool forced = false);
@@ -196,9 +285,17 @@ private:
     LLMutex mHeaderMutex;
     LLMutex mListMutex;
     LLMutex mFastCacheMutex;
-    LLAPRFile* mHeaderAPRFile;
     LLVolatileAPRPool* mFastCachePoolp;
 
+    // <FS> texture.entries mapped into memory: an EntriesInfo followed by
+    // room for mHeaderEntriesCapacity fixed size Entry records. The records
+    // and their count are published by openHeaderEntriesFile() and withdrawn
+    // by closeHeaderEntriesFile() under mHeaderMutex, while the hit path of
+    // getHeaderCacheEntry() reads them under a shard lock only.
+    LLMappedFile mHeaderEntriesMap;
+    std::atomic<Entry*> mHeaderEntries{ nullptr };
+    std::atomic<U32> mHeaderEntriesCapacity{ 0 };
+
     // mLocalAPRFilePoolp is not thread safe and is meant only for workers
     // howhever mHeaderEntriesFileName is accessed not from workers' threads
     // so it needs own pool (not thread safe by itself, relies onto header's mutex)
@@ -225,8 +322,24 @@ private:
     EntriesInfo mHeaderEntriesInfo;
     std::set<S32> mFreeList; // deleted entries
     std::set<LLUUID> mLRU;
-    typedef std::map<LLUUID, S32> id_map_t;
-    id_map_t mHeaderIDMap;
+    U32 mLRUTime{ 0 }; // entries stamped after this have been used since mLRU was built
+    EntryIDMap mHeaderIDMap;
+    std::atomic<bool> mStampEntryTimes{ false };
+
+    // <FS> Shared texture cache
+    bool mSharedCache{ false };
+    std::atomic<bool> mSharedCacheOwner{ true };    // only the owner purges
+    LLFileLock mSharedModeLock;     // shared by viewers sharing the cache, exclusive otherwise
+    LLFileLock mSharedOwnerLock;
+    LLFileLock mHeaderFileLock;     // held along with mHeaderMutex
+    U32 mHeaderLockDepth{ 0 };      // mHeaderMutex is recursive, the file lock isn't
+    std::string mHeaderLockFileName;
+    std::string mSharedOwnerFileName;
+    LLMappedFile mSharedChangesMap;
+    std::atomic<U32> mSharedChangeCount{ 0 }; // changes already applied to our index
+    // </FS>
+
+    U32 mScrubIndex{ 0 }; // <FS/> next entry scrub() checks
 
     LLAPRFile*   mFastCachep;
     LLFrameTimer mFastCacheTimer;
@@ -239,8 +352,6 @@ private:
     S64 mTexturesSizeTotal;
     LLAtomicBool mDoPurge;
 
-    typedef std::map<S32, Entry> idx_entry_map_t;
-    idx_entry_map_t mUpdatedEntryMap;
     typedef std::vector<std::pair<S32, Entry> > idx_entry_vector_t;
     idx_entry_vector_t mPurgeEntryList;
 
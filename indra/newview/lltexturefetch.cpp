@@ -469,6 +469,9 @@ private:
     // Locks:  Mw
     void setImagePriority(F32 priority);
 
+    // <FS> Decode class for mImagePriority
+    LL::PriorityWorkQueue::Priority getDecodePriority() const;
+
     // Locks:  Mw (ctor invokes without lock)
     void setDesiredDiscard(S32 discard, S32 size);
 
@@ -586,6 +589,10 @@ private:
                                 mCachedSize;
     e_request_state mSentRequest;
     handle_t mDecodeHandle;
+    // <FS> The queued decode, to move or drop it until a worker starts it
+    LL::PriorityWorkQueue::Handle mDecodeWorkHandle;
+    LL::PriorityWorkQueue::Priority mDecodePriority;
+    // </FS>
     bool mLoaded;
     bool mDecoded;
     bool mWritten;
@@ -931,6 +938,8 @@ LLTextureFetchWorker::LLTextureFetchWorker(LLTextureFetch* fetcher,
       mLoaded(false),
       mSentRequest(UNSENT),
       mDecodeHandle(0),
+      mDecodeWorkHandle(LL::PriorityWorkQueue::NO_HANDLE), // <FS/>
+      mDecodePriority(LL::PriorityWorkQueue::NORMAL), // <FS/>
       mDecoded(false),
       mWritten(false),
       mNeedsAux(false),
@@ -1097,7 +1106,39 @@ void LLTextureFetchWorker::setDesiredDiscard(S32 discard, S32 size)
 void LLTextureFetchWorker::setImagePriority(F32 priority)
 {
     mImagePriority = priority; //should map to max virtual size, abort if zero
+
+    // <FS> A decode that no worker has started yet follows the texture on
+    // or off screen
+    if (mDecodeHandle != 0 && mDecodeWorkHandle != LL::PriorityWorkQueue::NO_HANDLE)
+    {
+        LL::PriorityWorkQueue::Priority decode_priority = getDecodePriority();
+        if (decode_priority != mDecodePriority)
+        {
+            LLImageDecodeThread* decode_thread = LLAppViewer::getImageDecodeThread();
+            if (decode_thread && decode_thread->setDecodePriority(mDecodeWorkHandle, decode_priority))
+            {
+                mDecodePriority = decode_priority;
+            }
+            else
+            {
+                // already decoding
+                mDecodeWorkHandle = LL::PriorityWorkQueue::NO_HANDLE;
+            }
+        }
+    }
+    // </FS>
+}
+
+// <FS> Decode what is on screen or boosted ahead of prefetched textures.
+// mImagePriority is the texture's max virtual size: boosted textures get a
+// full resolution one, and it drops to 10 or less for textures that haven't
+// been visible for a while (see LLViewerLODTexture::processTextureStats()).
+LL::PriorityWorkQueue::Priority LLTextureFetchWorker::getDecodePriority() const
+{
+    static const F32 MIN_VISIBLE_PRIORITY = 10.f;
+    return mImagePriority > MIN_VISIBLE_PRIORITY ? LL::PriorityWorkQueue::HIGH : LL::PriorityWorkQueue::NORMAL;
 }
+// </FS>
 
 // Locks:  Mw
 void LLTextureFetchWorker::resetFormattedData()
@@ -1971,10 +2012,15 @@ bool LLTextureFetchWorker::doWork(S32 param)
         // In case worked manages to request decode, be shut down,
         // then init and request decode again with first decode
         // still in progress, assign a sufficiently unique id
+        // <FS> Decode what is on screen or boosted first, see getDecodePriority()
+        mDecodePriority = getDecodePriority();
         mDecodeHandle = LLAppViewer::getImageDecodeThread()->decodeImage(mFormattedImage,
                                                                        discard,
                                                                        mNeedsAux,
-                                                                       new DecodeResponder(mFetcher, mID, this));
+                                                                       new DecodeResponder(mFetcher, mID, this),
+                                                                       mDecodePriority,
+                                                                       &mDecodeWorkHandle);
+        // </FS>
         if (mDecodeHandle == 0)
         {
             // Abort, failed to put into queue.
@@ -2232,7 +2278,15 @@ void LLTextureFetchWorker::endWork(S32 param, bool aborted)
     LL_PROFILE_ZONE_SCOPED;
     if (mDecodeHandle != 0)
     {
-        // LL::ThreadPool has no operation to cancel a particular work item
+        // <FS> Drop the decode if no worker has started it yet
+        //// LL::ThreadPool has no operation to cancel a particular work item
+        LLImageDecodeThread* decode_thread = LLAppViewer::getImageDecodeThread();
+        if (decode_thread && mDecodeWorkHandle != LL::PriorityWorkQueue::NO_HANDLE)
+        {
+            decode_thread->cancelDecode(mDecodeWorkHandle);
+        }
+        mDecodeWorkHandle = LL::PriorityWorkQueue::NO_HANDLE;
+        // </FS>
         mDecodeHandle = 0;
     }
     mFormattedImage = NULL;
@@ -304,6 +304,7 @@ void LLViewerAssetStorage::storeAssetData(
             file.write(copy_buf, size);
         }
         fclose(fp);
+        file.close(); // <FS/> Pack-file storage: store it before the upload reads it
 
         // if this upload fails, the caller needs to setup a new tempfile for us
         if (temp_file)
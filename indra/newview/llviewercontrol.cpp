@@ -113,6 +113,7 @@
 #include "llviewerregion.h"
 #include "NACLantispam.h"
 #include "nd/ndlogthrottle.h"
+#include "llflightrecorder.h" // <FS/> Frame hitch flight recorder
 // <FS:Zi> Run Prio 0 default bento pose in the background to fix splayed hands, open mouths, etc.
 #include "llanimationstates.h"
 
@@ -927,6 +928,23 @@ void handleLogThrottleChanged(const LLSD& newvalue)
 }
 // </FS:Ansariel>
 
+// <FS> Asynchronous logging
+void handleAsyncLoggingChanged(const LLSD& newvalue)
+{
+    LLError::setAsyncLogging(newvalue.asBoolean());
+}
+// </FS>
+
+// <FS> Frame hitch flight recorder
+void handleFlightRecorderChanged()
+{
+    LLTrace::FlightRecorder::configure(gSavedSettings.getF32("FSFlightRecorderThreshold"),
+                                       gSavedSettings.getU32("FSFlightRecorderFrames"),
+                                       gDirUtilp->getExpandedFilename(LL_PATH_LOGS, ""));
+    LLTrace::FlightRecorder::setEnabled(gSavedSettings.getBOOL("FSFlightRecorder"));
+}
+// </FS>
+
 // <FS:Ansariel> FIRE-18250: Option to disable default eye movement
 void handleStaticEyesChanged()
 {
@@ -1471,6 +1489,12 @@ void settings_setup_listeners()
 
     // <FS:Ansariel> Debug setting to disable log throttle
     setting_setup_signal_listener(gSavedSettings, "FSEnableLogThrottle", handleLogThrottleChanged);
+    setting_setup_signal_listener(gSavedSettings, "FSAsyncLogging", handleAsyncLoggingChanged); // <FS/> Asynchronous logging
+    // <FS> Frame hitch flight recorder
+    setting_setup_signal_listener(gSavedSettings, "FSFlightRecorder", handleFlightRecorderChanged);
+    setting_setup_signal_listener(gSavedSettings, "FSFlightRecorderThreshold", handleFlightRecorderChanged);
+    setting_setup_signal_listener(gSavedSettings, "FSFlightRecorderFrames", handleFlightRecorderChanged);
+    // </FS>
 
     // <FS:Ansariel> FIRE-18250: Option to disable default eye movement
     setting_setup_signal_listener(gSavedSettings, "FSStaticEyesUUID", handleStaticEyesChanged);
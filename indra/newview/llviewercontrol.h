@@ -50,6 +50,9 @@ void create_graphics_group(LLControlGroup& group);
 // <FS:Ansariel> Expose handleSetShaderChanged()
 bool handleSetShaderChanged(const LLSD& newvalue);
 
+// <FS> Frame hitch flight recorder: apply the FSFlightRecorder* settings
+void handleFlightRecorderChanged();
+
 // saved at end of session
 extern LLControlGroup gSavedSettings;
 extern LLControlGroup gSavedPerAccountSettings;
@@ -987,6 +987,13 @@ void LLViewerInventoryCategory::changeType(LLFolderType::EType new_folder_type)
     gInventory.addChangedMask(LLInventoryObserver::LABEL, folder_id);
 }
 
+// <FS>
+void LLViewerInventoryItem::localizeName()
+{
+    LLLocalizedInventoryItemsDictionary::getInstance()->localizeInventoryObjectName(mName);
+}
+// </FS>
+
 void LLViewerInventoryCategory::localizeName()
 {
     LLLocalizedInventoryItemsDictionary::getInstance()->localizeInventoryObjectName(mName);
@@ -137,6 +137,7 @@ public:
     // new methods
     bool isFinished() const { return mIsComplete; }
     void setComplete(bool complete) { mIsComplete = complete; }
+    void localizeName(); // <FS/> for items not created through unpackMessage, e.g. FSInventoryCache
     //void updateAssetOnServer() const;
 
     virtual void setTransactionID(const LLTransactionID& transaction_id);
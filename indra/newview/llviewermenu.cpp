@@ -2589,7 +2589,7 @@ class LLAdvancedPurgeDiskCache : public view_listener_t
     bool handleEvent(const LLSD& userdata)
     {
         LL::WorkQueue::ptr_t main_queue = LL::WorkQueue::getInstance("mainloop");
-        LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+        LL::WorkQueueBase::ptr_t general_queue = LL::WorkQueueBase::getInstance("General");
         llassert_always(main_queue);
         llassert_always(general_queue);
         main_queue->postTo(
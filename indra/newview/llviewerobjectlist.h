@@ -33,6 +33,7 @@
 // common includes
 #include "llstring.h"
 #include "lltrace.h"
+#include "lluuidhashmap.h" // <FS/> Flat UUID object map
 
 // project includes
 #include "llviewerobject.h"
@@ -218,7 +219,10 @@ protected:
     uuid_multiset_t   mDeadObjects;
     // </FS:Beq>
 
-    std::map<LLUUID, LLPointer<LLViewerObject> > mUUIDObjectMap;
+    // <FS> Flat UUID object map: findObject() runs for every object update
+    //std::map<LLUUID, LLPointer<LLViewerObject> > mUUIDObjectMap;
+    LLUUIDHashMap<LLPointer<LLViewerObject> > mUUIDObjectMap;
+    // </FS>
 
     //set of objects that need to update their cost
     uuid_set_t   mStaleObjectCost;
@@ -62,6 +62,7 @@
 #include "lltexturecache.h"
 #include "llviewerwindow.h"
 #include "llwindow.h"
+#include "fsregionprefetch.h" // <FS> Region prefetch profiles
 ///////////////////////////////////////////////////////////////////////////////
 
 // statics
@@ -2180,6 +2181,16 @@ bool LLViewerFetchedTexture::updateFetch()
             mRequestedDiscardLevel = llmin(desired_discard, fetch_request_discard);
             mFetchState = LLAppViewer::getTextureFetch()->getFetchState(mID, mDownloadProgress, mRequestedDownloadPriority,
                                                        mFetchPriority, mFetchDeltaTime, mRequestDeltaTime, mCanUseHTTP);
+
+            // <FS> Region prefetch profiles
+            // Only record fetches for textures something in the scene is
+            // drawing, so speculative and UI requests don't end up in the
+            // profile (or count as hits)
+            if (mFTType == FTT_DEFAULT && getTotalNumFaces() > 0)
+            {
+                FSRegionPrefetch::instance().recordTexture(getID(), mRequestedDiscardLevel, mMaxVirtualSize);
+            }
+            // </FS>
         }
 
         // If createRequest() failed, that means one of two things:
@@ -35,6 +35,12 @@
 #include "llsdserialize.h"
 #include "llagent.h" // <FS:Beq/> For gAgent
 #include "llworld.h" // For LLWorld::getInstance()
+#include "workqueue.h"
+#ifdef LL_USESYSTEMLIBS
+#include <zlib.h>
+#else
+#include "zlib-ng/zlib.h"
+#endif
 
 //static variables
 U32 LLVOCacheEntry::sMinFrameRange = 0;
@@ -57,6 +63,134 @@ bool check_write(LLAPRFile* apr_file, void* src, S32 n_bytes)
     return apr_file->write(src, n_bytes) == n_bytes ;
 }
 
+// <FS> Compressed cache files
+//
+// An object cache file in the legacy layout is
+//   [region id][S32 num_entries][entries...]
+// and a compressed one is
+//   [region id][S32 COMPRESSED_FILE_MARKER][U32 version][S32 num_entries]
+//   [U32 dictionary size][dictionary][entries...]
+// num_entries is never negative, so the marker tells the two apart and old
+// caches keep loading. A compressed entry has one more header field, the
+// size of its body in the file, and the body is raw-deflated on its own.
+// A body is a few hundred bytes, too little for deflate to find much to
+// match on its own, so every body is packed against a preset dictionary of
+// sample bodies from the same region: that is where the texture ids, prim
+// parameters and object layouts it repeats are. The file is mapped like a
+// legacy one and the bodies are inflated on the General queue after the
+// region has loaded, ahead of getDP() asking for them.
+// A body that doesn't shrink is stored as is, with both sizes equal.
+const S32 COMPRESSED_FILE_MARKER = -1;
+const U32 COMPRESSED_FILE_VERSION = 3;
+const S32 COMPRESSED_ENTRY_HEADER_SIZE = ENTRY_HEADER_SIZE + sizeof(S32);
+// zlib only looks back 32KB, and the entry itself takes part of that
+const U32 DICTIONARY_SIZE = 16384;
+
+namespace
+{
+// Raw deflate and inflate of single entry bodies. The zlib state is kept
+// between entries: setting it up costs far more than packing one body.
+class LLVOCacheBodyCodec
+{
+public:
+    ~LLVOCacheBodyCodec()
+    {
+        if (mDeflateReady)
+        {
+            deflateEnd(&mDeflate);
+        }
+        if (mInflateReady)
+        {
+            inflateEnd(&mInflate);
+        }
+    }
+
+    // Deflate size bytes of body into out, which has room for size bytes.
+    // Returns the packed size.
+    S32 pack(const U8* body, S32 size, U8* out, const U8* dictionary, U32 dictionary_size)
+    {
+        if (!mDeflateReady)
+        {
+            mDeflate = {};
+            mDeflateReady = deflateInit2(&mDeflate, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+        }
+        // anything that doesn't come out smaller is stored
+        if (size > 1 && mDeflateReady && deflateReset(&mDeflate) == Z_OK
+            && (!dictionary_size || deflateSetDictionary(&mDeflate, dictionary, dictionary_size) == Z_OK))
+        {
+            mDeflate.next_in = const_cast<U8*>(body);
+            mDeflate.avail_in = size;
+            mDeflate.next_out = out;
+            mDeflate.avail_out = size - 1;
+            if (deflate(&mDeflate, Z_FINISH) == Z_STREAM_END)
+            {
+                return (S32)mDeflate.total_out;
+            }
+        }
+        memcpy(out, body, size);
+        return size;
+    }
+
+    bool unpack(const U8* packed, S32 packed_size, U8* out, S32 size, const U8* dictionary, U32 dictionary_size)
+    {
+        if (packed_size == size)
+        {
+            memcpy(out, packed, size); // stored
+            return true;
+        }
+        if (!mInflateReady)
+        {
+            mInflate = {};
+            mInflateReady = inflateInit2(&mInflate, -MAX_WBITS) == Z_OK;
+        }
+        if (!mInflateReady || inflateReset(&mInflate) != Z_OK
+            || (dictionary_size && inflateSetDictionary(&mInflate, dictionary, dictionary_size) != Z_OK))
+        {
+            return false;
+        }
+        mInflate.next_in = const_cast<U8*>(packed);
+        mInflate.avail_in = packed_size;
+        mInflate.next_out = out;
+        mInflate.avail_out = size;
+        return inflate(&mInflate, Z_FINISH) == Z_STREAM_END && mInflate.total_out == (uLong)size;
+    }
+
+private:
+    z_stream mDeflate;
+    z_stream mInflate;
+    bool mDeflateReady = false;
+    bool mInflateReady = false;
+};
+
+// for getDP() and writeToCache(), both on the main thread
+LLVOCacheBodyCodec sMainThreadCodec;
+
+// Whole bodies spread evenly over the region, so that the dictionary holds a
+// bit of everything the region repeats rather than its first few objects.
+void train_dictionary(const LLVOCacheEntry::vocache_entry_map_t& entries, std::vector<U8>& dictionary)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+    // bodies average a few hundred bytes
+    const size_t stride = llmax((size_t)1, entries.size() / (DICTIONARY_SIZE / 256));
+    dictionary.clear();
+    std::vector<U8> body;
+    size_t index = 0;
+    for (const auto& [local_id, entry] : entries)
+    {
+        if (dictionary.size() >= DICTIONARY_SIZE)
+        {
+            break;
+        }
+        if (index++ % stride == 0 && entry->copyBody(body))
+        {
+            dictionary.insert(dictionary.end(), body.begin(), body.end());
+        }
+    }
+    dictionary.resize(llmin(dictionary.size(), (size_t)DICTIONARY_SIZE));
+}
+}
+// </FS>
+
 // Material Override Cache needs a version label, so we can upgrade this later.
 const std::string LLGLTFOverrideCacheEntry::VERSION_LABEL = {"GLTFCacheVer"};
 const int LLGLTFOverrideCacheEntry::VERSION = 1;
@@ -194,7 +328,102 @@ LLVOCacheEntry::LLVOCacheEntry()
     mDP.assignBuffer(mBuffer, 0);
 }
 
-LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
+//---------------------------------------------------------------------------
+// LLVOCacheFileData
+//---------------------------------------------------------------------------
+
+bool LLVOCacheFileData::map(const std::string& filename)
+{
+    mCopy.clear();
+    return mMapping.open(filename);
+}
+
+LLVOCacheFileData::~LLVOCacheFileData()
+{
+    for (DeflatedBody& body : mDeflatedBodies)
+    {
+        if (body.mState == DeflatedBody::READY)
+        {
+            delete[] body.mInflated;
+        }
+    }
+}
+
+void LLVOCacheFileData::detach()
+{
+    // the worker reads straight from the mapping
+    mStopInflating = true;
+    std::lock_guard<std::mutex> lock(mInflateMutex);
+    if (mMapping.isOpen())
+    {
+        mCopy.assign(mMapping.data(), mMapping.data() + mMapping.size());
+        mMapping.close();
+    }
+}
+
+S32 LLVOCacheFileData::addDeflatedBody(size_t offset, S32 packed_size, S32 size)
+{
+    mDeflatedBodies.emplace_back(offset, packed_size, size);
+    return (S32)mDeflatedBodies.size() - 1;
+}
+
+void LLVOCacheFileData::startInflating(const std::shared_ptr<LLVOCacheFileData>& self)
+{
+    LL::WorkQueueBase::ptr_t general_queue = LL::WorkQueueBase::getInstance("General");
+    if (!mDeflatedBodies.empty() && general_queue)
+    {
+        // if it can't be posted, getDP() inflates them one by one
+        general_queue->post([self]() { self->inflateBodies(); });
+    }
+}
+
+void LLVOCacheFileData::inflateBodies()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+    LLVOCacheBodyCodec codec;
+    std::lock_guard<std::mutex> lock(mInflateMutex);
+    for (DeflatedBody& body : mDeflatedBodies)
+    {
+        if (mStopInflating)
+        {
+            break;
+        }
+        U8 state = DeflatedBody::PENDING;
+        if (!body.mState.compare_exchange_strong(state, DeflatedBody::INFLATING))
+        {
+            continue; // already claimed
+        }
+        U8* inflated = new U8[body.mSize];
+        if (!codec.unpack(data() + body.mOffset, body.mPackedSize, inflated, body.mSize, dictionary(), mDictionarySize))
+        {
+            // leave it to getDP() to report
+            delete[] inflated;
+            state = DeflatedBody::INFLATING;
+            body.mState.compare_exchange_strong(state, DeflatedBody::PENDING);
+            continue;
+        }
+        body.mInflated = inflated;
+        state = DeflatedBody::INFLATING;
+        if (!body.mState.compare_exchange_strong(state, DeflatedBody::READY, std::memory_order_release))
+        {
+            delete[] inflated; // claimed while we were at it
+        }
+    }
+}
+
+U8* LLVOCacheFileData::takeInflated(S32 slot)
+{
+    DeflatedBody& body = mDeflatedBodies[slot];
+    if (body.mState.exchange(DeflatedBody::CLAIMED, std::memory_order_acquire) == DeflatedBody::READY)
+    {
+        return body.mInflated;
+    }
+    return nullptr;
+}
+
+//---------------------------------------------------------------------------
+
+LLVOCacheEntry::LLVOCacheEntry(const file_data_ptr_t& file_data, size_t& offset, bool compressed)
 :   LLViewerOctreeEntryData(LLViewerOctreeEntry::LLVOCACHEENTRY),
     mBuffer(NULL),
     mUpdateFlags(-1),
@@ -205,23 +434,32 @@ LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
     mBSphereRadius(-1.0f)
 {
     S32 size = -1;
+    S32 packed_size = -1; // <FS/> Compressed cache files
+    const S32 header_size = compressed ? COMPRESSED_ENTRY_HEADER_SIZE : ENTRY_HEADER_SIZE; // <FS/>
     bool success;
-    static U8 data_buffer[ENTRY_HEADER_SIZE];
 
     mDP.assignBuffer(mBuffer, 0);
 
-    success = check_read(apr_file, (void *)data_buffer, ENTRY_HEADER_SIZE);
+    success = offset + header_size <= file_data->size();
     if (success)
     {
+        const U8* data_buffer = file_data->data() + offset;
         memcpy(&mLocalID, data_buffer, sizeof(U32));
         memcpy(&mCRC, data_buffer + sizeof(U32), sizeof(U32));
         memcpy(&mHitCount, data_buffer + (2 * sizeof(U32)), sizeof(S32));
         memcpy(&mDupeCount, data_buffer + (3 * sizeof(U32)), sizeof(S32));
         memcpy(&mCRCChangeCount, data_buffer + (4 * sizeof(U32)), sizeof(S32));
         memcpy(&size, data_buffer + (5 * sizeof(U32)), sizeof(S32));
+        // <FS> Compressed cache files
+        packed_size = size;
+        if (compressed)
+        {
+            memcpy(&packed_size, data_buffer + ENTRY_HEADER_SIZE, sizeof(S32));
+        }
+        // </FS>
 
         // Corruption in the cache entries
-        if ((size > MAX_ENTRY_BODY_SIZE) || (size < 1))
+        if ((size > MAX_ENTRY_BODY_SIZE) || (size < 1) || (packed_size > size) || (packed_size < 1)) // <FS/>
         {
             // We've got a bogus size, skip reading it.
             // We won't bother seeking, because the rest of this file
@@ -232,19 +470,27 @@ LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
     }
     if(success && size > 0)
     {
-        mBuffer = new U8[size];
-        success = check_read(apr_file, mBuffer, size);
+        success = offset + header_size + packed_size <= file_data->size();
 
         if(success)
         {
-            mDP.assignBuffer(mBuffer, size);
+            // Keep a reference to the data instead of copying it
+            mFileData = file_data;
+            mFileDataOffset = offset + header_size;
+            mFileDataSize = size;
+            mFilePackedSize = packed_size;
+            offset = mFileDataOffset + packed_size;
+            // <FS> Compressed cache files
+            if (packed_size != size)
+            {
+                mFileSlot = file_data->addDeflatedBody(mFileDataOffset, packed_size, size);
+            }
+            // </FS>
         }
         else
         {
             // Improve logging around vocache
             LL_WARNS() << "Error loading cache entry for " << mLocalID << ", size " << size << " aborting!" << LL_ENDL;
-            delete[] mBuffer ;
-            mBuffer = NULL ;
         }
     }
 
@@ -268,6 +514,8 @@ LLVOCacheEntry::~LLVOCacheEntry()
 
 void LLVOCacheEntry::updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp)
 {
+    mFileData.reset(); // superseded by the new data
+
     if(mCRC != crc)
     {
         mCRC = crc;
@@ -310,7 +558,7 @@ void LLVOCacheEntry::removeAllChildren()
 //virtual
 void LLVOCacheEntry::setOctreeEntry(LLViewerOctreeEntry* entry)
 {
-    if(!entry && mDP.getBufferSize() > 0)
+    if(!entry && getDP())
     {
         LLUUID fullid;
         LLViewerObject::unpackUUID(&mDP, fullid, "ID");
@@ -407,6 +655,11 @@ LLVOCacheEntry* LLVOCacheEntry::getChild()
 
 LLDataPackerBinaryBuffer *LLVOCacheEntry::getDP()
 {
+    if (mFileData)
+    {
+        loadFromFileData();
+    }
+
     if (mDP.getBufferSize() == 0)
     {
         //LL_INFOS() << "Not getting cache entry, invalid!" << LL_ENDL;
@@ -416,6 +669,39 @@ LLDataPackerBinaryBuffer *LLVOCacheEntry::getDP()
     return &mDP;
 }
 
+// <FS> Copy the packed data out of the region's cache file on first use,
+// or take it from the background inflation if the file is compressed
+void LLVOCacheEntry::loadFromFileData()
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+    if (mFileSlot >= 0)
+    {
+        mBuffer = mFileData->takeInflated(mFileSlot);
+        if (mBuffer)
+        {
+            mDP.assignBuffer(mBuffer, mFileDataSize);
+            mFileData.reset();
+            return;
+        }
+    }
+    if (mFileDataOffset + mFilePackedSize <= mFileData->size())
+    {
+        mBuffer = new U8[mFileDataSize];
+        if (sMainThreadCodec.unpack(mFileData->data() + mFileDataOffset, mFilePackedSize, mBuffer, mFileDataSize,
+                                    mFileData->dictionary(), mFileData->dictionarySize()))
+        {
+            mDP.assignBuffer(mBuffer, mFileDataSize);
+        }
+        else
+        {
+            LL_WARNS() << "Unreadable compressed cache entry for " << mLocalID << LL_ENDL;
+            delete[] mBuffer;
+            mBuffer = NULL;
+        }
+    }
+    mFileData.reset();
+}
+
 void LLVOCacheEntry::recordHit()
 {
     mHitCount++;
@@ -432,9 +718,17 @@ void LLVOCacheEntry::dump() const
         << LL_ENDL;
 }
 
-S32 LLVOCacheEntry::writeToBuffer(U8 *data_buffer) const
+S32 LLVOCacheEntry::writeToBuffer(U8 *data_buffer, bool compressed, const U8* dictionary, U32 dictionary_size) const
 {
     S32 size = mDP.getBufferSize();
+    S32 packed_size = size; // <FS/> Compressed cache files
+    const U8* body = mBuffer;
+    if (mFileData) // never loaded, write it straight from the old file
+    {
+        size = mFileDataSize;
+        packed_size = mFilePackedSize;
+        body = mFileData->data() + mFileDataOffset;
+    }
 
     if (size > MAX_ENTRY_BODY_SIZE)
     {
@@ -448,10 +742,54 @@ S32 LLVOCacheEntry::writeToBuffer(U8 *data_buffer) const
     memcpy(data_buffer + (3 * sizeof(U32)), &mDupeCount, sizeof(S32));
     memcpy(data_buffer + (4 * sizeof(U32)), &mCRCChangeCount, sizeof(S32));
     memcpy(data_buffer + (5 * sizeof(U32)), &size, sizeof(S32));
-    memcpy(data_buffer + ENTRY_HEADER_SIZE, (void*)mBuffer, size);
 
-    return ENTRY_HEADER_SIZE + size;
+    // <FS> Compressed cache files. A body that is still deflated in the old
+    // file is copied over as is when it was packed against the same
+    // dictionary; otherwise it is inflated, and packed again if need be.
+    U8* packed = data_buffer + COMPRESSED_ENTRY_HEADER_SIZE;
+    if (compressed && packed_size != size && mFileData->dictionary() == dictionary)
+    {
+        memcpy(packed, body, packed_size);
+        memcpy(data_buffer + ENTRY_HEADER_SIZE, &packed_size, sizeof(S32));
+        return COMPRESSED_ENTRY_HEADER_SIZE + packed_size;
+    }
+
+    U8 unpacked[MAX_ENTRY_BODY_SIZE];
+    U8* out = compressed ? unpacked : data_buffer + ENTRY_HEADER_SIZE;
+    if (packed_size != size || !compressed)
+    {
+        if (!sMainThreadCodec.unpack(body, packed_size, out, size,
+                                     mFileData ? mFileData->dictionary() : nullptr, mFileData ? mFileData->dictionarySize() : 0))
+        {
+            LL_WARNS() << "Failed to inflate cache entry " << mLocalID << LL_ENDL;
+            return 0;
+        }
+        body = out;
+    }
+    if (!compressed)
+    {
+        return ENTRY_HEADER_SIZE + size;
+    }
+
+    packed_size = sMainThreadCodec.pack(body, size, packed, dictionary, dictionary_size);
+    memcpy(data_buffer + ENTRY_HEADER_SIZE, &packed_size, sizeof(S32));
+    return COMPRESSED_ENTRY_HEADER_SIZE + packed_size;
+    // </FS>
+}
+
+// <FS> The body as it was received, for training a dictionary
+bool LLVOCacheEntry::copyBody(std::vector<U8>& body) const
+{
+    if (!mFileData)
+    {
+        body.assign(mBuffer, mBuffer + mDP.getBufferSize());
+        return mBuffer != NULL;
+    }
+    body.resize(mFileDataSize);
+    return sMainThreadCodec.unpack(mFileData->data() + mFileDataOffset, mFilePackedSize, body.data(), mFileDataSize,
+                                   mFileData->dictionary(), mFileData->dictionarySize());
 }
+// </FS>
 
 #ifndef LL_TEST
 //static
@@ -1164,6 +1502,7 @@ void LLVOCachePartition::removeOccluder(LLVOCacheGroup* group)
 // Format strings used to construct filename for the object cache
 static const char OBJECT_CACHE_FILENAME[] = "objects_%d_%d.slc";
 static const char OBJECT_CACHE_EXTRAS_FILENAME[] = "objects_%d_%d_extras.slec";
+static const char OBJECT_CACHE_PREFETCH_FILENAME[] = "objects_%d_%d_prefetch.slpf"; // <FS> Region prefetch profiles
 
 const U32 MAX_NUM_OBJECT_ENTRIES = 128 ;
 const U32 MIN_ENTRIES_TO_PURGE = 16 ;
@@ -1268,6 +1607,11 @@ void LLVOCache::removeCache(ELLPath location, bool started)
 
     LL_INFOS() << "about to remove the object cache due to settings." << LL_ENDL ;
 
+    while (!mMappedFiles.empty())
+    {
+        releaseMappedFile(mMappedFiles.begin()->first);
+    }
+
     std::string mask = "*";
     std::string cache_dir = gDirUtilp->getExpandedFilename(location, object_cache_dirname);
     LL_INFOS() << "Removing cache at " << cache_dir << LL_ENDL;
@@ -1292,6 +1636,11 @@ void LLVOCache::removeCache()
         return ;
     }
 
+    while (!mMappedFiles.empty())
+    {
+        releaseMappedFile(mMappedFiles.begin()->first);
+    }
+
     std::string mask = "*";
     LL_INFOS() << "Removing object cache at " << mObjectCacheDirName << LL_ENDL;
     gDirUtilp->deleteFilesInDir(mObjectCacheDirName, mask);
@@ -1381,6 +1730,18 @@ std::string LLVOCache::getObjectCacheExtrasFilename(U64 handle)
                llformat(OBJECT_CACHE_EXTRAS_FILENAME, region_x, region_y));
 }
 
+// <FS> Region prefetch profiles
+//static
+std::string LLVOCache::getPrefetchProfileFilename(U64 handle)
+{
+    U32 region_x, region_y;
+
+    grid_from_region_handle(handle, &region_x, &region_y);
+    return gDirUtilp->getExpandedFilename(LL_PATH_CACHE, object_cache_dirname,
+               llformat(OBJECT_CACHE_PREFETCH_FILENAME, region_x, region_y));
+}
+// </FS>
+
 void LLVOCache::removeFromCache(HeaderEntryInfo* entry)
 {
     if(mReadOnly)
@@ -1392,6 +1753,7 @@ void LLVOCache::removeFromCache(HeaderEntryInfo* entry)
     std::string filename;
     getObjectCacheFilename(entry->mHandle, filename);
     LL_WARNS("GLTF", "VOCache") << "Removing object cache for handle " << entry->mHandle << "Filename: " << filename << LL_ENDL;
+    releaseMappedFile(entry->mHandle);
     LLAPRFile::remove(filename, mLocalAPRFilePoolp);
 
     // Note: `removeFromCache` should take responsibility for cleaning up all cache artefacts specfic to the handle/entry.
@@ -1400,6 +1762,8 @@ void LLVOCache::removeFromCache(HeaderEntryInfo* entry)
     LL_WARNS("GLTF", "VOCache") << "Removing generic extras for handle " << entry->mHandle << "Filename: " << filename << LL_ENDL;
     LLFile::remove(filename);
 
+    LLFile::remove(getPrefetchProfileFilename(entry->mHandle), ENOENT); // <FS> Region prefetch profiles
+
     entry->mTime = INVALID_TIME ;
     updateEntry(entry) ; //update the head file.
 }
@@ -1575,9 +1939,18 @@ bool LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
 		LL_PROFILE_ZONE_NAMED_CATEGORY_NETWORK("VOCache:loadRegionObjectCache");        
         LLUUID cache_id;
         getObjectCacheFilename(handle, filename);
-        LLAPRFile apr_file(filename, APR_READ|APR_BINARY, mLocalAPRFilePoolp);
 
-        success = check_read(&apr_file, cache_id.mData, UUID_BYTES);
+        // <FS> Map the file rather than reading it; the entries only keep
+        // offsets into the mapping until their data is needed.
+        releaseMappedFile(handle);
+        LLVOCacheEntry::file_data_ptr_t file_data = std::make_shared<LLVOCacheFileData>();
+        success = file_data->map(filename) && file_data->size() >= UUID_BYTES + sizeof(S32);
+        size_t offset = 0;
+        if (success)
+        {
+            memcpy(cache_id.mData, file_data->data(), UUID_BYTES);
+            offset += UUID_BYTES;
+        }
 
         if(success)
         {
@@ -1590,13 +1963,52 @@ bool LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
 
             if(success)
             {
-                success = check_read(&apr_file, &num_entries, sizeof(S32)) ;
+                memcpy(&num_entries, file_data->data() + offset, sizeof(S32));
+                offset += sizeof(S32);
+
+                // <FS> A compressed file keeps its mapping too, its entries
+                // are inflated one by one as they are needed
+                const bool compressed = num_entries == COMPRESSED_FILE_MARKER;
+                if (compressed)
+                {
+                    U32 version = 0;
+                    success = offset + sizeof(U32) + sizeof(S32) <= file_data->size();
+                    if (success)
+                    {
+                        memcpy(&version, file_data->data() + offset, sizeof(U32));
+                        memcpy(&num_entries, file_data->data() + offset + sizeof(U32), sizeof(S32));
+                        offset += sizeof(U32) + sizeof(S32);
+                        success = version == COMPRESSED_FILE_VERSION;
+                    }
+                    U32 dictionary_size = 0;
+                    if (success)
+                    {
+                        success = offset + sizeof(U32) <= file_data->size();
+                        if (success)
+                        {
+                            memcpy(&dictionary_size, file_data->data() + offset, sizeof(U32));
+                            offset += sizeof(U32);
+                            success = dictionary_size <= DICTIONARY_SIZE && offset + dictionary_size <= file_data->size();
+                        }
+                        if (success)
+                        {
+                            file_data->setDictionary(offset, dictionary_size);
+                            offset += dictionary_size;
+                        }
+                    }
+
+                    if (!success)
+                    {
+                        LL_WARNS() << "Unreadable compressed cache file " << filename << " (version " << version << "), discarding" << LL_ENDL;
+                    }
+                }
+                // </FS>
 
                 if(success)
                 {
-                    for (S32 i = 0; i < num_entries && apr_file.eof() != APR_EOF; i++)
+                    for (S32 i = 0; i < num_entries && offset < file_data->size(); i++)
                     {
-                        LLPointer<LLVOCacheEntry> entry = new LLVOCacheEntry(&apr_file);
+                        LLPointer<LLVOCacheEntry> entry = new LLVOCacheEntry(file_data, offset, compressed);
                         if (!entry->getLocalID())
                         {
                             LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
@@ -1608,6 +2020,12 @@ bool LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
                 }
             }
         }
+
+        if (!cache_entry_map.empty())
+        {
+            mMappedFiles[handle] = file_data;
+            file_data->startInflating(file_data);
+        }
     }
 
     if(!success)
@@ -1843,14 +2261,59 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
     {
         std::string filename;
         getObjectCacheFilename(handle, filename);
+        // entries still reading from the old file must not see it truncated
+        releaseMappedFile(handle);
         LLAPRFile apr_file(filename, APR_CREATE|APR_WRITE|APR_BINARY|APR_TRUNCATE, mLocalAPRFilePoolp);
 
         success = check_write(&apr_file, (void*)id.mData, UUID_BYTES);
 
+        // <FS> Optionally store the entry bodies deflated
+        static LLCachedControl<bool> compress_cache(gSavedSettings, "FSObjectCacheCompression");
+        const bool compressed = compress_cache;
+        if (success && compressed)
+        {
+            S32 marker = COMPRESSED_FILE_MARKER;
+            U32 version = COMPRESSED_FILE_VERSION;
+            success = check_write(&apr_file, &marker, sizeof(S32))
+                && check_write(&apr_file, &version, sizeof(U32));
+        }
+
+        // Keep the dictionary of the old file once it is full grown, so its
+        // bodies can be copied over without inflating them
+        const U8* dictionary = nullptr;
+        U32 dictionary_size = 0;
+        std::vector<U8> trained_dictionary;
+        if (success && compressed)
+        {
+            for (const auto& [local_id, cache_entry] : cache_entry_map)
+            {
+                if (cache_entry->getFileData() && cache_entry->getFileData()->dictionarySize() == DICTIONARY_SIZE)
+                {
+                    dictionary = cache_entry->getFileData()->dictionary();
+                    dictionary_size = DICTIONARY_SIZE;
+                    break;
+                }
+            }
+            if (!dictionary)
+            {
+                train_dictionary(cache_entry_map, trained_dictionary);
+                dictionary = trained_dictionary.data();
+                dictionary_size = (U32)trained_dictionary.size();
+            }
+        }
+        // </FS>
+
         if(success)
         {
             S32 num_entries = static_cast<S32>(cache_entry_map.size()); // if removal is enabled num_entries might be wrong
             success = check_write(&apr_file, &num_entries, sizeof(S32));
+            // <FS> Compressed cache files
+            if (success && compressed)
+            {
+                success = check_write(&apr_file, &dictionary_size, sizeof(U32))
+                    && (!dictionary_size || check_write(&apr_file, (void*)dictionary, dictionary_size));
+            }
+            // </FS>
             if (success)
             {
                 const S32 buffer_size = 32768; //should be large enough for couple MAX_ENTRY_BODY_SIZE
@@ -1862,9 +2325,9 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
                 {
                     if (!removal_enabled || iter->second->isValid())
                     {
-                        S32 size = iter->second->writeToBuffer(data_buffer + size_in_buffer);
+                        S32 size = iter->second->writeToBuffer(data_buffer + size_in_buffer, compressed, dictionary, dictionary_size); // <FS/>
 
-                        if (size > ENTRY_HEADER_SIZE) // body is minimum of 1
+                        if (size > (compressed ? COMPRESSED_ENTRY_HEADER_SIZE : ENTRY_HEADER_SIZE)) // body is minimum of 1
                         {
                             size_in_buffer += size;
                         }
@@ -1876,7 +2339,7 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
                         }
 
                         // Make sure we have space in buffer for next element
-                        if (buffer_size - size_in_buffer < MAX_ENTRY_BODY_SIZE + ENTRY_HEADER_SIZE)
+                        if (buffer_size - size_in_buffer < MAX_ENTRY_BODY_SIZE + COMPRESSED_ENTRY_HEADER_SIZE) // <FS/>
                         {
                             success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
                             size_in_buffer = 0;
@@ -1912,6 +2375,24 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
     return ;
 }
 
+// <FS> Entries that were never loaded keep the region's cache file mapped.
+// Before the file is rewritten or deleted, move what they still refer to into
+// memory: truncating a mapped file would pull the pages out from under them.
+void LLVOCache::releaseMappedFile(U64 handle)
+{
+    auto iter = mMappedFiles.find(handle);
+    if (iter == mMappedFiles.end())
+    {
+        return;
+    }
+
+    if (LLVOCacheEntry::file_data_ptr_t file_data = iter->second.lock())
+    {
+        file_data->detach();
+    }
+    mMappedFiles.erase(iter);
+}
+
 void LLVOCache::removeGenericExtrasForHandle(U64 handle)
 {
     if(mReadOnly)
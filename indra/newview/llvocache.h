@@ -32,8 +32,13 @@
 #include "lldir.h"
 #include "llvieweroctree.h"
 #include "llapr.h"
+#include "llfile.h"
 #include "llgltfmaterial.h"
 
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 
 //---------------------------------------------------------------------------
@@ -55,6 +60,65 @@ public:
     U64 mRegionHandle = 0;
 };
 
+// <FS> A region's object cache file, mapped read-only and shared by all the
+// entries read from it. Entries only remember where their packed data lives
+// and copy it out the first time it is needed, so regions (and objects) we
+// never look at cost neither the copy nor the resident memory.
+class LLVOCacheFileData
+{
+public:
+    ~LLVOCacheFileData();
+
+    bool map(const std::string& filename);
+
+    // Copy the contents into memory and drop the mapping, so the file itself
+    // can be rewritten or deleted while entries still refer to it.
+    void detach();
+
+    const U8* data() const { return mMapping.isOpen() ? mMapping.data() : mCopy.data(); }
+    size_t size() const { return mMapping.isOpen() ? mMapping.size() : mCopy.size(); }
+
+    // The preset dictionary deflated bodies were packed against, if any
+    void setDictionary(size_t offset, U32 size) { mDictionaryOffset = offset; mDictionarySize = size; }
+    const U8* dictionary() const { return mDictionarySize ? data() + mDictionaryOffset : nullptr; }
+    U32 dictionarySize() const { return mDictionarySize; }
+
+    // Deflated bodies are inflated on the General queue once the whole file
+    // has been read, so getDP() usually finds them ready. An entry registers
+    // its body and later claims it by slot; takeInflated() returns nullptr
+    // when the worker hasn't got to it yet, and the caller inflates it.
+    S32 addDeflatedBody(size_t offset, S32 packed_size, S32 size);
+    void startInflating(const std::shared_ptr<LLVOCacheFileData>& self);
+    U8* takeInflated(S32 slot);
+
+private:
+    void inflateBodies();
+
+    struct DeflatedBody
+    {
+        enum { PENDING, INFLATING, READY, CLAIMED };
+
+        DeflatedBody(size_t offset, S32 packed_size, S32 size):
+            mOffset(offset), mPackedSize(packed_size), mSize(size) {}
+
+        size_t          mOffset;
+        S32             mPackedSize;
+        S32             mSize;
+        U8*             mInflated = nullptr; // published by mState READY
+        std::atomic<U8> mState{ PENDING };
+    };
+
+    LLMappedFile    mMapping;
+    std::vector<U8> mCopy;
+    size_t          mDictionaryOffset{ 0 };
+    U32             mDictionarySize{ 0 };
+    std::deque<DeflatedBody> mDeflatedBodies;
+    // held by the worker while it reads the file, see detach()
+    std::mutex          mInflateMutex;
+    std::atomic<bool>   mStopInflating{ false };
+};
+// </FS>
+
 class LLVOCacheEntry
 :   public LLViewerOctreeEntryData
 {
@@ -108,8 +172,13 @@ public:
 protected:
     ~LLVOCacheEntry();
 public:
+    typedef std::shared_ptr<LLVOCacheFileData> file_data_ptr_t;
+
     LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &dp);
-    LLVOCacheEntry(LLAPRFile* apr_file);
+    // Parse the entry at offset in file_data and advance offset past it.
+    // The packed data itself is left in file_data until getDP() needs it.
+    // A deflated body is handed to file_data to inflate in the background.
+    LLVOCacheEntry(const file_data_ptr_t& file_data, size_t& offset, bool compressed = false);
     LLVOCacheEntry();
 
     void updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp);
@@ -132,7 +201,12 @@ public:
     F32 getSceneContribution() const             { return mSceneContrib;}
 
     void dump() const;
-    S32 writeToBuffer(U8 *data_buffer) const;
+    // <FS> Compressed cache files: deflated bodies are packed against the
+    // preset dictionary, and copied over as they are when they already were
+    S32 writeToBuffer(U8 *data_buffer, bool compressed = false, const U8* dictionary = nullptr, U32 dictionary_size = 0) const;
+    bool copyBody(std::vector<U8>& body) const;
+    const file_data_ptr_t& getFileData() const { return mFileData; }
+    // </FS>
     LLDataPackerBinaryBuffer *getDP();
     void recordHit();
     void recordDupe() { mDupeCount++; }
@@ -164,6 +238,7 @@ public:
 
 private:
     void updateParentBoundingInfo(const LLVOCacheEntry* child);
+    void loadFromFileData();
 
 public:
     typedef std::map<U32, LLPointer<LLVOCacheEntry> >      vocache_entry_map_t;
@@ -184,6 +259,13 @@ protected:
     LLDataPackerBinaryBuffer    mDP;
     U8                          *mBuffer;
 
+    // <FS> Where the packed data still lives while it hasn't been loaded
+    file_data_ptr_t             mFileData;
+    size_t                      mFileDataOffset{ 0 };
+    S32                         mFileDataSize{ 0 };
+    S32                         mFilePackedSize{ 0 }; // mFileDataSize unless deflated
+    S32                         mFileSlot{ -1 }; // of the deflated body in mFileData
+
     F32                         mSceneContrib; //projected scene contributuion of this object.
     U32                         mState; //high 16 bits reserved for special use.
     vocache_entry_set_t         mChildrenList; //children entries in a linked set.
@@ -300,6 +382,9 @@ public:
     void removeEntry(U64 handle) ;
     void removeGenericExtrasForHandle(U64 handle);
 
+    // <FS> Region prefetch profiles are kept and purged along with the region's object cache
+    static std::string getPrefetchProfileFilename(U64 handle);
+
     U32 getCacheEntries() { return mNumEntries; }
     U32 getCacheEntriesMax() { return mCacheSize; }
 
@@ -316,6 +401,7 @@ private:
     void removeEntry(HeaderEntryInfo* entry) ;
     void purgeEntries(U32 size);
     bool updateEntry(const HeaderEntryInfo* entry);
+    void releaseMappedFile(U64 handle);
 
 private:
     bool                 mEnabled;
@@ -329,6 +415,9 @@ private:
     LLVolatileAPRPool*   mLocalAPRFilePoolp ;
     header_entry_queue_t mHeaderEntryQueue;
     handle_entry_map_t   mHandleEntryMap;
+
+    // <FS> Cache files currently mapped by the entries read from them
+    std::map<U64, std::weak_ptr<LLVOCacheFileData> > mMappedFiles;
 };
 
 #endif